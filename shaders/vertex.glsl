@@ -28,10 +28,24 @@
 #version 330
 
 layout (location = 0) in      vec2  in_Vertex;
+// Per instance transformation (instanced drawing of cell references). It is
+// a constant unity transformation for all other draws
+layout (location = 1) in      vec3  in_InstX;
+layout (location = 2) in      vec3  in_InstY;
 uniform mat4 in_CTM;
 uniform float in_Z = 0;
+// The elements of a cell array are drawn as instances. The displacement of
+// instance (row * in_ArrCols + col) is added after the per instance
+// transformation. A single element without displacement for all other draws
+uniform uint in_ArrCols    = 1u;
+uniform vec2 in_ArrColStep = vec2(0.0, 0.0);
+uniform vec2 in_ArrRowStep = vec2(0.0, 0.0);
 
 void main(void)
 {
-   gl_Position = in_CTM * vec4(in_Vertex, in_Z, 1.0);
+   vec3 vertex = vec3(in_Vertex, 1.0);
+   uint col    = uint(gl_InstanceID) % in_ArrCols;
+   uint row    = uint(gl_InstanceID) / in_ArrCols;
+   vec2 displ  = float(col) * in_ArrColStep + float(row) * in_ArrRowStep;
+   gl_Position = in_CTM * vec4(dot(in_InstX, vertex) + displ.x, dot(in_InstY, vertex) + displ.y, in_Z, 1.0);
 }
\ No newline at end of file
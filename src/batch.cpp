@@ -0,0 +1,474 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Toped batch mode - TELL scripts without GUI
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include <wx/wx.h>
+#include <wx/filename.h>
+#include <wx/dir.h>
+#include <wx/stopwatch.h>
+#include <iostream>
+#include <sstream>
+#include "ted_prompt.h"
+#include "datacenter.h"
+#include "viewprop.h"
+#include "trend.h"
+#include "laylogic.h"
+#include "tpdf_common.h"
+#ifdef TPD_EGL
+   #include <string.h>
+   #include <EGL/egl.h>
+   #include <EGL/eglext.h>
+#endif
+
+extern DataCenter*               DATC;
+extern layprop::PropertyCenter*  PROPC;
+extern trend::TrendCenter*       TRENDC;
+extern parsercmd::cmdBLOCK*      CMDBlock;
+extern parsercmd::TellPreProc*   tellPP;
+extern console::toped_logfile    LogFile;
+extern console::TllCmdLine*      Console;
+
+//=============================================================================
+/*! A headless openGL context for toped-batch -gl. It is an EGL context without
+ * a window - surfaceless if the EGL implementation allows it, otherwise with a
+ * 1x1 pbuffer which is never drawn into. The frames of renderview() are drawn
+ * in a frame buffer object anyway (see trend::OffScreen). Mesa provides both
+ * flavours with a software rasterizer, so this works on machines without a GPU
+ * or a display. The context is current in the main thread which is the one
+ * running the parser in batch mode. The capability checks are the same as in
+ * tui::TpdOglContext.*/
+class BatchGlContext {
+   public:
+                        BatchGlContext();
+                       ~BatchGlContext();
+      bool              status() const          {return _status;}
+      bool              useVboRendering() const {return _useVboRendering;}
+      bool              useShaders() const      {return _useShaders;}
+   private:
+      bool              create();
+#ifdef TPD_EGL
+      EGLDisplay        _display;
+      EGLSurface        _surface;
+      EGLContext        _context;
+#endif
+      bool              _status;
+      bool              _useVboRendering;
+      bool              _useShaders;
+};
+
+BatchGlContext::BatchGlContext() :
+#ifdef TPD_EGL
+   _display          ( EGL_NO_DISPLAY ),
+   _surface          ( EGL_NO_SURFACE ),
+   _context          ( EGL_NO_CONTEXT ),
+#endif
+   _status           ( false          ),
+   _useVboRendering  ( false          ),
+   _useShaders       ( false          )
+{
+   if (!create()) return;
+   GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+   // GLEW built for GLX checks for an X display, but the function pointers are
+   // resolved without it
+   if (GLEW_ERROR_NO_GLX_DISPLAY == err) err = GLEW_OK;
+#endif
+   if (GLEW_OK != err)
+   {
+      std::cout << "glewInit() returns an error: " << (const char*)glewGetErrorString(err) << std::endl;
+      return;
+   }
+   bool oglVersion14             = (0 != glewIsSupported("GL_VERSION_1_4"));
+   bool oglVersion33             = (0 != glewIsSupported("GL_VERSION_3_3"));
+   bool oglExtMultiDrawArrays    = (0 != glewIsSupported("GL_EXT_multi_draw_arrays"));
+   bool oglArbVertexBufferObject = (0 != glewIsSupported("GL_ARB_vertex_buffer_object"));
+   _useVboRendering = oglVersion14 && oglExtMultiDrawArrays && oglArbVertexBufferObject;
+   _useShaders      = oglVersion33;
+   _status          = true;
+}
+
+bool BatchGlContext::create()
+{
+#ifdef TPD_EGL
+#if defined(EGL_EXT_platform_base) && defined(EGL_MESA_platform_surfaceless)
+   // No X/wayland display is required for the surfaceless platform
+   const char* clientExt = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+   if ((NULL != clientExt) && (NULL != strstr(clientExt, "EGL_MESA_platform_surfaceless")))
+   {
+      PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+         (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+      if (NULL != getPlatformDisplay)
+         _display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+   }
+#endif
+   if (EGL_NO_DISPLAY == _display)
+      _display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+   if ((EGL_NO_DISPLAY == _display) || !eglInitialize(_display, NULL, NULL))
+   {
+      std::cout << "Can't initialise an EGL display" << std::endl;
+      _display = EGL_NO_DISPLAY;
+      return false;
+   }
+   if (!eglBindAPI(EGL_OPENGL_API))
+   {
+      std::cout << "The EGL implementation doesn't provide openGL" << std::endl;
+      return false;
+   }
+   const char* displayExt = eglQueryString(_display, EGL_EXTENSIONS);
+   bool surfaceless = (NULL != displayExt) && (NULL != strstr(displayExt, "EGL_KHR_surfaceless_context"));
+   EGLint cfgAttribs[] = {
+      EGL_SURFACE_TYPE   , surfaceless ? 0 : EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE       , 8,
+      EGL_GREEN_SIZE     , 8,
+      EGL_BLUE_SIZE      , 8,
+      EGL_NONE
+   };
+   EGLConfig config;
+   EGLint numConfigs = 0;
+   if (!eglChooseConfig(_display, cfgAttribs, &config, 1, &numConfigs) || (0 == numConfigs))
+   {
+      std::cout << "Can't find a suitable EGL configuration" << std::endl;
+      return false;
+   }
+   if (!surfaceless)
+   {
+      EGLint pbAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+      _surface = eglCreatePbufferSurface(_display, config, pbAttribs);
+      if (EGL_NO_SURFACE == _surface)
+      {
+         std::cout << "Can't create an EGL pbuffer" << std::endl;
+         return false;
+      }
+   }
+   _context = eglCreateContext(_display, config, EGL_NO_CONTEXT, NULL);
+   if (EGL_NO_CONTEXT == _context)
+   {
+      std::cout << "Can't create an EGL context" << std::endl;
+      return false;
+   }
+   if (!eglMakeCurrent(_display, _surface, _surface, _context))
+   {
+      std::cout << "Can't make the EGL context current" << std::endl;
+      return false;
+   }
+   return true;
+#else
+   std::cout << "toped-batch is built without EGL. Off-screen openGL rendering is not available" << std::endl;
+   return false;
+#endif
+}
+
+BatchGlContext::~BatchGlContext()
+{
+#ifdef TPD_EGL
+   if (EGL_NO_DISPLAY == _display) return;
+   eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+   if (EGL_NO_CONTEXT != _context)
+      eglDestroyContext(_display, _context);
+   if (EGL_NO_SURFACE != _surface)
+      eglDestroySurface(_display, _surface);
+   eglTerminate(_display);
+#endif
+}
+
+//=============================================================================
+/*! The batch (headless) version of Toped. It executes a TELL script given on
+ * the command line and exits. There is no main window and no canvas. All
+ * TpdPost messages are dropped (there are no windows registered) and the log
+ * goes to the standard output. By default there is no openGL context either
+ * and the text renderer (TrendCenter in non-GUI mode) is used. With -gl (or
+ * -render) a headless openGL context is created (see BatchGlContext) and the
+ * renderers are the same as in the GUI, so renderview() works and the
+ * rendering benchmarks can run without a display. The parallel operations
+ * (logic, import, rendering data, quad tree sorting) use all available CPUs
+ * unless -threads says otherwise. The execution time of every top level
+ * function call is logged. The exit code is not 0 if any of the tllcheck()
+ * calls of the script failed (see tll/tllcheck.tll).*/
+class TopedBatch : public wxAppConsole {
+   public:
+      virtual bool      OnInit();
+      virtual int       OnRun();
+      virtual int       OnExit();
+   private:
+      bool              parseCmdLineArgs();
+      void              getDirs();
+      void              loadGlfFonts();
+      wxString          _localDir;
+      wxString          _globalDir;
+      wxString          _tpdFontDir;
+      wxString          _tpdShadersDir;
+      wxString          _inputTellFile;
+      wxArrayString     _tllIncludePath;
+      word              _numThreads;
+      bool              _headlessGl;
+      trend::RenderType _forceRenderType;
+      BatchGlContext*   _glContext;
+};
+
+//=============================================================================
+bool TopedBatch::OnInit()
+{
+   _numThreads      = 0;
+   _headlessGl      = false;
+   _forceRenderType = trend::rtTBD;
+   _glContext       = NULL;
+   getDirs();
+   PROPC  = DEBUG_NEW layprop::PropertyCenter();
+   DATC   = DEBUG_NEW DataCenter(std::string(_localDir.mb_str(wxConvUTF8)), std::string(_globalDir.mb_str(wxConvUTF8)));
+   tellPP = DEBUG_NEW parsercmd::TellPreProc();
+   if (!parseCmdLineArgs())
+      return false;
+   TessellPoly::tenderTesel = gluNewTess();
+   #ifndef WIN32
+      gluTessCallback(TessellPoly::tenderTesel, GLU_TESS_BEGIN_DATA,
+                      (GLvoid(*)())&TessellPoly::teselBegin);
+      gluTessCallback(TessellPoly::tenderTesel, GLU_TESS_VERTEX_DATA,
+                      (GLvoid(*)())&TessellPoly::teselVertex);
+      gluTessCallback(TessellPoly::tenderTesel, GLU_TESS_END_DATA,
+                      (GLvoid(*)())&TessellPoly::teselEnd);
+   #else
+      gluTessCallback(TessellPoly::tenderTesel, GLU_TESS_BEGIN_DATA,
+                      (GLvoid(__stdcall *)())&TessellPoly::teselBegin);
+      gluTessCallback(TessellPoly::tenderTesel, GLU_TESS_VERTEX_DATA,
+                      (GLvoid(__stdcall *)())&TessellPoly::teselVertex);
+      gluTessCallback(TessellPoly::tenderTesel, GLU_TESS_END_DATA,
+                      (GLvoid(__stdcall *)())&TessellPoly::teselEnd);
+   #endif
+   DEBUG_NEW console::TllCCmdLine();
+   if (_headlessGl)
+   {
+      _glContext = DEBUG_NEW BatchGlContext();
+      if (!_glContext->status())
+      {
+         std::cout << "Can't create a headless openGL context (-gl)" << std::endl;
+         return false;
+      }
+      TRENDC = DEBUG_NEW trend::TrendCenter(true
+                                            ,_forceRenderType
+                                            ,_glContext->useVboRendering()
+                                            ,_glContext->useShaders());
+   }
+   else
+      TRENDC = DEBUG_NEW trend::TrendCenter(false);
+   console::ted_log_ctrl *logWindow = DEBUG_NEW console::ted_log_ctrl(NULL);
+   delete wxLog::SetActiveTarget(logWindow);
+   if (_headlessGl)
+   {
+      TRENDC->reportRenderer(_forceRenderType);
+      std::string stdShaderDir(_tpdShadersDir.mb_str(wxConvFile));
+      TRENDC->initShaders(stdShaderDir);
+   }
+   loadGlfFonts();
+   for (unsigned i = 0; i < _tllIncludePath.size(); i++)
+      Console->addTllIncludePath(_tllIncludePath[i]);
+   Console->addTllEnvList(wxT("TLL_INCLUDE_PATH"));
+   wxString tllDefaultIncPath;
+   tllDefaultIncPath << _globalDir << wxT("/tll/");
+   Console->addTllIncludePath(tllDefaultIncPath);
+   // No session log (and hence no recovery) in batch mode
+   LogFile.setEnabled(false);
+   // Parallel operations
+   logicop::LayerLogic::setThreads(_numThreads);
+   ImportDB::setThreads(_numThreads);
+   trend::TrendBase::setThreads(_numThreads);
+   laydata::QTreeBuild::setThreads(_numThreads);
+   // Register the TELL functions
+   CMDBlock = DEBUG_NEW parsercmd::cmdMAIN();
+   tellstdfunc::initInternalFunctions(static_cast<parsercmd::cmdMAIN*>(CMDBlock));
+   parsercmd::cmdFUNCCALL::setProfiling(true);
+   return true;
+}
+
+//=============================================================================
+int TopedBatch::OnRun()
+{
+   std::string fname(_inputTellFile.mb_str(wxConvFile));
+   std::string fullName;
+   if (!Console->findTellFile(fname.c_str(), fullName))
+   {
+      std::cout << "Can't find TELL file \"" << fname << "\"" << std::endl;
+      return 1;
+   }
+   wxString inputfile;
+   inputfile << wxT("#include \"") << _inputTellFile << wxT("\"");
+   wxStopWatch watch;
+   Console->parseCommand(inputfile, false);
+   std::ostringstream info;
+   info << "\"" << fname << "\" executed in " << watch.Time() << " msec.";
+   tell_log(console::MT_INFO, info.str());
+   // The scripts using tllcheck.tll are counting their failed checks
+   telldata::TellVar* failures = CMDBlock->getID("tll_failures");
+   if ((NULL != failures) && (telldata::tn_int == failures->get_type()))
+   {
+      int4b numFailures = static_cast<telldata::TtInt*>(failures)->value();
+      if (0 < numFailures)
+      {
+         std::cout << numFailures << " check(s) failed" << std::endl;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+//=============================================================================
+int TopedBatch::OnExit()
+{
+   delete CMDBlock;
+   delete PROPC;
+   delete TRENDC;
+   delete DATC;
+   delete tellPP;
+   if (NULL != TessellPoly::tenderTesel)
+      gluDeleteTess(TessellPoly::tenderTesel);
+   // The openGL objects are gone with the renderers above - the context last
+   if (NULL != _glContext)
+      delete _glContext;
+#ifdef DB_MEMORY_TRACE
+   MemTrack::TrackDumpBlocks();
+#endif
+   return wxAppConsole::OnExit();
+}
+
+//=============================================================================
+bool TopedBatch::parseCmdLineArgs()
+{
+   bool runTheTool = true;
+   int curarNum = 1;
+   while (runTheTool && (curarNum < argc))
+   {
+      wxString curar(argv[curarNum++]);
+      if (0 == curar.Find(wxT("-I")))
+         _tllIncludePath.Add(curar.Remove(0,2));
+      else if (0 == curar.Find(wxT("-D")))
+      {
+         wxString defOnly = curar.Remove(0,2);
+         tellPP->cmdlDefine( std::string(defOnly.mb_str(wxConvUTF8)) );
+      }
+      else if (wxT("-threads") == curar)
+      {
+         long int numThreads;
+         if ((curarNum < argc) && wxString(argv[curarNum++]).ToLong(&numThreads) && (0 <= numThreads))
+            _numThreads = (word)numThreads;
+         else
+         {
+            std::cout << "  -threads <number> : Non-negative integer expected" << std::endl;
+            runTheTool = false;
+         }
+      }
+      else if (wxT("-gl") == curar)
+         _headlessGl = true;
+      else if (wxT("-render") == curar)
+      {
+         wxString forceRenderType;
+         if (curarNum < argc) forceRenderType = argv[curarNum++];
+         if      (wxT("basic")  == forceRenderType) _forceRenderType = trend::rtTolder;
+         else if (wxT("vbo")    == forceRenderType) _forceRenderType = trend::rtTenderer;
+         else if (wxT("shader") == forceRenderType) _forceRenderType = trend::rtToshader;
+         else {
+            std::cout << "  -render <type> : One of \"basic\", \"vbo\" or \"shader\" expected" << std::endl;
+            runTheTool = false;
+         }
+         _headlessGl = true;
+      }
+      else if (wxT("-help") == curar)
+         runTheTool = false;
+      else if (!(0 == curar.Find('-')))
+         _inputTellFile = curar;
+      else
+      {
+         std::string invalid_argument(curar.mb_str(wxConvUTF8));
+         std::cout << "Unknown command line option \"" << invalid_argument <<"\"" << std::endl ;
+         runTheTool = false;
+      }
+   }
+   if (runTheTool && _inputTellFile.IsEmpty())
+   {
+      std::cout << "No TELL file specified" << std::endl;
+      runTheTool = false;
+   }
+   if (!runTheTool)
+   {
+      std::cout << "Usage: toped-batch {options}* tll-file" << std::endl ;
+      std::cout << "Command line options:" << std::endl ;
+      std::cout << "  -threads <number> : Threads of the parallel operations. 0 (default) - all CPUs" << std::endl;
+      std::cout << "  -gl               : Headless openGL context - renderview() works (needs EGL)" << std::endl;
+      std::cout << "  -render <type>    : Enforce openGL render type. One of \"basic\", \"vbo\" or \"shader\". Implies -gl" << std::endl;
+      std::cout << "  -I<path>          : Includes additional search paths for TLL files" << std::endl ;
+      std::cout << "  -D<macro>         : Equivalent to #define <macro> " << std::endl ;
+      std::cout << "  -help             : This help message " << std::endl ;
+   }
+   return runTheTool;
+}
+
+//=============================================================================
+void TopedBatch::getDirs()
+{
+   if (!wxGetEnv(wxT("TPD_LOCAL"), &_localDir))
+      _localDir = wxT("./");
+   else
+      _localDir << wxT("/");
+   if (!wxGetEnv(wxT("TPD_GLOBAL"), &_globalDir))
+      _globalDir = wxT("./");
+   else
+      _globalDir << wxT("/");
+   wxFileName fontsFolder(_globalDir);
+   fontsFolder.AppendDir(wxT("fonts"));
+   fontsFolder.Normalize();
+   if (fontsFolder.DirExists())
+      _tpdFontDir = fontsFolder.GetFullPath();
+   else
+      _tpdFontDir = wxT("./");
+   wxFileName shadersFolder(_globalDir);
+   shadersFolder.AppendDir(wxT("shaders"));
+   shadersFolder.Normalize();
+   if (shadersFolder.DirExists())
+      _tpdShadersDir = shadersFolder.GetFullPath();
+   else
+      _tpdShadersDir = wxT("");
+}
+
+//=============================================================================
+void TopedBatch::loadGlfFonts()
+{
+   wxDir fontDirectory(_tpdFontDir);
+   if (fontDirectory.IsOpened())
+   {
+      wxString curFN;
+      if (fontDirectory.GetFirst(&curFN, wxT("*.glf"), wxDIR_FILES))
+      {
+         do
+         {
+            std::string ffname(_tpdFontDir.mb_str(wxConvFile));
+            ffname += curFN.mb_str(wxConvFile);
+            TRENDC->loadLayoutFont(ffname);
+         } while (fontDirectory.GetNext(&curFN));
+      }
+   }
+   if (0 == TRENDC->numFonts())
+      tell_log(console::MT_WARNING, "Can't load layout fonts. Check the TPD_GLOBAL env. variable");
+}
+
+IMPLEMENT_APP_CONSOLE(TopedBatch)
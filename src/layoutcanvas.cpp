@@ -44,7 +44,7 @@
 
 extern DataCenter*               DATC;
 extern layprop::PropertyCenter*  PROPC;
-//extern trend::TrendCenter*       TRENDC;
+extern trend::TrendCenter*       TRENDC;
 extern console::TllCmdLine*      Console;
 extern const wxEventType         wxEVT_CANVAS_STATUS;
 extern const wxEventType         wxEVT_CANVAS_CURSOR;
@@ -54,11 +54,6 @@ extern const wxEventType         wxEVT_MOUSE_INPUT;
 extern const wxEventType         wxEVT_CURRENT_LAYER;
 extern const wxEventType         wxEVT_DRCDRAWPREP;
 
-//-----------------------------------------------------------------------------
-// Static members
-//-----------------------------------------------------------------------------
-wxMutex          tui::DrawThread::_mutex;
-
 #include "../ui/crosscursor.xpm"
 
 //tui::CanvasStatus::CanvasStatus(){};
@@ -292,7 +287,8 @@ tui::LayoutCanvas::LayoutCanvas(wxWindow *parent, const wxPoint& pos, const wxSi
    _reperX          ( false ),
    _reperY          ( false ),
    _longCursor      ( false ),
-   _oglThread       ( false ),
+   _oglThread       ( true  ),
+   _renderReady     ( false ),
    _blinkInterval   ( 0     ),
    _blinkOn         ( false ),
    _initialised     ( false )
@@ -321,12 +317,9 @@ tui::LayoutCanvas::LayoutCanvas(wxWindow *parent, const wxPoint& pos, const wxSi
    _blinkTimer.SetOwner(this);
    _crossCur = MakeCursor(crosscursor, 16, 16);
    SetCursor(*_crossCur);
-   // Running the openGL drawing in a separate thread - _oglThread
-   // This appears to be a bad idea especially on some platforms.
-   // Google it for some opinions.
-   // The code is there, but I never got it running reliably if at all
-   // The option stays for the sake of experiment.
-   // DON'T enable it if you're not sure what you're doing!
+   // _oglThread - only the DB traversal runs in a separate thread. All openGL
+   // calls stay in this one. Running the openGL drawing itself in a separate
+   // thread appears to be a bad idea especially on some platforms.
 }
 
 void   tui::LayoutCanvas::showInfo()
@@ -459,46 +452,41 @@ void tui::LayoutCanvas::OnresizeGL(wxSizeEvent& event) {
 void tui::LayoutCanvas::OnpaintGL(wxPaintEvent& event)
 {
    if (!_initialised) return;
-   if (_invalidWindow)
+   if (_invalidWindow || _renderReady)
    {
       // _invalidWindow indicates zooming or refreshing after a tell operation.
-      if (_oglThread)
-      {
-         tui::DrawThread *dthrd = DEBUG_NEW tui::DrawThread(this);
-         wxThreadError result = dthrd->Create();
-         if (wxTHREAD_NO_ERROR == result)
-            dthrd->Run();
-         else
-            tell_log( console::MT_ERROR, "Can't execute the drawing in a separate thread");
-      }
-      else
+      // _renderReady - the background traversal of the current view is done
+      _blinkTimer.Stop();
+      wxPaintDC dc(this);
+      // the traversal in progress (if any) is obsolete. Stop it before the
+      // property DB is locked for the viewport update
+      if (_invalidWindow) DATC->stopRender();
+      glMatrixMode( GL_MODELVIEW );
+      glShadeModel( GL_FLAT ); // Single colour
+      updateViewport();
+      // CTM matrix stuff
+      CTM ctmOrtho(TP(_lpBL.x(),_lpTR.y()), TP(_lpTR.x(), _lpBL.y()));
+      real mtrxOrtho [16];
+      ctmOrtho.oglForm(mtrxOrtho);
+      glLoadMatrixd(mtrxOrtho);
+
+      glClear(GL_COLOR_BUFFER_BIT);
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glClear(GL_ACCUM_BUFFER_BIT);
+      if      (!_oglThread)    DATC->render();
+      else if (_invalidWindow) DATC->renderAsync();
+      else                     DATC->renderFinish();
+      if (0 == _blinkInterval) DATC->grcDraw();
+      glAccum(GL_LOAD, 1.0);
+      _invalidWindow = false;
+      _renderReady = false;
+      rubberPaint();
+      SwapBuffers();
+      if (0 < _blinkInterval)
       {
-         _blinkTimer.Stop();
-         wxPaintDC dc(this);
-         glMatrixMode( GL_MODELVIEW );
-         glShadeModel( GL_FLAT ); // Single colour
-         updateViewport();
-         // CTM matrix stuff
-         CTM ctmOrtho(TP(_lpBL.x(),_lpTR.y()), TP(_lpTR.x(), _lpBL.y()));
-         real mtrxOrtho [16];
-         ctmOrtho.oglForm(mtrxOrtho);
-         glLoadMatrixd(mtrxOrtho);
-
-         glClear(GL_COLOR_BUFFER_BIT);
-         glEnable(GL_BLEND);
-         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-         glClear(GL_ACCUM_BUFFER_BIT);
-         DATC->render();
-         if (0 == _blinkInterval) DATC->grcDraw();
-         glAccum(GL_LOAD, 1.0);
-         _invalidWindow = false;
-         rubberPaint();
-         SwapBuffers();
-         if (0 < _blinkInterval)
-         {
-            _blinkOn = false;
-            _blinkTimer.Start(_blinkInterval,wxTIMER_CONTINUOUS);
-         }
+         _blinkOn = false;
+         _blinkTimer.Start(_blinkInterval,wxTIMER_CONTINUOUS);
       }
    }
    else
@@ -930,32 +918,22 @@ void tui::LayoutCanvas::OnZoom(wxCommandEvent& evt) {
       case ZOOM_EMPTY  : box = DEBUG_NEW DBbox(DEFAULT_OVL_BOX);
                         break;
       case ZOOM_REFRESH: _invalidWindow = true; Refresh(); return;
+      case ZOOM_RENDERED:
+         // the notification might be for a view which is already obsolete
+         if (DATC->renderDone()) {_renderReady = true; Refresh();}
+         return;
+      case ZOOM_OFFSCREEN:
+         offScreenRender(static_cast<trend::OffScreenView*>(evt.GetClientData()));
+         return;
       default: assert(false); break;
    }
    int Wcl, Hcl;
    GetClientSize(&Wcl,&Hcl);
    // To prevent a loss of precision in the following lines - don't use
    // integer variables (Wcl & Hcl) directly
-   double W = Wcl;
-   double H = Hcl;
-   double w = fabs((double)box->p1().x() - (double)box->p2().x());
-   double h = fabs((double)box->p1().y() - (double)box->p2().y());
-   if (w > (double) MAX_INT4B)
-   {
-      tell_log(console::MT_WARNING, "Can't zoom any further");
-      w = MAX_INT4B;
-   }
-   if (h > (double) MAX_INT4B)
-   {
-      tell_log(console::MT_WARNING, "Can't zoom any further");
-      h = MAX_INT4B;
-   }
-   double sc =  ((W/H < w/h) ? w/W : h/H);
-//   sc = (0 == sc) ? 1.0 : sc;
-   double tx = (((double)box->p1().x() + (double)box->p2().x()) - W*sc) / 2;
-   double ty = (((double)box->p1().y() + (double)box->p2().y()) - H*sc) / 2;
-   _layCTM.setCTM( sc, 0.0, 0.0, sc, tx, ty);
-   _layCTM.FlipX(((double)box->p1().y() + (double)box->p2().y())/2);  // flip Y coord towards the center
+   _layCTM = trend::fitView(*box, Wcl, Hcl);
+   // the background traversal holds the property DB lock and it is obsolete anyway
+   DATC->stopRender();
    layprop::DrawProperties* drawProp;
    if (PROPC->lockDrawProp(drawProp))
    {
@@ -967,6 +945,29 @@ void tui::LayoutCanvas::OnZoom(wxCommandEvent& evt) {
    Refresh();
 }
 
+/*! Renders the view requested off-screen (see DataCenter::renderOffScreen())
+ * and restores the canvas view afterwards. The parser thread waiting for the
+ * result is woken up at the end.*/
+void tui::LayoutCanvas::offScreenRender(trend::OffScreenView* request)
+{
+   // the traversal in progress (if any) is for the canvas view
+   DATC->stopRender();
+   if (DATC->renderOffScreen(*request))
+   {
+      // back to the canvas view
+      layprop::DrawProperties* drawProp;
+      if (PROPC->lockDrawProp(drawProp))
+      {
+         drawProp->setScrCTM(_layCTM.Reversed());
+      }
+      PROPC->unlockDrawProp(drawProp, false);
+      _invalidWindow = true;
+      Refresh();
+   }
+   // wake-up the thread expecting the result
+   Console->_threadWaits4->Signal();
+}
+
 void tui::LayoutCanvas::updateViewport()
 {
    int W, H;
@@ -1244,38 +1245,6 @@ tui::LayoutCanvas::~LayoutCanvas()
    if (NULL != _crossCur) delete _crossCur;
 }
 
-void* tui::DrawThread::Entry(/*wxGLContext* glRC*/)
-{
-   if (wxMUTEX_NO_ERROR == _mutex.TryLock())
-   {
-      wxClientDC dc(_canvas);
-      glMatrixMode( GL_MODELVIEW );
-      glShadeModel( GL_FLAT ); // Single color
-      _canvas->updateViewport();
-      // CTM matrix stuff
-      glLoadIdentity();
-      glOrtho(_canvas->_lpBL.x(),_canvas->_lpTR.x(),_canvas->_lpTR.y(),_canvas->_lpBL.y(),-1.0,1.0);
-      glClear(GL_COLOR_BUFFER_BIT);
-      glEnable(GL_BLEND);
-      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-      glClear(GL_ACCUM_BUFFER_BIT);
-      DATC->render();    // draw data
-      glAccum(GL_LOAD, 1.0);
-      _canvas->_invalidWindow = false;
-      _canvas->rubberPaint();
-//      if (_canvas->_rubberBand) _canvas->rubberPaint();
-//      if (_canvas->_reperX || _canvas->_reperY) _canvas->longCursor();
-      _canvas->SwapBuffers();
-      _mutex.Unlock();
-   }
-   else
-   {
-      tell_log( console::MT_ERROR, "GL drawing skipped. Mutex busy.");
-      return NULL;
-   }
-   return NULL;
-}
-
 wxCursor* tui::MakeCursor( const char * pXpm[36],  int HotX, int HotY )
 {
    wxCursor * pCursor;
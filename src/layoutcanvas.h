@@ -35,6 +35,7 @@
 #include <string>
 #include "ttt.h"
 #include "tuidefs.h"
+#include "offscreen.h"
 
 namespace tui {
    //=============================================================================
@@ -86,11 +87,10 @@ namespace tui {
    public:
                      LayoutCanvas(wxWindow *parent, const wxPoint&,
                                                 const wxSize& , int* attribList);
-      friend class DrawThread;
       virtual       ~LayoutCanvas();
       void           snapshot(byte*&, word&, word&);
       void           showInfo();
-      void           setOglThread(bool val) {_oglThread = true;}
+      void           setOglThread(bool val) {_oglThread = val;}
       TpdOglContext* glRC() { return _glRC;}
       void           glewContext() {_glRC->glewContext(this);_initialised = true;}
 
@@ -153,6 +153,7 @@ namespace tui {
       DBbox*         zoomRight();
       DBbox*         zoomUp();
       DBbox*         zoomDown();
+      void           offScreenRender(trend::OffScreenView*);
 //      void           drawInterim(const TP&);
       CTM            _layCTM;        //! Layout translation matrix
       TP             _scrMark;       //! Current marker position in DB units
@@ -175,7 +176,8 @@ namespace tui {
       bool           _reperX;        //! Draw a cursor line across the window parallel to the X axis
       bool           _reperY;        //! Draw a cursor line across the window parallel to the Y axis
       bool           _longCursor;    //! Stretch the cursor across the entire canvas
-      bool           _oglThread;     //! Run the openGL drawing in a separate thread
+      bool           _oglThread;     //! Traverse the DB in a separate thread (see DataCenter::renderAsync())
+      bool           _renderReady;   //! The background traversal is done - the view can be completed
       word           _blinkInterval; //!
       wxTimer        _blinkTimer;    //! To implement the flashing images
       bool           _blinkOn;
@@ -187,17 +189,6 @@ namespace tui {
       DECLARE_EVENT_TABLE();
    };
 
-   class DrawThread : public wxThread
-   {
-   public:
-                               DrawThread( LayoutCanvas* canvas, wxThreadKind kind=wxTHREAD_DETACHED ):
-                                 wxThread(kind), _canvas(canvas) {};
-   protected:
-      void*                    Entry();
-      tui::LayoutCanvas*       _canvas;
-      static wxMutex           _mutex;
-   };
-
    wxCursor* MakeCursor(const char * pXpm[36],  int HotX, int HotY );
 }
 #endif
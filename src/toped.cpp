@@ -38,6 +38,7 @@
 #include "datacenter.h"
 #include "viewprop.h"
 #include "tenderer.h"
+#include "offscreen.h"
 #include "tui.h"
 #include "techeditor.h"
 #include "../ui/toped16x16.xpm"
@@ -1182,41 +1183,11 @@ void tui::TopedFrame::OnTDTSnapshot(wxCommandEvent& WXUNUSED(event))
    wxString filename = dlg2.GetPath();
    if(!checkFileOverwriting(filename)) return;
 
-   // Note the pragmas below. It won't create a proper targa file without them!
-   // See the note in LayoutCanvas::snapshot(...)
-#pragma pack(push,1)
-   typedef struct {
-      byte   identsize;              // Size of ID field that follows header (0)
-      byte   colorMapType;           // 0 = None, 1 = paletted
-      byte   imageType;              // 0 = none, 1 = indexed, 2 = rgb, 3 = grey, +8=rle
-      word   colorMapStart;          // First colour map entry
-      word   colorMapLength;         // Number of colors
-      byte   colorMapBits;           // bits per palette entry
-      word   xstart;                 // image x origin
-      word   ystart;                 // image y origin
-      word   width;                  // width in pixels
-      word   height;                 // height in pixels
-      byte   bits;                   // bits per pixel (8 16, 24, 32)
-      byte   descriptor;             // image descriptor
-   } TargaHeader;
-#pragma pack(pop)
-
    byte* theImage = NULL;
    word szH, szW;
    _canvas->snapshot(theImage, szW, szH);
-   unsigned long imgSize = 3 * szH * szW;
-
-   // Initialize the Targa header
-   TargaHeader tHdr = {0, 0, 2, 0, 0, 0, 0, 0, szW, szH, 24, 0 };
-
-   FILE* tFile = fopen(filename.mb_str(wxConvUTF8) , "wb");
-   if(NULL != theImage)
-   {
-      //Save first the targa header and then - the data
-      fwrite(&tHdr, sizeof(TargaHeader), 1, tFile);
-      fwrite(theImage, imgSize, 1, tFile);
-   }
-   fclose(tFile);
+   if (!trend::saveTarga(std::string(filename.mb_str(wxConvUTF8)), theImage, szW, szH))
+      SetStatusText(wxT("Snapshot not saved"));
    delete[] theImage;
 }
 
@@ -398,7 +398,7 @@ void auxdata::GrcCell::write(OutputTdtFile* const tedfile) const
       assert(wl.editable());
       tedfile->putByte(tedf_LAYER);
       tedfile->putLayer(wl());
-      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
          DI->write(tedfile);
       tedfile->putByte(tedf_LAYEREND);
    }
@@ -410,7 +410,7 @@ void auxdata::GrcCell::dbExport(DbExportFile& exportf) const
    {
       assert(wl.editable());
       if ( !exportf.layerSpecification(wl()) ) continue;
-      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
          DI->dbExport(exportf);
    }
 }
@@ -556,7 +556,7 @@ void auxdata::GrcCell::reportLayData(const LayerDef& laydef, AuxDataList& dataLi
    LayerHolderGrc::Iterator wl = _layers.find(laydef);
    if (_layers.end() != wl)
    {
-      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
          dataList.push_back(*DI);
    }
 }
@@ -575,7 +575,7 @@ char auxdata::GrcCell::cleanLay(const LayerDef& laydef, AuxDataList& recovered)
    {
       // first mark all the shapes from the target layer and gather them in
       // the list provided
-      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
       {
          DI->setStatus(sh_selected);
          recovered.push_back(*DI);
@@ -600,7 +600,7 @@ bool auxdata::GrcCell::repairData(const LayerDef& laydef, laydata::ShapeList& ne
    LayerHolderGrc::Iterator wl = _layers.find(laydef);
    if (_layers.end() != wl)
    {
-      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
       {
          laydata::ShapeList* objReplacement = DI->getRepaired();
          if (NULL != objReplacement)
@@ -630,7 +630,7 @@ char auxdata::GrcCell::cleanRepaired(const LayerDef& laydef, AuxDataList& recove
    if (_layers.end() != wl)
    {
       // gather all invalid objects which had been recovered in an AuxdataList
-      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTreeGrc::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
       {
          if (sh_recovered == DI->status())
             recovered.push_back(*DI);
@@ -0,0 +1,968 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Scanline logic operations with entire layers
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include "laylogic.h"
+#include "logicop.h"
+#include "polycross.h"
+#include "tedat.h"
+#include "thrdpool.h"
+
+namespace logicop {
+   //! The position of an active edge within the current slab
+   class SlabEdge {
+   public:
+                        SlabEdge(real x0, real x1, unsigned edge) :
+                           _x0(x0), _x1(x1), _edge(edge) {}
+      bool              operator < (const SlabEdge& se) const
+      {
+         if (_x0 != se._x0) return (_x0 < se._x0);
+         if (_x1 != se._x1) return (_x1 < se._x1);
+         return (_edge < se._edge);
+      }
+      bool              coincide(const SlabEdge& se) const
+      {
+         return ((_x0 == se._x0) && (_x1 == se._x1));
+      }
+      real              _x0;  //! edge position at the bottom of the slab
+      real              _x1;  //! edge position at the top of the slab
+      unsigned          _edge;//! index of the edge
+   };
+   typedef std::vector<SlabEdge>    SlabEdges;
+
+   //! Sorts the edges by the y coordinate of their bottom point
+   class EdgeBottomOrder {
+   public:
+                        EdgeBottomOrder(const std::vector<ScanEdge>& edges) : _edges(edges) {}
+      bool              operator () (unsigned e1, unsigned e2) const
+      {
+         return (_edges[e1].bottom().y() < _edges[e2].bottom().y());
+      }
+   private:
+      const std::vector<ScanEdge>& _edges;
+   };
+
+   //! Compares the bottom of an edge with a given y coordinate
+   class EdgeBottomBelow {
+   public:
+                        EdgeBottomBelow(const std::vector<ScanEdge>& edges) : _edges(edges) {}
+      bool              operator () (unsigned edge, int4b y) const
+      {
+         return (_edges[edge].bottom().y() < y);
+      }
+   private:
+      const std::vector<ScanEdge>& _edges;
+   };
+
+   bool xyLess(const TP& p1, const TP& p2) {return (polycross::xyorder(&p1, &p2) < 0);}
+
+   //! A directed piece of a trapezoid boundary which is not shared with another trapezoid
+   class OutlineEdge {
+   public:
+                        OutlineEdge(const TP& p1, const TP& p2, unsigned trap) :
+                           _p1(p1), _p2(p2), _trap(trap) {}
+      bool              operator < (const OutlineEdge& oe) const
+      {
+         if (_p1 != oe._p1) return xyLess(_p1, oe._p1);
+         return xyLess(_p2, oe._p2);
+      }
+      TP                _p1;
+      TP                _p2;
+      unsigned          _trap;//! index of the trapezoid the edge belongs to
+   };
+   typedef std::vector<OutlineEdge>    OutlineEdges;
+
+   //! Sorts the non-horizontal edges regardless of their direction
+   class SlantedEdgeOrder {
+   public:
+      bool              operator () (const OutlineEdge& e1, const OutlineEdge& e2) const
+      {
+         const TP& lo1 = xyLess(e1._p1, e1._p2) ? e1._p1 : e1._p2;
+         const TP& lo2 = xyLess(e2._p1, e2._p2) ? e2._p1 : e2._p2;
+         if (lo1 != lo2) return xyLess(lo1, lo2);
+         const TP& hi1 = xyLess(e1._p1, e1._p2) ? e1._p2 : e1._p1;
+         const TP& hi2 = xyLess(e2._p1, e2._p2) ? e2._p2 : e2._p1;
+         return xyLess(hi1, hi2);
+      }
+   };
+
+   //! The horizontal side of a trapezoid - its bottom or its top
+   class HorizontalSpan {
+   public:
+                        HorizontalSpan(int4b y, int4b x0, int4b x1, bool top, unsigned trap) :
+                           _y(y), _x0(x0), _x1(x1), _top(top), _trap(trap) {}
+      bool              operator < (const HorizontalSpan& hs) const
+      {
+         if (_y   != hs._y  ) return (_y < hs._y);
+         if (_top != hs._top) return hs._top;
+         return (_x0 < hs._x0);
+      }
+      int4b             _y;
+      int4b             _x0;  //! left end
+      int4b             _x1;  //! right end
+      bool              _top; //! the trapezoid is below the span
+      unsigned          _trap;//! index of the trapezoid the span belongs to
+   };
+   typedef std::vector<HorizontalSpan> HorizontalSpans;
+
+   //! Groups of touching trapezoids (union-find)
+   class TrapezoidSets {
+   public:
+                        TrapezoidSets(unsigned size) : _parent(size)
+      {
+         for (unsigned i = 0; i < size; i++) _parent[i] = i;
+      }
+      unsigned          find(unsigned trap)
+      {
+         while (_parent[trap] != trap)
+            trap = _parent[trap] = _parent[_parent[trap]];
+         return trap;
+      }
+      void              join(unsigned t1, unsigned t2)
+      {
+         t1 = find(t1); t2 = find(t2);
+         if (t1 < t2) _parent[t2] = t1;
+         else         _parent[t1] = t2;
+      }
+   private:
+      std::vector<unsigned> _parent;
+   };
+
+   //! An outline loop traced from the outline edges
+   class OutlineLoop {
+   public:
+                        OutlineLoop(PointVector* points, unsigned group) :
+                           _points(points), _area(0), _group(group) {}
+      PointVector*      _points;
+      real              _area;   //! signed - positive for the outer loops
+      unsigned          _group;  //! the group of the trapezoids it is traced from
+   };
+   typedef std::vector<OutlineLoop>    OutlineLoops;
+
+   //! Twice the signed area of a loop
+   real loopArea(const PointVector& loop)
+   {
+      real area = 0;
+      for (unsigned i = 0, j = loop.size() - 1; i < loop.size(); j = i++)
+         area += real(loop[j].x()) * real(loop[i].y()) - real(loop[i].x()) * real(loop[j].y());
+      return area;
+   }
+
+   /*! Removes the duplicated and the collinear points of a loop - including
+    * the zero width spikes and the points where the loop starts */
+   void cleanLoop(PointVector& loop)
+   {
+      bool modified = true;
+      while (modified && (loop.size() > 2))
+      {
+         modified = false;
+         PointVector clean;
+         clean.reserve(loop.size());
+         for (unsigned i = 0; i < loop.size(); i++)
+         {
+            const TP& prev = clean.empty() ? loop.back() : clean.back();
+            const TP& next = loop[(i + 1) % loop.size()];
+            if (0 == polycross::orientation(&prev, &loop[i], &next))
+               modified = true;
+            else
+               clean.push_back(loop[i]);
+         }
+         loop.swap(clean);
+      }
+   }
+
+   /*! The turn from the direction p0-p1 to the direction p1-p2 in radians -
+    * positive to the left. Turning back is the least preferred choice */
+   real outlineTurn(const TP& p0, const TP& p1, const TP& p2)
+   {
+      real dx1 = real(p1.x()) - real(p0.x());
+      real dy1 = real(p1.y()) - real(p0.y());
+      real dx2 = real(p2.x()) - real(p1.x());
+      real dy2 = real(p2.y()) - real(p1.y());
+      real cross = dx1 * dy2 - dy1 * dx2;
+      real dot   = dx1 * dx2 + dy1 * dy2;
+      if ((0 == cross) && (dot < 0)) return -4.0;
+      return atan2(cross, dot);
+   }
+
+   //! Crossing number test - the point is never on the horizontal line of a vertex
+   bool loopInside(const PointVector& loop, real px, real py)
+   {
+      bool in = false;
+      for (unsigned i = 0, j = loop.size() - 1; i < loop.size(); j = i++)
+      {
+         const TP& a = loop[j];
+         const TP& b = loop[i];
+         if ((a.y() > py) == (b.y() > py)) continue;
+         real x = a.x() + (py - a.y()) * (real(b.x()) - real(a.x())) / (real(b.y()) - real(a.y()));
+         if (x < px) in = !in;
+      }
+      return in;
+   }
+
+   /*! A point inside a loop - half a DBU above its lowest vertex, between the
+    * first two crossings of the loop with that horizontal line */
+   void loopProbe(const PointVector& loop, real& px, real& py)
+   {
+      int4b ymin = loop[0].y();
+      for (unsigned i = 1; i < loop.size(); i++)
+         ymin = std::min(ymin, loop[i].y());
+      py = real(ymin) + 0.5;
+      std::vector<real> crossings;
+      for (unsigned i = 0, j = loop.size() - 1; i < loop.size(); j = i++)
+      {
+         const TP& a = loop[j];
+         const TP& b = loop[i];
+         if ((a.y() > py) == (b.y() > py)) continue;
+         crossings.push_back(a.x() + (py - a.y()) * (real(b.x()) - real(a.x())) / (real(b.y()) - real(a.y())));
+      }
+      std::sort(crossings.begin(), crossings.end());
+      px = (crossings[0] + crossings[1]) / 2;
+   }
+
+   //! Minimum number of edges worth scanning in a separate thread
+   const unsigned MIN_BAND_EDGES = 4096;
+}
+
+//=============================================================================
+/*! A horizontal band of the plane between two scanline stops. Bands are
+ * scanned independently of each other. The trapezoids which reach the top
+ * of the band might continue in the next one, so they are kept apart. */
+class logicop::LayerLogic::ScanBand : public ThreadJob {
+public:
+                     ScanBand(const LayerLogic& logic, LayLogicOp op, const EdgeIndexes& bottoms,
+                              const std::vector<int4b>& stops, unsigned first, unsigned last) :
+                        _nextEdge(0), _logic(logic), _op(op), _bottoms(bottoms),
+                        _stops(stops), _first(first), _last(last) {}
+   virtual void      run();
+   int4b             bottom() const {return _stops[_first];}
+   EdgeIndexes       _active;    //! edges crossing the bottom of the band
+   unsigned          _nextEdge;  //! first edge (in _bottoms) starting at or above the bottom
+   Trapezoids        _done;      //! complete trapezoids
+   Trapezoids        _open;      //! trapezoids reaching the top of the band
+private:
+   const LayerLogic&          _logic;
+   LayLogicOp                 _op;
+   const EdgeIndexes&         _bottoms;
+   const std::vector<int4b>&  _stops;
+   unsigned                   _first;
+   unsigned                   _last;
+};
+
+void logicop::LayerLogic::ScanBand::run()
+{
+   typedef std::map<std::pair<unsigned, unsigned>, unsigned> TrapezoidMap;
+   const ScanEdges& edges = _logic._edges;
+   Trapezoids&  pending = _open; // trapezoids from the previous slab (can be extended)
+   Trapezoids   current;         // trapezoids from the current slab
+   unsigned nextStop = _first;
+   int4b y0 = _stops[nextStop++];
+   while (nextStop <= _last)
+   {
+      // drop the edges ending at the bottom of the slab ...
+      unsigned numActive = 0;
+      for (unsigned i = 0; i < _active.size(); i++)
+         if (edges[_active[i]].top().y() > y0)
+            _active[numActive++] = _active[i];
+      _active.resize(numActive);
+      // ... and add those starting there
+      while ((_nextEdge < _bottoms.size()) && (edges[_bottoms[_nextEdge]].bottom().y() == y0))
+         _active.push_back(_bottoms[_nextEdge++]);
+      int4b y1 = _stops[nextStop];
+      current.clear();
+      if (!_active.empty())
+         y1 = _logic.scanSlab(_op, _active, y0, y1, current);
+      // join the new trapezoids with the pending ones bounded by the same edges
+      TrapezoidMap pendingMap;
+      for (unsigned i = 0; i < pending.size(); i++)
+         pendingMap[std::make_pair(pending[i]._left, pending[i]._right)] = i;
+      std::vector<bool> joined(pending.size(), false);
+      for (Trapezoids::iterator CT = current.begin(); CT != current.end(); CT++)
+      {
+         TrapezoidMap::const_iterator pt = pendingMap.find(std::make_pair(CT->_left, CT->_right));
+         if ((pendingMap.end() != pt) && (pending[pt->second]._top == CT->_bottom))
+         {
+            CT->_bottom = pending[pt->second]._bottom;
+            joined[pt->second] = true;
+         }
+      }
+      // the pending trapezoids which were not joined are complete
+      for (unsigned i = 0; i < pending.size(); i++)
+         if (!joined[i])
+            _done.push_back(pending[i]);
+      pending.swap(current);
+      if (y1 == _stops[nextStop]) nextStop++;
+      y0 = y1;
+   }
+}
+
+//-----------------------------------------------------------------------------
+// class ScanEdge
+//-----------------------------------------------------------------------------
+logicop::ScanEdge::ScanEdge(const TP& p1, const TP& p2, byte operand) :
+   _operand  ( operand )
+{
+   assert(p1.y() != p2.y());
+   if (p1.y() < p2.y())
+   {
+      _bottom = p1; _top = p2; _wind =  1;
+   }
+   else
+   {
+      _bottom = p2; _top = p1; _wind = -1;
+   }
+}
+
+/*! Returns the x coordinate of the edge at a given y. The y shall be within
+ * the edge span */
+real logicop::ScanEdge::xAt(int4b y) const
+{
+   if (y == _bottom.y()) return _bottom.x();
+   if (y == _top.y()   ) return _top.x();
+   return real(_bottom.x()) + (real(_top.x()) - real(_bottom.x())) *
+          (real(y) - real(_bottom.y())) / (real(_top.y()) - real(_bottom.y()));
+}
+
+int4b logicop::ScanEdge::xRound(int4b y) const
+{
+   return (int4b) rint(xAt(y));
+}
+
+//-----------------------------------------------------------------------------
+// class LayerLogic
+//-----------------------------------------------------------------------------
+word logicop::LayerLogic::_numThreads = 1;
+
+logicop::LayerLogic::LayerLogic() :
+   _numVertices   ( 0 )
+{}
+
+/*! Add a polygon to the operand. The polygon is implicitly closed. Layout
+ * shapes can be oriented either way, so the edges of the clockwise polygons
+ * are reversed - i.e. every polygon contributes +1 to the winding number of
+ * the area it covers. Horizontal edges don't change the winding numbers along
+ * the scanline, so they are not stored at all.*/
+void logicop::LayerLogic::addPoly(const PointVector& plist, byte operand)
+{
+   assert(operand < 2);
+   unsigned plysize = plist.size();
+   if (plysize < 3) return;
+   _numVertices += plysize;
+   // twice the oriented area of the polygon
+   real area = 0;
+   for (unsigned i = 0; i < plysize; i++)
+   {
+      const TP& p1 = plist[i];
+      const TP& p2 = plist[(i+1) % plysize];
+      area += real(p1.x()) * real(p2.y()) - real(p2.x()) * real(p1.y());
+   }
+   if (0 == area) return;
+   for (unsigned i = 0; i < plysize; i++)
+   {
+      const TP& p1 = plist[i];
+      const TP& p2 = plist[(i+1) % plysize];
+      if (p1.y() == p2.y()) continue;
+      if (area > 0)
+         _edges.push_back(ScanEdge(p1, p2, operand));
+      else
+         _edges.push_back(ScanEdge(p2, p1, operand));
+   }
+}
+
+/*! Execute the logic operation between the operands 0 and 1. The resulting
+ * polygons are appended to plycol. Returns false if no output shapes were
+ * generated */
+bool logicop::LayerLogic::execute(LayLogicOp op, pcollection& plycol)
+{
+   pcollection traps;
+   if (!scan(op, traps)) return false;
+   size_t numShapes = plycol.size();
+   mergeTrapezoids(traps, plycol);
+   return (plycol.size() > numShapes);
+}
+
+/*! The scanline pass of execute(). The resulting trapezoids are appended to
+ * plycol as they are - convex and not merged. Returns false if no output
+ * shapes were generated */
+bool logicop::LayerLogic::scan(LayLogicOp op, pcollection& plycol)
+{
+   if (_edges.empty()) return false;
+   size_t numShapes = plycol.size();
+   // sort the edges by their bottom point ...
+   EdgeIndexes bottoms(_edges.size());
+   for (unsigned i = 0; i < _edges.size(); i++) bottoms[i] = i;
+   std::sort(bottoms.begin(), bottoms.end(), EdgeBottomOrder(_edges));
+   // ... and gather all vertex y coordinates - those are the scanline stops
+   std::vector<int4b> stops;
+   stops.reserve(2 * _edges.size());
+   for (ScanEdges::const_iterator CE = _edges.begin(); CE != _edges.end(); CE++)
+   {
+      stops.push_back(CE->bottom().y());
+      stops.push_back(CE->top().y());
+   }
+   std::sort(stops.begin(), stops.end());
+   stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
+   // scan the bands ...
+   ScanBands bands;
+   splitBands(op, bottoms, stops, bands);
+   if (1 == bands.size())
+      bands[0]->run();
+   else
+   {
+      ThreadPool::JobList jobs(bands.begin(), bands.end());
+      ThreadPool pool(_numThreads);
+      pool.execute(jobs);
+   }
+   // ... put them together ...
+   Trapezoids result;
+   stitchBands(bands, result);
+   for (ScanBands::const_iterator CB = bands.begin(); CB != bands.end(); CB++)
+      delete (*CB);
+   // ... and generate the shapes in an order which doesn't depend on the bands
+   std::sort(result.begin(), result.end());
+   for (Trapezoids::const_iterator CT = result.begin(); CT != result.end(); CT++)
+      dumpTrapezoid(*CT, plycol);
+   return (plycol.size() > numShapes);
+}
+
+/*! Produce the shapes which are the result of sizing the operand 0 with the
+ * given value. The sizing is done with a square - i.e. for Manhattan shapes
+ * each edge is moved with sizeval. The non-Manhattan edges are moved further
+ * - a 45 degree edge with sizeval*sqrt(2). This differs from the edge offset
+ * of resize() (see TdtCell::stretchSelected()). The operand 1 is ignored.\n
+ * Oversizing is done by growing the non-overlapping trapezoids of the operand
+ * and merging the result. Undersizing is done the same way, but with the
+ * complement of the operand which is subtracted from it afterwards.*/
+bool logicop::LayerLogic::size(int4b sizeval, pcollection& plycol)
+{
+   LayerLogic original;
+   copyEdges(original, 0, 0);
+   if (original.empty()) return false;
+   if (0 == sizeval) return original.execute(lgc_or, plycol);
+   pcollection pieces;
+   LayerLogic sized;
+   // the pieces are grown one by one, so they must be convex
+   if (0 < sizeval)
+   {
+      original.scan(lgc_or, pieces);
+   }
+   else
+   {
+      sizeval = -sizeval;
+      // the frame around the operand which will limit its complement
+      const ScanEdge& fedge = original._edges[0];
+      DBbox frame(fedge.bottom());
+      for (ScanEdges::const_iterator CE = original._edges.begin(); CE != original._edges.end(); CE++)
+      {
+         frame.overlap(CE->bottom());
+         frame.overlap(CE->top());
+      }
+      PointVector fplist;
+      fplist.push_back(TP(frame.p1().x() - 2 * sizeval, frame.p1().y() - 2 * sizeval));
+      fplist.push_back(TP(frame.p2().x() + 2 * sizeval, frame.p1().y() - 2 * sizeval));
+      fplist.push_back(TP(frame.p2().x() + 2 * sizeval, frame.p2().y() + 2 * sizeval));
+      fplist.push_back(TP(frame.p1().x() - 2 * sizeval, frame.p2().y() + 2 * sizeval));
+      LayerLogic complement;
+      complement.addPoly(fplist, 0);
+      copyEdges(complement, 0, 1);
+      complement.scan(lgc_andnot, pieces);
+      copyEdges(sized, 0, 0);
+   }
+   byte operand = sized.empty() ? 0 : 1;
+   for (pcollection::const_iterator CP = pieces.begin(); CP != pieces.end(); CP++)
+   {
+      PointVector* grown = squareGrow(**CP, sizeval);
+      sized.addPoly(*grown, operand);
+      delete grown;
+      delete (*CP);
+   }
+   return sized.execute((0 == operand) ? lgc_or : lgc_andnot, plycol);
+}
+
+bool logicop::LayerLogic::inside(LayLogicOp op, int wind0, int wind1) const
+{
+   bool in0 = (0 != wind0);
+   bool in1 = (0 != wind1);
+   switch (op)
+   {
+      case lgc_and   : return in0 && in1;
+      case lgc_or    : return in0 || in1;
+      case lgc_andnot: return in0 && !in1;
+      case lgc_xor   : return in0 != in1;
+      default: assert(false); break;
+   }
+   return false;
+}
+
+/*! Split the scanline stops into bands with roughly the same number of
+ * edges starting in each of them. The number of bands depends on the number
+ * of threads available. Finds also the edges crossing the bottom of every
+ * band - those will be active when the scanning of the band starts.*/
+void logicop::LayerLogic::splitBands(LayLogicOp op, const EdgeIndexes& bottoms,
+                                     const std::vector<int4b>& stops, ScanBands& bands) const
+{
+   unsigned numThreads = (0 == _numThreads) ? ThreadPool::numCPUs() : _numThreads;
+   unsigned numBands = 1;
+   if (1 < numThreads)
+      numBands = std::min<unsigned>(4 * numThreads, _edges.size() / MIN_BAND_EDGES + 1);
+   unsigned lastStop = stops.size() - 1;
+   std::vector<unsigned> borders(1, 0);
+   for (unsigned i = 1; i < numBands; i++)
+   {
+      int4b y = _edges[bottoms[(i * bottoms.size()) / numBands]].bottom().y();
+      unsigned stop = std::lower_bound(stops.begin(), stops.end(), y) - stops.begin();
+      if ((stop > borders.back()) && (stop < lastStop))
+         borders.push_back(stop);
+   }
+   borders.push_back(lastStop);
+   std::vector<int4b> bandBottoms;
+   for (unsigned i = 1; i < borders.size(); i++)
+   {
+      ScanBand* band = DEBUG_NEW ScanBand(*this, op, bottoms, stops, borders[i-1], borders[i]);
+      band->_nextEdge = std::lower_bound(bottoms.begin(), bottoms.end(), band->bottom(),
+                                         EdgeBottomBelow(_edges)) - bottoms.begin();
+      bands.push_back(band);
+      bandBottoms.push_back(band->bottom());
+   }
+   if (1 == bands.size()) return;
+   for (unsigned i = 0; i < _edges.size(); i++)
+   {
+      const ScanEdge& cedge = _edges[i];
+      unsigned band = std::upper_bound(bandBottoms.begin(), bandBottoms.end(), cedge.bottom().y())
+                                      - bandBottoms.begin();
+      for (; (band < bands.size()) && (bandBottoms[band] < cedge.top().y()); band++)
+         bands[band]->_active.push_back(i);
+   }
+}
+
+/*! Collect the trapezoids of all bands in result. Every trapezoid which
+ * reaches the top of its band is joined with the trapezoid at the bottom of
+ * the next band bounded by the same edges if such exists - exactly as it
+ * would've been done if the bands were scanned as a whole.*/
+void logicop::LayerLogic::stitchBands(ScanBands& bands, Trapezoids& result) const
+{
+   typedef std::map<std::pair<unsigned, unsigned>, Trapezoid*> TrapezoidMap;
+   for (unsigned b = 0; b < bands.size(); b++)
+   {
+      ScanBand* cband = bands[b];
+      result.insert(result.end(), cband->_done.begin(), cband->_done.end());
+      if (bands.size() == b + 1)
+      {
+         result.insert(result.end(), cband->_open.begin(), cband->_open.end());
+         break;
+      }
+      ScanBand* nband = bands[b+1];
+      int4b border = nband->bottom();
+      TrapezoidMap bottomMap;
+      for (Trapezoids::iterator CT = nband->_done.begin(); CT != nband->_done.end(); CT++)
+         if (border == CT->_bottom)
+            bottomMap[std::make_pair(CT->_left, CT->_right)] = &(*CT);
+      for (Trapezoids::iterator CT = nband->_open.begin(); CT != nband->_open.end(); CT++)
+         if (border == CT->_bottom)
+            bottomMap[std::make_pair(CT->_left, CT->_right)] = &(*CT);
+      for (Trapezoids::const_iterator CT = cband->_open.begin(); CT != cband->_open.end(); CT++)
+      {
+         TrapezoidMap::const_iterator nt = bottomMap.find(std::make_pair(CT->_left, CT->_right));
+         if (bottomMap.end() != nt)
+            nt->second->_bottom = CT->_bottom;
+         else
+            result.push_back(*CT);
+      }
+   }
+}
+
+/*! Process one horizontal slab between y0 and y1. The active edges are sorted
+ * along the scanline. The neighbouring edges are checked for crossing points
+ * inside the slab and if such are found, the slab is reduced up to the first
+ * crossing point. Method returns the actual top of the slab.*/
+int4b logicop::LayerLogic::scanSlab(LayLogicOp op, EdgeIndexes& active, int4b y0, int4b y1, Trapezoids& traps) const
+{
+   SlabEdges slab;
+   slab.reserve(active.size());
+   for (EdgeIndexes::const_iterator CE = active.begin(); CE != active.end(); CE++)
+      slab.push_back(SlabEdge(_edges[*CE].xAt(y0), _edges[*CE].xAt(y1), *CE));
+   std::sort(slab.begin(), slab.end());
+   // the first crossing point within the slab is always between neighbours
+   int4b ytop = y1;
+   for (unsigned i = 1; i < slab.size(); i++)
+   {
+      const SlabEdge& se1 = slab[i-1];
+      const SlabEdge& se2 = slab[i  ];
+      if (se1._x1 > se2._x1)
+      {
+         real ratio = (se2._x0 - se1._x0) / ((se1._x1 - se1._x0) - (se2._x1 - se2._x0));
+         int4b ycross = y0 + (int4b) floor(ratio * (real(y1) - real(y0)));
+         // the crossing is rounded down to the grid, but the slab can't be
+         // thinner than 1 DBU
+         if (ycross <= y0) ycross = y0 + 1;
+         if (ycross < ytop) ytop = ycross;
+      }
+   }
+   if (ytop != y1)
+      for (SlabEdges::iterator CE = slab.begin(); CE != slab.end(); CE++)
+         CE->_x1 = _edges[CE->_edge].xAt(ytop);
+   // now traverse the slab left to right accumulating the winding numbers.
+   // Coinciding edges are processed together
+   int  wind[2] = {0, 0};
+   bool in = false;
+   unsigned left = 0;
+   unsigned i = 0;
+   while (i < slab.size())
+   {
+      unsigned first = i;
+      do
+      {
+         const ScanEdge& cedge = _edges[slab[i]._edge];
+         wind[cedge.operand()] += cedge.wind();
+      } while ((++i < slab.size()) && slab[i].coincide(slab[first]));
+      bool nowIn = inside(op, wind[0], wind[1]);
+      if (!in && nowIn)
+         left = slab[first]._edge;
+      else if (in && !nowIn)
+         traps.push_back(Trapezoid(left, slab[first]._edge, y0, ytop));
+      in = nowIn;
+   }
+   // keep the order for the next slab - it will be (almost) sorted
+   for (i = 0; i < slab.size(); i++)
+      active[i] = slab[i]._edge;
+   return ytop;
+}
+
+void logicop::LayerLogic::dumpTrapezoid(const Trapezoid& trap, pcollection& plycol) const
+{
+   const ScanEdge& left  = _edges[trap._left ];
+   const ScanEdge& right = _edges[trap._right];
+   int4b xlb = left.xRound(trap._bottom);
+   int4b xlt = left.xRound(trap._top);
+   // clamp the right side - the edges might have been swapped within the
+   // last DBU before their crossing point
+   int4b xrb = std::max(xlb, right.xRound(trap._bottom));
+   int4b xrt = std::max(xlt, right.xRound(trap._top));
+   if ((xlb == xrb) && (xlt == xrt)) return;
+   PointVector* shape = DEBUG_NEW PointVector();
+   shape->reserve(4);
+   shape->push_back(TP(xlb, trap._bottom));
+   if (xrb != xlb) shape->push_back(TP(xrb, trap._bottom));
+   shape->push_back(TP(xrt, trap._top));
+   if (xlt != xrt) shape->push_back(TP(xlt, trap._top));
+   plycol.push_back(shape);
+}
+
+void logicop::LayerLogic::copyEdges(LayerLogic& dst, byte srcOp, byte dstOp) const
+{
+   for (ScanEdges::const_iterator CE = _edges.begin(); CE != _edges.end(); CE++)
+   {
+      if (srcOp != CE->operand()) continue;
+      if (1 == CE->wind())
+         dst._edges.push_back(ScanEdge(CE->bottom(), CE->top(), dstOp));
+      else
+         dst._edges.push_back(ScanEdge(CE->top(), CE->bottom(), dstOp));
+   }
+   dst._numVertices += _numVertices;
+}
+
+/*! Returns the Minkowski sum of a convex polygon and a square with a half size
+ * sizeval. This is the convex hull of the polygon vertices shifted to the four
+ * corners of the square.*/
+PointVector* logicop::squareGrow(const PointVector& plist, int4b sizeval)
+{
+   PointVector cloud;
+   cloud.reserve(4 * plist.size());
+   for (PointVector::const_iterator CP = plist.begin(); CP != plist.end(); CP++)
+   {
+      cloud.push_back(TP(CP->x() - sizeval, CP->y() - sizeval));
+      cloud.push_back(TP(CP->x() + sizeval, CP->y() - sizeval));
+      cloud.push_back(TP(CP->x() + sizeval, CP->y() + sizeval));
+      cloud.push_back(TP(CP->x() - sizeval, CP->y() + sizeval));
+   }
+   std::sort(cloud.begin(), cloud.end(), xyLess);
+   cloud.erase(std::unique(cloud.begin(), cloud.end()), cloud.end());
+   // monotone chain - lower hull and then upper hull
+   PointVector* hull = DEBUG_NEW PointVector(2 * cloud.size());
+   unsigned hsize = 0;
+   for (unsigned i = 0; i < cloud.size(); i++)
+   {
+      while ((hsize >= 2) && (0 >= polycross::orientation(&(*hull)[hsize-1], &cloud[i], &(*hull)[hsize-2])))
+         hsize--;
+      (*hull)[hsize++] = cloud[i];
+   }
+   unsigned lower = hsize + 1;
+   for (int i = cloud.size() - 2; i >= 0; i--)
+   {
+      while ((hsize >= lower) && (0 >= polycross::orientation(&(*hull)[hsize-1], &cloud[i], &(*hull)[hsize-2])))
+         hsize--;
+      (*hull)[hsize++] = cloud[i];
+   }
+   hull->resize(hsize - 1);
+   return hull;
+}
+
+/*! Merge the touching trapezoids of traps into outline polygons which are
+ * appended to plycol. traps is emptied.\n
+ * The sides shared by two trapezoids are dropped - the horizontal ones
+ * partially, interval by interval. The remaining edges are traced into loops
+ * always taking the leftmost turn, so the areas touching in a single point
+ * stay apart. Counterclockwise loops are outlines, clockwise ones - holes.
+ * Every hole belongs to the outline traced from the same group of touching
+ * trapezoids and is cut in it with hole2simple(). If a group can't be
+ * converted this way, its trapezoids are returned as they are.*/
+void logicop::mergeTrapezoids(pcollection& traps, pcollection& plycol)
+{
+   std::vector<PointVector*> tlist(traps.begin(), traps.end());
+   traps.clear();
+   TrapezoidSets groups(tlist.size());
+   // split the trapezoids into edges
+   OutlineEdges    slanted;
+   HorizontalSpans spans;
+   for (unsigned t = 0; t < tlist.size(); t++)
+   {
+      const PointVector& trap = *tlist[t];
+      for (unsigned i = 0; i < trap.size(); i++)
+      {
+         const TP& p1 = trap[i];
+         const TP& p2 = trap[(i + 1) % trap.size()];
+         if      (p1.y() != p2.y()) slanted.push_back(OutlineEdge(p1, p2, t));
+         else if (p1.x() <  p2.x()) spans.push_back(HorizontalSpan(p1.y(), p1.x(), p2.x(), false, t));
+         else if (p1.x() >  p2.x()) spans.push_back(HorizontalSpan(p1.y(), p2.x(), p1.x(), true , t));
+      }
+   }
+   OutlineEdges outline;
+   // drop the coinciding non-horizontal edges with opposite directions
+   std::sort(slanted.begin(), slanted.end(), SlantedEdgeOrder());
+   for (unsigned first = 0; first < slanted.size(); )
+   {
+      unsigned last = first + 1;
+      while ((last < slanted.size()) && !SlantedEdgeOrder()(slanted[first], slanted[last]))
+         last++;
+      std::vector<unsigned> up, down;
+      for (unsigned i = first; i < last; i++)
+      {
+         if (slanted[i]._p1.y() < slanted[i]._p2.y()) up.push_back(i);
+         else                                         down.push_back(i);
+      }
+      unsigned shared = std::min(up.size(), down.size());
+      for (unsigned i = 0; i < shared; i++)
+         groups.join(slanted[up[i]]._trap, slanted[down[i]]._trap);
+      for (unsigned i = shared; i < up.size()  ; i++) outline.push_back(slanted[up[i]]);
+      for (unsigned i = shared; i < down.size(); i++) outline.push_back(slanted[down[i]]);
+      first = last;
+   }
+   // The horizontal sides with the same y - the bottoms of the trapezoids
+   // above and the tops of those below. Each of them is a set of disjoint
+   // intervals, so they are walked together interval by interval
+   std::sort(spans.begin(), spans.end());
+   for (unsigned first = 0; first < spans.size(); )
+   {
+      int4b y = spans[first]._y;
+      unsigned last = first;
+      std::vector<int4b> stops;
+      while ((last < spans.size()) && (y == spans[last]._y))
+      {
+         stops.push_back(spans[last]._x0);
+         stops.push_back(spans[last]._x1);
+         last++;
+      }
+      unsigned tops = first;
+      while ((tops < last) && !spans[tops]._top) tops++;
+      std::sort(stops.begin(), stops.end());
+      stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
+      unsigned cbot = first;
+      unsigned ctop = tops;
+      for (unsigned i = 1; i < stops.size(); i++)
+      {
+         int4b x0 = stops[i-1];
+         int4b x1 = stops[i];
+         while ((cbot < tops) && (spans[cbot]._x1 <= x0)) cbot++;
+         while ((ctop < last) && (spans[ctop]._x1 <= x0)) ctop++;
+         bool bottom = (cbot < tops) && (spans[cbot]._x0 <= x0);
+         bool top    = (ctop < last) && (spans[ctop]._x0 <= x0);
+         if (bottom && top)
+            groups.join(spans[cbot]._trap, spans[ctop]._trap);
+         else if (bottom)
+            outline.push_back(OutlineEdge(TP(x0, y), TP(x1, y), spans[cbot]._trap));
+         else if (top)
+            outline.push_back(OutlineEdge(TP(x1, y), TP(x0, y), spans[ctop]._trap));
+      }
+      first = last;
+   }
+   // trace the loops
+   std::sort(outline.begin(), outline.end());
+   PointVector starts;
+   starts.reserve(outline.size());
+   for (OutlineEdges::const_iterator CE = outline.begin(); CE != outline.end(); CE++)
+      starts.push_back(CE->_p1);
+   std::vector<bool> used(outline.size(), false);
+   OutlineLoops loops;
+   bool traced = true;
+   for (unsigned first = 0; traced && (first < outline.size()); first++)
+   {
+      if (used[first]) continue;
+      used[first] = true;
+      PointVector* loop = DEBUG_NEW PointVector();
+      loops.push_back(OutlineLoop(loop, groups.find(outline[first]._trap)));
+      unsigned cur = first;
+      do
+      {
+         const OutlineEdge& cedge = outline[cur];
+         loop->push_back(cedge._p1);
+         std::pair<PointVector::const_iterator, PointVector::const_iterator> range =
+               std::equal_range(starts.begin(), starts.end(), cedge._p2, xyLess);
+         unsigned next = outline.size();
+         real bestTurn = 0;
+         for (unsigned i = range.first - starts.begin(); i < unsigned(range.second - starts.begin()); i++)
+         {
+            if (used[i] && (first != i)) continue;
+            real turn = outlineTurn(cedge._p1, cedge._p2, outline[i]._p2);
+            if ((outline.size() == next) || (turn > bestTurn))
+            {
+               next = i; bestTurn = turn;
+            }
+         }
+         if (outline.size() == next)
+            traced = false;
+         else
+            used[next] = true;
+         cur = next;
+      } while (traced && (first != cur));
+   }
+   if (!traced)
+   {
+      // shouldn't happen - the edges of closed shapes always form loops
+      for (OutlineLoops::const_iterator CL = loops.begin(); CL != loops.end(); CL++)
+         delete CL->_points;
+      plycol.insert(plycol.end(), tlist.begin(), tlist.end());
+      return;
+   }
+   // sort the loops into outlines and holes by group
+   typedef std::map<unsigned, std::pair<std::vector<unsigned>, std::vector<unsigned> > > LoopGroups;
+   LoopGroups lgroups;
+   std::vector<unsigned> gorder;
+   for (unsigned l = 0; l < loops.size(); l++)
+   {
+      OutlineLoop& cloop = loops[l];
+      cleanLoop(*cloop._points);
+      if (cloop._points->size() > 2)
+         cloop._area = loopArea(*cloop._points);
+      if (0 == cloop._area) continue;
+      if (lgroups.end() == lgroups.find(cloop._group))
+         gorder.push_back(cloop._group);
+      if (0 < cloop._area) lgroups[cloop._group].first.push_back(l);
+      else                 lgroups[cloop._group].second.push_back(l);
+   }
+   std::vector<bool> failed(tlist.size(), false);
+   for (std::vector<unsigned>::const_iterator CG = gorder.begin(); CG != gorder.end(); CG++)
+   {
+      const std::vector<unsigned>& outers = lgroups[*CG].first;
+      const std::vector<unsigned>& holes  = lgroups[*CG].second;
+      bool gfailed = outers.empty();
+      // find the outline of every hole - normally there is only one per group
+      std::vector<pcollection> ohole(outers.size());
+      for (unsigned h = 0; !gfailed && (h < holes.size()); h++)
+      {
+         const OutlineLoop& hloop = loops[holes[h]];
+         unsigned owner = 0;
+         if (1 < outers.size())
+         {
+            real px, py;
+            loopProbe(*hloop._points, px, py);
+            owner = outers.size();
+            for (unsigned o = 0; o < outers.size(); o++)
+            {
+               const OutlineLoop& oloop = loops[outers[o]];
+               if ((oloop._area <= -hloop._area) || !loopInside(*oloop._points, px, py)) continue;
+               if ((outers.size() == owner) || (oloop._area < loops[outers[owner]]._area))
+                  owner = o;
+            }
+            if (outers.size() == owner)
+            {
+               gfailed = true;
+               break;
+            }
+         }
+         PointVector hpoints(hloop._points->rbegin(), hloop._points->rend());
+         laydata::ValidPoly check(hpoints);
+         if (!check.valid())
+         {
+            gfailed = true;
+            break;
+         }
+         ohole[owner].push_back(DEBUG_NEW PointVector(check.getValidated()));
+      }
+      // cut the holes into their outlines
+      pcollection gresult;
+      for (unsigned o = 0; o < outers.size(); o++)
+      {
+         pcollection& choles = ohole[o];
+         PointVector* respoly = NULL;
+         if (!gfailed)
+         {
+            laydata::ValidPoly check(*loops[outers[o]]._points);
+            if (check.valid())
+               respoly = DEBUG_NEW PointVector(check.getValidated());
+         }
+         while ((NULL != respoly) && !choles.empty())
+         {
+            PointVector* curpolyA = respoly;
+            PointVector* curpolyB = choles.front();
+            choles.pop_front();
+            respoly = hole2simple(*curpolyA, *curpolyB, choles);
+            delete curpolyA; delete curpolyB;
+            if (NULL == respoly) break;
+            laydata::ValidPoly check(*respoly);
+            if (!check.valid())
+            {
+               delete respoly; respoly = NULL;
+            }
+         }
+         for (pcollection::const_iterator CP = choles.begin(); CP != choles.end(); CP++)
+            delete (*CP);
+         if (NULL != respoly)
+            gresult.push_back(respoly);
+         else
+            gfailed = true;
+      }
+      if (gfailed)
+      {
+         for (pcollection::const_iterator CP = gresult.begin(); CP != gresult.end(); CP++)
+            delete (*CP);
+         failed[*CG] = true;
+      }
+      else
+         plycol.insert(plycol.end(), gresult.begin(), gresult.end());
+   }
+   for (OutlineLoops::const_iterator CL = loops.begin(); CL != loops.end(); CL++)
+      delete CL->_points;
+   // the trapezoids of the groups which failed are returned as they are
+   for (unsigned t = 0; t < tlist.size(); t++)
+   {
+      if (failed[groups.find(t)])
+         plycol.push_back(tlist[t]);
+      else
+         delete tlist[t];
+   }
+}
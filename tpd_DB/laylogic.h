@@ -0,0 +1,136 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Scanline logic operations with entire layers
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef LAYLOGIC_H_INCLUDED
+#define LAYLOGIC_H_INCLUDED
+
+#include <vector>
+#include "ttt.h"
+
+namespace logicop {
+
+   typedef enum {
+      lgc_and     ,
+      lgc_or      ,
+      lgc_andnot  ,
+      lgc_xor
+   } LayLogicOp;
+
+   //===========================================================================
+   /*! A non-horizontal polygon edge as seen by the scanline. The edge is
+    * always stored bottom to top, the original direction is kept in the
+    * winding number (_wind) */
+   class ScanEdge {
+   public:
+                        ScanEdge(const TP&, const TP&, byte);
+      real              xAt(int4b y) const;
+      int4b             xRound(int4b y) const;
+      const TP&         bottom() const    {return _bottom;}
+      const TP&         top() const       {return _top;}
+      int               wind() const      {return _wind;}
+      byte              operand() const   {return _operand;}
+   private:
+      TP                _bottom;
+      TP                _top;
+      int               _wind;
+      byte              _operand;
+   };
+
+   //===========================================================================
+   /*! Layer wide logic operations. The class collects the polygons of two
+    * operands (0 and 1 - normally the contents of two layers) and produces
+    * the result of a logic operation between them in a single scanline pass
+    * instead of processing the polygons pair by pair.\n
+    * The plane is split into horizontal slabs at every vertex. The slabs are
+    * further split at the crossing points of the edges which are detected
+    * the Bentley-Ottmann way - between the neighbours in the scanline order.
+    * Within a slab the edges don't cross, so the winding numbers of both
+    * operands are accumulated from left to right and every interval where
+    * the logic function is true is generated as a trapezoid. Trapezoids
+    * bounded by the same pair of edges in consecutive slabs are joined.\n
+    * The touching trapezoids are merged into outline polygons at the end (see
+    * mergeTrapezoids()), so the result is a collection of non-overlapping
+    * polygons - one per connected area, with the holes cut in. Each operand
+    * is evaluated with the non-zero winding rule, so the polygons in the same
+    * operand can overlap. The crossing points are rounded to the database
+    * grid, so for arbitrary angles the result is precise within 1 DBU.\n
+    * Every vertex stop is a slab boundary, so the plane can be split at any
+    * stop into bands which are processed independently. The bands are
+    * scanned in parallel and then the trapezoids crossing the band borders
+    * are stitched back. The trapezoids are sorted before they are merged, so
+    * the result is the same regardless of the number of threads used (see
+    * setThreads()).
+    */
+   class LayerLogic {
+   public:
+                        LayerLogic();
+      void              addPoly(const PointVector&, byte operand);
+      bool              execute(LayLogicOp, pcollection&);
+      bool              size(int4b, pcollection&);
+      //! Number of vertices added to the engine so far
+      unsigned long     numVertices() const  {return _numVertices;}
+      bool              empty() const        {return _edges.empty();}
+      static void       setThreads(word threads) {_numThreads = threads;}
+      static word       threads()            {return _numThreads;}
+   private:
+      typedef std::vector<ScanEdge>    ScanEdges;
+      typedef std::vector<unsigned>    EdgeIndexes;
+      class Trapezoid {
+      public:
+                        Trapezoid(unsigned left, unsigned right, int4b bottom, int4b top) :
+                           _left(left), _right(right), _bottom(bottom), _top(top) {}
+         bool           operator < (const Trapezoid& tr) const
+         {
+            if (_bottom != tr._bottom) return (_bottom < tr._bottom);
+            if (_top    != tr._top   ) return (_top    < tr._top   );
+            if (_left   != tr._left  ) return (_left   < tr._left  );
+            return (_right < tr._right);
+         }
+         unsigned       _left;
+         unsigned       _right;
+         int4b          _bottom;
+         int4b          _top;
+      };
+      typedef std::vector<Trapezoid>   Trapezoids;
+      class ScanBand;
+      typedef std::vector<ScanBand*>   ScanBands;
+      bool              scan(LayLogicOp, pcollection&);
+      bool              inside(LayLogicOp, int, int) const;
+      int4b             scanSlab(LayLogicOp, EdgeIndexes&, int4b, int4b, Trapezoids&) const;
+      void              splitBands(LayLogicOp, const EdgeIndexes&, const std::vector<int4b>&, ScanBands&) const;
+      void              stitchBands(ScanBands&, Trapezoids&) const;
+      void              dumpTrapezoid(const Trapezoid&, pcollection&) const;
+      void              copyEdges(LayerLogic&, byte src, byte dst) const;
+      ScanEdges         _edges;
+      unsigned long     _numVertices;
+      static word       _numThreads;   //! 0 - use all CPUs
+   };
+
+   //! Grow a convex polygon with a square of a given half size
+   PointVector*      squareGrow(const PointVector&, int4b);
+   //! Merge non-overlapping trapezoids into outline polygons
+   void              mergeTrapezoids(pcollection&, pcollection&);
+}
+
+#endif
@@ -33,6 +33,7 @@
 #include "tenderer.h"
 #include "outbox.h"
 #include "auxdat.h"
+#include "thrdpool.h"
 
 //-----------------------------------------------------------------------------
 // class QTreeTmpl
@@ -40,14 +41,17 @@
 
 /*! The main and only constructor of the class*/
 template <typename DataT>
-laydata::QTreeTmpl<DataT>::QTreeTmpl() : _overlap(DEFAULT_OVL_BOX), _subQuads(NULL), _data(NULL), _props()
+laydata::QTreeTmpl<DataT>::QTreeTmpl() : _overlap(DEFAULT_OVL_BOX), _subQuads(NULL), _data(NULL), _boxes(NULL), _props(), _lod(NULL)
 {
 }
 
-/*! A convenience method initializing the QTreeTmpl::Iterator*/
+/*! A convenience method initializing the QTreeTmpl::Iterator. All iterators
+ * are giving away pointers to the objects, so the packed boxes are converted
+ * to objects first. Read-only traversals shall use forEach() instead*/
 template <typename DataT>
 const typename laydata::Iterator<DataT> laydata::QTreeTmpl<DataT>::begin()
 {
+   materialize();
    return Iterator(*this);
 }
 
@@ -55,6 +59,7 @@ const typename laydata::Iterator<DataT> laydata::QTreeTmpl<DataT>::begin()
 template <typename DataT>
 const typename laydata::ClipIterator<DataT> laydata::QTreeTmpl<DataT>::begin(const DBbox& clip)
 {
+   materialize();
    return ClipIterator(*this, clip);
 }
 
@@ -62,6 +67,7 @@ const typename laydata::ClipIterator<DataT> laydata::QTreeTmpl<DataT>::begin(con
 template <typename DataT>
 const typename laydata::DrawIterator<DataT> laydata::QTreeTmpl<DataT>::begin(const layprop::DrawProperties& drawprop, const CTM& ctm)
 {
+   materialize();
    return DrawIterator(*this, drawprop, ctm);
 }
 
@@ -93,6 +99,8 @@ const typename laydata::Iterator<DataT> laydata::QTreeTmpl<DataT>::end()
 template <typename DataT>
 void laydata::QTreeTmpl<DataT>::add(DataT* shape)
 {
+   releaseLod();
+   unpack();
    DBbox shovl(shape->overlap());
    if (empty())
    {
@@ -209,97 +217,137 @@ char laydata::QTreeTmpl<DataT>::fitSubTree(const DBbox& shovl, DBbox* maxsubbox
    return -1; // shape can not be fit into any subtree
 }
 
+/*! Sorts the sub-quad quad of a tree in a separate thread (see ThreadPool).
+ * The sub-quads of a tree and the ranges of the sort buffers they are given
+ * don't overlap, so the jobs don't share any data.*/
+template <typename DataT>
+class laydata::QTreeTmpl<DataT>::SortJob : public ThreadJob {
+public:
+                        SortJob(QTreeTmpl<DataT>* quad, DataT** objs, DataT** scratch, char* fits, unsigned size) :
+                           _quad(quad), _objs(objs), _scratch(scratch), _fits(fits), _size(size) {}
+   virtual void         run() {_quad->sort(_objs, _scratch, _fits, _size, false);}
+private:
+   QTreeTmpl<DataT>*    _quad;
+   DataT**              _objs;
+   DataT**              _scratch;
+   char*                _fits;
+   unsigned             _size;
+};
+
 /*! Build a new QTreeTmpl structure for the DataT in the inlist. The method is
- * using the existing _overlap variable. For every layout object fitinsubtree()
- * method is called in a try to put the data in the child QTreeTmpl. At the end
- * the method is called for every of the child structures.
+ * using the existing _overlap variable. The order of the objects in inlist is
+ * changed - see the method below.
  */
 template <typename DataT>
-void laydata::QTreeTmpl<DataT>::sort(TObjList& inlist)
+void laydata::QTreeTmpl<DataT>::sort(TObjVector& inlist)
 {
-   unsigned int entryListSize = inlist.size();
    // if the input list is empty - nothing to do!
-   if (0 == entryListSize) return;
-   typename TObjList::iterator DI = inlist.begin();
+   if (inlist.empty()) return;
+   TObjVector scratch(inlist.size());
+   std::vector<char> fits(inlist.size());
+   bool parallel = (1 != QTreeBuild::threads()) && (QTREE_MIN_PARALLEL <= inlist.size());
+   sort(&(inlist[0]), &(scratch[0]), &(fits[0]), inlist.size(), parallel);
+}
+
+/*! Build the tree for the size objects in objs top-down. For every layout
+ * object fitSubTree() is called to find the child QTreeTmpl it belongs to.
+ * Then the objects are distributed (in a single pass, preserving their order)
+ * in consecutive ranges - the objects which stay in this quad first, followed
+ * by the objects of every child. Finally the method is called for every child
+ * with its own range of objs. So every object is moved once per tree level and
+ * no memory is allocated apart of the tree itself. scratch and fits are
+ * buffers with the same size as objs.\n
+ * If parallel is true, the children are sorted simultaneously by a ThreadPool
+ * as soon as the objects are split between at least two of them.
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::sort(DataT** objs, DataT** scratch, char* fits, unsigned size, bool parallel)
+{
+   if (0 == size) return;
    // if the list contains only one component - link it and run away
-   if (1 == entryListSize)
+   if (1 == size)
    {
       _data = DEBUG_NEW DataT*[1];
       _props._numObjects = 1;
-      _data[0] = *DI;
+      _data[0] = objs[0];
       return;
    }
-   // the overlapping box of the current shape
-   DBbox shovl = DEFAULT_OVL_BOX;
    // the maximum possible overlapping boxes of the 4 children
    DBbox maxsubbox[4] = {DEFAULT_OVL_BOX, DEFAULT_OVL_BOX,
                          DEFAULT_OVL_BOX, DEFAULT_OVL_BOX};
    for (byte i = 0; i < 4; i++) maxsubbox[i] = _overlap.getcorner((QuadIdentificators)i);
-   // the sub-lists data will be sorted in
-   TObjList sublist[4];
-   // which is the child where current shape fits
-   char fitinsubbox;
-   // initialize the iterator
-   int8b sharea, totalarea = _overlap.boxarea();
-   while (inlist.end() != DI)
-   {
-      assert(*DI);
+   // the overlapping boxes of the children
+   DBbox subovl[4] = {DEFAULT_OVL_BOX, DEFAULT_OVL_BOX,
+                      DEFAULT_OVL_BOX, DEFAULT_OVL_BOX};
+   // the number of objects in every child. The last one is this quad
+   unsigned count[5] = {0, 0, 0, 0, 0};
+   int8b totalarea = _overlap.boxarea();
+   for (unsigned i = 0; i < size; i++)
+   {
+      assert(objs[i]);
       // get the overlap of the current shape
-      shovl = (*DI)->overlap();
-      sharea = shovl.boxarea();
+      DBbox shovl(objs[i]->overlap());
       // Check it fits in some of the children
-      if (totalarea <= 4ll * sharea)
-      {
-         // no fit. The shape is sorted in the current tree
-         DI++;
-      }
+      char fitinsubbox = (totalarea <= 4ll * shovl.boxarea()) ? -1 : fitSubTree(shovl, maxsubbox);
+      if (0 > fitinsubbox)
+         fitinsubbox = 4; // no fit. The shape is sorted in the current tree
       else
-      {
-         fitinsubbox = fitSubTree(shovl, maxsubbox);
-         if (fitinsubbox < 0)
-         {
-            DI++;
-         }
-         else
-         {
-            // fits in sub-tree fitinsubbox
-            sublist[(byte)fitinsubbox].push_back(*DI);
-            // secure the subQuad (create it if it doesn't exist)
-            byte quadIndex = sequreQuad((QuadIdentificators)fitinsubbox);
-            // update the overlapping box of the subQuad
-            _subQuads[quadIndex]->_overlap.overlap(shovl);
-            // get rid of the current shape pointer. It is pushed in the sbulists
-            DI = inlist.erase(DI);
-         }
-      }
+         subovl[(byte)fitinsubbox].overlap(shovl);
+      fits[i] = fitinsubbox;
+      count[(byte)fitinsubbox]++;
    }
-   // at this point inlist MUST contain only the shapes for this QTreeTmpl.
-   // The rest was split over the underlying (maximum 4) QuadTrees.
-   _props._numObjects = inlist.size();
-   assert (entryListSize == (_props._numObjects +
-                             sublist[0].size()  +
-                             sublist[1].size()  +
-                             sublist[2].size()  +
-                             sublist[3].size()    )
-          );
+   // distribute the objects in consecutive ranges - this quad first
+   unsigned offset[5];
+   offset[4] = 0;
+   unsigned curOffset = count[4];
+   for (byte i = 0; i < 4; i++)
+   {
+      offset[i] = curOffset;
+      curOffset += count[i];
+   }
+   assert(size == curOffset);
+   for (unsigned i = 0; i < size; i++)
+      scratch[offset[(byte)fits[i]]++] = objs[i];
+   memcpy(objs, scratch, sizeof(DataT*) * size);
    // So - first save the local ones
+   _props._numObjects = count[4];
    if (0 < _props._numObjects)
    {
       _data = DEBUG_NEW DataT*[_props._numObjects];
-      QuadsIter j = 0;
-      for (DI = inlist.begin(); DI != inlist.end(); DI++)
+      memcpy(_data, objs, sizeof(DataT*) * _props._numObjects);
+   }
+   // secure the subQuads (this must be done before the threads are started)
+   byte numSubLists = 0;
+   for (byte i = 0; i < 4; i++)
+      if (0 < count[i])
       {
-         _data[j] = *DI;
-         j++;
+         byte quadIndex = sequreQuad((QuadIdentificators)i);
+         _subQuads[quadIndex]->_overlap = subovl[i];
+         numSubLists++;
       }
-   }
    // now go and sort the children - if any
+   bool spawn = parallel && (1 < numSubLists);
+   ThreadPool::JobList jobs;
+   unsigned first = count[4];
    for (byte i = 0; i < 4; i++)
-      if (!sublist[i].empty())
+   {
+      if (0 < count[i])
       {
-         char quadPosition = _props.getPosition((QuadIdentificators) i);
-         _subQuads[(byte)quadPosition]->sort(sublist[i]);
+         QTreeTmpl* subQuad = _subQuads[(byte)_props.getPosition((QuadIdentificators) i)];
+         if (spawn)
+            jobs.push_back(DEBUG_NEW SortJob(subQuad, objs + first, scratch + first, fits + first, count[i]));
+         else
+            subQuad->sort(objs + first, scratch + first, fits + first, count[i], parallel && (QTREE_MIN_PARALLEL <= count[i]));
       }
+      first += count[i];
+   }
+   if (!jobs.empty())
+   {
+      ThreadPool pool(QTreeBuild::threads());
+      pool.execute(jobs);
+      for (ThreadPool::JobList::const_iterator CJ = jobs.begin(); CJ != jobs.end(); CJ++)
+         delete (*CJ);
+   }
 }
 
 /*! Removes marked shapes from the QTreeTmpl without deleting them. The removed
@@ -320,6 +368,8 @@ template <typename DataT>
 bool laydata::QTreeTmpl<DataT>::deleteMarked(SH_STATUS stat, bool partselect)
 {
    assert(!((stat != sh_selected) && (partselect == true)));
+   releaseLod();
+   unpack();
    // Create and initialize a variable "to be sorted"
    bool _2B_sorted = false;
    // save the old overlap, and initialize the new one
@@ -394,6 +444,20 @@ bool laydata::QTreeTmpl<DataT>::deleteMarked(SH_STATUS stat, bool partselect)
 template <typename DataT>
 bool laydata::QTreeTmpl<DataT>::deleteThis(DataT* object)
 {
+   TObjVector objects(1, object);
+   return deleteThese(objects);
+}
+
+/*! Unlinks all objects in the sorted (by pointer value) objects array from the
+ * tree in a single pass. The objects themselves are not deleted. This is the
+ * bulk version of deleteThis() - the cost is one tree traversal plus a binary
+ * search per object in the tree, rather than one traversal per object.
+ */
+template <typename DataT>
+bool laydata::QTreeTmpl<DataT>::deleteThese(const TObjVector& objects)
+{
+   releaseLod();
+   unpack();
    // Create and initialize a variable "to be sorted"
    bool _2B_sorted = false;
    // save the old overlap, and initialize the new one
@@ -406,7 +470,7 @@ bool laydata::QTreeTmpl<DataT>::deleteThis(DataT* object)
       char position = _props.getPosition(cquad);
       if (-1 < position)
       {
-         _2B_sorted |= _subQuads[(byte)position]->deleteThis(object);
+         _2B_sorted |= _subQuads[(byte)position]->deleteThese(objects);
          // check that there is still something left in the child QTreeTmpl
          if (_subQuads[(byte)position]->empty())
          {
@@ -421,7 +485,7 @@ bool laydata::QTreeTmpl<DataT>::deleteThis(DataT* object)
    for (QuadsIter i = 0; i < _props._numObjects; i++)
    {
       DataT* wds = _data[i];
-      if (wds == object)
+      if (std::binary_search(objects.begin(), objects.end(), wds))
       {
          inventoryChanged = true;
       }
@@ -474,6 +538,8 @@ template <typename DataT>
 void laydata::QTreeTmpl<DataT>::validate()
 {
    if (empty()) return;
+   releaseLod();
+   unpack();
    if (_props._invalid)
    {
       resort(); _props._invalid = false;
@@ -492,11 +558,12 @@ bool laydata::QTreeTmpl<DataT>::fullValidate()
 {
    if (_props._invalid)
    {
-      TObjList store;
+      releaseLod();
+      TObjVector store;
       tmpStore(store);
       DBbox oldovl = _overlap;
       _overlap = DEFAULT_OVL_BOX;
-      for (typename TObjList::const_iterator DI = store.begin(); DI != store.end(); DI++)
+      for (typename TObjVector::const_iterator DI = store.begin(); DI != store.end(); DI++)
          updateOverlap((*DI)->overlap());
       sort(store);
       _props._invalid = false;
@@ -514,15 +581,16 @@ bool laydata::QTreeTmpl<DataT>::fullValidate()
 template <typename DataT>
 void laydata::QTreeTmpl<DataT>::resort(DataT* newdata)
 {
+   releaseLod();
    // first save the existing data in a temporary store
-   TObjList store;
+   TObjVector store;
    if (NULL != newdata) store.push_back(newdata);
    tmpStore(store);
    sort(store);
 }
 
 template <typename DataT>
-void laydata::QTreeTmpl<DataT>::resort(TObjList& store)
+void laydata::QTreeTmpl<DataT>::resort(TObjVector& store)
 {
    tmpStore(store);
    sort(store);
@@ -558,9 +626,25 @@ short laydata::QTreeTmpl<DataT>::clipType(trend::TrendBase& rend) const
    else return -1;
 }
 
+/*! Renders the tree. If lod is true, the nodes which are too small on the
+ * screen are rendered using their LOD data (see renderLod()). This is never
+ * the case for the trees with selected objects, nor for the trees without
+ * LOD data (see buildLod()).
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::openGlRender(trend::TrendBase& rend, const TObjDataPairList* slst, bool lod) const
+{
+   if (lod && (NULL == slst) && (NULL != _lod))
+      renderNode(rend, NULL, _lod);
+   else
+      renderNode(rend, slst, NULL);
+}
+
 template <typename DataT>
-void laydata::QTreeTmpl<DataT>::openGlRender(trend::TrendBase& rend, const TObjDataPairList* slst) const
+void laydata::QTreeTmpl<DataT>::renderNode(trend::TrendBase& rend, const TObjDataPairList* slst, const LodCache* lod) const
 {
+   if (rend.cancelled()) return;
+   if ((NULL != lod) && renderLod(rend, *lod)) return;
    // The drawing will be faster like this for the cells without selected shapes
    // that will be the vast majority of the cases. A bit bigger code though.
    // Seems the bargain is worth it.
@@ -591,10 +675,124 @@ void laydata::QTreeTmpl<DataT>::openGlRender(trend::TrendBase& rend, const TObjD
          _data[i]->drawRequest(rend);
       }
    }
+   // packed boxes are never selected
+   if (0 < _props._numBoxes)
+      drawPackedBoxes(rend);
    // continue traversing down given that the objects exists and are visible
    for (byte i = 0; i < _props.numSubQuads(); i++)
       if ( 0 != _subQuads[i]->clipType(rend))
-         _subQuads[i]->openGlRender(rend, slst);
+         _subQuads[i]->renderNode(rend, slst, lod);
+}
+
+namespace laydata {
+   //! Collects the overlaps of the visited objects into LodTiles
+   template <typename DataT>
+   class LodCollector {
+   public:
+                           LodCollector(LodTiles& tiles) : _tiles(tiles) {}
+      bool                 operator()(const DataT* obj)
+      {
+         // stop at the first object which can't be substituted
+         if (!LodTraits<DataT>::substitutable(obj)) return false;
+         _tiles.addArea(obj->overlap());
+         return true;
+      }
+   private:
+      LodTiles&            _tiles;
+   };
+}
+
+/*! Renders the LOD data of this node if the node is small enough on the
+ * screen and if it has LOD data in lod (see buildLod()). Returns true if the
+ * node has been rendered.
+ */
+template <typename DataT>
+bool laydata::QTreeTmpl<DataT>::renderLod(trend::TrendBase& rend, const LodCache& lod) const
+{
+   DBbox sbox = _overlap.overlap(rend.topCTM() * rend.scrCTM());
+   const int8b maxSize = LOD_TILES * LOD_TILE_PIXELS;
+   if (  ((int8b)sbox.p2().x() - (int8b)sbox.p1().x() > maxSize)
+       ||((int8b)sbox.p2().y() - (int8b)sbox.p1().y() > maxSize) ) return false;
+   const LodTiles* tiles = lod.find(this);
+   if (NULL == tiles) return false;
+   const int4b* cbox = tiles->boxes();
+   for (unsigned i = 0; i < tiles->numBoxes(); i++, cbox += 4)
+      rend.box(cbox);
+   return true;
+}
+
+/*! Builds the LOD data of all nodes of the tree, unless it's already there.
+ * The rendering only reads this data, so it must be built in advance - with
+ * the DB locked and before the traversing. It is dropped by any change of the
+ * tree (see releaseLod()).
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::buildLod()
+{
+   if ((NULL != _lod) || empty()) return;
+   _lod = DEBUG_NEW LodCache();
+   buildLod(*_lod);
+}
+
+/*! Adds the LOD data of this node and of its children to lod. The data is
+ * kept only if it's useful - i.e. the node (together with its children) holds
+ * more objects than the LOD data has boxes. The nodes holding objects which
+ * can't be substituted (see LodTraits) are skipped.
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::buildLod(LodCache& lod) const
+{
+   LodTiles* tiles = DEBUG_NEW LodTiles(_overlap);
+   LodCollector<DataT> collector(*tiles);
+   bool complete = forEach(collector);
+   if (complete) tiles->finalize();
+   if (complete && tiles->useful())
+      lod.add(this, tiles);
+   else
+      delete tiles;
+   for (byte i = 0; i < _props.numSubQuads(); i++)
+      _subQuads[i]->buildLod(lod);
+}
+
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::releaseLod()
+{
+   if (NULL != _lod)
+   {
+      delete _lod;
+      _lod = NULL;
+   }
+}
+
+/*! Sends the packed boxes of this node to the renderer. The coordinates are
+ * passed directly from the packed block. If the node is only partially
+ * visible, the boxes are checked in batches against the clip region
+ * (transformed back to the coordinates of the cell) and the invisible ones
+ * are skipped.
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::drawPackedBoxes(trend::TrendBase& rend) const
+{
+   const int4b* cbox = _boxes;
+   const int4b* ebox = _boxes + 4 * _props._numBoxes;
+   DBbox clip = rend.clipRegion();
+   if (-1ll == clip.cliparea(_overlap.overlap(rend.topCTM())))
+   {
+      // the entire node is visible
+      for (; cbox != ebox; cbox += 4)
+         rend.box(cbox);
+      return;
+   }
+   DBbox lclip = clip.overlap(rend.topCTM().Reversed());
+   unsigned visible[BoxClip::CHUNK];
+   while (cbox != ebox)
+   {
+      unsigned numInChunk = std::min<unsigned>(BoxClip::CHUNK, (ebox - cbox) / 4);
+      unsigned numVisible = BoxClip::overlapping(cbox, numInChunk, lclip, visible);
+      for (unsigned i = 0; i < numVisible; i++)
+         rend.box(&(cbox[4*visible[i]]));
+      cbox += 4 * numInChunk;
+   }
 }
 
 /*! Used to copy DataT objects from QTreeTmpl to a TObjDataPairList. This is
@@ -602,8 +800,31 @@ void laydata::QTreeTmpl<DataT>::openGlRender(trend::TrendBase& rend, const TObjD
  * rebuild
  */
 template <typename DataT>
-void laydata::QTreeTmpl<DataT>::tmpStore(TObjList &store)
+void laydata::QTreeTmpl<DataT>::tmpStore(TObjVector &store)
 {
+   if (_props._packed)
+   {
+      // all objects are in a single array here - so no need to traverse
+      unsigned numObjects = _props._numObjects;
+      QTreeTmpl* nodes = _subQuads[0];
+      unsigned numNodes = packedNodes();
+      for (unsigned i = 0; i < numNodes; i++)
+         numObjects += nodes[i]._props._numObjects;
+      store.reserve(store.size() + numObjects);
+      for (unsigned i = 0; i < numObjects; i++)
+         store.push_back(_data[i]);
+      // ... and so are the packed boxes
+      if (NULL != _boxes)
+      {
+         unsigned numBoxes = _props._numBoxes;
+         for (unsigned i = 0; i < numNodes; i++)
+            numBoxes += nodes[i]._props._numBoxes;
+         for (unsigned i = 0; i < numBoxes; i++)
+            store.push_back(BoxPackTraits<DataT>::create(&(_boxes[4*i])));
+      }
+      releasePack();
+      return;
+   }
    if (NULL != _data)
    {
       for (QuadsIter i = 0; i < _props._numObjects; i++)
@@ -688,6 +909,10 @@ bool laydata::QTreeTmpl<DataT>::empty() const
    return (DEFAULT_OVL_BOX == _overlap);
 }
 
+/*! Finds the next object after prev which contains the point. The search
+ * starts from the beginning of the tree if prev is NULL. The packed boxes are
+ * not visited - they are not objects (see getPackedBoxOver()).
+ */
 template <typename DataT>
 bool laydata::QTreeTmpl<DataT>::getObjectOver(const TP pnt, DataT*& prev)
 {
@@ -709,6 +934,40 @@ bool laydata::QTreeTmpl<DataT>::getObjectOver(const TP pnt, DataT*& prev)
    return false;
 }
 
+/*! Returns the smallest packed box which contains the point or NULL if there
+ * is no such box. The result points to the raw coordinates in the packed block
+ * (the same layout as the ones of TdtBox) and it's valid until the tree is
+ * changed. The tree is not modified.
+ */
+template <typename DataT>
+const int4b* laydata::QTreeTmpl<DataT>::getPackedBoxOver(const TP pnt) const
+{
+   DBbox ovl(_overlap); // DBbox::inside() is not const
+   if (!ovl.inside(pnt)) return NULL;
+   const int4b* found = NULL;
+   int8b foundArea = 0ll;
+   for (QuadsIter i = 0; i < _props._numBoxes; i++)
+   {
+      const int4b* cbox = &(_boxes[4*i]);
+      DBbox wbox(cbox[0], cbox[1], cbox[2], cbox[3]);
+      if (wbox.inside(pnt) && ((NULL == found) || (foundArea > wbox.boxarea())))
+      {
+         found = cbox; foundArea = wbox.boxarea();
+      }
+   }
+   for (byte i = 0; i < _props.numSubQuads(); i++)
+   {
+      const int4b* cbox = _subQuads[i]->getPackedBoxOver(pnt);
+      if (NULL == cbox) continue;
+      DBbox wbox(cbox[0], cbox[1], cbox[2], cbox[3]);
+      if ((NULL == found) || (foundArea > wbox.boxarea()))
+      {
+         found = cbox; foundArea = wbox.boxarea();
+      }
+   }
+   return found;
+}
+
 /*! Delete all DataT objects in the container and free the heap. This function
  *  shall be called before the destructor in case the whole layer is to be
  *  destroyed - i.e. on exit for example
@@ -716,6 +975,20 @@ bool laydata::QTreeTmpl<DataT>::getObjectOver(const TP pnt, DataT*& prev)
 template <typename DataT>
 void laydata::QTreeTmpl<DataT>::freeMemory()
 {
+   releaseLod();
+   if (_props._packed)
+   {
+      // no point to convert the packed boxes to objects just to delete them
+      unsigned numObjects = _props._numObjects;
+      QTreeTmpl* nodes = _subQuads[0];
+      unsigned numNodes = packedNodes();
+      for (unsigned i = 0; i < numNodes; i++)
+         numObjects += nodes[i]._props._numObjects;
+      for (unsigned i = 0; i < numObjects; i++)
+         delete _data[i];
+      releasePack();
+      return;
+   }
    for (byte i = 0; i < _props.numSubQuads(); i++)
       _subQuads[i]->freeMemory();
    for (QuadsIter i = 0; i < _props._numObjects; i++)
@@ -733,6 +1006,12 @@ void laydata::QTreeTmpl<DataT>::freeMemory()
 template <typename DataT>
 laydata::QTreeTmpl<DataT>::~QTreeTmpl()
 {
+   releaseLod();
+   if (_props._packed)
+   {
+      releasePack();
+      return;
+   }
    if (NULL != _subQuads)
    {
       for (byte i = 0; i < _props.numSubQuads(); i++)
@@ -745,6 +1024,230 @@ laydata::QTreeTmpl<DataT>::~QTreeTmpl()
    if (NULL != _data)     delete [] _data;
 }
 
+/*! Relocates the entire tree in three contiguous arrays - one for the nodes
+ * below the root, one for the links to the sub-quads and one for the object
+ * pointers. All of them are filled-in in breadth-first order, so the siblings
+ * as well as their data end-up next to each other in the memory. The layout of
+ * the tree (overlaps, quad maps, fitting of the objects) is not changed at
+ * all, so all the iterators and the rendering are running on the packed tree
+ * unchanged.\n
+ * Must be called on the root of a sorted tree only. Any further modification
+ * will unpack the tree first (see unpack()), so it pays off only for data
+ * which is not going to be edited - i.e. imported layers.\n
+ * The plain boxes (see BoxPackTraits) are moved into a fourth array as raw
+ * coordinates (again in breadth-first order) and the original objects are
+ * deleted. The tree takes the ownership of them here, so it must not be
+ * called on trees which objects are referenced from elsewhere (undo lists,
+ * selection etc.).
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::pack()
+{
+   if (_props._packed || (NULL == _subQuads)) return;
+   releaseLod(); // the nodes are relocated
+   // collect all the nodes in breadth-first order
+   std::vector<QTreeTmpl*> bfOrder;
+   bfOrder.push_back(this);
+   unsigned numObjects = 0;
+   unsigned numBoxes = 0;
+   for (unsigned i = 0; i < bfOrder.size(); i++)
+   {
+      QTreeTmpl* cnode = bfOrder[i];
+      for (QuadsIter j = 0; j < cnode->_props._numObjects; j++)
+      {
+         if (BoxPackTraits<DataT>::packable(cnode->_data[j])) numBoxes++;
+         else                                                 numObjects++;
+      }
+      for (byte j = 0; j < cnode->_props.numSubQuads(); j++)
+         bfOrder.push_back(cnode->_subQuads[j]);
+   }
+   unsigned numNodes = bfOrder.size() - 1; // the root stays where it is
+   QTreeTmpl*  nodes   = DEBUG_NEW QTreeTmpl[numNodes];
+   QTreeTmpl** links   = DEBUG_NEW QTreeTmpl*[numNodes];
+   DataT**     objects = DEBUG_NEW DataT*[numObjects];
+   int4b*      boxes   = (0 < numBoxes) ? DEBUG_NEW int4b[4 * numBoxes] : NULL;
+   unsigned cLink = 0;    // current position in the links array
+   unsigned cObject = 0;  // current position in the objects array
+   unsigned cBox = 0;     // current position in the boxes array
+   for (unsigned i = 0; i < bfOrder.size(); i++)
+   {
+      QTreeTmpl* src = bfOrder[i];
+      QTreeTmpl* dst = (0 == i) ? this : &(nodes[i-1]);
+      byte numSubQuads = src->_props.numSubQuads();
+      QuadsIter numData = 0;
+      QuadsIter numNodeBoxes = 0;
+      for (QuadsIter j = 0; j < src->_props._numObjects; j++)
+      {
+         DataT* wdt = src->_data[j];
+         if (BoxPackTraits<DataT>::packable(wdt))
+         {
+            BoxPackTraits<DataT>::store(wdt, &(boxes[4 * (cBox + numNodeBoxes++)]));
+            delete wdt;
+         }
+         else
+            objects[cObject + numData++] = wdt;
+      }
+      if (NULL != src->_data) delete [] src->_data;
+      if (NULL != src->_subQuads) delete [] src->_subQuads;
+      dst->_overlap  = src->_overlap;
+      dst->_props    = src->_props;
+      dst->_props._numObjects = numData;
+      dst->_props._numBoxes   = numNodeBoxes;
+      dst->_data     = &(objects[cObject]);
+      // the root holds the beginning of the block (see releasePack())
+      if ((NULL != boxes) && ((0 < numNodeBoxes) || (0 == i)))
+         dst->_boxes = &(boxes[4 * cBox]);
+      else
+         dst->_boxes = NULL;
+      // children of the current node are next to each other in bfOrder and
+      // they are coming in the same order as the current nodes do.
+      if (0 < numSubQuads)
+      {
+         dst->_subQuads = &(links[cLink]);
+         for (byte j = 0; j < numSubQuads; j++, cLink++)
+            links[cLink] = &(nodes[cLink]);
+      }
+      else
+         dst->_subQuads = NULL;
+      cObject += numData;
+      cBox    += numNodeBoxes;
+      if (0 < i)
+      {
+         // get rid of the original node (it's empty by now)
+         src->_data = NULL; src->_subQuads = NULL;
+         delete src;
+      }
+   }
+   assert(cLink   == numNodes  );
+   assert(cObject == numObjects);
+   assert(cBox    == numBoxes  );
+   _props._packed = true;
+}
+
+/*! Converts the packed boxes back to objects. Must be called before any
+ * operation which might keep a pointer to an object of the tree or might
+ * change it - i.e. selection, editing etc. The boxes are not kept in the
+ * packed tree, so this is a simple unpack() in practice. Does nothing if the
+ * tree doesn't hold any packed boxes.
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::materialize()
+{
+   if (_props._packed && (NULL != _boxes))
+      unpack();
+}
+
+/*! Converts a packed tree back to a regular one keeping the existing layout
+ * of the tree. The packed boxes are converted back to objects. Does nothing
+ * if the tree is not packed.
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::unpack()
+{
+   if (!_props._packed) return;
+   releaseLod(); // the nodes are relocated
+   QTreeTmpl** subQuads = NULL;
+   byte numSubQuads = _props.numSubQuads();
+   if (0 < numSubQuads)
+   {
+      subQuads = DEBUG_NEW QTreeTmpl*[numSubQuads];
+      for (byte i = 0; i < numSubQuads; i++)
+         subQuads[i] = _subQuads[i]->clone();
+   }
+   DataT** data = cloneData();
+   QuadProps props = _props;
+   releasePack();
+   _props = props;
+   _props._numObjects += _props._numBoxes;
+   _props._numBoxes = 0;
+   _props._packed = false;
+   _subQuads = subQuads;
+   _data = data;
+}
+
+/*! Frees the contiguous arrays of a packed tree. Objects are not deleted.
+ * Leaves the root empty - with no children and no data.
+ */
+template <typename DataT>
+void laydata::QTreeTmpl<DataT>::releasePack()
+{
+   assert(_props._packed);
+   QTreeTmpl* nodes = _subQuads[0];
+   unsigned numNodes = packedNodes();
+   // the nodes must not release any memory on their own
+   for (unsigned i = 0; i < numNodes; i++)
+   {
+      nodes[i]._subQuads = NULL;
+      nodes[i]._data = NULL;
+      nodes[i]._boxes = NULL;
+   }
+   delete [] nodes;
+   delete [] _subQuads;
+   delete [] _data;
+   if (NULL != _boxes) delete [] _boxes;
+   _subQuads = NULL;
+   _data = NULL;
+   _boxes = NULL;
+   _props._numObjects = 0;
+   _props._numBoxes = 0;
+   _props._packed = false;
+   _props.clearQuadMap();
+}
+
+/*! Returns the number of nodes (excluding the root) of a packed tree*/
+template <typename DataT>
+unsigned laydata::QTreeTmpl<DataT>::packedNodes() const
+{
+   assert(_props._packed);
+   // nodes are in breadth-first order, so the children of every node are
+   // coming after all the nodes of the upper levels
+   const QTreeTmpl* nodes = _subQuads[0];
+   unsigned numNodes = _props.numSubQuads();
+   for (unsigned i = 0; i < numNodes; i++)
+      numNodes += nodes[i]._props.numSubQuads();
+   return numNodes;
+}
+
+/*! Returns a regular (not packed) copy of this node and all its children.
+ * The objects are not copied - only the pointers to them. The packed boxes
+ * are converted to objects.
+ */
+template <typename DataT>
+laydata::QTreeTmpl<DataT>* laydata::QTreeTmpl<DataT>::clone() const
+{
+   QTreeTmpl* copy = DEBUG_NEW QTreeTmpl();
+   copy->_overlap = _overlap;
+   copy->_props   = _props;
+   copy->_props._packed = false;
+   copy->_props._numObjects += _props._numBoxes;
+   copy->_props._numBoxes = 0;
+   copy->_data = cloneData();
+   byte numSubQuads = _props.numSubQuads();
+   if (0 < numSubQuads)
+   {
+      copy->_subQuads = DEBUG_NEW QTreeTmpl*[numSubQuads];
+      for (byte i = 0; i < numSubQuads; i++)
+         copy->_subQuads[i] = _subQuads[i]->clone();
+   }
+   return copy;
+}
+
+/*! Returns a new array with the object pointers of this node followed by
+ * new objects created from the packed boxes of the node. Returns NULL if the
+ * node is empty.
+ */
+template <typename DataT>
+DataT** laydata::QTreeTmpl<DataT>::cloneData() const
+{
+   QuadsIter numData = _props._numObjects + _props._numBoxes;
+   if (0 == numData) return NULL;
+   DataT** data = DEBUG_NEW DataT*[numData];
+   if (0 < _props._numObjects)
+      memcpy(data, _data, sizeof(DataT*) * _props._numObjects);
+   for (QuadsIter i = 0; i < _props._numBoxes; i++)
+      data[_props._numObjects + i] = BoxPackTraits<DataT>::create(&(_boxes[4*i]));
+   return data;
+}
 
 // template <typename DataT>
 // laydata::DataT* laydata::QTreeTmpl<DataT>::getfirstover(const TP pnt) {
@@ -30,7 +30,9 @@
 #ifndef QTREE_TMPL_H_
 #define QTREE_TMPL_H_
 
+#include <algorithm>
 #include "quadtree.h"
+#include "boxclip.h"
 
 namespace laydata {
    //==============================================================================
@@ -56,7 +58,23 @@ namespace laydata {
     * array of up to 4 QTreeTmpl objects (_subQuads). \n
     * From outside a QTreeTmpl object shall behave like a container -
     * abstracting out as much as possible of the clipping, sorting etc.
-    * To achieve that appropriate iterators are defined.
+    * To achieve that appropriate iterators are defined.\n
+    * A sorted tree can be packed (see pack()). Then all the nodes below the
+    * root, the links between them and the object pointers are relocated in
+    * three contiguous arrays in breadth-first order. Packed tree is traversed
+    * exactly as the normal one, but any modification will unpack it first.\n
+    * Packing also moves the plain boxes (see BoxPackTraits) out of the object
+    * arrays into a single block of raw coordinates - 16 bytes per box instead
+    * of a separately allocated object plus a pointer to it. Those boxes are
+    * rendered straight from the block and are visited as temporary objects by
+    * forEach(), forEachInBox() and drawVisible(). getObjectOver() skips them
+    * (see getPackedBoxOver()). Everything which might keep a pointer to an
+    * object (the iterators and all modifications) converts them back to
+    * objects first - see materialize(). Only the edit paths shall do that.\n
+    * The nodes which are too small on the screen can be rendered using a
+    * precomputed coverage of their area instead of the objects (see LodTiles).
+    * This data is computed by buildLod() before the rendering, kept in the root
+    * of the tree and it's dropped on any change of the tree.
     */
    template <typename DataT>
    class QTreeTmpl {
@@ -66,6 +84,7 @@ namespace laydata {
       friend class DrawIterator<DataT>;
       friend class QTStoreTmpl<DataT>;
       typedef     std::list<DataT*>             TObjList;
+      typedef     std::vector<DataT*>           TObjVector;
       typedef     std::pair<DataT*, SGBitSet>   TObjDataPair;
       typedef     std::list<TObjDataPair>       TObjDataPairList;
       typedef laydata::Iterator<DataT>          Iterator;
@@ -78,38 +97,134 @@ namespace laydata {
       const ClipIterator   begin(const DBbox&);
       const DrawIterator   begin(const layprop::DrawProperties&, const CTM&);
       const Iterator       end();
-      void                 openGlRender(trend::TrendBase&, const TObjDataPairList*) const;
+      void                 openGlRender(trend::TrendBase&, const TObjDataPairList*, bool lod = false) const;
       short                clipType(trend::TrendBase&) const;
       void                 add(DataT* shape);
       bool                 deleteMarked(SH_STATUS stat=sh_selected, bool partselect=false);
       bool                 deleteThis(DataT*);
+      bool                 deleteThese(const TObjVector&);
       bool                 getObjectOver(const TP pnt, DataT*& prev);
+      const int4b*         getPackedBoxOver(const TP pnt) const;
+      template <typename FunctorT>
+      bool                 forEachInBox(const DBbox&, FunctorT&) const;
+      template <typename FunctorT>
+      bool                 forEach(FunctorT&) const;
+      template <typename FunctorT>
+      void                 drawVisible(trend::TrendBase&, FunctorT&) const;
       void                 validate();
       bool                 fullValidate();
       void                 resort(DataT* newdata = NULL);
       bool                 empty() const;
       void                 freeMemory();
+      void                 pack();
+      void                 materialize();
+      void                 buildLod();
       //! Return the overlapping box
       DBbox                overlap() const   {return _overlap;}
       //! Return the status of _invalid flag*/
       bool                 invalid() const   { return _props._invalid;}
       //! Mark the tree as invalid*/
-      void                 invalidate()      {_props._invalid = true;}
+      void                 invalidate()      {_props._invalid = true; releaseLod();}
+      //! Return the status of _packed flag*/
+      bool                 packed() const    { return _props._packed;}
    private:
-      void                 resort(TObjList&);
-      void                 sort(TObjList&);
+      class SortJob;
+      friend class SortJob;
+      void                 resort(TObjVector&);
+      void                 sort(TObjVector&);
+      void                 sort(DataT**, DataT**, char*, unsigned, bool);
       bool                 fitInTree(DataT* shape);
       char                 fitSubTree(const DBbox&, DBbox*);
-      void                 tmpStore(TObjList& store);
+      void                 tmpStore(TObjVector& store);
       byte                 biggest(int8b* array) const;
       void                 updateOverlap(const DBbox& hovl);
       byte                 sequreQuad(QuadIdentificators);
       void                 removeQuad(QuadIdentificators);
+      void                 unpack();
+      void                 releasePack();
+      void                 drawPackedBoxes(trend::TrendBase&) const;
+      void                 renderNode(trend::TrendBase&, const TObjDataPairList*, const LodCache*) const;
+      bool                 renderLod(trend::TrendBase&, const LodCache&) const;
+      void                 buildLod(LodCache&) const;
+      void                 releaseLod();
+      unsigned             packedNodes() const;
+      QTreeTmpl*           clone() const;
+      DataT**              cloneData() const;
       DBbox                _overlap;   //! The overlapping box of the quad
       QTreeTmpl**          _subQuads;  //! A pointers to the child QTreeTmpl structures
       DataT**              _data;      //! Pointer to The array of objects stored in this QTreeTmpl
+      int4b*               _boxes;     //! The boxes packed in this QTreeTmpl as raw coordinates
       QuadProps            _props;     //! The structure holding the properties of this QTreeTmpl
+      LodCache*            _lod;       //! LOD data of the tree (root only, see buildLod())
    };
+
+   /*! Visit all objects in the quads overlapping the clip box. This is the
+    * recursive alternative of the ClipIterator - no iterator state at all.
+    * The functor is called with a DataT* parameter and shall return false to
+    * stop the traversal. The function returns false if the traversal has been
+    * stopped by the functor.\n
+    * Note that (as with ClipIterator) the functor is called with all objects
+    * of a quad which overlaps the box, i.e. the objects themselves still have
+    * to be checked if that's required.\n
+    * The packed boxes are passed to the functor as temporary objects, so the
+    * functor must not keep the pointer or change the object. Call
+    * materialize() first if that's required. Unlike the other objects, only
+    * the packed boxes which overlap the clip box are visited - they are
+    * filtered in batches by BoxClip.
+    */
+   template <typename DataT> template <typename FunctorT>
+   bool QTreeTmpl<DataT>::forEachInBox(const DBbox& clip, FunctorT& func) const
+   {
+      if (0ll == clip.cliparea(_overlap)) return true;
+      for (QuadsIter i = 0; i < _props._numObjects; i++)
+         if (!func(_data[i])) return false;
+      unsigned visible[BoxClip::CHUNK];
+      for (QuadsIter c = 0; c < _props._numBoxes; c += BoxClip::CHUNK)
+      {
+         const int4b* chunk = &(_boxes[4*c]);
+         unsigned numInChunk = std::min<unsigned>(BoxClip::CHUNK, _props._numBoxes - c);
+         unsigned numVisible = BoxClip::overlapping(chunk, numInChunk, clip, visible);
+         for (unsigned i = 0; i < numVisible; i++)
+            if (!BoxPackTraits<DataT>::visit(&(chunk[4*visible[i]]), func)) return false;
+      }
+      for (byte i = 0; i < _props.numSubQuads(); i++)
+         if (!_subQuads[i]->forEachInBox(clip, func)) return false;
+      return true;
+   }
+
+   /*! Visit all objects in the tree. The same rules as for forEachInBox()
+    * apply. This is the way to read a packed tree without converting its boxes
+    * back to objects.
+    */
+   template <typename DataT> template <typename FunctorT>
+   bool QTreeTmpl<DataT>::forEach(FunctorT& func) const
+   {
+      for (QuadsIter i = 0; i < _props._numObjects; i++)
+         if (!func(_data[i])) return false;
+      for (QuadsIter i = 0; i < _props._numBoxes; i++)
+         if (!BoxPackTraits<DataT>::visit(&(_boxes[4*i]), func)) return false;
+      for (byte i = 0; i < _props.numSubQuads(); i++)
+         if (!_subQuads[i]->forEach(func)) return false;
+      return true;
+   }
+
+   /*! Visit all objects in the nodes which are visible in the renderer (see
+    * clipType()). The packed boxes of those nodes are not passed to the
+    * functor - they are sent to the renderer as they are (see
+    * drawPackedBoxes()). This is the read-only alternative of the DrawIterator
+    * for the drawing which doesn't care about the selection (i.e. motion draw).
+    */
+   template <typename DataT> template <typename FunctorT>
+   void QTreeTmpl<DataT>::drawVisible(trend::TrendBase& rend, FunctorT& func) const
+   {
+      if (0 == clipType(rend)) return;
+      for (QuadsIter i = 0; i < _props._numObjects; i++)
+         func(_data[i]);
+      if (0 < _props._numBoxes)
+         drawPackedBoxes(rend);
+      for (byte i = 0; i < _props.numSubQuads(); i++)
+         _subQuads[i]->drawVisible(rend, func);
+   }
 }
 //    void                 visible_shapes(laydata::ShapeList*, const DBbox&, const CTM&, const CTM&, unsigned long&);
 //    DataT*               getfirstover(const TP);
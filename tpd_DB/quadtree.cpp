@@ -26,11 +26,14 @@
 //===========================================================================
 
 #include "tpdph.h"
+#include <typeinfo>
 #include "quadtree.h"
 #include "qtree_tmpl.h"
 #include "auxdat.h"
 
-laydata::QuadProps::QuadProps(): _numObjects(0), _invalid(false), _quadMap(0)
+word laydata::QTreeBuild::_numThreads = 1;
+
+laydata::QuadProps::QuadProps(): _numObjects(0), _numBoxes(0), _invalid(false), _packed(false), _quadMap(0)
 {}
 
 byte laydata::QuadProps::numSubQuads() const
@@ -125,6 +128,160 @@ char laydata::QuadProps::getNWQuad() const
    return -1;
 }
 
+//=============================================================================
+/*! Only the plain boxes are packed. Selected or otherwise marked shapes as
+ * well as the extended boxes (TdtBoxEXT) stay as they are.*/
+bool laydata::BoxPackTraits<laydata::TdtData>::packable(const TdtData* shape)
+{
+   return (sh_active == shape->status()) && (typeid(*shape) == typeid(TdtBox));
+}
+
+void laydata::BoxPackTraits<laydata::TdtData>::store(const TdtData* shape, int4b* box)
+{
+   // the boxes are normalized, so the overlap is exactly the box
+   DBbox ovl = shape->overlap();
+   box[0] = ovl.p1().x(); box[1] = ovl.p1().y();
+   box[2] = ovl.p2().x(); box[3] = ovl.p2().y();
+}
+
+laydata::TdtData* laydata::BoxPackTraits<laydata::TdtData>::create(const int4b* box)
+{
+   return DEBUG_NEW TdtBox(TP(box[0], box[1]), TP(box[2], box[3]));
+}
+
+//=============================================================================
+//! A run of covered LOD tiles in a row (see LodTiles::finalize())
+struct TileRun {word first; word last; word row;};
+
+laydata::LodTiles::LodTiles(const DBbox& overlap) :
+   _overlap    ( overlap ),
+   _boxes      ( NULL    ),
+   _numBoxes   ( 0u      ),
+   _numObjects ( 0u      )
+{
+   // degenerated overlaps (i.e. a single wire) are still divided in tiles
+   _stepX = std::max<real>(1.0, (real)(_overlap.p2().x() - _overlap.p1().x()) / LOD_TILES);
+   _stepY = std::max<real>(1.0, (real)(_overlap.p2().y() - _overlap.p1().y()) / LOD_TILES);
+   _coverage = DEBUG_NEW real[LOD_TILES * LOD_TILES];
+   for (unsigned i = 0; i < LOD_TILES * LOD_TILES; i++)
+      _coverage[i] = 0.0;
+}
+
+/*! Adds the area of the box to the coverage of all tiles it overlaps*/
+void laydata::LodTiles::addArea(const DBbox& ovl)
+{
+   assert(NULL != _coverage);
+   _numObjects++;
+   real x1 = ovl.p1().x() - _overlap.p1().x();
+   real y1 = ovl.p1().y() - _overlap.p1().y();
+   real x2 = ovl.p2().x() - _overlap.p1().x();
+   real y2 = ovl.p2().y() - _overlap.p1().y();
+   // lines and points have a zero area - count them as 1 DBU thick
+   if (x2 == x1) x2 += 1.0;
+   if (y2 == y1) y2 += 1.0;
+   word tx1 = std::min<word>(LOD_TILES - 1, (word)(x1 / _stepX));
+   word ty1 = std::min<word>(LOD_TILES - 1, (word)(y1 / _stepY));
+   word tx2 = std::min<word>(LOD_TILES - 1, (word)(x2 / _stepX));
+   word ty2 = std::min<word>(LOD_TILES - 1, (word)(y2 / _stepY));
+   for (word j = ty1; j <= ty2; j++)
+   {
+      real cy = std::min(y2, (j + 1) * _stepY) - std::max(y1, j * _stepY);
+      for (word i = tx1; i <= tx2; i++)
+      {
+         real cx = std::min(x2, (i + 1) * _stepX) - std::max(x1, i * _stepX);
+         if ((cx > 0.0) && (cy > 0.0))
+            _coverage[j * LOD_TILES + i] += cx * cy;
+      }
+   }
+}
+
+/*! Converts the accumulated coverage into boxes. The covered tiles in a row
+ * are merged together and the equal runs of the consecutive rows are merged
+ * as well. Overlapping objects may add-up above the tile area - that's fine,
+ * the result is a density estimation anyway.*/
+void laydata::LodTiles::finalize()
+{
+   assert(NULL != _coverage);
+   const real minArea = _stepX * _stepY / LOD_MIN_COVERAGE;
+   typedef std::list<TileRun> RunList;
+   std::vector<int4b> boxes;
+   RunList openRuns;
+   for (word j = 0; j <= LOD_TILES; j++)
+   {
+      RunList rowRuns;
+      for (word i = 0; (j < LOD_TILES) && (i < LOD_TILES); i++)
+      {
+         if (_coverage[j * LOD_TILES + i] < minArea) continue;
+         TileRun run;
+         run.first = i;
+         while ((i + 1 < LOD_TILES) && (_coverage[j * LOD_TILES + i + 1] >= minArea)) i++;
+         run.last = i;
+         run.row  = j;
+         rowRuns.push_back(run);
+      }
+      // extend the open runs which continue in this row, close the others
+      for (RunList::const_iterator CR = openRuns.begin(); CR != openRuns.end(); CR++)
+      {
+         RunList::iterator NR = rowRuns.begin();
+         while ((NR != rowRuns.end()) && ((NR->first != CR->first) || (NR->last != CR->last))) NR++;
+         if (NR != rowRuns.end())
+            NR->row = CR->row;
+         else
+         {
+            boxes.push_back(tileX(CR->first   )); boxes.push_back(tileY(CR->row));
+            boxes.push_back(tileX(CR->last + 1)); boxes.push_back(tileY(j      ));
+         }
+      }
+      openRuns = rowRuns;
+   }
+   assert(openRuns.empty());
+   delete [] _coverage;
+   _coverage = NULL;
+   _numBoxes = boxes.size() / 4;
+   if (0 < _numBoxes)
+   {
+      _boxes = DEBUG_NEW int4b[boxes.size()];
+      memcpy(_boxes, &(boxes[0]), sizeof(int4b) * boxes.size());
+   }
+}
+
+int4b laydata::LodTiles::tileX(word i) const
+{
+   if (LOD_TILES == i) return _overlap.p2().x();
+   return std::min<int4b>(_overlap.p2().x(), _overlap.p1().x() + (int4b)rint(i * _stepX));
+}
+
+int4b laydata::LodTiles::tileY(word j) const
+{
+   if (LOD_TILES == j) return _overlap.p2().y();
+   return std::min<int4b>(_overlap.p2().y(), _overlap.p1().y() + (int4b)rint(j * _stepY));
+}
+
+laydata::LodTiles::~LodTiles()
+{
+   if (NULL != _coverage) delete [] _coverage;
+   if (NULL != _boxes   ) delete [] _boxes;
+}
+
+//=============================================================================
+const laydata::LodTiles* laydata::LodCache::find(const void* node) const
+{
+   LodTilesMap::const_iterator CT = _tiles.find(node);
+   return (_tiles.end() == CT) ? NULL : CT->second;
+}
+
+void laydata::LodCache::add(const void* node, LodTiles* tiles)
+{
+   assert(_tiles.end() == _tiles.find(node));
+   _tiles[node] = tiles;
+}
+
+laydata::LodCache::~LodCache()
+{
+   for (LodTilesMap::const_iterator CT = _tiles.begin(); CT != _tiles.end(); CT++)
+      delete CT->second;
+}
+
 //=============================================================================
 
 template <typename DataT>
@@ -179,10 +336,14 @@ void laydata::QTStoreTmpl<DataT>::put(DataT* shape)
 //   put(shape);
 //}
 
+/*! Sort all the stored data into the _trunk. If pack is true the resulting
+tree is packed afterwards (see QTreeTmpl::pack()). This is the preferred way to
+fill-in layers which are not likely to be edited - i.e. imported ones.*/
 template <typename DataT>
-void laydata::QTStoreTmpl<DataT>::commit()
+void laydata::QTStoreTmpl<DataT>::commit(bool pack)
 {
    _trunk->resort(_data);
+   if (pack) _trunk->pack();
 }
 
 
@@ -194,8 +355,7 @@ template <typename DataT>
 laydata::Iterator<DataT>::Iterator() :
    _cQuad     ( NULL                 ),
    _cData     ( 0                    ),
-   _qPosStack ( NULL                 ),
-   _copy      ( false                )
+   _qPosDepth ( 0                    )
 {
 }
 
@@ -203,8 +363,7 @@ template <typename DataT>
 laydata::Iterator<DataT>::Iterator(const QTreeTmpl<DataT>& cQuad) :
    _cQuad     (&cQuad                ),
    _cData     ( 0                    ),
-   _qPosStack ( DEBUG_NEW QPosStack()),
-   _copy      ( false                )
+   _qPosDepth ( 0                    )
 {
    secureNonEmptyDown();
 }
@@ -213,9 +372,13 @@ template <typename DataT>
 laydata::Iterator<DataT>::Iterator(const Iterator<DataT>& iter):
    _cQuad     ( iter._cQuad          ),
    _cData     ( iter._cData          ),
-   _qPosStack ( iter._qPosStack      ),
-   _copy      ( true                 )
-{}
+   _qPosOverflow( iter._qPosOverflow ),
+   _qPosDepth ( iter._qPosDepth      )
+{
+   // copy only the used part of the position stack
+   for (unsigned i = 0; (i < _qPosDepth) && (i < QTREE_MAX_DEPTH); i++)
+      _qPosStack[i] = iter._qPosStack[i];
+}
 
 template <typename DataT>
 const typename laydata::Iterator<DataT>& laydata::Iterator<DataT>::operator++()
@@ -224,10 +387,10 @@ const typename laydata::Iterator<DataT>& laydata::Iterator<DataT>::operator++()
       return *this;
    if (nextSubQuad(0, _cQuad->_props.numSubQuads()))
       return *this;
-   while (0 < _qPosStack->size())
+   while (0 < _qPosDepth)
    {
       //pop a quad
-      QtPosition<DataT> prevQuad = _qPosStack->top(); _qPosStack->pop();
+      QtPosition<DataT> prevQuad = popPosition();
       _cQuad = prevQuad._cQuad;
       // Note! - if we're traversing the subquads - it means that we've already
       // traversed the eventual data in the popped quad. So go and find the next
@@ -285,7 +448,7 @@ bool laydata::Iterator<DataT>::secureNonEmptyDown()
    {
       if (0 < _cQuad->_props.numSubQuads())
       {
-         _qPosStack->push(QtPosition<DataT>(_cQuad,0));
+         pushPosition(_cQuad,0);
          _cQuad = _cQuad->_subQuads[0];
       }
       else assert(false); // i.e. the tree is not in traversable condition
@@ -299,24 +462,39 @@ bool laydata::Iterator<DataT>::nextSubQuad(byte quadBeg, byte quadEnd)
 {
    for (byte i = quadBeg; i < quadEnd; i++)
    {
-      _qPosStack->push(QtPosition<DataT>(_cQuad,i));
+      pushPosition(_cQuad,i);
       _cQuad = _cQuad->_subQuads[i];
       if (secureNonEmptyDown())
          return true;
       else
-      {
-         QtPosition<DataT> pQuad = _qPosStack->top(); _qPosStack->pop();
-         _cQuad = pQuad._cQuad;
-      }
+         _cQuad = popPosition()._cQuad;
    }
    return false;
 }
 
 template <typename DataT>
-laydata::Iterator<DataT>::~Iterator()
+void laydata::Iterator<DataT>::pushPosition(const QTreeTmpl<DataT>* cQuad, byte cSubQuad)
+{
+   if (_qPosDepth < QTREE_MAX_DEPTH)
+   {
+      QtPosition<DataT>& cPos = _qPosStack[_qPosDepth];
+      cPos._cQuad    = cQuad;
+      cPos._cSubQuad = cSubQuad;
+   }
+   else
+      _qPosOverflow.push_back(QtPosition<DataT>(cQuad, cSubQuad));
+   _qPosDepth++;
+}
+
+template <typename DataT>
+laydata::QtPosition<DataT> laydata::Iterator<DataT>::popPosition()
 {
-   if ((!_copy) && (NULL != _qPosStack))
-      delete _qPosStack;
+   assert(0 < _qPosDepth);
+   if (--_qPosDepth < QTREE_MAX_DEPTH)
+      return _qPosStack[_qPosDepth];
+   QtPosition<DataT> cPos = _qPosOverflow.back();
+   _qPosOverflow.pop_back();
+   return cPos;
 }
 
 //-----------------------------------------------------------------------------
@@ -34,22 +34,53 @@ namespace laydata {
 
    typedef unsigned            QuadsIter;
 
+   /*! The maximum depth of a quad tree. Every level down the tree reduces the
+    * area of the quad at least 3.6 times (see QTreeTmpl::fitInTree()), so
+    * the int4b coordinates limit the depth well below this number.*/
+   const byte                  QTREE_MAX_DEPTH = 64;
+   /*! The resolution of the level of detail data (see LodTiles) - tiles per
+    * side of a quad tree node. A node is rendered using its LOD data if it
+    * projects on the screen to less than LOD_TILES * LOD_TILE_PIXELS pixels*/
+   const word                  LOD_TILES       = 32;
+   const word                  LOD_TILE_PIXELS = 2;
+   /*! A tile is drawn if at least 1/LOD_MIN_COVERAGE of it is covered*/
+   const word                  LOD_MIN_COVERAGE = 4;
+   /*! The minimum number of objects in a quad tree which is worth sorting its
+    * sub-quads in parallel (see QTreeTmpl::sort())*/
+   const unsigned              QTREE_MIN_PARALLEL = 65536;
+
+   /*! The number of threads used to sort the sub-quads of the big quad trees.
+    * Value 0 means all CPUs. The default is 1 - i.e. no parallel sort.*/
+   class QTreeBuild {
+   public:
+      static void               setThreads(word threads) {_numThreads = threads;}
+      static word               threads()                {return _numThreads;}
+   private:
+      static word               _numThreads;
+   };
+
    template <typename DataT>
    class QtPosition {
    public:
+         QtPosition() {}
          QtPosition(const QTreeTmpl<DataT>* cQuad, byte cSubQuad) : _cQuad(cQuad), _cSubQuad(cSubQuad) {}
       const QTreeTmpl<DataT>*   _cQuad;
-      const byte                _cSubQuad;
+      byte                      _cSubQuad;
    };
 
+   /*! The iterators keep the path from the root to the current quad in a fixed
+    * size array (_qPosStack) instead of a heap allocated stack, so creating,
+    * copying and traversing them doesn't touch the heap at all. Only the
+    * positions deeper than QTREE_MAX_DEPTH (which a valid tree shall not
+    * have) are kept in _qPosOverflow. Still the prefix increment shall be
+    * preferred in the loops, because the postfix one copies the iterator.*/
    template <typename DataT>
    class Iterator {
    public:
-      typedef  std::stack<QtPosition<DataT> >        QPosStack;
                                 Iterator();
                                 Iterator(const QTreeTmpl<DataT>&);
                                 Iterator(const Iterator&);
-      virtual                  ~Iterator();
+      virtual                  ~Iterator() {}
       const Iterator&           operator++();    //Prefix
       const Iterator            operator++(int); //Postfix
       bool                      operator==(const Iterator&);
@@ -59,10 +90,13 @@ namespace laydata {
    protected:
       virtual bool              secureNonEmptyDown();
       bool                      nextSubQuad(byte, byte);
+      void                      pushPosition(const QTreeTmpl<DataT>*, byte);
+      QtPosition<DataT>         popPosition();
       const QTreeTmpl<DataT>*   _cQuad;
       QuadsIter                 _cData;
-      QPosStack*                _qPosStack;
-      bool                      _copy;
+      QtPosition<DataT>         _qPosStack[QTREE_MAX_DEPTH];
+      std::vector<QtPosition<DataT> > _qPosOverflow;
+      unsigned                  _qPosDepth;
    };
 
    template <typename DataT>
@@ -109,8 +143,12 @@ namespace laydata {
       void                      removeQuad(QuadIdentificators);
       void                      clearQuadMap() {_quadMap = 0;}
       QuadsIter                 _numObjects;
+     /*! Number of boxes stored as raw coordinates (packed trees only)*/
+      QuadsIter                 _numBoxes;
      /*! Flag indicates that the container needs to be resorted*/
       bool                      _invalid;
+     /*! Flag indicates that the tree below is packed in contiguous arrays*/
+      bool                      _packed;
    private:
       char                      getNEQuad() const;
       char                      getNWQuad() const;
@@ -119,20 +157,106 @@ namespace laydata {
       byte                      _quadMap;
    };
 
+   /*! Describes how the objects of a certain type are stored in the packed box
+    * block of a QTreeTmpl (see QTreeTmpl::pack()). Only the plain boxes of the
+    * layout data are stored there - as four int4b coordinates in the order
+    * expected by the renderers (p1x, p1y, p2x, p2y). The default template
+    * doesn't pack anything.*/
+   template <typename DataT>
+   struct BoxPackTraits {
+      static bool               packable(const DataT*)            {return false;}
+      static void               store(const DataT*, int4b*)       {assert(false);}
+      static DataT*             create(const int4b*)              {assert(false); return NULL;}
+      template <typename FunctorT>
+      static bool               visit(const int4b*, FunctorT&)    {assert(false); return false;}
+   };
+
+   template <>
+   struct BoxPackTraits<TdtData> {
+      static bool               packable(const TdtData*);
+      static void               store(const TdtData*, int4b*);
+      static TdtData*           create(const int4b*);
+      /*! Calls func with a temporary TdtBox having the coordinates of box.
+       * The object is valid only for the duration of the call*/
+      template <typename FunctorT>
+      static bool               visit(const int4b* box, FunctorT& func)
+      {
+         TdtBox fwBox(TP(box[0], box[1]), TP(box[2], box[3]));
+         return func(&fwBox);
+      }
+   };
+
+   /*! Describes which objects can be substituted by the LOD data of a quad tree
+    * node (see LodTiles). The default template allows all of them.*/
+   template <typename DataT>
+   struct LodTraits {
+      static bool               substitutable(const DataT*)       {return true;}
+   };
+
+   /*! The texts are never replaced by their overlap, so the nodes holding texts
+    * are always rendered with their objects.*/
+   template <>
+   struct LodTraits<TdtData> {
+      static bool               substitutable(const TdtData* obj) {return (_lmtext != obj->lType());}
+   };
+
    template <typename DataT>
    class QTStoreTmpl {
    public:
                                 QTStoreTmpl(QTreeTmpl<DataT>* trunk) : _trunk(trunk) {};
        void                     put(DataT* shape);
-       void                     commit();
+       void                     commit(bool pack = false);
        unsigned                 numObjects()  {return _data.size();}
    private:
-      typedef  std::list<DataT*>    ShapeList;
+      typedef  std::vector<DataT*>  ShapeList;
       ShapeList                 _data;
       QTreeTmpl<DataT>*         _trunk;
    };
 
    typedef QTStoreTmpl<TdtData>  QTreeTmp;
+
+   /*! Level of detail data of a single quad tree node. The overlap of the node
+    * is divided into LOD_TILES x LOD_TILES tiles and the coverage of each tile
+    * is accumulated from the overlapping boxes of all objects in the node and
+    * its children (addArea()). The tiles which are covered enough are merged
+    * into as few boxes as possible (finalize()) - and those are rendered
+    * instead of the objects when the node is too small on the screen to show
+    * them anyway. The data is useful only if it contains less boxes than the
+    * objects it stands for.*/
+   class LodTiles {
+   public:
+                                LodTiles(const DBbox&);
+                               ~LodTiles();
+      void                      addArea(const DBbox&);
+      void                      finalize();
+      bool                      useful() const   {return _numBoxes < _numObjects;}
+      unsigned                  numBoxes() const {return _numBoxes;}
+      const int4b*              boxes() const    {return _boxes;}
+   private:
+      int4b                     tileX(word) const;
+      int4b                     tileY(word) const;
+      DBbox                     _overlap;
+      real                      _stepX;
+      real                      _stepY;
+      real*                     _coverage;   //! Covered area per tile - collecting phase only
+      int4b*                    _boxes;      //! The merged tiles as raw coordinates (p1x, p1y, p2x, p2y)
+      unsigned                  _numBoxes;
+      unsigned                  _numObjects; //! Number of objects collected in the tiles
+   };
+
+   /*! The LOD data of the nodes of a quad tree. It's created by the root of the
+    * tree before the rendering (see QTreeTmpl::buildLod()) and it is dropped
+    * by any change of the tree (including packing) - see QTreeTmpl::releaseLod()*/
+   class LodCache {
+   public:
+                                LodCache() {}
+                               ~LodCache();
+      const LodTiles*           find(const void*) const;
+      void                      add(const void*, LodTiles*);
+   private:
+      typedef std::map<const void*, LodTiles*> LodTilesMap;
+      LodTilesMap               _tiles;
+   };
 }
 
 #endif
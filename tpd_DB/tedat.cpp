@@ -627,12 +627,10 @@ laydata::TdtPoly::TdtPoly(const PointVector& plst) : TdtData()
       _pdata[index++] = plst[i].x();
       _pdata[index++] = plst[i].y();
    }
-   _teseldata.tessellate(_pdata, _psize);
 }
 
 laydata::TdtPoly::TdtPoly(int4b* pdata, unsigned psize) : _pdata(pdata), _psize(psize)
 {
-   _teseldata.tessellate(_pdata, _psize);
 }
 
 laydata::TdtPoly::TdtPoly(InputTdtFile* const tedfile) : TdtData()
@@ -647,7 +645,6 @@ laydata::TdtPoly::TdtPoly(InputTdtFile* const tedfile) : TdtData()
       _pdata[2*i  ] = wpnt.x();
       _pdata[2*i+1] = wpnt.y();
    }
-   _teseldata.tessellate(_pdata, _psize);
 }
 
 void laydata::TdtPoly::drawRequest(trend::TrendBase& rend) const
@@ -699,8 +696,8 @@ laydata::Validator* laydata::TdtPoly::move(const CTM& trans, SGBitSet& plst)
          {
             _pdata[2*i] = (*nshape)[i].x();_pdata[2*i+1] = (*nshape)[i].y();
          }
-         // retessellate the modified shape
-         _teseldata.tessellate(_pdata, _psize);
+         // drop the tessellation of the modified shape
+         _teseldata.clear();
          nshape->clear(); delete nshape;
          delete check;
          return NULL;
@@ -733,6 +730,7 @@ laydata::Validator* laydata::TdtPoly::move(const CTM& trans, SGBitSet& plst)
             {
                _pdata[2*i] = (*mlist)[i].x();_pdata[2*i+1] = (*mlist)[i].y();
             }
+            _teseldata.clear();
             delete check; delete mlist;
             return NULL;
          }
@@ -766,8 +764,8 @@ void laydata::TdtPoly::transfer(const CTM& trans)
          _pdata[index++] = plist[i].y();
       }
    assert(index == (2*_psize));
-   // retessellate the modified shape
-   _teseldata.tessellate(_pdata, _psize);
+   // drop the tessellation of the modified shape
+   _teseldata.clear();
 }
 
 laydata::TdtData* laydata::TdtPoly::copy(const CTM& trans)
@@ -1612,6 +1610,15 @@ void laydata::TdtCellAref::drawRequest(trend::TrendBase& rend) const
 
    // finally - start drawing
    rend.arefOBox(structure()->name(), _translation, array_overlap, (sh_selected == _status) );
+   // the shader renderer draws all visible elements from the first one
+   if ((col_beg < col_end) && (row_beg < row_end) &&
+       rend.pushArray(_translation, _arrprops.colStep(), _arrprops.rowStep(), col_end - col_beg, row_end - row_beg))
+   {
+      CTM refCTM(_arrprops.displ(col_beg,row_beg), 1, 0, false);
+      structure()->openGlRender(rend, refCTM * _translation, false, false);
+      rend.popArray();
+      return;
+   }
    for (int i = col_beg; i < col_end; i++)
    {// start/stop rows
       for(int j = row_beg; j < row_end; j++)
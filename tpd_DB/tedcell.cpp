@@ -38,9 +38,235 @@
 #include "tenderer.h"
 #include "trend.h"
 #include "outbox.h"
+#include "laylogic.h"
 
 extern trend::TrendCenter*       TRENDC;
 
+//=============================================================================
+// Visitors for QTreeTmpl::forEachInBox() and QTreeTmpl::forEach()
+//=============================================================================
+namespace laydata {
+   /*! Stops the traversal at the first shape which contains the point*/
+   class PointOverVisitor {
+   public:
+                        PointOverVisitor(const TP& pnt) : _pnt(pnt) {}
+      bool              operator() (TdtData* wdt) {return !wdt->pointInside(_pnt);}
+   private:
+      const TP&         _pnt;
+   };
+
+   /*! Unselects the selected shapes within the box. The packed boxes are
+    * never selected, so they are never found in the select list*/
+   class UnselectInBoxVisitor {
+   public:
+                        UnselectInBoxVisitor(DBbox& select_in, DataList* ssl, bool pntsel) :
+                           _selectIn(select_in), _ssl(ssl), _pntSel(pntsel) {}
+      bool              operator() (TdtData* wdt)
+      {
+         DataList::iterator DI = _ssl->begin();
+         while ( DI != _ssl->end() )
+            if ((wdt == DI->first) &&
+                (DI->first->unselect(_selectIn, *DI, _pntSel)))
+                  DI = _ssl->erase(DI);
+            else DI++;
+         return true;
+      }
+   private:
+      DBbox&            _selectIn;
+      DataList*         _ssl;
+      bool              _pntSel;
+   };
+
+   /*! Selects all shapes on the selectable layers within the box*/
+   class SelectInBoxVisitor {
+   public:
+                        SelectInBoxVisitor(DBbox& select_in, DataList* ssl, word layselmask, bool pntsel) :
+                           _selectIn(select_in), _ssl(ssl), _laySelMask(layselmask), _pntSel(pntsel) {}
+      bool              operator() (TdtData* wdt)
+      {
+         if (_laySelMask & wdt->lType())
+            wdt->selectInBox(_selectIn, _ssl, _pntSel);
+         return true;
+      }
+   private:
+      DBbox&            _selectIn;
+      DataList*         _ssl;
+      word              _laySelMask;
+      bool              _pntSel;
+   };
+
+   /*! Looks for the first selected shape which can be merged with the
+    * reference shape. The traversal stops with the first successful merge*/
+   class MergeVisitor {
+   public:
+                        MergeVisitor(TdtData* refShape) :
+                           _refShape(refShape), _overlapRef(refShape->overlap()),
+                           _mergeRes(NULL), _mergedWith(NULL) {}
+      bool              operator() (TdtData* wdt)
+      {
+         // for fully selected shapes if they overlap with the reference
+         // and this is not the same shape as the reference
+         if ((wdt != _refShape) &&
+             ((sh_selected == wdt->status()) || (sh_merged == wdt->status())) &&
+             (0ll != _overlapRef.cliparea(wdt->overlap())))
+         {
+            // go and merge it
+            _mergeRes = polymerge(wdt->shape2poly(), _refShape->shape2poly());
+            if (NULL != _mergeRes)
+            {
+               _mergedWith = wdt;
+               return false;
+            }
+         }
+         return true;
+      }
+      const DBbox&      overlapRef() const {return _overlapRef;}
+      TdtData*          mergeRes() const   {return _mergeRes;}
+      TdtData*          mergedWith() const {return _mergedWith;}
+   private:
+      TdtData*          _refShape;
+      DBbox             _overlapRef;
+      TdtData*          _mergeRes;
+      TdtData*          _mergedWith;
+   };
+
+   /*! Cuts the fully selected shapes with the polygon*/
+   class PolyCutVisitor {
+   public:
+                        PolyCutVisitor(PointVector& plst, const DBbox& cut_ovl, ShapeList** decure) :
+                           _plst(plst), _cutOvl(cut_ovl), _decure(decure) {}
+      bool              operator() (TdtData* wdt)
+      {
+         // for fully selected shapes if they overlap with the cutting polygon
+         if ((sh_selected == wdt->status()) &&
+                                       (0ll != _cutOvl.cliparea(wdt->overlap())))
+            // go and clip it
+            wdt->polyCut(_plst, _decure);
+         return true;
+      }
+   private:
+      PointVector&      _plst;
+      DBbox             _cutOvl;
+      ShapeList**       _decure;
+   };
+
+   /*! Draws the shapes of a cell which reference is moved*/
+   class MotionDrawVisitor {
+   public:
+                        MotionDrawVisitor(trend::TrendBase& rend) : _rend(rend) {}
+      bool              operator() (TdtData* wdt) {wdt->motionDraw(_rend, NULL); return true;}
+   private:
+      trend::TrendBase& _rend;
+   };
+
+   /*! Writes all shapes in a TDT file*/
+   class WriteVisitor {
+   public:
+                        WriteVisitor(OutputTdtFile* const tedfile) : _tedfile(tedfile) {}
+      bool              operator() (TdtData* wdt) {wdt->write(_tedfile); return true;}
+   private:
+      OutputTdtFile* const _tedfile;
+   };
+
+   /*! Exports all shapes in an external format*/
+   class ExportVisitor {
+   public:
+                        ExportVisitor(DbExportFile& exportf) : _exportf(exportf) {}
+      bool              operator() (TdtData* wdt) {wdt->dbExport(_exportf); return true;}
+   private:
+      DbExportFile&     _exportf;
+   };
+
+   /*! Feeds all shapes into the layer logic engine*/
+   class LogicVisitor {
+   public:
+                        LogicVisitor(const CTM& trans, logicop::LayerLogic& engine, byte operand) :
+                           _trans(trans), _engine(engine), _operand(operand) {}
+      bool              operator() (TdtData* wdt)
+      {
+         PointVector plist = wdt->shape2poly();
+         for (PointVector::iterator CP = plist.begin(); CP != plist.end(); CP++)
+            (*CP) *= _trans;
+         _engine.addPoly(plist, _operand);
+         return true;
+      }
+   private:
+      const CTM&        _trans;
+      logicop::LayerLogic& _engine;
+      byte              _operand;
+   };
+
+   /*! Selects all shapes of the types in the mask. The selected shapes must
+    * be real objects, so the packed boxes are rejected by the mask (see
+    * TdtCell::selectAllWrapper())*/
+   class SelectAllVisitor {
+   public:
+                        SelectAllVisitor(DataList* selist, word selmask, bool mark) :
+                           _selist(selist), _selMask(selmask), _mark(mark) {}
+      bool              operator() (TdtData* wdt)
+      {
+         if (_selMask & wdt->lType())
+         {
+            _selist->push_back(SelectDataPair(wdt,SGBitSet()));
+            if (_mark) wdt->setStatus(sh_selected);
+         }
+         return true;
+      }
+   private:
+      DataList*         _selist;
+      word              _selMask;
+      bool              _mark;
+   };
+
+   /*! Moves the shapes found in the src list to the dst list and selects them.
+    * The shapes in the src list are real objects, so the packed boxes never
+    * match them. The traversal stops when the src list is exhausted*/
+   class SelectFromListVisitor {
+   public:
+                        SelectFromListVisitor(DataList* src, DataList* dst) :
+                           _src(src), _dst(dst) {}
+      bool              operator() (TdtData* wdt)
+      {
+         // loop the objects from the select list
+         for (DataList::iterator DI = _src->begin(); DI != _src->end(); DI++)
+         {
+            // if the objects (pointer) coincides - that's our object
+            if (wdt == DI->first)
+            {
+               // select the object
+               if (DI->second.size() == wdt->numPoints()) {
+                  wdt->setStatus(sh_partsel);
+                  _dst->push_back(SelectDataPair(wdt,DI->second));
+               }
+               else {
+                  wdt->setStatus(sh_selected);
+                  _dst->push_back(SelectDataPair(wdt,SGBitSet()));
+               }
+               // remove it from the select list - it will speed up the
+               // following operations
+               _src->erase(DI);
+               break;
+            }
+         }
+         return !_src->empty();
+      }
+   private:
+      DataList*         _src;
+      DataList*         _dst;
+   };
+
+   /*! Collects the visible overlap of the cell references*/
+   class VisibleOverlapVisitor {
+   public:
+                        VisibleOverlapVisitor(const layprop::DrawProperties& prop, DBbox& vlOverlap) :
+                           _prop(prop), _vlOverlap(vlOverlap) {}
+      bool              operator() (TdtData* wdt) {wdt->vlOverlap(_prop, _vlOverlap); return true;}
+   private:
+      const layprop::DrawProperties& _prop;
+      DBbox&            _vlOverlap;
+   };
+}
+
 
 //=============================================================================
 laydata::EditObject::EditObject()
@@ -476,6 +702,8 @@ void laydata::TdtCell::openGlRender(trend::TrendBase& rend, const CTM& trans,
    // Draw figures
    for (LayerHolder::Iterator lay = _layers.begin(); lay != _layers.end(); lay++)
    {
+      // the view is obsolete - don't waste time on it
+      if (rend.cancelled()) break;
       //first - to check visibility of the layer
       if (rend.layerHidden(lay())) continue;
       //second - get internal layer number:
@@ -510,12 +738,12 @@ void laydata::TdtCell::openGlRender(trend::TrendBase& rend, const CTM& trans,
             {
                case -1: {// full overlap - conditional rendering
                   if ( !rend.chunkExists(curLayDef, (NULL != dlist)) )
-                     lay->openGlRender(rend, dlist);
+                     lay->openGlRender(rend, dlist, rend.drawprop()->lodRender());
                   break;
                }
                case  1: {//partial clip - render always
                   rend.setLayer(curLayDef, (NULL != dlist));
-                  lay->openGlRender(rend, dlist);
+                  lay->openGlRender(rend, dlist, rend.drawprop()->lodRender());
                   break;
                }
                default: assert(0 == cltype);
@@ -567,8 +795,8 @@ void laydata::TdtCell::motionDraw(trend::TrendBase& rend, const CTM& trans, bool
          {
             if (REF_LAY_DEF != lay())
                rend.setLayer(lay(), false);
-            for (QuadTree::DrawIterator CI = lay->begin(*(rend.drawprop()), rend.topCTM()); CI != lay->end(); CI++)
-               CI->motionDraw(rend, NULL);
+            MotionDrawVisitor motionVisitor(rend);
+            lay->drawVisible(rend, motionVisitor);
          }
       }
    }
@@ -577,11 +805,12 @@ void laydata::TdtCell::motionDraw(trend::TrendBase& rend, const CTM& trans, bool
 
 bool laydata::TdtCell::getShapeOver(TP pnt, const LayerDefSet& unselable)
 {
-   laydata::TdtData* shape = NULL;
+   PointOverVisitor pointOver(pnt);
+   DBbox pntBox(pnt);
    for (LayerHolder::Iterator lay = _layers.begin(); lay != _layers.end(); lay++)
       if ( (REF_LAY_DEF != lay())
           && (unselable.end() == unselable.find(lay()))
-          && lay->getObjectOver(pnt,shape)
+          && !lay->forEachInBox(pntBox, pointOver)
           )
          return true;
    return false;
@@ -606,6 +835,23 @@ laydata::AtticList* laydata::TdtCell::changeSelect(TP pnt, SH_STATUS status, con
          }
       }
    }
+   // The packed boxes are not selected, so they are candidates for selection
+   // only. If one of them wins - its layer is converted back to objects and
+   // the search is repeated
+   if (sh_selected == status)
+   {
+      for (LayerHolder::Iterator lay = _layers.begin(); lay != _layers.end(); lay++)
+      {
+         if (unselable.end() != unselable.find(lay())) continue;
+         const int4b* pbox = lay->getPackedBoxOver(pnt);
+         if (  (NULL != pbox)
+             &&((NULL == prev) || (prev->overlap().boxarea() > DBbox(pbox[0], pbox[1], pbox[2], pbox[3]).boxarea())))
+         {
+            lay->materialize();
+            return changeSelect(pnt, status, unselable);
+         }
+      }
+   }
    if (NULL != prev)
    {
       laydata::AtticList* retlist = DEBUG_NEW AtticList();
@@ -656,12 +902,30 @@ void laydata::TdtCell::mouseHoover(TP& position, trend::TrendBase& rend, const C
          }
       }
    }
-   if (NULL == prev) return;
+   // the packed boxes are highlighted straight from the packed block
+   const int4b* pbox = NULL;
+   for (LayerHolder::Iterator lay = _layers.begin(); lay != _layers.end(); lay++)
+   {
+      if (unselable.end() != unselable.find(lay())) continue;
+      const int4b* cbox = lay->getPackedBoxOver(position);
+      if (NULL == cbox) continue;
+      int8b carea = DBbox(cbox[0], cbox[1], cbox[2], cbox[3]).boxarea();
+      if (  ((NULL == prev) && (NULL == pbox))
+          ||((NULL != prev) && (prev->overlap().boxarea() > carea))
+          ||((NULL != pbox) && (DBbox(pbox[0], pbox[1], pbox[2], pbox[3]).boxarea() > carea)))
+      {
+         pbox = cbox; prev = NULL; prevlay = lay();
+      }
+   }
+   if ((NULL == prev) && (NULL == pbox)) return;
    assert(LayerDef(ERR_LAY_DEF) != prevlay);
    //
    rend.pushCell(_name, trans, _cellOverlap, true, false);
    rend.setHvrLayer(rend.getTenderLay(prevlay));
-   prev->drawSRequest(rend, NULL);
+   if (NULL != pbox)
+      rend.box(pbox, NULL); // the same as TdtBox::drawSRequest()
+   else
+      prev->drawSRequest(rend, NULL);
    rend.popCell();
 }
 
@@ -746,7 +1010,7 @@ void laydata::TdtCell::write(OutputTdtFile* const tedfile, const CellMap& allcel
       if (REF_LAY_DEF == lay())
       {
          tedfile->putByte(tedf_REFS);
-         for (QuadTree::Iterator DI = lay->begin(); DI != lay->end(); DI++)
+         for (QuadTree::Iterator DI = lay->begin(); DI != lay->end(); ++DI)
             DI->write(tedfile);
          tedfile->putByte(tedf_REFSEND);
       }
@@ -754,14 +1018,14 @@ void laydata::TdtCell::write(OutputTdtFile* const tedfile, const CellMap& allcel
       {
          tedfile->putByte(tedf_LAYER);
          tedfile->putLayer(lay());
-         for (QuadTree::Iterator DI = lay->begin(); DI != lay->end(); DI++)
-            DI->write(tedfile);
+         WriteVisitor writeVisitor(tedfile);
+         lay->forEach(writeVisitor);
          tedfile->putByte(tedf_LAYEREND);
       }
       else if (GRC_LAY_DEF == lay())
       {
          tedfile->putByte(tedf_GRC);
-         for (QuadTree::Iterator DI = lay->begin(); DI != lay->end(); DI++)
+         for (QuadTree::Iterator DI = lay->begin(); DI != lay->end(); ++DI)
             DI->write(tedfile);
          tedfile->putByte(tedf_GRCEND);
       }
@@ -809,8 +1073,8 @@ void laydata::TdtCell::dbExport(DbExportFile& exportf, const CellMap& allcells,
            (GRC_LAY_DEF != lay()) &&
            !exportf.layerSpecification(lay()))
          continue;
-      for (QuadTree::Iterator DI = lay->begin(); DI != lay->end(); DI++)
-         DI->dbExport(exportf);
+      ExportVisitor exportVisitor(exportf);
+      lay->forEach(exportVisitor);
    }
    exportf.definitionFinish();
 }
@@ -864,8 +1128,8 @@ DBbox laydata::TdtCell::getVisibleOverlap(const layprop::DrawProperties& prop)
       {
          if (REF_LAY_DEF == LCI())
          {
-            for(QuadTree::Iterator CS = LCI->begin(); CS != LCI->end(); CS++)
-               CS->vlOverlap(prop, vlOverlap);
+            VisibleOverlapVisitor overlapVisitor(prop, vlOverlap);
+            LCI->forEach(overlapVisitor);
          }
          else
             vlOverlap.overlap(LCI->overlap());
@@ -904,9 +1168,12 @@ void laydata::TdtCell::selectInBox(DBbox select_in, const LayerDefSet& unselable
                ssl = DEBUG_NEW DataList();
                newDLHolder = true;
             }
-            for (QuadTree::ClipIterator CI = lay->begin(select_in); CI != lay->end(); CI++)
-               if (layselmask & CI->lType())
-                  CI->selectInBox(select_in, ssl, pntsel);
+            // the selection list keeps pointers to the shapes, so the packed
+            // boxes must be converted to real objects first
+            if ((laydata::_lmbox & layselmask) && (0ll != select_in.cliparea(lay->overlap())))
+               lay->materialize();
+            SelectInBoxVisitor selectVisitor(select_in, ssl, layselmask, pntsel);
+            lay->forEachInBox(select_in, selectVisitor);
             if (ssl->empty())
             {
                delete ssl;
@@ -937,16 +1204,8 @@ void laydata::TdtCell::unselectInBox(DBbox select_in, bool pntsel, const LayerDe
 //               void laydata::QTreeTmpl<DataT>::unselectInBox(DBbox& unselect_in, TObjDataPairList* unselist,
 //                                                                                bool pselect)
                // check the entire holder for clipping...
-               for (QuadTree::ClipIterator CI = lay->begin(select_in); CI != lay->end(); CI++)
-               {
-                  // now start unselecting from the list
-                  DataList::iterator DI = ssl->begin();
-                  while ( DI != ssl->end() )
-                     if ((*CI == DI->first) &&
-                         (DI->first->unselect(select_in, *DI, pntsel)))
-                           DI = ssl->erase(DI);
-                     else DI++;
-               }
+               UnselectInBoxVisitor unselectVisitor(select_in, ssl, pntsel);
+               lay->forEachInBox(select_in, unselectVisitor);
 
 /*-----------------------------------------------------------------------------*/
                if (ssl->empty())
@@ -1386,15 +1645,8 @@ bool laydata::TdtCell::cutPolySelected(PointVector& plst, AtticList** dasao)
       // do the clipping
       QuadTree* curlay = _layers[CL()];
 //      _layers[CL.number()]->cutPolySelected(plst, cut_ovl, decure);
-      for (QuadTree::ClipIterator CI = curlay->begin(cut_ovl); CI != curlay->end(); CI++)
-      {
-//         DataT* wdt = _data[i];
-         // for fully selected shapes if they overlap with the cutting polygon
-         if ((sh_selected == CI->status()) &&
-                                       (0ll != cut_ovl.cliparea(CI->overlap())))
-            // go and clip it
-            CI->polyCut(plst, decure);
-      }
+      PolyCutVisitor cutVisitor(plst, cut_ovl, decure);
+      curlay->forEachInBox(cut_ovl, cutVisitor);
       // add the shapelists to the collection, but only if they are not empty
       for (i = 0; i < 3; i++)
       {
@@ -1432,6 +1684,43 @@ bool laydata::TdtCell::stretchSelected(int bfactor, AtticList** dasao)
    return !dasao[0]->empty();
 }
 
+/*! Feed the layer engine with all the shapes on layer laydef. The shapes are
+ * transformed with trans. If hier is true, the shapes in all referenced cells
+ * are added as well - i.e. the layer is flattened on the fly.*/
+void laydata::TdtCell::flatLogicData(const LayerDef& laydef, const CTM& trans, bool hier,
+                                     logicop::LayerLogic& engine, byte operand) const
+{
+   LayerHolder::Iterator wl = _layers.find(laydef);
+   if (_layers.end() != wl)
+   {
+      LogicVisitor logicVisitor(trans, engine, operand);
+      wl->forEach(logicVisitor);
+   }
+   if (!hier) return;
+   wl = _layers.find(REF_LAY_DEF);
+   if (_layers.end() == wl) return;
+   for (QuadTree::Iterator CI = wl->begin(); CI != wl->end(); ++CI)
+   {
+      TdtCellRef* cref = static_cast<TdtCellRef*>(*CI);
+      TdtCell* cstr = cref->cStructure();
+      // skip the references to undefined cells
+      if (NULL == cstr) continue;
+      ArrayProps arrprops = cref->arrayProps();
+      if (arrprops.valid())
+      {
+         for (word i = 0; i < arrprops.cols(); i++)
+            for (word j = 0; j < arrprops.rows(); j++)
+            {
+               CTM refCTM(arrprops.displ(i,j), 1, 0, false);
+               refCTM *= cref->translation();
+               cstr->flatLogicData(laydef, refCTM * trans, hier, engine, operand);
+            }
+      }
+      else
+         cstr->flatLogicData(laydef, cref->translation() * trans, hier, engine, operand);
+   }
+}
+
 bool laydata::TdtCell::mergeSelected(AtticList** dasao)
 {
    // for every single layer in the select list
@@ -1543,6 +1832,41 @@ void laydata::TdtCell::destroyThis(laydata::TdtLibDir* libdir, TdtData* ds, cons
    if (REF_LAY_DEF == laydef) updateHierarchy(libdir);
 }
 
+/*! Bulk version of destroyThis(). All shapes are unlinked from the layer in a
+ * single pass of its quad tree (see QTreeTmpl::deleteThese()) and deleted.
+ * The shapes which happen to be selected are dropped from the select list.*/
+void laydata::TdtCell::destroyThese(laydata::TdtLibDir* libdir, const ShapeList& shapes, const LayerDef& laydef)
+{
+   if (_layers.end() == _layers.find(laydef)) return;
+   laydata::QuadTree* lay = _layers[laydef];
+   QuadTree::TObjVector sorted(shapes.begin(), shapes.end());
+   std::sort(sorted.begin(), sorted.end());
+   if (_shapesel.end() != _shapesel.find(laydef))
+   {
+      DataList* lslct = _shapesel[laydef];
+      DataList::iterator CI = lslct->begin();
+      while (lslct->end() != CI)
+         if (std::binary_search(sorted.begin(), sorted.end(), CI->first))
+            CI = lslct->erase(CI);
+         else CI++;
+      if (lslct->empty())
+      {
+         delete lslct; _shapesel.erase(laydef);
+      }
+   }
+   if (lay->deleteThese(sorted))
+   {
+      if (lay->empty())
+      {
+         delete lay; _layers.erase(laydef);
+      }
+      else lay->validate();
+   }
+   for (ShapeList::const_iterator CS = shapes.begin(); CS != shapes.end(); CS++)
+      delete (*CS);
+   if (REF_LAY_DEF == laydef) updateHierarchy(libdir);
+}
+
 void laydata::TdtCell::selectAll(const LayerDefSet& unselable, word layselmask)
 {
    // This method might be called redundant, because the result of the
@@ -1940,12 +2264,16 @@ void laydata::TdtCell::transferLayer(SelectList* slst, const LayerDef& laydef)
    // so no need to refresh the overlapping box etc.
 }
 
-void laydata::TdtCell::fixUnsorted()
+/*! Sorts all the data put in the unsorted layers (see secureUnsortedLayer()).
+ * If pack is true - the resulting quad trees will be packed. See
+ * QTreeTmpl::pack() for details.
+ */
+void laydata::TdtCell::fixUnsorted(bool pack)
 {
    for (TmpLayerMap::Iterator lay = _tmpLayers.begin(); lay != _tmpLayers.end(); lay++)
    {
       if (0 != lay->numObjects())
-         lay->commit();
+         lay->commit(pack);
       else
       {
          LayerHolder::Iterator tlay = _layers.find(lay());
@@ -2237,82 +2565,48 @@ void laydata::TdtCell::collectUsedLays(const TdtLibDir* LTDB, bool recursive, La
          laylist.push_back(lay());
 }
 
+/*! Builds the LOD data of the layers which might be rendered in LOD mode (see
+ * openGlRender()). The reference layers are never rendered that way. */
+void laydata::TdtCell::buildLod()
+{
+   for(LayerHolder::Iterator lay = _layers.begin(); lay != _layers.end(); lay++)
+      if (lay.editable())
+         lay->buildLod();
+}
+
+/*! Selects all shapes of the types in selmask. The selected boxes must be
+ * real objects, so a packed tree is converted back to objects only if the
+ * boxes are selected. Otherwise the tree is traversed as it is.*/
 void laydata::TdtCell::selectAllWrapper(QuadTree* qtree, DataList* selist, word selmask, bool mark)
 {
    if (laydata::_lmnone == selmask) return;
-   for (QuadTree::Iterator CI = qtree->begin(); CI != qtree->end(); CI++)
-   {
-      if (selmask & CI->lType())
-      {
-         selist->push_back(SelectDataPair(*CI,SGBitSet()));
-         if (mark) CI->setStatus(sh_selected);
-      }
-   }
+   if (selmask & laydata::_lmbox)
+      qtree->materialize();
+   SelectAllVisitor selectVisitor(selist, selmask, mark);
+   qtree->forEach(selectVisitor);
 }
 
 laydata::TdtData* laydata::TdtCell::mergeWrapper(QuadTree* qtree, TdtData*& ref_shape)
 {
-   TdtData* mergeres = NULL;
-   DBbox overlapRef = ref_shape->overlap();
+   MergeVisitor mergeVisitor(ref_shape);
    // now start traversing the shapes in the current holder one by one
-   for (QuadTree::ClipIterator CI = qtree->begin(overlapRef); CI != qtree->end(); CI++)
-   {
-//      DataT* wdt = _data[i];
-      // for fully selected shapes if they overlap with the reference
-      // and this is not the same shape as the reference
-      if ((*CI != ref_shape) &&
-          ((sh_selected == CI->status()) || (sh_merged == CI->status())) &&
-          (0ll != overlapRef.cliparea(CI->overlap())))
-      {
-         // go and merge it
-         mergeres = polymerge(CI->shape2poly(), ref_shape->shape2poly());
-         if (NULL != mergeres)
-         {
-            // If the merge produce a result - return the result and
-            // substitute the ref_shape with its merged counterpart
-            ref_shape = *CI;
-            break;
-         }
-      }
+   if (!qtree->forEachInBox(mergeVisitor.overlapRef(), mergeVisitor))
+   {
+      // If the merge produce a result - return the result and
+      // substitute the ref_shape with its merged counterpart
+      ref_shape = mergeVisitor.mergedWith();
    }
-   return mergeres;
+   return mergeVisitor.mergeRes();
 }
 
 void laydata::TdtCell::selectFromListWrapper(QuadTree* qtree, DataList* src, DataList* dst)
 {
-   DataList::iterator DI;
    // loop the objects in the qTree first. It will be faster when there
-   // are no objects in the current QTreeTmpl
-   for (QuadTree::Iterator CI = qtree->begin(); CI != qtree->end(); CI++)
-   {
-      TdtData* wdt = *CI;
-      DI = src->begin();
-      // loop the objects from the select list
-      while ( DI != src->end())
-      {
-         // if the objects (pointer) coincides - that's out object
-         if (wdt == DI->first)
-         {
-            // select the object
-            if (DI->second.size() == wdt->numPoints()) {
-               wdt->setStatus(sh_partsel);
-               dst->push_back(SelectDataPair(wdt,DI->second));
-            }
-            else {
-               wdt->setStatus(sh_selected);
-               dst->push_back(SelectDataPair(wdt,SGBitSet()));
-            }
-            // remove it from the select list - it will speed up the following
-            // operations
-            DI = src->erase(DI);
-            // there is no point looping further, get the next object
-            break;
-         }
-         else DI++;
-      }
-   }
-//   for (byte i = 0; i < _props.numSubQuads(); i++)
-//      _subQuads[i]->selectFromList(src, dst);
+   // are no objects in the current QTreeTmpl. The tree is not converted to
+   // objects, because the packed boxes are never in the select list
+   if (src->empty()) return;
+   SelectFromListVisitor selectVisitor(src, dst);
+   qtree->forEach(selectVisitor);
 }
 
 auxdata::GrcCell* laydata::TdtCell::getGrcCell()
@@ -2324,7 +2618,7 @@ auxdata::GrcCell* laydata::TdtCell::getGrcCell()
       // of type TdtAuxRef
       unsigned numObjects = 0;
       QuadTree* wl = _layers[GRC_LAY_DEF];
-      for (QuadTree::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTree::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
       {
          theCell = static_cast<laydata::TdtAuxRef*>(*DI)->structure();
          numObjects++;
@@ -2343,7 +2637,7 @@ void laydata::TdtCell::clearGrcCell()
       // of type TdtAuxRef
       unsigned numObjects = 0;
       QuadTree* wl = _layers[GRC_LAY_DEF];
-      for (QuadTree::Iterator DI = wl->begin(); DI != wl->end(); DI++)
+      for (QuadTree::Iterator DI = wl->begin(); DI != wl->end(); ++DI)
       {
          delete *DI;
          numObjects++;
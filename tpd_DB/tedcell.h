@@ -113,6 +113,7 @@ namespace laydata {
          virtual void        write(OutputTdtFile* const, const CellMap&, const TDTHierTree*) const;
          virtual void        dbExport(DbExportFile&, const CellMap&, const TDTHierTree*) const;
          virtual void        collectUsedLays(const TdtLibDir*, bool, LayerDefList&) const;
+         virtual void        buildLod() {}
          virtual void        renameChild(std::string, std::string) {assert(false); /* TdTDefaultCell can not be renamed */}
          bool                checkLayer(const LayerDef&) const;
          void                setName(std::string nname) {_name = nname;}
@@ -166,18 +167,20 @@ namespace laydata {
       void                 transferSelected(const CTM&);
       void                 deleteSelected(AtticList*, laydata::TdtLibDir* );
       void                 destroyThis(TdtLibDir*, TdtData*, const LayerDef&);
+      void                 destroyThese(TdtLibDir*, const ShapeList&, const LayerDef&);
       AtticList*           groupPrep(TdtLibDir*);
       ShapeList*           ungroupPrep(TdtLibDir*);
       void                 transferLayer(const LayerDef&);
       void                 transferLayer(SelectList*, const LayerDef&);
 //      void                 resort();
-      void                 fixUnsorted();
+      void                 fixUnsorted(bool pack = false);
       bool                 validateCells(TdtLibrary*);
       void                 validateLayers();
       unsigned int         numSelected();
       bool                 cutPolySelected(PointVector&, AtticList**);
       bool                 mergeSelected(AtticList**);
       bool                 stretchSelected(int bfactor, AtticList**);
+      void                 flatLogicData(const LayerDef&, const CTM&, bool, logicop::LayerLogic&, byte) const;
       AtticList*           changeSelect(TP, SH_STATUS status, const LayerDefSet&);
       void                 mouseHoover(TP&, trend::TrendBase&, const CTM&, const LayerDefSet&);
       laydata::AtticList*  findSelected(TP);
@@ -189,6 +192,7 @@ namespace laydata {
       virtual void         relinkThis(std::string, laydata::CellDefin, laydata::TdtLibDir*);
       void                 reportSelected(real) const;
       virtual void         collectUsedLays(const TdtLibDir*, bool, LayerDefList&) const;
+      virtual void         buildLod();
       bool                 overlapChanged(DBbox&, TdtDesign*);
       virtual DBbox        getVisibleOverlap(const layprop::DrawProperties&);
       virtual void         renameChild(std::string, std::string);
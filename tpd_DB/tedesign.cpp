@@ -33,6 +33,7 @@
 #include "tedat.h"
 #include "viewprop.h"
 #include "tenderer.h"
+#include "thrdpool.h"
 
 extern layprop::PropertyCenter*  PROPC;
 
@@ -309,6 +310,12 @@ void laydata::TdtLibrary::collectUsedLays(LayerDefList& laylist) const
 //      laylist.pop_front();
 }
 
+void laydata::TdtLibrary::buildLod()
+{
+   for (CellMap::const_iterator CC = _cells.begin(); CC != _cells.end(); CC++)
+      CC->second->buildLod();
+}
+
 void laydata::TdtLibrary::dbHierAdd(const laydata::TdtDefaultCell* comp, const laydata::TdtDefaultCell* prnt)
 {
    assert(comp);
@@ -428,6 +435,7 @@ int laydata::TdtLibDir::loadLib(std::string filename)
    tempin.closeStream();
    addLibrary(tempin.design(), libRef);
    relink();// Re-link everything
+   if (NULL != _TEDDB) _TEDDB->markAllChanged();
    return libRef;
 }
 
@@ -445,6 +453,7 @@ bool laydata::TdtLibDir::unloadLib(std::string libname)
       reextractHierarchy();
       // after all above - remove the library
       delete tberased;
+      if (NULL != _TEDDB) _TEDDB->markAllChanged();
       return true;
    }
    else return false;
@@ -620,6 +629,16 @@ void laydata::TdtLibDir::relink()
       _TEDDB->relink(this);
 }
 
+/*! Builds the LOD data of all cells which might be rendered. Must be called
+ * with the DB locked and before the rendering, which only reads that data. */
+void laydata::TdtLibDir::buildLod()
+{
+   for (int i = _libdirectory.size() - 2; i > 0 ; i--)
+      _libdirectory[i]->second->buildLod();
+   if (NULL !=_TEDDB)
+      _TEDDB->buildLod();
+}
+
 void laydata::TdtLibDir::reextractHierarchy()
 {
    // parse starting from the back of the library queue
@@ -826,7 +845,8 @@ laydata::TdtDesign::TdtDesign(std::string name, time_t created, time_t lastUpdat
            real DBU, real UU)  :
    laydata::TdtDesign::TdtLibrary(name, DBU, UU, TARGETDB_LIB, created, lastUpdated),
    _tmpdata       ( NULL        ),
-   _modified      ( false       )
+   _modified      ( false       ),
+   _allChanged    ( true        )
 {}
 
 void laydata::TdtDesign::read(InputTdtFile* const tedfile)
@@ -843,6 +863,7 @@ laydata::TdtCell* laydata::TdtDesign::addCell(std::string name, laydata::TdtLibD
    if (_cells.end() != _cells.find(name)) return NULL; // cell already exists in the target library
    laydata::TdtDefaultCell* libcell = libdir->getLibCellDef(name);
    setModified();
+   markAllChanged();
    TdtCell* ncl = DEBUG_NEW TdtCell(name);
    _cells[name] = ncl;
    _hiertree = DEBUG_NEW TDTHierTree(ncl, NULL, _hiertree);
@@ -870,6 +891,7 @@ void laydata::TdtDesign::addThisCell(laydata::TdtCell* strdefn, laydata::TdtLibD
    std::string cname = strdefn->name();
    assert(_cells.end() == _cells.find(cname));
    setModified();
+   markAllChanged();
    // Check whether structure with this name exists in the libraries or among the
    // referenced, but undefined cells
    laydata::TdtDefaultCell* libcell = libdir->getLibCellDef(cname);
@@ -894,6 +916,7 @@ laydata::TdtCell* laydata::TdtDesign::removeTopCell(std::string& name, laydata::
    assert(NULL == _hiertree->GetMember(_cells[name])->Getparent());
 
    setModified();
+   markAllChanged();
    // get the cell by name
    TdtCell* remcl = static_cast<laydata::TdtCell*>(_cells[name]);
    //empty the contents of the removed cell and return it in AtticList
@@ -913,6 +936,7 @@ void laydata::TdtDesign::renameCell(TdtDefaultCell* targetCell, std::string newN
 {
    assert(NULL != targetCell);
    std::string oldName = targetCell->name();
+   markAllChanged();
    if (!targetCell->orphan())
    {
       for (CellMap::iterator CS = _cells.begin(); CS != _cells.end(); CS++)
@@ -930,6 +954,7 @@ void laydata::TdtDesign::renameCell(TdtDefaultCell* targetCell, std::string newN
 void laydata::TdtDesign::removeRefdCell(std::string& name, CellDefList& pcells, laydata::AtticList* fsel, laydata::TdtLibDir* libdir)
 {
    setModified();
+   markAllChanged();
    // get the cell by name
    TdtCell* remcl = static_cast<laydata::TdtCell*>(_cells[name]);
    // We need a replacement cell for the references
@@ -1005,6 +1030,24 @@ laydata::TdtData* laydata::TdtDesign::putBox(const LayerDef& laydef, TP* p1, TP*
    return newshape;
 }
 
+/*! Bulk version of putBox(). corners contains the two opposite corners of
+ * every box. All boxes are staged in the unsorted layer, so the quad tree is
+ * built once - when the layer is fixed (see fixUnsorted()). The new shapes are
+ * returned in newShapes.*/
+void laydata::TdtDesign::putBoxes(const LayerDef& laydef, const PointVector& corners, ShapeList& newShapes)
+{
+   if (corners.size() < 2) return;
+   QTreeTmp *actlay = _target.edit()->secureUnsortedLayer(laydef);
+   setModified();
+   CTM rartm(_target.rARTM());
+   for (unsigned i = 0; i + 1 < corners.size(); i += 2)
+   {
+      laydata::TdtData* newshape = DEBUG_NEW TdtBox(corners[i] * rartm, corners[i+1] * rartm);
+      actlay->put(newshape);
+      newShapes.push_back(newshape);
+   }
+}
+
 void laydata::TdtDesign::fixUnsorted()
 {
    TdtCell* editTarget = _target.edit();
@@ -1032,6 +1075,30 @@ void laydata::TdtDesign::setModified()
 {
    _modified = true;
    _lastUpdated = time(NULL);
+   markChanged();
+}
+
+/*! Records that the contents of cell has been changed. If cell is NULL - the
+ * current edit target is recorded. The renderers are keeping the data of the
+ * cells between the views (see trend::TenderCache) - this way they know what
+ * is not valid anymore (see takeChanged())*/
+void laydata::TdtDesign::markChanged(const TdtDefaultCell* cell)
+{
+   if (NULL == cell) cell = _target.edit();
+   if (NULL == cell) _allChanged = true;
+   else              _changedCells.insert(cell->name());
+}
+
+/*! Moves the names of the cells changed since the last call in cells. Returns
+ * true if all cells shall be considered changed - i.e. the cells were
+ * renamed, removed, or the design is new*/
+bool laydata::TdtDesign::takeChanged(NameSet& cells)
+{
+   bool allChanged = _allChanged;
+   cells.swap(_changedCells);
+   _changedCells.clear();
+   _allChanged = false;
+   return allChanged;
 }
 
 laydata::TdtData* laydata::TdtDesign::addPoly(const LayerDef& laydef, PointVector* pl)
@@ -1237,6 +1304,7 @@ laydata::TdtData* laydata::TdtDesign::addCellARef(std::string& name, CTM& ori,
 void laydata::TdtDesign::addList(AtticList* nlst, TdtCell* tCell)
 {
    TdtCell* targetCell = (NULL == tCell) ? _target.edit() : tCell;
+   markChanged(targetCell);
    DBbox old_overlap(targetCell->cellOverlap());
    targetCell->addList(this, nlst);
    fixReferenceOverlap(old_overlap, targetCell);
@@ -1304,13 +1372,60 @@ bool laydata::TdtDesign::editTop() {
    return _target.top();
 }
 
+//=============================================================================
+/*! Traverses the view cell for a layer job of the renderer (see
+ * trend::TrendBase::layerJob()). All jobs are traversing the entire hierarchy,
+ * but every one of them is collecting the data of its own layers only.*/
+class laydata::TdtDesign::RenderJob : public ThreadJob {
+   public:
+                              RenderJob(const TdtCell* view, trend::TrendBase* rend, bool isCell) :
+                                 _view(view), _rend(rend), _isCell(isCell) {}
+      virtual void            run()
+      {
+         const CTM unity;
+         _view->openGlRender(*_rend, unity, false, _isCell);
+      }
+      trend::TrendBase*       rend() const { return _rend; }
+   private:
+      const TdtCell*          _view;
+      trend::TrendBase*       _rend;
+      bool                    _isCell;
+};
+
 void laydata::TdtDesign::openGlRender(trend::TrendBase& rend)
 {
    if (_target.checkEdit())
    {
       const CTM unity;
+      unsigned numThreads = (0 == trend::TrendBase::threads()) ? ThreadPool::numCPUs()
+                                                              : trend::TrendBase::threads();
       rend.initDrawRefStack(_target.pEditChain());
-      _target.view()->openGlRender(rend, unity, false, _target.isCell());
+      // The layer jobs can't be used in edit in place mode (the reference
+      // stack in the DrawProperties is updated during the traversing) and
+      // with selected shapes (the offsets of the selected indexes are
+      // accumulated across the layers in the renderer)
+      if ((1 < numThreads) && (NULL == _target.pEditChain()) && (0 == numSelected()))
+      {
+         // Twice as many jobs as threads - the layers are not equal in size
+         word numJobs = 2 * numThreads;
+         ThreadPool::JobList jobs;
+         rend.setLayerJob(0, numJobs);
+         jobs.push_back(DEBUG_NEW RenderJob(_target.view(), &rend, _target.isCell()));
+         for (word jobIndex = 1; jobIndex < numJobs; jobIndex++)
+            jobs.push_back(DEBUG_NEW RenderJob(_target.view(), rend.layerJob(jobIndex, numJobs), _target.isCell()));
+         ThreadPool pool(numThreads);
+         pool.execute(jobs);
+         for (ThreadPool::JobList::const_iterator CJ = jobs.begin(); CJ != jobs.end(); CJ++)
+         {
+            RenderJob* rjob = static_cast<RenderJob*>(*CJ);
+            if (&rend != rjob->rend())
+               rend.mergeLayerJob(rjob->rend());
+            delete rjob;
+         }
+         rend.setLayerJob(0, 0);
+      }
+      else
+         _target.view()->openGlRender(rend, unity, false, _target.isCell());
       rend.clearDrawRefStack();
    }
 }
@@ -1434,6 +1549,7 @@ void laydata::TdtDesign::unselectInBox(TP* p1, TP* p2, const LayerDefSet& unsela
 
 void laydata::TdtDesign::copySelected( TP p1, TP p2)
 {
+   markChanged();
    CTM trans;
    DBbox old_overlap(_target.edit()->cellOverlap());
    p1 *= _target.rARTM();
@@ -1447,6 +1563,7 @@ void laydata::TdtDesign::copySelected( TP p1, TP p2)
 
 void laydata::TdtDesign::moveSelected( TP p1, TP p2, SelectList** fadead)
 {
+   markChanged();
    CTM trans;
    DBbox old_overlap(_target.edit()->cellOverlap());
    p1 *= _target.rARTM();
@@ -1478,8 +1595,64 @@ bool laydata::TdtDesign::stretch(int bfactor, AtticList** dasao)
    return _target.edit()->stretchSelected(bfactor, dasao);
 }
 
+/*! Logic operation between the entire layers la and lb of the active cell.
+ * If hier is true, the layers are flattened through the hierarchy. The result
+ * is returned in nshp in the target layer. The new shapes are not added to the
+ * cell here - it's up to the caller to do that (see addList)*/
+bool laydata::TdtDesign::layerLogic(logicop::LayLogicOp op, const LayerDef& la,
+      const LayerDef& lb, const LayerDef& target, bool hier, AtticList* nshp)
+{
+   logicop::LayerLogic engine;
+   _target.edit()->flatLogicData(la, CTM(), hier, engine, 0);
+   _target.edit()->flatLogicData(lb, CTM(), hier, engine, 1);
+   pcollection result;
+   engine.execute(op, result);
+   return layerLogicResult(engine, result, target, nshp);
+}
+
+/*! Size the entire layer src of the active cell with sizeval. Negative sizeval
+ * shrinks the layer. The rest - same as layerLogic*/
+bool laydata::TdtDesign::layerSize(const LayerDef& src, const LayerDef& target,
+      int4b sizeval, bool hier, AtticList* nshp)
+{
+   logicop::LayerLogic engine;
+   _target.edit()->flatLogicData(src, CTM(), hier, engine, 0);
+   pcollection result;
+   engine.size(sizeval, result);
+   return layerLogicResult(engine, result, target, nshp);
+}
+
+bool laydata::TdtDesign::layerLogicResult(const logicop::LayerLogic& engine, pcollection& result,
+      const LayerDef& target, AtticList* nshp)
+{
+   ShapeList* newShapes = DEBUG_NEW ShapeList();
+   for (pcollection::const_iterator CP = result.begin(); CP != result.end(); CP++)
+   {
+      laydata::ValidPoly check(**CP);
+      if (check.acceptable())
+      {
+         laydata::ShapeList* slist = check.replacements();
+         newShapes->splice(newShapes->end(), *slist);
+         delete slist;
+      }
+      delete (*CP);
+   }
+   std::ostringstream ost;
+   ost << engine.numVertices() << " vertices processed, "
+       << newShapes->size()     << " shapes generated";
+   tell_log(console::MT_INFO, ost.str());
+   if (newShapes->empty())
+   {
+      delete newShapes;
+      return false;
+   }
+   nshp->add(target, newShapes);
+   return true;
+}
+
 void laydata::TdtDesign::rotateSelected( TP p, real angle, SelectList** fadead)
 {
+   markChanged();
    // Things to remember...
    // To deal with edit in place, you have to :
    // - get the current translation matrix of the active cell
@@ -1501,6 +1674,7 @@ void laydata::TdtDesign::rotateSelected( TP p, real angle, SelectList** fadead)
 }
 
 void laydata::TdtDesign::flipSelected( TP p, bool Xaxis) {
+   markChanged();
    // Here - same principle as for rotateSelected
    // Otherwise flip toggles between X and Y depending on the angle
    // of rotation of the active cell reference
@@ -1516,6 +1690,7 @@ void laydata::TdtDesign::flipSelected( TP p, bool Xaxis) {
 void laydata::TdtDesign::deleteSelected(laydata::AtticList* fsel,
                                          laydata::TdtLibDir* libdir)
 {
+   markChanged();
    DBbox old_overlap(_target.edit()->cellOverlap());
    _target.edit()->deleteSelected(fsel, libdir);
    fixReferenceOverlap(old_overlap);
@@ -1523,11 +1698,20 @@ void laydata::TdtDesign::deleteSelected(laydata::AtticList* fsel,
 
 void laydata::TdtDesign::destroyThis(TdtData* ds, const LayerDef& laydef, laydata::TdtLibDir* libdir)
 {
+   markChanged();
    DBbox old_overlap(_target.edit()->cellOverlap());
    _target.edit()->destroyThis(libdir, ds, laydef);
    fixReferenceOverlap(old_overlap);
 }
 
+void laydata::TdtDesign::destroyThese(const ShapeList& shapes, const LayerDef& laydef, laydata::TdtLibDir* libdir)
+{
+   markChanged();
+   DBbox old_overlap(_target.edit()->cellOverlap());
+   _target.edit()->destroyThese(libdir, shapes, laydef);
+   fixReferenceOverlap(old_overlap);
+}
+
 bool laydata::TdtDesign::groupSelected(std::string name, laydata::TdtLibDir* libdir)
 {
    // first check that the cell with this name does not exist already
@@ -1578,12 +1762,14 @@ bool laydata::TdtDesign::groupSelected(std::string name, laydata::TdtLibDir* lib
 
 laydata::ShapeList* laydata::TdtDesign::ungroupPrep(laydata::TdtLibDir* libdir)
 {
+   markChanged();
    //unlink the selected ref/aref's from the QuadTree of the current cell
    return _target.edit()->ungroupPrep(libdir);
 }
 
 laydata::AtticList* laydata::TdtDesign::ungroupThis(laydata::ShapeList* cells4u)
 {
+   markChanged();
    laydata::AtticList* shapeUngr = DEBUG_NEW laydata::AtticList();
    for (ShapeList::const_iterator CC = cells4u->begin();
                                                      CC != cells4u->end(); CC++)
@@ -1616,6 +1802,7 @@ bool laydata::TdtDesign::checkValidRef(std::string newref)
 
 laydata::AtticList* laydata::TdtDesign::changeRef(ShapeList* cells4u, std::string newref)
 {
+   markChanged();
    assert(checkCell(newref));
    assert((!cells4u->empty()));
    laydata::ShapeList* cellsUngr = DEBUG_NEW laydata::ShapeList();
@@ -1669,11 +1856,13 @@ void laydata::TdtDesign::tryUnselectAll() const {
 
 void laydata::TdtDesign::transferLayer(const LayerDef& laydef)
 {
+   markChanged();
    _target.edit()->transferLayer(laydef);
 }
 
 void laydata::TdtDesign::transferLayer(laydata::SelectList* slst, const LayerDef& laydef)
 {
+   markChanged();
    _target.edit()->transferLayer(slst, laydef);
 }
 
@@ -29,6 +29,7 @@
 #define TEDESIGN_H_INCLUDED
 
 #include "tedcell.h"
+#include "laylogic.h"
 namespace laydata {
 
    class TdtLibrary {
@@ -49,6 +50,7 @@ namespace laydata {
       void              clearLib();
       void              cleanUnreferenced();
       void              collectUsedLays(LayerDefList&) const;
+      void              buildLod();
       void              dbHierAdd(const TdtDefaultCell*, const TdtDefaultCell*);
       void              dbHierAddParent(const TdtDefaultCell*, const TdtDefaultCell*);
       void              dbHierRemoveParent(TdtDefaultCell*, const TdtDefaultCell*, laydata::TdtLibDir*);
@@ -96,6 +98,7 @@ namespace laydata {
       void           removeRefdCell(std::string&, CellDefList&, laydata::AtticList*, laydata::TdtLibDir*);
       TdtData*       addBox(const LayerDef&, TP*, TP*);
       TdtData*       putBox(const LayerDef&, TP*, TP*);
+      void           putBoxes(const LayerDef&, const PointVector&, ShapeList&);
       TdtData*       addPoly(const LayerDef&, PointVector*);
       TdtData*       putPoly(const LayerDef&, PointVector*);
       TdtData*       addWire(const LayerDef&, PointVector*, WireWidth);
@@ -126,12 +129,15 @@ namespace laydata {
       void           flipSelected( TP p, bool Xaxis);
       void           deleteSelected(laydata::AtticList*, laydata::TdtLibDir*);
       void           destroyThis(TdtData*, const LayerDef&, laydata::TdtLibDir* );
+      void           destroyThese(const ShapeList&, const LayerDef&, laydata::TdtLibDir* );
       bool           groupSelected(std::string name, laydata::TdtLibDir*);
       ShapeList*     ungroupPrep(laydata::TdtLibDir*);
       AtticList*     ungroupThis(ShapeList*);
       bool           cutPoly(PointVector& pl, AtticList** dasao);
       bool           merge(AtticList** dasao);
       bool           stretch(int bfactor, AtticList** dasao);
+      bool           layerLogic(logicop::LayLogicOp, const LayerDef&, const LayerDef&, const LayerDef&, bool, AtticList*);
+      bool           layerSize(const LayerDef&, const LayerDef&, int4b, bool, AtticList*);
       unsigned int   numSelected() const;
       DBbox          activeOverlap();
       DBbox          getVisibleOverlap(layprop::DrawProperties&);
@@ -145,6 +151,9 @@ namespace laydata {
       void           fixUnsorted();
       void           fixReferenceOverlap(DBbox&, TdtCell* targetCell = NULL);
       void           setModified();
+      void           markChanged(const TdtDefaultCell* cell = NULL);
+      void           markAllChanged()   {_allChanged = true;}
+      bool           takeChanged(NameSet&);
       void           storeViewPort(const DBbox& vp)  {_target.storeViewPort(vp);}
       DBbox*         getLastViewPort() const  { return _target.getLastViewPort();}
       TdtCell*       targetECell()            {assert(_target.checkEdit()); return _target.edit();}
@@ -168,10 +177,14 @@ namespace laydata {
       bool           modified() const       {return _modified;}
       //
    private:
+      class RenderJob;
+      bool           layerLogicResult(const logicop::LayerLogic&, pcollection&, const LayerDef&, AtticList*);
       EditObject     _target;       //! edit/view target - introduced with pedit operations
       CTM            _tmpctm;
       TdtTmpData*    _tmpdata;      //! pointer to a data under construction - for view purposes
       bool           _modified;
+      NameSet        _changedCells; //! cells changed since the last takeChanged()
+      bool           _allChanged;   //! all cells shall be considered changed
    };
 
    /*! Library directory or Directory of libraries.
@@ -231,6 +244,7 @@ namespace laydata {
       bool              TDTcheckwrite(const TpdTime&, const TpdTime&, bool&);
       bool              TDTcheckread(const std::string filename, const TpdTime&, const TpdTime&, bool&);
       void              relink();
+      void              buildLod();
       void              reextractHierarchy();
       int               getLastLibRefNo();
       bool              getCellNamePair(std::string, laydata::CellDefin&);
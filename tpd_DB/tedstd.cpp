@@ -37,6 +37,13 @@
 #include "outbox.h"
 #include "tedesign.h"
 #include "auxdat.h"
+#include "thrdpool.h"
+#ifndef WIN32
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+   #include <fcntl.h>
+   #include <unistd.h>
+#endif
 
 //=============================================================================
 // class InputDBFile
@@ -48,11 +55,14 @@
  * of the class.
  * @param fileName - the fully qualified filename - OS dependent
  */
+bool InputDBFile::_mapInput = true;
+
 InputDBFile::InputDBFile( const wxString& fileName, bool forceSeek) :
       _inStream      (      NULL ),
       _gziped        (     false ),
       _ziped         (     false ),
       _forceSeek     ( forceSeek ),
+      _mapAddr       (      NULL ),
       _fileLength    (         0 ),
       _filePos       (         0 ),
       _progresPos    (         0 ),
@@ -142,22 +152,60 @@ InputDBFile::InputDBFile( const wxString& fileName, bool forceSeek) :
 
 bool InputDBFile::readStream(void* buffer, size_t len, bool updateProgress)
 {
+   if (mapped())
+   {
+      const byte* data = readMapped(len, updateProgress);
+      if (NULL == data) return false;
+      memcpy(buffer, data, len);
+      return true;
+   }
    _inStream->Read(buffer,len);// read record header
    size_t numread = _inStream->LastRead();
    if (numread != len)
       return false;// error during read in
+   advancePos(numread, updateProgress);
+   return true;
+}
+
+/*! Returns a pointer to the next len bytes of the mapped input file and
+ * advances the current file position. No data is copied - the result
+ * points directly in the mapped memory and remains valid until the file is
+ * unmapped. Returns NULL if there are less than len bytes till the end of
+ * the file.
+ */
+const byte* InputDBFile::readMapped(size_t len, bool updateProgress)
+{
+   assert(mapped());
+   if ((_filePos + (wxFileOffset)len) > _fileLength)
+      return NULL;
+   const byte* data = _mapAddr + _filePos;
+   advancePos(len, updateProgress);
+   return data;
+}
+
+void InputDBFile::advancePos(size_t numread, bool updateProgress)
+{
    // update file position
    _filePos += numread;
    // update progress indicator
+   if (updateProgress)
+      this->updateProgress(numread);
+   else
+      _progresPos += numread;
+}
+
+/*! Advances the progress indicator with numread bytes without changing the
+ * file position. Used by the readers which read ahead of the data they
+ * actually process*/
+void InputDBFile::updateProgress(size_t numread)
+{
    _progresPos += numread;
-   if (    updateProgress
-       && (_progresStep > 0)
+   if (    (_progresStep > 0)
        && (_progresStep < (_progresPos - _progresMark)))
    {
       _progresMark = _progresPos;
       TpdPost::toped_status(console::TSTS_PROGRESS, _progresMark);
    }
-   return true;
 }
 
 size_t InputDBFile::readTextStream(char* buffer, size_t len )
@@ -176,17 +224,68 @@ size_t InputDBFile::readTextStream(char* buffer, size_t len )
 //   return result;
    _inStream->Read(buffer,len);// read record header
    size_t numread = _inStream->LastRead();
-   // update file position
-   _filePos += numread;
-   // update progress indicator
-   _progresPos += numread;
-   if(   (_progresStep > 0)
-      && (_progresStep < (_progresPos - _progresMark)))
+   advancePos(numread, true);
+   return numread;
+}
+
+/*! Maps the input file in the memory. On success the input stream is closed
+ * and all subsequent reads (readStream(), readMapped()) are served directly
+ * from the mapped memory, which also makes the positioning in the file free.
+ * Compressed files are mapped only if they were already inflated in a
+ * temporary file. If the mapping fails for whatever reason (a file which
+ * doesn't fit in the address space for example), the input stream stays
+ * in place and the method returns false. The same happens if the mapping is
+ * switched off with setparams({"MAP_INPUT", "false"}) - for benchmarking.
+ */
+bool InputDBFile::mapStream()
+{
+   if (mapped()) return true;
+   if (!_mapInput) return false;
+   if ((NULL == _inStream) || (0 >= _fileLength)) return false;
+   wxString mapName;
+   if (_ziped || (_gziped && _forceSeek)) mapName = _tmpFileName;
+   else if (!_gziped)                     mapName = _fileName;
+   else                                   return false; // zlib stream is read as it is inflated
+   std::string fname(mapName.mb_str(wxConvFile));
+#ifdef WIN32
+   HANDLE fileH = CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+   if (INVALID_HANDLE_VALUE == fileH) return false;
+   HANDLE mapH = CreateFileMapping(fileH, NULL, PAGE_READONLY, 0, 0, NULL);
+   CloseHandle(fileH);
+   if (NULL == mapH) return false;
+   void* addr = MapViewOfFile(mapH, FILE_MAP_READ, 0, 0, 0);
+   CloseHandle(mapH);
+   if (NULL == addr) return false;
+#else
+   int fd = open(fname.c_str(), O_RDONLY);
+   if (-1 == fd) return false;
+   struct stat fstatus;
+   if ((0 != fstat(fd, &fstatus)) || (fstatus.st_size != _fileLength))
    {
-      _progresMark = _progresPos;
-      TpdPost::toped_status(console::TSTS_PROGRESS, _progresMark);
+      close(fd);
+      return false;
    }
-   return numread;
+   void* addr = mmap(NULL, _fileLength, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if (MAP_FAILED == addr) return false;
+   madvise(addr, _fileLength, MADV_SEQUENTIAL);
+#endif
+   _mapAddr = (const byte*)addr;
+   delete _inStream;
+   _inStream = NULL;
+   return true;
+}
+
+void InputDBFile::unmapStream()
+{
+   if (!mapped()) return;
+#ifdef WIN32
+   UnmapViewOfFile(_mapAddr);
+#else
+   munmap(const_cast<byte*>(_mapAddr), _fileLength);
+#endif
+   _mapAddr = NULL;
 }
 
 void InputDBFile::closeStream()
@@ -286,6 +385,7 @@ bool InputDBFile::unZlib2Temp()
 InputDBFile::~InputDBFile()
 {
    if (NULL != _inStream) delete _inStream;
+   unmapStream();
 }
 
 //-----------------------------------------------------------------------------
@@ -702,6 +802,12 @@ ForeignDbFile::ForeignDbFile(const wxString& fileName, bool forceSeek) : InputDB
 
 bool ForeignDbFile::reopenFile()
 {
+   if (mapped())
+   {
+      // the mapping is kept for the lifetime of the object - just rewind
+      initFileMetrics(_convLength);
+      return true;
+   }
    if (_gziped)
    {
       if (_forceSeek)
@@ -736,8 +842,11 @@ bool ForeignDbFile::reopenFile()
 
 void ForeignDbFile::setPosition(wxFileOffset filePos)
 {
-   wxFileOffset result = _inStream->SeekI(filePos, wxFromStart);
-   assert(wxInvalidOffset != result);
+   if (!mapped())
+   {
+      wxFileOffset result = _inStream->SeekI(filePos, wxFromStart);
+      assert(wxInvalidOffset != result);
+   }
    setFilePos(filePos);
 }
 
@@ -831,6 +940,115 @@ std::string ENameLayerCM::printSrcLayer() const
    return ostr.str();
 }
 //=============================================================================
+/*! A cell reference found during the staged import of a cell. The referenced
+ * cells are linked when the staged cells are registered in the target DB*/
+class ImportDB::StagedRef {
+   public:
+                              StagedRef(const std::string& name, const CTM& trans) :
+                                 _name(name), _trans(trans), _aref(false) {}
+                              StagedRef(const std::string& name, const CTM& trans,
+                                        const laydata::ArrayProps& aprop) :
+                                 _name(name), _trans(trans), _aprop(aprop), _aref(true) {}
+      std::string             _name  ;
+      CTM                     _trans ;
+      laydata::ArrayProps     _aprop ;
+      bool                    _aref  ;
+};
+
+//=============================================================================
+/*! Progress indicator shared by the cells imported concurrently. The status
+ * bar is updated only when the thread which created the object advances it -
+ * the worker threads just accumulate their progress*/
+class StagedProgress {
+   public:
+                              StagedProgress() : _position(0),
+                                 _owner(wxThread::GetCurrentId()) {}
+      void                    advance(wxFileOffset size)
+      {
+         wxMutexLocker lock(_mutex);
+         _position += size;
+         if (wxThread::GetCurrentId() == _owner)
+            TpdPost::toped_status(console::TSTS_PROGRESS, _position);
+      }
+   private:
+      wxMutex                 _mutex;
+      wxFileOffset            _position;
+      wxThreadIdType          _owner;
+};
+
+//=============================================================================
+/*! A cell imported concurrently with others. The cell is converted and its
+ * quad trees are sorted in a staging copy of the ImportDB which doesn't touch
+ * the target DB at all. The references are collected and linked later when
+ * the cell is registered (see ImportDB::convertConcurrent()).\n
+ * Note that nothing on this path shall use the GLU tessellator - it is a
+ * single global object. The polygons are tessellated on the first rendering
+ * (see TessellPoly::tessellate()). The messages logged during the import are
+ * captured and flushed by the calling thread when the cell is linked*/
+class ImportDB::StagedCell : public ThreadJob {
+   public:
+                              StagedCell(const ImportDB& parent, ForeignCell* src,
+                                         StagedProgress* progress) :
+                                 _iDB(parent), _src(src), _progress(progress),
+                                 _imported(false) {}
+      virtual void            run();
+      void                    link(laydata::TdtLibDir*);
+      void                    discard();
+      void                    flushLog()        { _log.flush();     }
+      ForeignCell*            src() const       { return _src;      }
+      bool                    imported() const  { return _imported; }
+   private:
+      ImportDB                _iDB;
+      ForeignCell*            _src;
+      StagedProgress*         _progress;
+      console::LogBuffer      _log;
+      bool                    _imported;
+};
+
+void ImportDB::StagedCell::run()
+{
+   console::LogCapture capture(_log);
+   try
+   {
+      _src->import(_iDB);
+      _iDB.completeCell();
+      _imported = true;
+      _progress->advance(_src->strSize());
+   }
+   // the failure is reported by convertConcurrent(), the cell is not imported
+   catch (EXPTN&) {_imported = false;}
+}
+
+void ImportDB::StagedCell::link(laydata::TdtLibDir* tdt_db)
+{
+   laydata::TdtCell* dstCell = _iDB._dst_structure;
+   StagedRefList* refs = _iDB._stagedRefs;
+   if (!refs->empty())
+   {
+      for (StagedRefList::iterator CR = refs->begin(); CR != refs->end(); CR++)
+      {
+         laydata::CellDefin strdefn = tdt_db->linkCellRef(CR->_name, TARGETDB_LIB);
+         if (CR->_aref)
+            dstCell->registerCellARef(strdefn, CR->_trans, CR->_aprop);
+         else
+            dstCell->registerCellRef(strdefn, CR->_trans);
+      }
+      dstCell->fixUnsorted(true);
+   }
+   (*tdt_db)()->registerCellRead(_src->strctName(), dstCell);
+}
+
+void ImportDB::StagedCell::discard()
+{
+   // the error structure is either deleted or added as a reference in the
+   // target cell already, so it goes together with it
+   if (!_imported && (NULL != _iDB._grc_structure)) delete _iDB._grc_structure;
+   delete _iDB._dst_structure;
+}
+
+//=============================================================================
+word ImportDB::_numThreads = 1;
+
 ImportDB::ImportDB(ForeignDbFile* src_lib, laydata::TdtLibDir* tdt_db, const LayerMapExt& theLayMap) :
       _src_lib       ( src_lib                                    ),
       _tdt_db        ( tdt_db                                     ),
@@ -838,7 +1056,8 @@ ImportDB::ImportDB(ForeignDbFile* src_lib, laydata::TdtLibDir* tdt_db, const Lay
       _grc_structure ( NULL                                       ),
       _dbuCoeff      ( src_lib->libUnits() / (*_tdt_db)()->DBU()  ),
       _crossCoeff    ( _dbuCoeff                                  ),
-      _technoSize    ( 0.0                                        )
+      _technoSize    ( 0.0                                        ),
+      _stagedRefs    ( NULL                                       )
 {
    _layCrossMap = DEBUG_NEW ENumberLayerCM(theLayMap);
 }
@@ -850,11 +1069,29 @@ ImportDB::ImportDB(ForeignDbFile* src_lib, laydata::TdtLibDir* tdt_db, const Imp
       _grc_structure ( NULL                                       ),
       _dbuCoeff      ( src_lib->libUnits() / (*_tdt_db)()->DBU()  ),
       _crossCoeff    ( _dbuCoeff                                  ),
-      _technoSize    ( techno                                     )
+      _technoSize    ( techno                                     ),
+      _stagedRefs    ( NULL                                       )
 {
    _layCrossMap = DEBUG_NEW ENameLayerCM(theLayMap);
 }
 
+/*! Creates a staging copy of the iDB which takes over its current target
+ * structures (see newCell()). It has its own layer cross map, and collects the
+ * cell references instead of linking them, so a number of staging copies can
+ * import cells simultaneously.*/
+ImportDB::ImportDB(const ImportDB& iDB) :
+      _layCrossMap   ( iDB._layCrossMap->clone()                  ),
+      _src_lib       ( iDB._src_lib                               ),
+      _tdt_db        ( iDB._tdt_db                                ),
+      _dst_structure ( iDB._dst_structure                         ),
+      _grc_structure ( iDB._grc_structure                         ),
+      _dbuCoeff      ( iDB._dbuCoeff                              ),
+      _crossCoeff    ( iDB._crossCoeff                            ),
+      _technoSize    ( iDB._technoSize                            ),
+      _stagedRefs    ( DEBUG_NEW StagedRefList()                  )
+{
+}
+
 void ImportDB::run(const NameList& top_str_names, bool overwrite, bool reopenFile)
 {
    if (!reopenFile || (reopenFile && _src_lib->reopenFile()))
@@ -862,10 +1099,16 @@ void ImportDB::run(const NameList& top_str_names, bool overwrite, bool reopenFil
       try
       {
          ForeignCellList wList = _src_lib->convList();
-         for (ForeignCellList::iterator CS = wList.begin(); CS != wList.end(); CS++)
+         unsigned numThreads = (0 == _numThreads) ? ThreadPool::numCPUs() : _numThreads;
+         if ((1 < numThreads) && (1 < wList.size()) && _src_lib->concurrentImport())
+            convertConcurrent(wList, overwrite, numThreads);
+         else
          {
-            convert(*CS, overwrite);
-            (*CS)->set_traversed(false); // restore the state for eventual second conversion
+            for (ForeignCellList::iterator CS = wList.begin(); CS != wList.end(); CS++)
+            {
+               convert(*CS, overwrite);
+               (*CS)->set_traversed(false); // restore the state for eventual second conversion
+            }
          }
          tell_log(console::MT_INFO, "Done");
       }
@@ -876,7 +1119,9 @@ void ImportDB::run(const NameList& top_str_names, bool overwrite, bool reopenFil
    }
 }
 
-void ImportDB::convert(ForeignCell* src_structure, bool overwrite)
+/*! Checks whether src_structure shall be imported and if so - creates the new
+ * target structures for it. Returns false if the cell shall be skipped. */
+bool ImportDB::newCell(ForeignCell* src_structure, bool overwrite)
 {
    std::string gname = src_structure->strctName();
    // check that destination structure with this name exists
@@ -895,25 +1140,94 @@ void ImportDB::convert(ForeignCell* src_structure, bool overwrite)
          ost << "Structure "<< gname << " already exists. Skipped";
          tell_log(console::MT_INFO,ost.str());
       }
+      return false;
    }
+   ost << "Importing " << gname << "...";
+   tell_log(console::MT_INFO,ost.str());
+   // create a new cell
+   _dst_structure = DEBUG_NEW laydata::TdtCell(gname);
+   _grc_structure = DEBUG_NEW auxdata::GrcCell(gname);
+   return true;
+}
+
+/*! Sorts the quad trees of the imported cell and attaches the error cell to it*/
+void ImportDB::completeCell()
+{
+   bool emptyCell = _grc_structure->fixUnsorted();
+   if (emptyCell)
+      delete _grc_structure;
    else
+      _dst_structure->addAuxRef(_grc_structure);
+   // imported data is rarely edited, so pack the quad trees
+   _dst_structure->fixUnsorted(true);
+}
+
+void ImportDB::convert(ForeignCell* src_structure, bool overwrite)
+{
+   if (!newCell(src_structure, overwrite)) return;
+   // call the cell converter
+   src_structure->import(*this);
+   // Sort the qtrees of the new cell
+   completeCell();
+   // and finally - register the cell
+   (*_tdt_db)()->registerCellRead(src_structure->strctName(), _dst_structure);
+}
+
+/*! The concurrent version of the conversion loop in run(). All cells in wList
+ * are imported on a pool of numThreads threads, each one in its own staging
+ * copy of this (see StagedCell). Then, in the original bottom-up order, the
+ * references of every cell are linked and the cell is registered in the target
+ * DB - the same way it would've been done by convert(). This way the result
+ * doesn't depend on the number of threads.\n
+ * If the import of a cell fails, the cells after it in the list are dropped as
+ * if the conversion was aborted at that point.*/
+void ImportDB::convertConcurrent(ForeignCellList& wList, bool overwrite, unsigned numThreads)
+{
+   ThreadPool::JobList jobs;
+   StagedProgress progress;
+   for (ForeignCellList::iterator CS = wList.begin(); CS != wList.end(); CS++)
    {
-      ost << "Importing " << gname << "...";
-      tell_log(console::MT_INFO,ost.str());
-      // first create a new cell
-      _dst_structure = DEBUG_NEW laydata::TdtCell(gname);
-      _grc_structure = DEBUG_NEW auxdata::GrcCell(gname);
-      // call the cell converter
-      src_structure->import(*this);
-      // Sort the qtrees of the new cell
-      bool emptyCell = _grc_structure->fixUnsorted();
-      if (emptyCell)
-         delete _grc_structure;
+      if (newCell(*CS, overwrite))
+         jobs.push_back(DEBUG_NEW StagedCell(*this, *CS, &progress));
+      else
+         (*CS)->set_traversed(false);
+   }
+   _dst_structure = NULL;
+   _grc_structure = NULL;
+   ThreadPool pool(numThreads);
+   pool.execute(jobs);
+   std::string failedCell;
+   unsigned    numDropped = 0;
+   for (ThreadPool::JobList::const_iterator CJ = jobs.begin(); CJ != jobs.end(); CJ++)
+   {
+      StagedCell* cell = static_cast<StagedCell*>(*CJ);
+      if (failedCell.empty() && cell->imported())
+      {
+         cell->flushLog();
+         cell->link(_tdt_db);
+      }
       else
-         _dst_structure->addAuxRef(_grc_structure);
-      _dst_structure->fixUnsorted();
-      // and finally - register the cell
-      (*_tdt_db)()->registerCellRead(gname, _dst_structure);
+      {
+         if (failedCell.empty())
+         {
+            cell->flushLog();
+            failedCell = cell->src()->strctName();
+         }
+         else
+            numDropped++;
+         cell->discard();
+      }
+      cell->src()->set_traversed(false); // restore the state for eventual second conversion
+      delete cell;
+   }
+   if (!failedCell.empty())
+   {
+      std::ostringstream ost;
+      ost << "Import of structure " << failedCell << " failed";
+      if (0 < numDropped)
+         ost << ". " << numDropped << " structure(s) after it dropped";
+      tell_log(console::MT_ERROR, ost.str());
+      throw EXPTN();
    }
 }
 
@@ -1008,19 +1322,24 @@ void ImportDB::addRef(std::string strctName, TP bPoint, double magnification,
                       double angle, bool reflection)
 {
    // @FIXME absolute magnification, absolute angle should be reflected somehow!!!
+   CTM location(bPoint, magnification, angle, reflection);
+   if (staging())
+   {
+      _stagedRefs->push_back(StagedRef(strctName, location));
+      return;
+   }
    laydata::CellDefin strdefn = _tdt_db->linkCellRef(strctName, TARGETDB_LIB);
-   _dst_structure->registerCellRef( strdefn,
-                                    CTM(bPoint,
-                                        magnification,
-                                        angle,
-                                        reflection
-                                       )
-                                  );
+   _dst_structure->registerCellRef( strdefn, location);
 }
 
 void ImportDB::addRef(std::string strctName, CTM location)
 {
    // @FIXME absolute magnification, absolute angle should be reflected somehow!!!
+   if (staging())
+   {
+      _stagedRefs->push_back(StagedRef(strctName, location));
+      return;
+   }
    laydata::CellDefin strdefn = _tdt_db->linkCellRef(strctName, TARGETDB_LIB);
    _dst_structure->registerCellRef( strdefn, location);
 }
@@ -1029,15 +1348,14 @@ void ImportDB::addARef(std::string strctName, TP bPoint, double magnification,
                       double angle, bool reflection, laydata::ArrayProps& aprop)
 {
    // @FIXME absolute magnification, absolute angle should be reflected somehow!!!
+   CTM location(bPoint, magnification, angle, reflection);
+   if (staging())
+   {
+      _stagedRefs->push_back(StagedRef(strctName, location, aprop));
+      return;
+   }
    laydata::CellDefin strdefn = _tdt_db->linkCellRef(strctName, TARGETDB_LIB);
-   _dst_structure->registerCellARef( strdefn,
-                                     CTM(bPoint,
-                                         magnification,
-                                         angle,
-                                         reflection
-                                        ),
-                                     aprop
-                                  );
+   _dst_structure->registerCellARef( strdefn, location, aprop);
 }
 
 bool ImportDB::polyAcceptable(PointVector& plist, bool& box)
@@ -1093,4 +1411,5 @@ bool ImportDB::pathAcceptable(PointVector& plist, int4b width )
 ImportDB::~ImportDB()
 {
    delete _layCrossMap;
+   if (NULL != _stagedRefs) delete _stagedRefs;
 }
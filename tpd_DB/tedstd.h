@@ -61,6 +61,7 @@ const byte TED_CUR_SUBREVISION  = 0x0B;
 
 namespace logicop {
    class  CrossFix;
+   class  LayerLogic;
 }
 
 namespace laydata {
@@ -191,18 +192,25 @@ class InputDBFile {
                            InputDBFile( const wxString& fileName, bool _forceSeek);
       virtual             ~InputDBFile();
       bool                 readStream(void*, size_t, bool updateProgress = false);
+      const byte*          readMapped(size_t, bool updateProgress = false);
       size_t               readTextStream(char*, size_t);
       void                 closeStream();
+      bool                 mapped() const                   { return (NULL != _mapAddr);}
+      const byte*          mapAddr() const                  { return _mapAddr;      }
       std::string          fileName()                       { return std::string(_fileName.mb_str(wxConvFile));}
       wxFileOffset         fileLength() const               { return _fileLength;   }
       wxFileOffset         filePos() const                  { return _filePos;      }
       bool                 status() const                   { return _status;       }
       void                 setStatus(bool stat)             {        _status = stat;}
+      static void          setMapInput(bool map)            {      _mapInput = map; }
    protected:
       void                 initFileMetrics(wxFileOffset);
       void                 setFilePos(wxFileOffset fp)      { _filePos = fp;     }
       bool                 unZlib2Temp();//! inflate the input zlib file in a temporary one
       bool                 unZip2Temp() ;//! inflate the input zip file in a temporary one
+      bool                 mapStream()  ;//! map the input file in the memory instead of streaming it
+      void                 unmapStream();
+      void                 updateProgress(size_t);
       wxInputStream*       _inStream    ;//! The input stream of the opened file
       bool                 _gziped      ;//! Indicates that the file is in compressed with gzip
       bool                 _ziped       ;//! Indicates that the file is in compressed with zip
@@ -210,6 +218,8 @@ class InputDBFile {
       wxString             _fileName    ;//! A fully validated name of the file. Path,extension, everything
       wxString             _tmpFileName ;//! The name of the eventually deflated file (if the input is compressed)
    private:
+      void                 advancePos(size_t, bool);
+      const byte*          _mapAddr     ;//! The start of the mapped input file (NULL if not mapped)
       wxFileOffset         _fileLength  ;//! The length of the file in bytes
       wxFileOffset         _filePos     ;//! Current position in the file
       wxFileOffset         _progresPos  ;//! Current position of the progress bar (Toped status line)
@@ -217,7 +227,7 @@ class InputDBFile {
       wxFileOffset         _progresStep ;//! Update step of the progress bar (Toped status line)
       unsigned const       _progresDivs ;//! Number of updates to the progress bar during the current operation
       bool                 _status      ;//! Used only in the constructor if the file can't be
-
+      static bool          _mapInput    ;//! The input files are mapped if possible (see mapStream())
 };
 
 //==============================================================================
@@ -331,6 +341,8 @@ class ForeignDbFile : public InputDBFile {
       virtual void         getTopCells(NameList&) const = 0;
       virtual void         getAllCells(wxListBox&) const = 0;
       virtual void         convertPrep(const NameList&, bool) = 0;
+      //! Can the cells be imported simultaneously (see ImportDB::convertConcurrent)
+      virtual bool         concurrentImport() const         { return false;      }
       // If you hit any of the asserts below - it most likely means that you're using wrong
       // combination of ForeignDbFile extend class type and parameters for this function call
       // ExtLayers is used for GDS/OASIS, NameList is used for CIF
@@ -384,6 +396,7 @@ class LayerCrossMap {
       virtual bool            mapTdtLay(laydata::TdtCell*,const std::string&)
                                                          {assert(false); return false;}
       virtual std::string     printSrcLayer() const      {assert(false); return std::string("");}
+      virtual LayerCrossMap*  clone() const              {assert(false); return NULL;}
    protected:
       LayerDef                _tdtLayNumber  ; //! Current layer number
       laydata::QTreeTmp*      _tmpLayer      ; //! Current target layer
@@ -396,6 +409,7 @@ class ENumberLayerCM : public LayerCrossMap {
                                  _extDataType(0) {}
       virtual bool            mapTdtLay(laydata::TdtCell*,word, word);
       virtual std::string     printSrcLayer() const;
+      virtual LayerCrossMap*  clone() const              {return DEBUG_NEW ENumberLayerCM(*this);}
    private:
       const LayerMapExt&      _layMap;
       word                    _extLayNumber;
@@ -408,6 +422,7 @@ class ENameLayerCM : public LayerCrossMap {
                                  _layMap(lmap), _extLayName("") {}
       virtual bool            mapTdtLay(laydata::TdtCell*, const std::string&);
       virtual std::string     printSrcLayer() const;
+      virtual LayerCrossMap*  clone() const              {return DEBUG_NEW ENameLayerCM(*this);}
    private:
       const ImpLayMap&         _layMap;
       std::string             _extLayName;
@@ -433,8 +448,18 @@ class ImportDB {
       ForeignDbFile*          srcFile()               { return _src_lib;   }
       real                    technoSize()            { return _technoSize;}
       real                    crossCoeff()            { return _crossCoeff;}
+      //! True if this is a staging copy used for concurrent import of a single cell
+      bool                    staging() const         { return (NULL != _stagedRefs);}
+      static void             setThreads(word threads){ _numThreads = threads;}
    protected:
+      class StagedRef;
+      class StagedCell;
+      typedef std::list<StagedRef>     StagedRefList;
+                              ImportDB(const ImportDB&);
+      bool                    newCell(ForeignCell*, bool);
+      void                    completeCell();
       void                    convert(ForeignCell*, bool);
+      void                    convertConcurrent(ForeignCellList&, bool, unsigned);
       bool                    polyAcceptable(PointVector&, bool&);
       bool                    pathAcceptable(PointVector&, int4b);
       LayerCrossMap*          _layCrossMap   ;
@@ -445,6 +470,8 @@ class ImportDB {
       real                    _dbuCoeff      ; //! The DBU ratio between the foreign and local DB
       real                    _crossCoeff    ; //! Current cross coefficient
       real                    _technoSize    ; //! technology size (used for conversion of some texts)
+      StagedRefList*          _stagedRefs    ; //! References in the staged cell - linked after the import
+      static word             _numThreads    ; //! Number of threads for concurrent import (0 - all CPUs)
 };
 
 
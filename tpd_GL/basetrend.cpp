@@ -39,8 +39,10 @@ trend::TrendTV::TrendTV(TrxCellRef* const refCell, bool filled, bool reusable,
                    unsigned parray_offset, unsigned iarray_offset) :
    _refCell             ( refCell         ),
    _num_total_strings   ( 0u              ),
+   _num_shapes          ( 0u              ),
    _filled              ( filled          ),
-   _reusable            ( reusable        )
+   _reusable            ( reusable        ),
+   _cached              ( false           )
 {
    for (int i = fqss; i <= ftss; i++)
    {
@@ -57,6 +59,7 @@ trend::TrendTV::TrendTV(TrxCellRef* const refCell, bool filled, bool reusable,
 void trend::TrendTV::registerBox (TrxCnvx* cobj)
 {
    unsigned allpoints = cobj->csize();
+   _num_shapes++;
    if (_filled)
    {
       _cnvx_data.push_back(cobj);
@@ -74,6 +77,7 @@ void trend::TrendTV::registerBox (TrxCnvx* cobj)
 void trend::TrendTV::registerPoly (TrxNcvx* cobj, const TessellPoly* tchain)
 {
    unsigned allpoints = cobj->csize();
+   _num_shapes++;
    if (_filled && tchain && tchain->valid())
    {
       cobj->setTeselData(tchain);
@@ -96,6 +100,7 @@ void trend::TrendTV::registerPoly (TrxNcvx* cobj, const TessellPoly* tchain)
 void trend::TrendTV::registerWire (TrxWire* cobj)
 {
    unsigned allpoints = cobj->csize();
+   _num_shapes++;
    _line_data.push_back(cobj);
    _alvrtxs[line] += cobj->lsize();
    _alobjvx[line]++;
@@ -121,8 +126,12 @@ void trend::TrendTV::registerWire (TrxWire* cobj)
 
 void trend::TrendTV::registerText (TrxText* cobj, TrxTextOvlBox* oobj)
 {
-   _text_data.push_back(cobj);
-   _num_total_strings++;
+   _num_shapes++;
+   if (NULL != cobj)
+   {// NULL if the text is too small to be read (see TrendBase::text)
+      _text_data.push_back(cobj);
+      _num_total_strings++;
+   }
    if (NULL != oobj)
    {
       _txto_data.push_back(oobj);
@@ -191,7 +200,9 @@ trend::TrendLay::TrendLay():
    _num_total_points     (          0u ),
    _num_total_indexs     (          0u ),
    _num_total_slctdx     (          0u ),
-   _num_total_strings    (          0u )
+   _num_total_strings    (          0u ),
+   _num_total_cached     (          0u ),
+   _tessel_time          (         0.0 )
 {
    for (int i = lstr; i <= lnes; i++)
    {
@@ -200,6 +211,38 @@ trend::TrendLay::TrendLay():
    }
 }
 
+/**
+ * Create a new reusable slice which data will be kept in the scene cache
+ * after this rendering view. Its vertexes are not counted in the totals of
+ * the layer, because the slice gets its own VBOs (see TenderCache)
+ */
+void trend::TrendLay::newCacheSlice(TrxCellRef* const ctrans, bool fill)
+{
+   newSlice(ctrans, fill, true);
+   _cslice->setCached();
+}
+
+/**
+ * Register a chunk from the scene cache as reusable in this view. The
+ * subsequent chunkExists() with the same cell name will find it.
+ */
+void trend::TrendLay::addCachedChunk(const std::string& cellName, TrendTV* chunk)
+{
+   assert(chunk->cached());
+   if (chunk->filled())
+   {
+      assert(_reusableFData.end() == _reusableFData.find(cellName));
+      _reusableFData[cellName] = chunk;
+   }
+   else
+   {
+      assert(_reusableCData.end() == _reusableCData.find(cellName));
+      _reusableCData[cellName] = chunk;
+   }
+   _num_total_cached  += chunk->num_total_points();
+   _num_total_strings += chunk->num_total_strings();
+}
+
 /** Add the current slice object (_cslice) to the list of slices _layData but
 only if it's not empty. Also track the total number of vertexes in the layer
 */
@@ -212,9 +255,17 @@ void trend::TrendLay::ppSlice()
       if ((num_points > 0) || (num_strings > 0))
       {
          _layData.push_back(_cslice);
-         _num_total_points  += num_points;
          _num_total_strings += num_strings;
-         _num_total_indexs  += _cslice->num_total_indexs();
+         if (_cslice->cached())
+         {
+            _cacheData.push_back(_cslice);
+            _num_total_cached  += num_points;
+         }
+         else
+         {
+            _num_total_points  += num_points;
+            _num_total_indexs  += _cslice->num_total_indexs();
+         }
          if (_cslice->reusable())
          {
             if (_cslice->filled())
@@ -261,6 +312,7 @@ void trend::TrendLay::box (const int4b* pdata, const SGBitSet* ss, const CTM& rm
 
 void trend::TrendLay::poly (const int4b* pdata, unsigned psize, const TessellPoly* tpoly)
 {
+   tessellate(pdata, psize, tpoly);
    _cslice->registerPoly(DEBUG_NEW TrxNcvx(pdata, psize), tpoly);
 }
 
@@ -271,6 +323,7 @@ void trend::TrendLay::poly (const PointVector& pdata, const CTM& rmm)
 
 void trend::TrendLay::poly (const int4b* pdata, unsigned psize, const TessellPoly* tpoly, const SGBitSet* ss)
 {
+   tessellate(pdata, psize, tpoly);
    TrxSNcvx* sobj = DEBUG_NEW TrxSNcvx(pdata, psize, ss);
    registerSPoly(sobj);
    _cslice->registerPoly(sobj, tpoly);
@@ -278,11 +331,44 @@ void trend::TrendLay::poly (const int4b* pdata, unsigned psize, const TessellPol
 
 void trend::TrendLay::poly (const int4b* pdata, unsigned psize, const TessellPoly* tpoly, const SGBitSet* ss, const CTM& rmm)
 {
+   tessellate(pdata, psize, tpoly);
    TrxSNcvx* sobj = DEBUG_NEW TrxSMNcvx(pdata, psize, ss, rmm);
    registerSPoly(sobj);
    _cslice->registerPoly(sobj, tpoly);
 }
 
+/*! The tessellation of the DB polygons is calculated on demand - only if they
+ * are going to be filled*/
+void trend::TrendLay::tessellate(const int4b* pdata, unsigned psize, const TessellPoly* tpoly)
+{
+   if ((NULL == tpoly) || !_cslice->filled()) return;
+   if (RenderStats::enabled())
+   {
+      wxStopWatch watch;
+      tpoly->tessellate(pdata, psize);
+      _tessel_time += RenderStats::elapsed(watch);
+   }
+   else
+      tpoly->tessellate(pdata, psize);
+}
+
+/*! The statistics of this layer for the frame profile (see RenderStats)*/
+trend::RenderStats::LayStats trend::TrendLay::layStats() const
+{
+   RenderStats::LayStats lstat;
+   for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
+   {
+      lstat._shapes += (*TLAY)->num_shapes();
+      lstat._chunks++;
+   }
+   lstat._reused   = _reLayData.size();
+   lstat._vertexes = _num_total_points;
+   lstat._indexes  = _num_total_indexs;
+   lstat._strings  = _num_total_strings;
+   lstat._tessel   = _tessel_time;
+   return lstat;
+}
+
 void trend::TrendLay::wire (int4b* pdata, unsigned psize, WireWidth width, bool center_only)
 {
    _cslice->registerWire(DEBUG_NEW TrxWire(pdata, psize, width, center_only));
@@ -324,9 +410,14 @@ void trend::TrendLay::text (const std::string* txt, const CTM& ftmtrx, const DBb
       cobj = DEBUG_NEW TrxTextOvlBox((*ovl) , ftmtrx);
    }
 
-   CTM ftm(ftmtrx.a(), ftmtrx.b(), ftmtrx.c(), ftmtrx.d(), 0, 0);
-   ftm.Translate(cor * ftmtrx);
-   _cslice->registerText(DEBUG_NEW TrxText(txt, ftm), cobj);
+   TrxText* tobj = NULL;
+   if (NULL != txt)
+   {
+      CTM ftm(ftmtrx.a(), ftmtrx.b(), ftmtrx.c(), ftmtrx.d(), 0, 0);
+      ftm.Translate(cor * ftmtrx);
+      tobj = DEBUG_NEW TrxText(txt, ftm);
+   }
+   _cslice->registerText(tobj, cobj);
 }
 
 
@@ -393,8 +484,14 @@ unsigned trend::TrendLay::total_slctdx()
 
 trend::TrendLay::~TrendLay()
 {
+   // the cached slices are owned by the scene cache - unless the view was
+   // dropped before they were passed to it (see cacheTaken())
    for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
+      if (!(*TLAY)->cached()) delete (*TLAY);
+   for (TrendTVList::const_iterator TLAY = _cacheData.begin(); TLAY != _cacheData.end(); TLAY++)
       delete (*TLAY);
+   // the current slice if the traversing was interrupted
+   if (NULL != _cslice) delete _cslice;
    for (TrendReTVList::const_iterator TLAY = _reLayData.begin(); TLAY != _reLayData.end(); TLAY++)
       delete (*TLAY);
 // not required?!
@@ -460,6 +557,13 @@ trend::TrendRefLay::~TrendRefLay()
 // class TrendMarks
 //
 
+void trend::TrendMarks::merge(TrendMarks& job)
+{
+   _refMarks.splice(_refMarks.end(), job._refMarks);
+   _textMarks.splice(_textMarks.end(), job._textMarks);
+   _arefMarks.splice(_arefMarks.end(), job._arefMarks);
+}
+
 unsigned trend::TrendMarks::total_points()
 {
    return ( _refMarks.size()
@@ -478,18 +582,26 @@ trend::TrendBase::TrendBase( layprop::DrawProperties* drawprop, real UU ) :
    _grcLayer             (      NULL ),
    _refLayer             (      NULL ),
    _cslctd_array_offset  (        0u ),
+   _cellArray            (           ),
+   _arrayClip            ( DEFAULT_OVL_BOX ),
    _activeCS             (      NULL ),
    _dovCorrection        (         0 ),
    _marks                (      NULL ),
    _rmm                  (      NULL ),
-   _num_grid_points      (        0u )
-
+   _num_grid_points      (        0u ),
+   _vlScale              (         1 ),
+   _cancelled            (     false ),
+   _jobIndex             (         0 ),
+   _numJobs              (         0 ),
+   _master               (      NULL )
 {
    // Initialize the cell (CTM) stack
    _cellStack.push(DEBUG_NEW TrxCellRef());
 
 }
 
+word trend::TrendBase::_numThreads = 1;
+
 void trend::TrendBase::setRmm(const CTM& mm)
 {
    _rmm = DEBUG_NEW CTM(mm.Reversed());
@@ -502,8 +614,19 @@ void trend::TrendBase::pushCell(std::string cname, const CTM& trans, const DBbox
                                           overlap,
                                           _cellStack.size()
                                          );
-   if (selected || (!_drawprop->cellBoxHidden()))
+   cRefBox->setCellArray(_cellArray);
+   if ((0 == _jobIndex) && (selected || (!_drawprop->cellBoxHidden())))
+   {
       _refLayer->addCellOBox(cRefBox, _cellStack.size(), selected);
+      // The shader draws only the layer data of the array elements. The
+      // overlapping boxes of the remaining ones are added here
+      for (unsigned i = 1; i < _cellArray.numElements(); i++)
+      {
+         CTM elCtm(cRefBox->ctm() * _cellArray.displ(i % _cellArray.cols(), i / _cellArray.cols()));
+         _refLayer->addCellOBox(DEBUG_NEW TrxCellRef(cname, elCtm, overlap, _cellStack.size()),
+                                _cellStack.size(), selected);
+      }
+   }
    else
       // This list is to keep track of the hidden cRefBox - so we can clean
       // them up. Don't get confused - we need cRefBox during the collecting
@@ -511,6 +634,8 @@ void trend::TrendBase::pushCell(std::string cname, const CTM& trans, const DBbox
       // poped-up from _cellStack. The confusion is coming from the "duality"
       // of the TrxCellRef - once as a cell reference with CTM, view depth etc.
       // and then as a placeholder of the overlapping reference box
+      // The same is valid for all cell references of the layer jobs - the
+      // reference boxes are handled by the main renderer only.
       _hiddenRefBoxes.push_back(cRefBox);
 
    _cellStack.push(cRefBox);
@@ -519,10 +644,42 @@ void trend::TrendBase::pushCell(std::string cname, const CTM& trans, const DBbox
       assert(NULL == _activeCS);
       _activeCS = cRefBox;
    }
-   else if (!_drawprop->cellMarksHidden())
+   else if ((0 == _jobIndex) && !_drawprop->cellMarksHidden())
    {
       _marks->addRefMark(overlap.p1(), _cellStack.top()->ctm());
-   }
+      for (unsigned i = 1; i < _cellArray.numElements(); i++)
+         _marks->addRefMark(overlap.p1(), _cellStack.top()->ctm()
+                            * _cellArray.displ(i % _cellArray.cols(), i / _cellArray.cols()));
+   }
+}
+
+/*! Starts the traversal of a cell array which is going to be expanded by the
+ * vertex shader. Only the first visible element of the array is traversed
+ * after this call - with a clip region which covers the visible region of all
+ * elements. All cell references pushed until popArray() get the array
+ * properties, so the layer chunks collected in them are drawn with one
+ * instanced draw for all cols x rows elements.
+ * Returns false if the renderer can't expand the array. The caller shall
+ * traverse the elements one by one in this case. Nested arrays are always
+ * traversed by the caller.
+ * @param trans the translation of the array reference
+ * @param colStep the column step of the array in the reference coordinates
+ * @param rowStep the row step of the array in the reference coordinates
+ * @param cols the number of visible columns
+ * @param rows the number of visible rows
+ */
+bool trend::TrendBase::pushArray(const CTM& trans, const TP& colStep, const TP& rowStep, word cols, word rows)
+{
+   if (!shaderArrays() || _cellArray.expanded() || (2 > cols * rows)) return false;
+   // the steps in the coordinates of the top cell
+   CTM actm(trans * topCTM());
+   _cellArray = TrxCellArray(cols, rows,
+                             actm.a() * colStep.x() + actm.c() * colStep.y(),
+                             actm.b() * colStep.x() + actm.d() * colStep.y(),
+                             actm.a() * rowStep.x() + actm.c() * rowStep.y(),
+                             actm.b() * rowStep.x() + actm.d() * rowStep.y());
+   _arrayClip = _cellArray.clipRegion(_drawprop->clipRegion());
+   return true;
 }
 
 void trend::TrendBase::grcpoly(int4b* pdata, unsigned psize)
@@ -573,6 +730,7 @@ void trend::TrendBase::grcwire (int4b* pdata, unsigned psize, WireWidth width)
 
 void trend::TrendBase::arefOBox(std::string cname, const CTM& trans, const DBbox& overlap, bool selected)
 {
+   if (0 != _jobIndex) return; // see pushCell()
    if (!_drawprop->cellMarksHidden())
    {
       _marks->addARefMark(overlap.p1(), trans * _cellStack.top()->ctm());
@@ -589,12 +747,21 @@ void trend::TrendBase::arefOBox(std::string cname, const CTM& trans, const DBbox
    }
 }
 
+/**
+ * Registers the text txt in the current layer. The texts which are too small
+ * to be read (see textReadable()) are culled here - only their overlapping box
+ * and their mark are registered if they are not hidden.
+ */
 void trend::TrendBase::text (const std::string* txt, const CTM& ftmtrx, const DBbox& ovl, const TP& cor, bool sel)
 {
+   if (!textReadable(ftmtrx)) txt = NULL;
    if (sel)
       _clayer->text(txt, ftmtrx, &ovl, cor, true);
    else if (_drawprop->textBoxHidden())
-      _clayer->text(txt, ftmtrx, NULL, cor, false);
+   {
+      if (NULL != txt)
+         _clayer->text(txt, ftmtrx, NULL, cor, false);
+   }
    else
       _clayer->text(txt, ftmtrx, &ovl, cor, false);
    if (!_drawprop->textMarksHidden())
@@ -608,6 +775,18 @@ void trend::TrendBase::textt(const std::string* txt, const CTM& ftmtrx, const TP
    _clayer->text(txt, ftmtrx*(*_rmm), NULL, cor, false);
 }
 
+/**
+ * Returns true if the height of the font with translation matrix ftmtrx (in
+ * the current cell) is at least DrawProperties::textLimit() pixels on the
+ * screen.
+ */
+bool trend::TrendBase::textReadable(const CTM& ftmtrx) const
+{
+   CTM sctm(ftmtrx * topCTM() * scrCTM());
+   real fsize = sqrt(fabs(sctm.a() * sctm.d() - sctm.b() * sctm.c())) * OPENGL_FONT_UNIT;
+   return (fsize >= _drawprop->textLimit());
+}
+
 bool trend::TrendBase::preCheckCRS(const laydata::TdtCellRef* ref, layprop::CellRefChainType& crchain)
 {
    crchain = _drawprop->preCheckCRS(ref);
@@ -626,6 +805,64 @@ bool trend::TrendBase::preCheckCRS(const laydata::TdtCellRef* ref, layprop::Cell
    return true;// Dummy statement - to prevent compiler warnings
 }
 
+/*! Returns a new renderer of the same type to traverse the layers with
+ * (number % numJobs) == jobIndex. The job 0 is always the main renderer
+ * itself - it handles the cell reference boxes and all the data which is not
+ * related to a particular layer. The frame must be the same regardless of the
+ * number of jobs - tll/traversebench.tll checks that (see RenderStats::digest())
+ * and reports the speedup of the traversing and the collecting.*/
+trend::TrendBase* trend::TrendBase::layerJob(word jobIndex, word numJobs)
+{
+   assert((0 < jobIndex) && (jobIndex < numJobs));
+   TrendBase* job = newLayerJob();
+   job->_master  = this;
+   job->_vlScale = _vlScale;
+   job->setLayerJob(jobIndex, numJobs);
+   return job;
+}
+
+/*! Takes over the data of a layer job after the traversing. The layer slices
+ * are referring to the cell references of the job, so they are taken over as
+ * well. The empty job is owned by this renderer after that. It is destroyed
+ * together with it, because the destructors of the openGL renderers must be
+ * called in the openGL thread.*/
+void trend::TrendBase::mergeLayerJob(TrendBase* job)
+{
+   assert(this == job->_master);
+   for (DataLay::Iterator CLAY = job->_data.begin(); CLAY != job->_data.end(); CLAY++)
+      _data.add(CLAY(), *CLAY);
+   job->_data.clear();
+   job->_clayer = NULL;
+   _hiddenRefBoxes.splice(_hiddenRefBoxes.end(), job->_hiddenRefBoxes);
+   assert(1 == job->_cellStack.size());
+   _hiddenRefBoxes.push_back(job->_cellStack.top());
+   job->_cellStack.pop();
+   job->_cellStack.push(DEBUG_NEW TrxCellRef());
+   _marks->merge(*job->_marks);
+   _layerJobs.push_back(job);
+}
+
+/*! Completes the profile of the frame with the statistics of the layers. The
+ * draw calls are counted since the last RenderStats::newFrame() */
+const trend::RenderStats& trend::TrendBase::frameStats()
+{
+   for (DataLay::Iterator CLAY = _data.begin(); CLAY != _data.end(); CLAY++)
+      _stats.setLayer(CLAY(), CLAY->layStats());
+   _stats.setDrawCalls();
+   return _stats;
+}
+
+bool trend::TrendBase::jobLayer(const LayerDef& laydef) const
+{
+   if (0 == _numJobs) return true;
+   switch (laydef.num())
+   {
+      case REF_LAY: return true;              // all jobs need the hierarchy
+      case GRC_LAY: return (0 == _jobIndex);
+      default     : return (_jobIndex == (laydef.num() % _numJobs));
+   }
+}
+
 void trend::TrendBase::cleanUp()
 {
    for (DataLay::Iterator CLAY = _data.begin(); CLAY != _data.end(); CLAY++)
@@ -707,6 +944,8 @@ void trend::TrendBase::genRulerMarks(const CTM& LayCTM, DBline& long_mark, DBlin
 
 trend::TrendBase::~TrendBase()
 {
+   for (TrendList::const_iterator CJ = _layerJobs.begin(); CJ != _layerJobs.end(); CJ++)
+      delete (*CJ);
    if (_refLayer) delete _refLayer;
    if (_marks)    delete _marks;
    if (_rmm)      delete _rmm;
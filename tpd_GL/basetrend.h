@@ -164,6 +164,7 @@
 
 #include <GL/glew.h>
 #include "trendat.h"
+#include "trendstat.h"
 // to cast properly the indices parameter in glDrawElements when
 // drawing from VBO
 #define VBO_BUFFER_OFFSET(i) ((char *)NULL + (i))
@@ -189,6 +190,9 @@ namespace trend {
                        , glslu_in_MStippleEn
                        , glslu_in_ScreenSize
                        , glslu_in_PatScale
+                       , glslu_in_ArrCols
+                       , glslu_in_ArrColStep
+                       , glslu_in_ArrRowStep
                       };
    enum glsl_Programs { glslp_NULL
                        ,glslp_VF  //! Vertex and Fragment (default)
@@ -341,12 +345,17 @@ namespace trend {
          virtual void      draw(layprop::DrawProperties*) = 0;
          virtual void      drawTexts(layprop::DrawProperties*) = 0;
          TrxCellRef*       swapRefCells(TrxCellRef*);
+         TrxCellRef*       refCell() const      {return _refCell;}
 
          unsigned          num_total_points();
          unsigned          num_total_indexs();
          unsigned          num_total_strings()  {return _num_total_strings;}
+         unsigned          num_shapes() const   {return _num_shapes;}
+         const TrendStrings& texts() const      {return _text_data;}
          bool              reusable() const     {return _reusable;}
          bool              filled() const       {return _filled;}
+         bool              cached() const       {return _cached;}
+         void              setCached()          {_cached = true;}
          std::string       cellName()           {return _refCell->name();}
       protected:
          virtual void      setAlpha(layprop::DrawProperties*);
@@ -366,8 +375,10 @@ namespace trend {
          unsigned          _alobjix[4]; //! array with the total number of objects that will be drawn with index related functions
          //
          unsigned          _num_total_strings;
+         unsigned          _num_shapes;
          bool              _filled;
          bool              _reusable;
+         bool              _cached;    //! The data is kept in the scene cache (see TenderCache)
    };
 
    /**
@@ -407,6 +418,8 @@ namespace trend {
          virtual          ~TrendReTV() {}
          virtual void      draw(layprop::DrawProperties*) = 0;
          virtual void      drawTexts(layprop::DrawProperties*) = 0;
+         TrendTV*          chunk() const  {return _chunk;}
+         TrxCellRef*       refCell() const{return _refCell;}
       protected:
          TrendTV*  const   _chunk;
          TrxCellRef* const _refCell;
@@ -531,6 +544,8 @@ namespace trend {
          virtual void      newSlice(TrxCellRef* const, bool, bool /*, bool, unsigned*/) = 0;
          virtual void      newSlice(TrxCellRef* const, bool, bool, unsigned slctd_array_offset) = 0;
          virtual bool      chunkExists(TrxCellRef* const, bool) = 0;
+         void              newCacheSlice(TrxCellRef* const, bool);
+         void              addCachedChunk(const std::string&, TrendTV*);
          void              ppSlice();
          virtual void      draw(layprop::DrawProperties*) = 0;
          virtual void      drawSelected() = 0;
@@ -541,8 +556,13 @@ namespace trend {
          unsigned          total_indexs() {return _num_total_indexs;}
          unsigned          total_slctdx();
          unsigned          total_strings(){return _num_total_strings;}
+         unsigned          total_cached() {return _num_total_cached;}
+         const TrendTVList& cacheData() const {return _cacheData;}
+         void              cacheTaken()   {_cacheData.clear();}
+         RenderStats::LayStats layStats() const;
 
       protected:
+         void              tessellate(const int4b*, unsigned, const TessellPoly*);
          void              registerSBox  (TrxSBox*);
          void              registerSPoly (TrxSNcvx*);
          void              registerSWire (TrxSWire*);
@@ -551,11 +571,14 @@ namespace trend {
          ReusableTTVMap    _reusableCData; // reusable contour chunks
          TrendTVList       _layData;
          TrendReTVList     _reLayData;
+         TrendTVList       _cacheData; //! New slices not passed to the scene cache yet (also listed in _layData)
          TrendTV*          _cslice;    //!Working variable pointing to the current slice
          unsigned          _num_total_points;
          unsigned          _num_total_indexs;
          unsigned          _num_total_slctdx;
          unsigned          _num_total_strings;
+         unsigned          _num_total_cached; //! Vertexes kept in the scene cache VBOs
+         double            _tessel_time;      //! Tessellation time in msec (see RenderStats)
          // Data related to selected objects
          SliceSelected     _slct_data;
          // index related data for selected objects
@@ -599,6 +622,7 @@ namespace trend {
          unsigned          total_points();
          virtual void      draw(layprop::DrawProperties*) = 0;
          virtual void      collect(GLuint)  { assert(false);}
+         void              merge(TrendMarks&);
       protected:
          typedef std::list<TP> PointList;
          PointList         _refMarks;
@@ -652,9 +676,17 @@ namespace trend {
       data collection or rendering view is invoked. The data gathered from the
       previous view must be considered invalid. The object structure created by
       this class is shown in the documentation of the module.
+      The data traversing doesn't make any openGL calls, so it can run in a
+      thread different from the one holding the openGL context. It can be
+      abandoned from another thread using cancel() - see DataCenter::renderAsync()
+      The traversing can be split between several threads by layers. Every
+      thread is filling-up its own renderer - a layer job (see layerJob()).
+      The layer jobs are merged into the main renderer before the collect()
+      phase (see mergeLayerJob()).
    */
    class TrendBase {
       public:
+         typedef std::list<TrendBase*> TrendList;
                            TrendBase( layprop::DrawProperties* drawprop, real UU );
          virtual          ~TrendBase();
          virtual void      setLayer(const LayerDef&, bool) = 0;
@@ -664,6 +696,8 @@ namespace trend {
          void              pushCell(std::string, const CTM&, const DBbox&, bool, bool);
          void              setRmm(const CTM&);
          void              popCell()                              {_cellStack.pop();}
+         bool              pushArray(const CTM&, const TP&, const TP&, word, word);
+         void              popArray()                             {_cellArray = TrxCellArray();}
          const CTM&        topCTM() const                         {return  _cellStack.top()->ctm();}
          void              box  (const int4b* pdata)              {_clayer->box(pdata);}
          void              box  (const int4b* pdata, const SGBitSet* ss){_clayer->box(pdata, ss);}
@@ -701,10 +735,10 @@ namespace trend {
          void              setState(layprop::PropertyState state)
                                                          {        _drawprop->setState(state)       ;}
          bool              layerHidden(const LayerDef& laydef) const
-                                                         {return _drawprop->layerHidden(laydef)    ;}
+                                                         {return _drawprop->layerHidden(laydef) || !jobLayer(laydef);}
          const CTM&        scrCTM() const                {return _drawprop->scrCtm()               ;}
-         word              visualLimit() const           {return _drawprop->visualLimit()          ;}
-         const DBbox&      clipRegion() const            {return _drawprop->clipRegion()           ;}
+         word              visualLimit() const           {return _drawprop->visualLimit() * _vlScale;}
+         const DBbox&      clipRegion() const            {return _cellArray.expanded() ? _arrayClip : _drawprop->clipRegion();}
          void              postCheckCRS(const laydata::TdtCellRef* ref)
                                                          {        _drawprop->postCheckCRS(ref)     ;}
          bool              preCheckCRS(const laydata::TdtCellRef*, layprop::CellRefChainType&);
@@ -716,7 +750,22 @@ namespace trend {
          void              setDrawProp(layprop::DrawProperties* drawprop)
                                                          {       _drawprop = drawprop              ;}
          bool              grcDataEmpty()                {return _grcData.empty()                  ;}
+         void              setCoarse(word vlScale)       {       _vlScale = vlScale                ;}
+         void              cancel()                      {       _cancelled = true                 ;}
+         bool              cancelled() const             {return _cancelled || ((NULL != _master) && _master->_cancelled);}
+         TrendBase*        layerJob(word, word);
+         void              mergeLayerJob(TrendBase*);
+         bool              textReadable(const CTM&) const;
+         void              setLayerJob(word jobIndex, word numJobs)
+                                                         {_jobIndex = jobIndex; _numJobs = numJobs ;}
+         RenderStats&      stats()                       {return _stats                            ;}
+         const RenderStats& frameStats();
+         static void       setThreads(word threads)      {_numThreads = threads                    ;}
+         static word       threads()                     {return _numThreads                       ;}
       protected:
+         virtual TrendBase* newLayerJob() = 0;
+         virtual bool      shaderArrays() const          {return false                             ;}
+         bool              jobLayer(const LayerDef&) const;
          virtual void      cleanUp();
          virtual void      grcCleanUp();
          virtual void      grdCleanUp();
@@ -734,6 +783,8 @@ namespace trend {
          TrendRefLay*      _refLayer;        //!All cell references with visible overlapping boxes
          CellStack         _cellStack;       //!Required during data traversing stage
          unsigned          _cslctd_array_offset; //! Current selected array offset
+         TrxCellArray      _cellArray;       //!The cell array expanded by the shader (see pushArray())
+         DBbox             _arrayClip;       //!The clip region of the first element of _cellArray
          //
          TrxCellRef*       _activeCS;
          byte              _dovCorrection;   //!Cell ref Depth of view correction (for Edit in Place purposes)
@@ -744,6 +795,14 @@ namespace trend {
          unsigned          _num_grid_points; //! Number of all points in all grids
 //         TrendGrids        _grids;           //!All grid points
          TrendStrings      _rulerTexts;      //!The labels on all rulers
+         word              _vlScale;         //!Visual limit multiplier (coarse views)
+         volatile bool     _cancelled;       //!The traversal was abandoned - the data is incomplete
+         word              _jobIndex;        //!The layers traversed by this renderer (if _numJobs > 0) ...
+         word              _numJobs;         //!... are the ones with (number % _numJobs) == _jobIndex
+         const TrendBase*  _master;          //!The renderer which is going to merge this layer job
+         TrendList         _layerJobs;       //!The merged layer jobs (empty)
+         RenderStats       _stats;           //!The profile of the frame (if enabled)
+         static word       _numThreads;      //!Number of threads for the data traversing (0 - all CPUs)
 
    };
 
@@ -538,6 +538,7 @@ layprop::DrawProperties::DrawProperties() :
    _curlay                ( TLL_LAY_DEF         ),
    _clipRegion            ( 0,0                 ),
    _visualLimit           ( 40                  ),
+   _textLimit             ( 8                   ),
    _cellDepthAlphaEbb     ( 0                   ),
    _cellDepthView         ( 0                   ),
    _cellMarksHidden       ( true                ),
@@ -545,6 +546,7 @@ layprop::DrawProperties::DrawProperties() :
    _textMarksHidden       ( true                ),
    _textBoxHidden         ( true                ),
    _adjustTextOrientation ( false               ),
+   _lodRender             ( false               ),
    _currentOp             ( console::op_none    ),
    _blockFill             ( false               ),
    _refStack              ( NULL                ),
@@ -554,6 +556,67 @@ layprop::DrawProperties::DrawProperties() :
 {
 }
 
+/*! A snapshot of the properties required for the rendering. The layer,
+ * colour, fill and line definitions are copied together with the view
+ * parameters, so the copy can be used by the background traversal without
+ * holding the property lock (see DataCenter::bgTraverse()). The rendering
+ * state (reference & CTM stacks, current layer) is not copied and neither
+ * is the layer status history.*/
+layprop::DrawProperties::DrawProperties(const DrawProperties& cobj) :
+   _curlay                ( cobj._curlay                ),
+   _clipRegion            ( cobj._clipRegion            ),
+   _scrCtm                ( cobj._scrCtm                ),
+   _visualLimit           ( cobj._visualLimit           ),
+   _textLimit             ( cobj._textLimit             ),
+   _cellDepthAlphaEbb     ( cobj._cellDepthAlphaEbb     ),
+   _cellDepthView         ( cobj._cellDepthView         ),
+   _cellMarksHidden       ( cobj._cellMarksHidden       ),
+   _cellBoxHidden         ( cobj._cellBoxHidden         ),
+   _textMarksHidden       ( cobj._textMarksHidden       ),
+   _textBoxHidden         ( cobj._textBoxHidden         ),
+   _adjustTextOrientation ( cobj._adjustTextOrientation ),
+   _lodRender             ( cobj._lodRender             ),
+   _currentOp             ( cobj._currentOp             ),
+   _blockFill             ( false                       ),
+   _refStack              ( NULL                        ),
+   _drawingLayer          ( TLL_LAY_DEF                 ),
+   _drawingLayerValid     ( false                       ),
+   _propertyState         ( cobj._propertyState         )
+{
+   for (LaySetList::Iterator LSI = cobj._laySetDb.begin(); LSI != cobj._laySetDb.end(); LSI++)
+      _laySetDb.add(LSI(), DEBUG_NEW LayerSettings(*(*LSI)));
+   for (LaySetList::Iterator LSI = cobj._laySetDrc.begin(); LSI != cobj._laySetDrc.end(); LSI++)
+      _laySetDrc.add(LSI(), DEBUG_NEW LayerSettings(*(*LSI)));
+   for (LaySetList::Iterator LSI = cobj._laySetScr.begin(); LSI != cobj._laySetScr.end(); LSI++)
+      _laySetScr.add(LSI(), DEBUG_NEW LayerSettings(*(*LSI)));
+   for (ColorMap::const_iterator CMI = cobj._layColorsDb.begin(); CMI != cobj._layColorsDb.end(); CMI++)
+      _layColorsDb[CMI->first] = DEBUG_NEW tellRGB(*(CMI->second));
+   for (ColorMap::const_iterator CMI = cobj._layColorsScr.begin(); CMI != cobj._layColorsScr.end(); CMI++)
+      _layColorsScr[CMI->first] = DEBUG_NEW tellRGB(*(CMI->second));
+   for (FillMap::const_iterator FMI = cobj._layFillDb.begin(); FMI != cobj._layFillDb.end(); FMI++)
+   {
+      byte* ptrn = DEBUG_NEW byte[128];
+      memcpy(ptrn, FMI->second, 128);
+      _layFillDb[FMI->first] = ptrn;
+   }
+   for (FillMap::const_iterator FMI = cobj._layFillScr.begin(); FMI != cobj._layFillScr.end(); FMI++)
+   {
+      byte* ptrn = DEBUG_NEW byte[128];
+      memcpy(ptrn, FMI->second, 128);
+      _layFillScr[FMI->first] = ptrn;
+   }
+   for (LineMap::const_iterator LMI = cobj._lineSetDb.begin(); LMI != cobj._lineSetDb.end(); LMI++)
+      _lineSetDb[LMI->first] = DEBUG_NEW LineSettings(*(LMI->second));
+   for (LineMap::const_iterator LMI = cobj._lineSetScr.begin(); LMI != cobj._lineSetScr.end(); LMI++)
+      _lineSetScr[LMI->first] = DEBUG_NEW LineSettings(*(LMI->second));
+   // point to the copies of the current property set
+   _layCurSet    = (cobj._layCurSet    == &cobj._laySetScr   ) ? &_laySetScr    :
+                   (cobj._layCurSet    == &cobj._laySetDrc   ) ? &_laySetDrc    : &_laySetDb;
+   _layCurColors = (cobj._layCurColors == &cobj._layColorsScr) ? &_layColorsScr : &_layColorsDb;
+   _layCurFill   = (cobj._layCurFill   == &cobj._layFillScr  ) ? &_layFillScr   : &_layFillDb;
+   _lineCurSet   = (cobj._lineCurSet   == &cobj._lineSetScr  ) ? &_lineSetScr   : &_lineSetDb;
+}
+
 bool layprop::DrawProperties::addLayer( const LayerDef& laydef )
 {
    if (_layCurSet->end() != _layCurSet->find(laydef))
@@ -262,6 +262,7 @@ namespace layprop {
    class DrawProperties {
       public:
                                     DrawProperties();
+                                    DrawProperties(const DrawProperties&);
                                    ~DrawProperties();
          // Called during the rendering - protected in the render initialisation
          bool                       setCurrentColor(const LayerDef&, layprop::tellRGB&);
@@ -278,6 +279,7 @@ namespace layprop {
          void                       setState (PropertyState state);
          const CTM&                 scrCtm() const       {return  _scrCtm;}
          word                       visualLimit() const  {return _visualLimit;}
+         word                       textLimit() const    {return _textLimit;}
          const DBbox&               clipRegion() const   {return _clipRegion;}
          void                       initCtmStack()       {_tranStack.push(CTM(_clipRegion.p1(), _clipRegion.p2()));}
          void                       clearCtmStack()      {while (!_tranStack.empty()) _tranStack.pop();}
@@ -295,6 +297,7 @@ namespace layprop {
                                                          {return _cellMarksHidden;}
          bool                       adjustTextOrientation() const
                                                          {return _adjustTextOrientation;}
+         bool                       lodRender() const    {return _lodRender;}
          byte                       cellDepthView()      {return _cellDepthView;}
 
          const byte*                ref_mark_bmp()       {return _ref_mark_bmp ;}
@@ -310,6 +313,8 @@ namespace layprop {
          void                       setScrCTM(CTM ScrCTM){_scrCtm = ScrCTM;}
          void                       setVisualLimit(word mva)
                                                          {_visualLimit = mva;}
+         void                       setTextLimit(word mts)
+                                                         {_textLimit = mts;}
          void                       setCellDepthAlphaEbb(byte ebb)
                                                          {_cellDepthAlphaEbb = ebb;}
          void                       setCellDepthView(byte dov)
@@ -346,6 +351,7 @@ namespace layprop {
          void                       setTextboxHidden(bool hide)      {_textBoxHidden = hide;}
          void                       setAdjustTextOrientation(bool ori)
                                                                      {_adjustTextOrientation = ori;}
+         void                       setLodRender(bool lod)           {_lodRender = lod;}
          void                       defaultLayer(LayerDef layno)     {_curlay = layno;}
          LayerDef                   curLay() const                   {return _curlay;}
 
@@ -394,6 +400,7 @@ namespace layprop {
          DBbox                      _clipRegion;
          CTM                        _scrCtm;
          word                       _visualLimit;   // that would be 40 pixels
+         word                       _textLimit;     // minimal readable text height in pixels
          byte                       _cellDepthAlphaEbb;
          byte                       _cellDepthView; //
          bool                       _cellMarksHidden;
@@ -401,6 +408,7 @@ namespace layprop {
          bool                       _textMarksHidden;
          bool                       _textBoxHidden;
          bool                       _adjustTextOrientation;
+         bool                       _lodRender;     // small quad tree nodes rendered from their LOD tiles
          console::ACTIVE_OP         _currentOp;    //
          bool                       _blockFill;
          laydata::CellRefStack*     _refStack;
@@ -0,0 +1,169 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Off-screen rendering (frame buffer object)
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include <stdio.h>
+#include <math.h>
+#include <sstream>
+#include "offscreen.h"
+#include "outbox.h"
+
+//=============================================================================
+trend::OffScreen::OffScreen(word width, word height) :
+   _width         ( width  ),
+   _height        ( height ),
+   _frameBuffer   ( 0      ),
+   _colorBuffer   ( 0      ),
+   _status        ( false  ),
+   _bound         ( false  )
+{
+   if (0 == glewIsSupported("GL_EXT_framebuffer_object"))
+   {
+      tell_log(console::MT_ERROR,"Off-screen rendering requires GL_EXT_framebuffer_object");
+      return;
+   }
+   GLint maxSize;
+   glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE_EXT, &maxSize);
+   if ((0 == _width) || (0 == _height) || (maxSize < _width) || (maxSize < _height))
+   {
+      std::ostringstream info;
+      info << "Off-screen image size must be between 1 and " << maxSize << " pixels";
+      tell_log(console::MT_ERROR,info.str());
+      return;
+   }
+   glGenFramebuffersEXT(1, &_frameBuffer);
+   glGenRenderbuffersEXT(1, &_colorBuffer);
+   glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, _colorBuffer);
+   glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, _width, _height);
+   glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, 0);
+   glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, _frameBuffer);
+   glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+                                GL_RENDERBUFFER_EXT, _colorBuffer);
+   _status = (GL_FRAMEBUFFER_COMPLETE_EXT == glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT));
+   glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+   if (!_status)
+      tell_log(console::MT_ERROR,"Can't create an off-screen frame buffer");
+}
+
+/*! Redirects the drawing to the off-screen buffer and sets the view port to
+ * its size. The current view port is saved and restored by release()*/
+void trend::OffScreen::bind()
+{
+   assert(_status && !_bound);
+   glGetIntegerv(GL_VIEWPORT, _viewPort);
+   glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, _frameBuffer);
+   glViewport(0, 0, _width, _height);
+   _bound = true;
+}
+
+void trend::OffScreen::release()
+{
+   if (!_bound) return;
+   glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+   glViewport(_viewPort[0], _viewPort[1], _viewPort[2], _viewPort[3]);
+   _bound = false;
+}
+
+/*! Returns the contents of the buffer - 3 bytes per pixel in BGR order, rows
+ * from the bottom up, i.e. ready for a targa file. The caller takes the
+ * ownership of the returned array. Must be called while the buffer is bound*/
+byte* trend::OffScreen::pixels() const
+{
+   assert(_bound);
+   byte* image = DEBUG_NEW byte[3 * (unsigned long)_width * _height];
+   glPixelStorei(GL_PACK_ALIGNMENT  , 1);
+   glPixelStorei(GL_PACK_ROW_LENGTH , 0);
+   glPixelStorei(GL_PACK_SKIP_ROWS  , 0);
+   glPixelStorei(GL_PACK_SKIP_PIXELS, 0);
+   glReadBuffer(GL_COLOR_ATTACHMENT0_EXT);
+   glReadPixels(0, 0, _width, _height, GL_BGR_EXT, GL_UNSIGNED_BYTE, image);
+   return image;
+}
+
+trend::OffScreen::~OffScreen()
+{
+   release();
+   if (0 != _colorBuffer) glDeleteRenderbuffersEXT(1, &_colorBuffer);
+   if (0 != _frameBuffer) glDeleteFramebuffersEXT(1, &_frameBuffer);
+}
+
+//=============================================================================
+/*! Writes an uncompressed 24 bit targa file. image is expected in the format
+ * returned by glReadPixels(..., GL_BGR_EXT, GL_UNSIGNED_BYTE, ...) */
+bool trend::saveTarga(const std::string& fileName, const byte* image, word width, word height)
+{
+   // Note the pragmas below. It won't create a proper targa file without them!
+#pragma pack(push,1)
+   typedef struct {
+      byte   identsize;              // Size of ID field that follows header (0)
+      byte   colorMapType;           // 0 = None, 1 = paletted
+      byte   imageType;              // 0 = none, 1 = indexed, 2 = rgb, 3 = grey, +8=rle
+      word   colorMapStart;          // First colour map entry
+      word   colorMapLength;         // Number of colors
+      byte   colorMapBits;           // bits per palette entry
+      word   xstart;                 // image x origin
+      word   ystart;                 // image y origin
+      word   width;                  // width in pixels
+      word   height;                 // height in pixels
+      byte   bits;                   // bits per pixel (8 16, 24, 32)
+      byte   descriptor;             // image descriptor
+   } TargaHeader;
+#pragma pack(pop)
+   if (NULL == image) return false;
+   FILE* tFile = fopen(fileName.c_str() , "wb");
+   if (NULL == tFile) return false;
+   // Initialize the Targa header
+   TargaHeader tHdr = {0, 0, 2, 0, 0, 0, 0, 0, width, height, 24, 0 };
+   //Save first the targa header and then - the data
+   fwrite(&tHdr, sizeof(TargaHeader), 1, tFile);
+   fwrite(image, 3 * (unsigned long)width * height, 1, tFile);
+   fclose(tFile);
+   return true;
+}
+
+/*! Returns the layout translation matrix which fits the view in a window with
+ * size width x height (in pixels)*/
+CTM trend::fitView(const DBbox& view, double width, double height)
+{
+   double w = fabs((double)view.p1().x() - (double)view.p2().x());
+   double h = fabs((double)view.p1().y() - (double)view.p2().y());
+   if (w > (double) MAX_INT4B)
+   {
+      tell_log(console::MT_WARNING, "Can't zoom any further");
+      w = MAX_INT4B;
+   }
+   if (h > (double) MAX_INT4B)
+   {
+      tell_log(console::MT_WARNING, "Can't zoom any further");
+      h = MAX_INT4B;
+   }
+   double sc =  ((width/height < w/h) ? w/width : h/height);
+//   sc = (0 == sc) ? 1.0 : sc;
+   double tx = (((double)view.p1().x() + (double)view.p2().x()) - width*sc) / 2;
+   double ty = (((double)view.p1().y() + (double)view.p2().y()) - height*sc) / 2;
+   CTM layCTM( sc, 0.0, 0.0, sc, tx, ty);
+   layCTM.FlipX(((double)view.p1().y() + (double)view.p2().y())/2);  // flip Y coord towards the center
+   return layCTM;
+}
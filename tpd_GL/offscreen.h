@@ -0,0 +1,86 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Off-screen rendering (frame buffer object)
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef OFFSCREEN_H_INCLUDED
+#define OFFSCREEN_H_INCLUDED
+
+#include <string>
+#include <GL/glew.h>
+#include "ttt.h"
+
+namespace trend {
+
+   /**
+    * An off-screen render target - an openGL frame buffer object with a single
+    * colour render buffer. While the object is bound, all the drawing goes to
+    * it instead of the canvas, so a view of arbitrary size can be rendered by
+    * the normal rendering pipeline regardless of the size (or the visibility)
+    * of the canvas window. The result is read back with pixels().\n
+    * It requires GL_EXT_framebuffer_object which is available on practically
+    * all openGL implementations including the software ones (Mesa).
+    * All methods must be called by the thread holding the openGL context.
+    */
+   class OffScreen {
+      public:
+                           OffScreen(word width, word height);
+                          ~OffScreen();
+         bool              status() const    {return _status;}
+         void              bind();
+         void              release();
+         byte*             pixels() const;
+         word              width() const     {return _width;}
+         word              height() const    {return _height;}
+      private:
+         word              _width;
+         word              _height;
+         GLuint            _frameBuffer;
+         GLuint            _colorBuffer;
+         GLint             _viewPort[4];  //! the view port to be restored by release()
+         bool              _status;
+         bool              _bound;
+   };
+
+   /**
+    * An off-screen rendering request for the canvas (see tui::ZOOM_OFFSCREEN).
+    * The requester fills-in the view and the output file and waits until the
+    * canvas is done. The canvas returns the frame profile.
+    */
+   struct OffScreenView {
+                           OffScreenView(const DBbox& view, word width, word height,
+                                          const std::string& fileName) :
+                              _view(view), _width(width), _height(height),
+                              _fileName(fileName) {}
+      DBbox                _view;      //! the view in DB units
+      word                 _width;     //! image width in pixels
+      word                 _height;    //! image height in pixels
+      std::string          _fileName;  //! targa file. Empty - no image
+      std::string          _stats;     //! frame profile (JSON). Empty - not rendered
+   };
+
+   bool saveTarga(const std::string& fileName, const byte* image, word width, word height);
+   CTM  fitView(const DBbox& view, double width, double height);
+
+}
+
+#endif //OFFSCREEN_H_INCLUDED
@@ -30,9 +30,38 @@
 #include "tenderer.h"
 #include "viewprop.h"
 #include "trend.h"
+#include "thrdpool.h"
 
 extern trend::TrendCenter*        TRENDC;
 
+//=============================================================================
+// The minimum number of points collected by a single CollectJob. The smaller
+// layers are collected in the openGL thread directly.
+static const unsigned COLLECT_JOB_POINTS = 0x10000;
+
+/*! Copies the data of a range of slices of a layer into the mapped VBOs. Every
+ * slice has its own place in the buffers (see TrendTV::_point_array_offset),
+ * so the jobs of the same layer are not overlapping.*/
+class CollectJob : public ThreadJob {
+public:
+                        CollectJob(trend::TrendLay::TrendTVList::const_iterator first,
+                                   trend::TrendLay::TrendTVList::const_iterator last,
+                                   TNDR_GLDATAT* point_array, unsigned int* index_array) :
+                           _first(first), _last(last), _point_array(point_array),
+                           _index_array(index_array) {}
+   virtual void         run()
+   {
+      for (trend::TrendLay::TrendTVList::const_iterator TLAY = _first; TLAY != _last; TLAY++)
+         if (!(*TLAY)->cached())
+            (*TLAY)->collect(_point_array, _index_array);
+   }
+private:
+   trend::TrendLay::TrendTVList::const_iterator _first;
+   trend::TrendLay::TrendTVList::const_iterator _last;
+   TNDR_GLDATAT*        _point_array;
+   unsigned int*        _index_array;
+};
+
 //=============================================================================
 //
 // class TenderTV
@@ -41,7 +70,9 @@ trend::TenderTV::TenderTV(TrxCellRef* const refCell, bool filled, bool reusable,
                    unsigned parray_offset, unsigned iarray_offset) :
    TrendTV(refCell, filled, reusable, parray_offset, iarray_offset),
    _point_array_offset  ( parray_offset   ),
-   _index_array_offset  ( iarray_offset   )
+   _index_array_offset  ( iarray_offset   ),
+   _pbuffer             ( 0u              ),
+   _ibuffer             ( 0u              )
 {
    for (int i = fqss; i <= ftss; i++)
    {
@@ -223,6 +254,45 @@ void trend::TenderTV::collect(TNDR_GLDATAT* point_array, unsigned int* index_arr
    }
 }
 
+/**
+ * Collects the data of a cached chunk. Unlike the other chunks it is not a
+ * part of the layer VBOs - it gets its own buffers, so it can outlive the
+ * current rendering view.
+ */
+void trend::TenderTV::collectCache()
+{
+   assert(_cached);
+   assert((0u == _pbuffer) && (0u == _ibuffer));
+   unsigned num_points = num_total_points();
+   unsigned num_indexs = num_total_indexs();
+   if (0 == num_points) return; // texts only
+   _point_array_offset = 0u;
+   _index_array_offset = 0u;
+   TNDR_GLDATAT* cpoint_array = NULL;
+   unsigned int* cindex_array = NULL;
+   glGenBuffers(1, &_pbuffer);
+   glBindBuffer(GL_ARRAY_BUFFER, _pbuffer);
+   glBufferData(GL_ARRAY_BUFFER                       ,
+                2 * num_points * sizeof(TNDR_GLDATAT) ,
+                NULL                                  ,
+                GL_STATIC_DRAW                        );
+   cpoint_array = (TNDR_GLDATAT*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+   if (0 < num_indexs)
+   {
+      glGenBuffers(1, &_ibuffer);
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibuffer);
+      glBufferData(GL_ELEMENT_ARRAY_BUFFER           ,
+                   num_indexs * sizeof(unsigned)     ,
+                   NULL                              ,
+                   GL_STATIC_DRAW                    );
+      cindex_array = (unsigned int*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+   }
+   collect(cpoint_array, cindex_array);
+   glUnmapBuffer(GL_ARRAY_BUFFER);
+   if (0 < num_indexs)
+      glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+}
+
 void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
 {
    // First - deal with openGL translation matrix
@@ -239,6 +309,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
       assert(_firstvx[line]);
       assert(_sizesvx[line]);
       glMultiDrawArrays(GL_LINE_STRIP, _firstvx[line], _sizesvx[line], _alobjvx[line]);
+      RenderStats::drawCalls();
    }
    if  (_alobjvx[cnvx] > 0)
    {// Draw convex polygons
@@ -246,6 +317,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
       assert(_sizesvx[cnvx]);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx[cnvx], _sizesvx[cnvx], _alobjvx[cnvx]);
       glMultiDrawArrays(GL_QUADS, _firstvx[cnvx], _sizesvx[cnvx], _alobjvx[cnvx]);
+      RenderStats::drawCalls(2);
    }
    if  (_alobjvx[ncvx] > 0)
    {// Draw non-convex polygons
@@ -253,6 +325,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
       assert(_firstvx[ncvx]);
       assert(_sizesvx[ncvx]);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx[ncvx], _sizesvx[ncvx], _alobjvx[ncvx]);
+      RenderStats::drawCalls();
       if (_alobjix[fqss] > 0)
       {
          assert(_sizesix[fqss]);
@@ -261,6 +334,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
          // The suspect is (const GLvoid**)_firstix[fqss] but it's quite possible that it is a driver bug
          // Besides - everybody is saying that there is no speed benefit from this operation
          //glMultiDrawElements(GL_QUAD_STRIP    , _sizesix[fqss], GL_UNSIGNED_INT, (const GLvoid**)_firstix[fqss], _alobjix[fqss]);
+         RenderStats::drawCalls(_alobjix[fqss]);
          for (unsigned i= 0; i < _alobjix[fqss]; i++)
             glDrawElements(GL_QUAD_STRIP, _sizesix[fqss][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[fqss][i]));
       }
@@ -269,6 +343,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
          assert(_sizesix[ftrs]);
          assert(_firstix[ftrs]);
          //glMultiDrawElements(GL_TRIANGLES     , _sizesix[ftrs], GL_UNSIGNED_INT, (const GLvoid**)_firstix[ftrs], _alobjix[ftrs]);
+         RenderStats::drawCalls(_alobjix[ftrs]);
          for (unsigned i= 0; i < _alobjix[ftrs]; i++)
             glDrawElements(GL_TRIANGLES, _sizesix[ftrs][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftrs][i]));
       }
@@ -277,6 +352,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
          assert(_sizesix[ftfs]);
          assert(_firstix[ftfs]);
          //glMultiDrawElements(GL_TRIANGLE_FAN  , _sizesix[ftfs], GL_UNSIGNED_INT, (const GLvoid**)_firstix[ftfs], _alobjix[ftfs]);
+         RenderStats::drawCalls(_alobjix[ftfs]);
          for (unsigned i= 0; i < _alobjix[ftfs]; i++)
             glDrawElements(GL_TRIANGLE_FAN, _sizesix[ftfs][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftfs][i]));
       }
@@ -285,6 +361,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
          assert(_sizesix[ftss]);
          assert(_firstix[ftss]);
          //glMultiDrawElements(GL_TRIANGLE_STRIP, _sizesix[ftss], GL_UNSIGNED_INT, (const GLvoid**)_firstix[ftss], _alobjix[ftss]);
+         RenderStats::drawCalls(_alobjix[ftss]);
          for (unsigned i= 0; i < _alobjix[ftss]; i++)
             glDrawElements(GL_TRIANGLE_STRIP, _sizesix[ftss][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftss][i]));
       }
@@ -295,6 +372,7 @@ void trend::TenderTV::draw(layprop::DrawProperties* drawprop)
       assert(_firstvx[cont]);
       assert(_sizesvx[cont]);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx[cont], _sizesvx[cont], _alobjvx[cont]);
+      RenderStats::drawCalls();
    }
    // Switch the vertex buffers OFF in the openGL engine ...
    glDisableClientState(GL_VERTEX_ARRAY);
@@ -341,6 +419,9 @@ trend::TenderTV::~TenderTV()
    if (NULL != _firstix[ftrs]) delete [] _firstix[ftrs];
    if (NULL != _firstix[ftfs]) delete [] _firstix[ftfs];
    if (NULL != _firstix[ftss]) delete [] _firstix[ftss];
+
+   if (0u != _pbuffer) glDeleteBuffers(1, &_pbuffer);
+   if (0u != _ibuffer) glDeleteBuffers(1, &_ibuffer);
 }
 
 //=============================================================================
@@ -416,6 +497,12 @@ bool trend::TenderLay::chunkExists(TrxCellRef* const ctrans, bool filled)
 
 void trend::TenderLay::collect(bool fill, GLuint pbuf, GLuint ibuf)
 {
+   // the new cached chunks have their own buffers. They are already passed to
+   // the scene cache, so they are found in _layData only
+   for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
+      if ((*TLAY)->cached())
+         static_cast<TenderTV*>(*TLAY)->collectCache();
+   if (0 == _num_total_points) return;
    TNDR_GLDATAT* cpoint_array = NULL;
    unsigned int* cindex_array = NULL;
    _pbuffer = pbuf;
@@ -435,8 +522,39 @@ void trend::TenderLay::collect(bool fill, GLuint pbuf, GLuint ibuf)
                    GL_DYNAMIC_DRAW                    );
       cindex_array = (unsigned int*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
    }
-   for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
-      (*TLAY)->collect(cpoint_array, cindex_array);
+   word numThreads = TrendBase::threads();
+   if (0 == numThreads) numThreads = ThreadPool::numCPUs();
+   if ((1 < numThreads) && (2 * COLLECT_JOB_POINTS <= _num_total_points))
+   {
+      // Split the slices in jobs with roughly the same number of points. The
+      // VBOs stay mapped in this thread - the jobs don't make any GL calls.
+      unsigned jobPoints = _num_total_points / (2 * numThreads);
+      if (COLLECT_JOB_POINTS > jobPoints) jobPoints = COLLECT_JOB_POINTS;
+      ThreadPool::JobList jobs;
+      TrendTVList::const_iterator first = _layData.begin();
+      unsigned points = 0;
+      for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); )
+      {
+         if (!(*TLAY)->cached())
+            points += (*TLAY)->num_total_points();
+         TLAY++;
+         if ((jobPoints <= points) || (_layData.end() == TLAY))
+         {
+            jobs.push_back(DEBUG_NEW CollectJob(first, TLAY, cpoint_array, cindex_array));
+            first = TLAY; points = 0;
+         }
+      }
+      ThreadPool pool(numThreads);
+      pool.execute(jobs);
+      for (ThreadPool::JobList::const_iterator CJ = jobs.begin(); CJ != jobs.end(); CJ++)
+         delete (*CJ);
+   }
+   else
+   {
+      for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
+         if (!(*TLAY)->cached())
+            (*TLAY)->collect(cpoint_array, cindex_array);
+   }
    // Unmap the buffers
    glUnmapBuffer(GL_ARRAY_BUFFER);
 //   glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -509,29 +627,54 @@ void trend::TenderLay::collectSelected(unsigned int* slctd_array)
 
 void trend::TenderLay::draw(layprop::DrawProperties* drawprop)
 {
-   glBindBuffer(GL_ARRAY_BUFFER, _pbuffer);
-   // Check the state of the buffer
-   GLint bufferSize;
-   glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufferSize);
-   assert(bufferSize == (GLint)(2 * _num_total_points * sizeof(TNDR_GLDATAT)));
-   if (0 != _ibuffer)
-   {
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibuffer);
-      glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufferSize);
-      assert(bufferSize == (GLint)(_num_total_indexs * sizeof(unsigned)));
+   if (0 != _pbuffer)
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, _pbuffer);
+      // Check the state of the buffer
+      GLint bufferSize;
+      glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufferSize);
+      assert(bufferSize == (GLint)(2 * _num_total_points * sizeof(TNDR_GLDATAT)));
+      if (0 != _ibuffer)
+      {
+         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibuffer);
+         glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufferSize);
+         assert(bufferSize == (GLint)(_num_total_indexs * sizeof(unsigned)));
+      }
    }
    for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
    {
+      bindChunk(*TLAY);
       (*TLAY)->draw(drawprop);
    }
    for (TrendReTVList::const_iterator TLAY = _reLayData.begin(); TLAY != _reLayData.end(); TLAY++)
    {
+      bindChunk((*TLAY)->chunk());
       (*TLAY)->draw(drawprop);
    }
 
    glBindBuffer(GL_ARRAY_BUFFER, 0);
-   if (0 != _ibuffer)
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Bind the VBOs containing the data of chunk. Those are the layer VBOs unless
+ * the chunk is coming from the scene cache.
+ */
+void trend::TenderLay::bindChunk(const TrendTV* chunk) const
+{
+   if (chunk->cached())
+   {
+      const TenderTV* cchunk = static_cast<const TenderTV*>(chunk);
+      glBindBuffer(GL_ARRAY_BUFFER, cchunk->pbuffer());
+      if (0 != cchunk->ibuffer())
+         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cchunk->ibuffer());
+   }
+   else if (0 != _pbuffer)
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, _pbuffer);
+      if (0 != _ibuffer)
+         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibuffer);
+   }
 }
 
 void trend::TenderLay::drawSelected()
@@ -551,6 +694,7 @@ void trend::TenderLay::drawSelected()
       assert(_sizslix[lstr]);
       assert(_fstslix[lstr]);
       //glMultiDrawElements(GL_LINE_STRIP, _sizslix[lstr], GL_UNSIGNED_INT, (const GLvoid**)_fstslix[lstr], _asobjix[lstr]);
+      RenderStats::drawCalls(_asobjix[lstr]);
       for (unsigned i= 0; i < _asobjix[lstr]; i++)
          glDrawElements(GL_LINE_STRIP, _sizslix[lstr][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_fstslix[lstr][i]));
    }
@@ -559,6 +703,7 @@ void trend::TenderLay::drawSelected()
       assert(_sizslix[llps]);
       assert(_fstslix[llps]);
          //glMultiDrawElements(GL_LINE_LOOP     , _sizslix[llps], GL_UNSIGNED_INT, (const GLvoid**)_fstslix[llps], _alobjix[llps]);
+      RenderStats::drawCalls(_asobjix[llps]);
       for (unsigned i= 0; i < _asobjix[llps]; i++)
          glDrawElements(GL_LINE_LOOP, _sizslix[llps][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_fstslix[llps][i]));
    }
@@ -567,6 +712,7 @@ void trend::TenderLay::drawSelected()
       assert(_sizslix[lnes]);
       assert(_fstslix[lnes]);
          //glMultiDrawElements(GL_LINES  , _sizslix[lnes], GL_UNSIGNED_INT, (const GLvoid**)_fstslix[lnes], _alobjix[lnes]);
+      RenderStats::drawCalls(_asobjix[lnes]);
       for (unsigned i= 0; i < _asobjix[lnes]; i++)
          glDrawElements(GL_LINES, _sizslix[lnes][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_fstslix[lnes][i]));
    }
@@ -676,11 +822,13 @@ void trend::TenderRefLay::draw(layprop::DrawProperties* drawprop)
    {
       assert(_firstvx); assert(_sizesvx);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx, _sizesvx, _alobjvx + _asobjix);
+      RenderStats::drawCalls();
       if (0 < _asindxs)
       {
          assert(_fstslix); assert(_sizslix);
          setLine(drawprop, true);
          glMultiDrawArrays(GL_LINE_LOOP, _fstslix, _sizslix, _asobjix);
+         RenderStats::drawCalls();
          setLine(drawprop, false);
       }
    }
@@ -777,6 +925,159 @@ void trend::TenderMarks::draw(layprop::DrawProperties* drawprop)
    }
 }
 
+//=============================================================================
+//
+// class TenderCache
+//
+trend::TenderCache::TenderCache() :
+   _visualLimit          (       0u   ),
+   _textLimit            (       0u   ),
+   _textBoxHidden        (      false ),
+   _adjustTextOrientation(      false ),
+   _lodRender            (      false ),
+   _valid                (      false ),
+   _numChunks            (       0u   ),
+   _numHits              (       0u   ),
+   _numMisses            (       0u   )
+{}
+
+/**
+ * Marks the chunks of the cells as stale. They are not reused anymore and
+ * they are dropped by the next checkView() (or replaced by addChunks()). No
+ * openGL calls here, so it can be called by the traversing thread.
+ */
+void trend::TenderCache::invalidate(const NameSet& cells)
+{
+   _staleCells.insert(cells.begin(), cells.end());
+}
+
+/**
+ * Validates the cache against the current view. All cached chunks are dropped
+ * if the cache was invalidated or if any of the properties which affect the
+ * contents of a chunk have changed. Otherwise only the chunks of the changed
+ * cells are dropped (see invalidate(const NameSet&)). Must be called before
+ * the DB traversing.
+ */
+void trend::TenderCache::checkView(const layprop::DrawProperties* drawprop)
+{
+   const CTM& ctm = drawprop->scrCtm();
+   if (  !_valid
+       || (ctm.a() != _viewCtm.a()) || (ctm.b() != _viewCtm.b())
+       || (ctm.c() != _viewCtm.c()) || (ctm.d() != _viewCtm.d())
+       || (drawprop->visualLimit()           != _visualLimit          )
+       || (drawprop->textLimit()             != _textLimit            )
+       || (drawprop->textBoxHidden()         != _textBoxHidden        )
+       || (drawprop->adjustTextOrientation() != _adjustTextOrientation)
+       || (drawprop->lodRender()             != _lodRender            )
+      )
+      clear();
+   else if (!_staleCells.empty())
+      dropStale();
+   _staleCells.clear();
+   _viewCtm               = ctm;
+   _visualLimit           = drawprop->visualLimit();
+   _textLimit             = drawprop->textLimit();
+   _textBoxHidden         = drawprop->textBoxHidden();
+   _adjustTextOrientation = drawprop->adjustTextOrientation();
+   _lodRender             = drawprop->lodRender();
+   _valid                 = true;
+   _numHits               = 0u;
+   _numMisses             = 0u;
+}
+
+/**
+ * Looks for a chunk of the cell referenced by ctrans on layer laydef. If it's
+ * found - it's registered in lay as a reusable chunk and it is referenced
+ * with ctrans in the current view.
+ */
+bool trend::TenderCache::reuse(const LayerDef& laydef, TrxCellRef* const ctrans, bool filled, TrendLay* lay)
+{
+   if (!_valid) return false;
+   CachedChunks& cdata = filled ? _fData : _cData;
+   CachedChunks::iterator clay = cdata.find(laydef);
+   if (cdata.end() == clay) return false;
+   if (_staleCells.end() != _staleCells.find(ctrans->name())) return false;
+   TrendLay::ReusableTTVMap::iterator achunk = clay->second.find(ctrans->name());
+   if (clay->second.end() == achunk) return false;
+   lay->addCachedChunk(achunk->first, achunk->second);
+   VERIFY(lay->chunkExists(ctrans, filled));
+   wxMutexLocker lock(_hitsMutex);
+   _numHits++;
+   return true;
+}
+
+/**
+ * Takes the ownership of the new chunks of layer laydef. Must be called
+ * during the collect() phase - i.e. while the cell references of the
+ * current view are still valid.
+ */
+void trend::TenderCache::addChunks(const LayerDef& laydef, const TrendLay::TrendTVList& chunks)
+{
+   for (TrendLay::TrendTVList::const_iterator CC = chunks.begin(); CC != chunks.end(); CC++)
+   {
+      assert((*CC)->cached());
+      TrendLay::ReusableTTVMap& clay = (*CC)->filled() ? _fData[laydef] : _cData[laydef];
+      std::string cellName = (*CC)->cellName();
+      TrendLay::ReusableTTVMap::iterator ochunk = clay.find(cellName);
+      if (clay.end() != ochunk)
+      {
+         // a stale chunk (see invalidate(const NameSet&))
+         assert(_staleCells.end() != _staleCells.find(cellName));
+         delete ochunk->second;
+         _numChunks--;
+      }
+      clay[cellName] = *CC;
+      _numChunks++;
+      _numMisses++;
+   }
+}
+
+std::string trend::TenderCache::report() const
+{
+   std::ostringstream ost;
+   ost << "Scene cache: " << _numHits   << " reused, "
+                          << _numMisses << " new, "
+                          << _numChunks << " resident chunks";
+   return ost.str();
+}
+
+void trend::TenderCache::clear()
+{
+   for (CachedChunks::const_iterator CL = _fData.begin(); CL != _fData.end(); CL++)
+      for (TrendLay::ReusableTTVMap::const_iterator CC = CL->second.begin(); CC != CL->second.end(); CC++)
+         delete CC->second;
+   for (CachedChunks::const_iterator CL = _cData.begin(); CL != _cData.end(); CL++)
+      for (TrendLay::ReusableTTVMap::const_iterator CC = CL->second.begin(); CC != CL->second.end(); CC++)
+         delete CC->second;
+   _fData.clear();
+   _cData.clear();
+   _numChunks = 0u;
+}
+
+void trend::TenderCache::dropStale()
+{
+   CachedChunks* allData[2] = {&_fData, &_cData};
+   for (byte i = 0; i < 2; i++)
+   {
+      for (CachedChunks::iterator CL = allData[i]->begin(); CL != allData[i]->end(); CL++)
+      {
+         for (NameSet::const_iterator CN = _staleCells.begin(); CN != _staleCells.end(); CN++)
+         {
+            TrendLay::ReusableTTVMap::iterator CC = CL->second.find(*CN);
+            if (CL->second.end() == CC) continue;
+            delete CC->second;
+            CL->second.erase(CC);
+            _numChunks--;
+         }
+      }
+   }
+}
+
+trend::TenderCache::~TenderCache()
+{
+   clear();
+}
+
 //=============================================================================
 //
 // class Tenderer
@@ -791,7 +1092,8 @@ trend::Tenderer::Tenderer( layprop::DrawProperties* drawprop, real UU, bool crea
    _ogl_grc_buffers      (       NULL ),
    _ogl_rlr_buffer       (       NULL ),
    _ogl_grd_buffer       (       NULL ),
-   _sbuffer              (       0u   )
+   _sbuffer              (       0u   ),
+   _sceneCache           (       NULL )
 {
    if (createRefLay)
    {
@@ -800,6 +1102,13 @@ trend::Tenderer::Tenderer( layprop::DrawProperties* drawprop, real UU, bool crea
    }
 }
 
+trend::TrendBase* trend::Tenderer::newLayerJob()
+{
+   Tenderer* job = DEBUG_NEW Tenderer(_drawprop, _UU);
+   job->setSceneCache(_sceneCache);
+   return job;
+}
+
 bool trend::Tenderer::chunkExists(const LayerDef& laydef, bool has_selected)
 {
    // Reference layer is processed differently (pushCell), so make sure
@@ -822,6 +1131,12 @@ bool trend::Tenderer::chunkExists(const LayerDef& laydef, bool has_selected)
    }
    if (has_selected)
       _clayer->newSlice(_cellStack.top(), _drawprop->layerFilled(laydef), true, _cslctd_array_offset);
+   else if (NULL != _sceneCache)
+   {
+      if (_sceneCache->reuse(laydef, _cellStack.top(), _drawprop->layerFilled(laydef), _clayer))
+         return true;
+      _clayer->newCacheSlice(_cellStack.top(), _drawprop->layerFilled(laydef));
+   }
    else
       _clayer->newSlice(_cellStack.top(), _drawprop->layerFilled(laydef), true);
    return false;
@@ -879,6 +1194,7 @@ void trend::Tenderer::grdDraw()
       glColor4ub(theColor.red(), theColor.green(), theColor.blue(), theColor.alpha());
       // draw
       glDrawArrays(GL_POINTS, startP, (*CG)->asize());
+      RenderStats::drawCalls();
       startP += (*CG)->asize();
    }
    glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -893,11 +1209,20 @@ bool trend::Tenderer::collect()
    DataLay::Iterator CCLAY = _data.begin();
    unsigned num_total_slctdx = 0; // Initialize the number of total selected indexes
    unsigned num_total_strings = 0;
+   unsigned num_total_cached = 0;
    while (CCLAY != _data.end())
    {
       CCLAY->ppSlice();
       num_total_strings += CCLAY->total_strings();
-      if ((0 == CCLAY->total_points()) && (0 == CCLAY->total_strings()))
+      num_total_cached  += CCLAY->total_cached();
+      // new chunks for the scene cache are handed over before anything else.
+      // The cache takes the ownership, so they survive the layer
+      if ((NULL != _sceneCache) && !CCLAY->cacheData().empty())
+      {
+         _sceneCache->addChunks(CCLAY(), CCLAY->cacheData());
+         CCLAY->cacheTaken();
+      }
+      if ((0 == CCLAY->total_points()) && (0 == CCLAY->total_strings()) && (0 == CCLAY->total_cached()))
       {
          delete (*CCLAY);
          // Note! Careful here with the map iteration and erasing! Erase method
@@ -928,7 +1253,7 @@ bool trend::Tenderer::collect()
    if (0 < _marks->total_points()   )  _num_ogl_buffers ++; // reference marks
    if (0 < num_total_slctdx      )     _num_ogl_buffers ++;  // selected
    // Check whether we have to continue after traversing
-   if (0 == _num_ogl_buffers)
+   if ((0 == _num_ogl_buffers) && (0 == num_total_cached))
    {
       if (0 == num_total_strings)  return false;
       else                         return true;
@@ -937,8 +1262,11 @@ bool trend::Tenderer::collect()
    //
    // generate all VBOs
    //
-   _ogl_buffers = DEBUG_NEW GLuint [_num_ogl_buffers];
-   glGenBuffers(_num_ogl_buffers, _ogl_buffers);
+   if (0 < _num_ogl_buffers)
+   {
+      _ogl_buffers = DEBUG_NEW GLuint [_num_ogl_buffers];
+      glGenBuffers(_num_ogl_buffers, _ogl_buffers);
+   }
    unsigned current_buffer = 0;
    //
    // collect the point arrays
@@ -946,7 +1274,9 @@ bool trend::Tenderer::collect()
    {
       if (0 == CLAY->total_points())
       {
-         assert(0 != CLAY->total_strings());
+         assert((0 != CLAY->total_strings()) || (0 != CLAY->total_cached()));
+         // the scene cache chunks only (if any) - they have their own VBOs
+         CLAY->collect(_drawprop->layerFilled(CLAY()), 0u, 0u);
          continue;
       }
       assert(current_buffer < _num_ogl_buffers);
@@ -1198,11 +1528,12 @@ void trend::Tenderer::draw()
       }
       setLine(false);
       // draw everything
-      if (0 != CLAY->total_points())
+      if ((0 != CLAY->total_points()) || (0 != CLAY->total_cached()))
          CLAY->draw(_drawprop);
       // draw texts
       if (0 != CLAY->total_strings())
       {
+         RenderTimer timer(_stats, rspTexts);
          TRENDC->bindFont();
          CLAY->drawTexts(_drawprop);
       }
@@ -1305,6 +1636,7 @@ void trend::Tenderer::rlrDraw()
    glVertexPointer(2, TNDR_GLENUMT, 0, 0);
    // draw
    glDrawArrays(GL_LINES, 0, _num_ruler_ticks);
+   RenderStats::drawCalls();
 
    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -28,6 +28,7 @@
 #define TENDERER_H
 
 #include <GL/glew.h>
+#include <wx/thread.h>
 #include "basetrend.h"
 
 namespace trend {
@@ -38,8 +39,11 @@ namespace trend {
          virtual          ~TenderTV();
 
          virtual void      collect(TNDR_GLDATAT*, unsigned int*);
+         void              collectCache();
          virtual void      draw(layprop::DrawProperties*);
          virtual void      drawTexts(layprop::DrawProperties*);
+         GLuint            pbuffer() const {return _pbuffer;}
+         GLuint            ibuffer() const {return _ibuffer;}
       protected:
          void              collectIndexs(unsigned int*, const TeselChain*, unsigned*, unsigned*, unsigned);
          GLsizei*          _sizesvx[4]; //! arrays of sizes for vertex sets
@@ -49,6 +53,9 @@ namespace trend {
          // offsets in the VBO
          unsigned          _point_array_offset; //! The offset of this chunk of vertex data in the vertex VBO
          unsigned          _index_array_offset; //! The offset of this chunk of index  data in the index  VBO
+         // own VBOs (cached chunks only)
+         GLuint            _pbuffer;
+         GLuint            _ibuffer;
    };
 
    class TenderReTV : public TrendReTV {
@@ -73,6 +80,7 @@ namespace trend {
          virtual void      collectSelected(unsigned int*);
 
       protected:
+         void              bindChunk(const TrendTV*) const;
          GLuint            _pbuffer;
          GLuint            _ibuffer;
          // index related data for selected objects
@@ -109,6 +117,64 @@ namespace trend {
          GLuint            _pbuffer;
    };
 
+   /**
+      The scene cache keeps the reusable chunks (see TrendReTV) together with
+      their VBOs in the GPU memory between the rendering views. The chunks are
+      sorted by layer and by cell name in the same way as in TrendLay, but the
+      maps here survive the renderer object.
+
+      When a chunk is entirely inside the view window and it is not found in
+      the current view, the renderer is looking for it here (reuse()). If it's
+      found - there is no DB traversing and no data copying at all for it. The
+      view just draws the existing VBOs with a different translation matrix.
+      If it's not found, the new chunk is created as usual, but it gets its
+      own VBOs (TenderTV::collectCache()) and it is passed to the cache during
+      the collect() step of the renderer (addChunks()).
+
+      The contents of a chunk which is entirely inside the view doesn't depend
+      on the location of the view window. So a pan needs only the draw calls.
+      It does depend on the zoom factor and on some of the properties though
+      (visual limit, text boxes etc.). The cache is dropped if any of them is
+      changed (checkView()). The edits of the DB are recorded per cell (see
+      laydata::TdtDesign::markChanged()) and only the chunks of the changed
+      cells are dropped (invalidate(const NameSet&)). The whole cache goes
+      when the cells are renamed or removed, or the design is replaced.
+
+      The chunks which contain selected shapes are never cached. All methods
+      except invalidate() and reuse() must be called with the openGL context
+      current and the DB locked. reuse() is called during the traversing and
+      might be called simultaneously by several layer jobs.
+   */
+   class TenderCache {
+      public:
+                           TenderCache();
+                          ~TenderCache();
+         void              invalidate()      {_valid = false;}
+         void              invalidate(const NameSet&);
+         void              checkView(const layprop::DrawProperties*);
+         bool              reuse(const LayerDef&, TrxCellRef* const, bool, TrendLay*);
+         void              addChunks(const LayerDef&, const TrendLay::TrendTVList&);
+         std::string       report() const;
+      private:
+         typedef std::map<LayerDef, TrendLay::ReusableTTVMap> CachedChunks;
+         void              clear();
+         void              dropStale();
+         CachedChunks      _fData;           //! filled chunks
+         CachedChunks      _cData;           //! contour chunks
+         NameSet           _staleCells;      //! cells changed since their chunks were generated
+         CTM               _viewCtm;         //! screen CTM when the chunks were generated
+         word              _visualLimit;
+         word              _textLimit;
+         bool              _textBoxHidden;
+         bool              _adjustTextOrientation;
+         bool              _lodRender;
+         bool              _valid;
+         unsigned          _numChunks;       //! total number of chunks in the cache
+         unsigned          _numHits;         //! chunks reused in the current view
+         wxMutex           _hitsMutex;       //! guards _numHits in reuse()
+         unsigned          _numMisses;       //! chunks added in the current view
+   };
+
    /**
       Toped rENDERER is the front-end class for the VBO renderer. All data parsing
       functionality is implemented in the parent class. VBO collection and drawing
@@ -130,7 +196,9 @@ namespace trend {
          virtual void      grcDraw();
          virtual void      grdDraw();
          virtual void      rlrDraw();
+         void              setSceneCache(TenderCache* cache) {_sceneCache = cache;}
       protected:
+         virtual TrendBase* newLayerJob();
          virtual void      cleanUp();
          virtual void      grcCleanUp();
          virtual void      grdCleanUp();
@@ -148,6 +216,7 @@ namespace trend {
          GLuint*           _ogl_rlr_buffer;  //!
          GLuint*           _ogl_grd_buffer;
          GLuint            _sbuffer;         //! The "name" of the selected index buffer
+         TenderCache*      _sceneCache;      //! The scene cache (if used by this renderer)
    };
 
 }
@@ -256,6 +256,11 @@ trend::Tolder::Tolder( layprop::DrawProperties* drawprop, real UU ) :
    _marks    = DEBUG_NEW TolderMarks();
 }
 
+trend::TrendBase* trend::Tolder::newLayerJob()
+{
+   return DEBUG_NEW Tolder(_drawprop, _UU);
+}
+
 
 void trend::Tolder::grdDraw()
 {
@@ -559,6 +564,7 @@ void trend::Tolder::draw()
       // draw texts
       if (0 != CLAY->total_strings())
       {
+         RenderTimer timer(_stats, rspTexts);
          CLAY->drawTexts(_drawprop);
       }
    }
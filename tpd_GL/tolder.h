@@ -94,6 +94,7 @@ namespace trend {
          virtual void      grcDraw();
          virtual void      rlrDraw();
       protected:
+         virtual TrendBase* newLayerJob();
          virtual void      cleanUp();
          virtual void      grcCleanUp();
          virtual void      setLayColor(const LayerDef& layer);
@@ -40,14 +40,57 @@ void trend::setShaderCtm(layprop::DrawProperties* drawprop, const TrxCellRef* re
    drawprop->topCtm().oglForm(mtrxOrtho);
    glUniformMatrix4fv(TRENDC->getUniformLoc(glslu_in_CTM), 1, GL_FALSE, mtrxOrtho);
 }
-       
+
+/*! Restores the default (unity) per instance transformation in the vertex
+ * shader. It is used by all non-instanced draws*/
+void trend::resetShaderInstance()
+{
+   glVertexAttrib3f(TSHDR_LOC_INSTX, 1.0f, 0.0f, 0.0f);
+   glVertexAttrib3f(TSHDR_LOC_INSTY, 0.0f, 1.0f, 0.0f);
+}
+
+/*! Sets the cell array expanded in the vertex shader by the following
+ * instanced draws. The steps are transformed to the view coordinates, because
+ * the shader adds them after the per instance transformation*/
+void trend::setShaderArray(layprop::DrawProperties* drawprop, const TrxCellArray& cArray)
+{
+   float colStep[2], rowStep[2];
+   cArray.viewSteps(drawprop->topCtm(), colStep, rowStep);
+   glUniform1ui(TRENDC->getUniformLoc(glslu_in_ArrCols), cArray.cols());
+   glUniform2fv(TRENDC->getUniformLoc(glslu_in_ArrColStep), 1, colStep);
+   glUniform2fv(TRENDC->getUniformLoc(glslu_in_ArrRowStep), 1, rowStep);
+}
+
+/*! Restores the default (single element) cell array in the vertex shader*/
+void trend::resetShaderArray()
+{
+   glUniform1ui(TRENDC->getUniformLoc(glslu_in_ArrCols), 1u);
+   glUniform2f(TRENDC->getUniformLoc(glslu_in_ArrColStep), 0.0f, 0.0f);
+   glUniform2f(TRENDC->getUniformLoc(glslu_in_ArrRowStep), 0.0f, 0.0f);
+}
+
+/*! Sets the alpha of the objects in the cell references alphaDepth levels
+ * deep in the hierarchy*/
+void trend::setShaderAlpha(layprop::DrawProperties* drawprop, word alphaDepth)
+{
+   layprop::tellRGB tellColor;
+   if (drawprop->getAlpha(alphaDepth - 1, tellColor))
+   {
+      float alpha = (float)tellColor.alpha() / 255.0f;
+      glUniform1f(TRENDC->getUniformLoc(glslu_in_Alpha), alpha);
+   }
+}
+
 //=============================================================================
 //
 // class ToshaderTV
 //
 trend::ToshaderTV::ToshaderTV(TrxCellRef* const refCell, bool filled, bool reusable,
                                     unsigned parray_offset, unsigned iarray_offset) :
-   TenderTV(refCell, filled, reusable, parray_offset, iarray_offset)
+   TenderTV(refCell, filled, reusable, parray_offset, iarray_offset),
+   _lbuffer    ( 0u ),
+   _numStripIx ( 0  ),
+   _numLoopIx  ( 0  )
 {}
 
 void trend::ToshaderTV::draw(layprop::DrawProperties* drawprop)
@@ -95,6 +138,131 @@ void trend::ToshaderTV::drawTexts(layprop::DrawProperties* drawprop)
    drawprop->popCtm();
 }
 
+/**
+ * Draws numInst instances of this chunk. The per instance transformations
+ * (already multiplied by the view matrix) must be set-up by the caller and
+ * the vertex buffer of the chunk must be bound.
+ */
+void trend::ToshaderTV::drawInstanced(layprop::DrawProperties* drawprop, GLsizei numInst)
+{
+   // The entire translation is in the instance data
+   float mtrxOrtho [16];
+   CTM().oglForm(mtrxOrtho);
+   glUniformMatrix4fv(TRENDC->getUniformLoc(glslu_in_CTM), 1, GL_FALSE, mtrxOrtho);
+   setAlpha(drawprop);
+   glEnableVertexAttribArray(TSHDR_LOC_VERTEX);
+   glVertexAttribPointer(TSHDR_LOC_VERTEX, 2, TNDR_GLENUMT, GL_FALSE, 0, (GLvoid*)(sizeof(TNDR_GLDATAT) * _point_array_offset));
+   drawTriQuadsInstanced(numInst);
+   glUniform1ui(TRENDC->getUniformLoc(glslu_in_StippleEn), 0);
+   drawLinesInstanced(numInst);
+   glUniform1ui(TRENDC->getUniformLoc(glslu_in_StippleEn), 1);
+   glDisableVertexAttribArray(TSHDR_LOC_VERTEX);
+}
+
+void trend::ToshaderTV::drawTriQuadsInstanced(GLsizei numInst)
+{
+   if  (_alobjvx[cnvx] > 0)
+   {// Boxes only here and they are consecutive - so it's a single call
+      assert(_firstvx[cnvx]);
+      glDrawArraysInstanced(GL_QUADS, _firstvx[cnvx][0], _alvrtxs[cnvx], numInst);
+      RenderStats::drawCalls();
+   }
+   if  (_alobjvx[ncvx] > 0)
+   {// Draw non-convex polygons
+      if (_alobjix[fqss] > 0)
+      {
+         assert(_sizesix[fqss]);
+         assert(_firstix[fqss]);
+         RenderStats::drawCalls(_alobjix[fqss]);
+         for (unsigned i= 0; i < _alobjix[fqss]; i++)
+            glDrawElementsInstanced(GL_QUAD_STRIP, _sizesix[fqss][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[fqss][i]), numInst);
+      }
+      if (_alobjix[ftrs] > 0)
+      {// the triangle indexes are consecutive as well
+         assert(_firstix[ftrs]);
+         glDrawElementsInstanced(GL_TRIANGLES, _alindxs[ftrs], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftrs][0]), numInst);
+         RenderStats::drawCalls();
+      }
+      if (_alobjix[ftfs] > 0)
+      {
+         assert(_sizesix[ftfs]);
+         assert(_firstix[ftfs]);
+         RenderStats::drawCalls(_alobjix[ftfs]);
+         for (unsigned i= 0; i < _alobjix[ftfs]; i++)
+            glDrawElementsInstanced(GL_TRIANGLE_FAN, _sizesix[ftfs][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftfs][i]), numInst);
+      }
+      if (_alobjix[ftss] > 0)
+      {
+         assert(_sizesix[ftss]);
+         assert(_firstix[ftss]);
+         RenderStats::drawCalls(_alobjix[ftss]);
+         for (unsigned i= 0; i < _alobjix[ftss]; i++)
+            glDrawElementsInstanced(GL_TRIANGLE_STRIP, _sizesix[ftss][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftss][i]), numInst);
+      }
+   }
+}
+
+/**
+ * All line strips and all line loops of the chunk are drawn with a single
+ * call each using primitive restart. The index buffer is generated on the
+ * first call.
+ */
+void trend::ToshaderTV::drawLinesInstanced(GLsizei numInst)
+{
+   if (0u == _lbuffer) collectLineIndexes();
+   if ((0 == _numStripIx) && (0 == _numLoopIx)) return;
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _lbuffer);
+   glEnable(GL_PRIMITIVE_RESTART);
+   glPrimitiveRestartIndex(TSHDR_RESTART_INDEX);
+   if (0 < _numStripIx)
+   {
+      glDrawElementsInstanced(GL_LINE_STRIP, _numStripIx, GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(0), numInst);
+      RenderStats::drawCalls();
+   }
+   if (0 < _numLoopIx)
+   {
+      glDrawElementsInstanced(GL_LINE_LOOP, _numLoopIx, GL_UNSIGNED_INT,
+                              VBO_BUFFER_OFFSET(sizeof(unsigned) * _numStripIx), numInst);
+      RenderStats::drawCalls();
+   }
+   glDisable(GL_PRIMITIVE_RESTART);
+}
+
+void trend::ToshaderTV::collectLineIndexes()
+{
+   std::vector<unsigned> lindexes;
+   if (_alobjvx[line] > 0)
+   {
+      for (unsigned i = 0; i < _alobjvx[line]; i++)
+      {
+         for (int j = 0; j < _sizesvx[line][i]; j++)
+            lindexes.push_back(_firstvx[line][i] + j);
+         lindexes.push_back(TSHDR_RESTART_INDEX);
+      }
+   }
+   _numStripIx = lindexes.size();
+   const ObjtTypes loops[3] = {cnvx, ncvx, cont};
+   for (int lt = 0; lt < 3; lt++)
+   {
+      for (unsigned i = 0; i < _alobjvx[loops[lt]]; i++)
+      {
+         for (int j = 0; j < _sizesvx[loops[lt]][i]; j++)
+            lindexes.push_back(_firstvx[loops[lt]][i] + j);
+         lindexes.push_back(TSHDR_RESTART_INDEX);
+      }
+   }
+   _numLoopIx = lindexes.size() - _numStripIx;
+   glGenBuffers(1, &_lbuffer);
+   if (lindexes.empty()) return;
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _lbuffer);
+   glBufferData(GL_ELEMENT_ARRAY_BUFFER, lindexes.size() * sizeof(unsigned), &(lindexes[0]), GL_STATIC_DRAW);
+}
+
+trend::ToshaderTV::~ToshaderTV()
+{
+   if (0u != _lbuffer) glDeleteBuffers(1, &_lbuffer);
+}
+
 void trend::ToshaderTV::drawTriQuads()
 {
    if  (_alobjvx[cnvx] > 0)
@@ -102,6 +270,7 @@ void trend::ToshaderTV::drawTriQuads()
       assert(_firstvx[cnvx]);
       assert(_sizesvx[cnvx]);
       glMultiDrawArrays(GL_QUADS, _firstvx[cnvx], _sizesvx[cnvx], _alobjvx[cnvx]);
+      RenderStats::drawCalls();
    }
    if  (_alobjvx[ncvx] > 0)
    {// Draw non-convex polygons
@@ -113,6 +282,7 @@ void trend::ToshaderTV::drawTriQuads()
          // The suspect is (const GLvoid**)_firstix[fqss] but it's quite possible that it is a driver bug
          // Besides - everybody is saying that there is no speed benefit from this operation
          //glMultiDrawElements(GL_QUAD_STRIP    , _sizesix[fqss], GL_UNSIGNED_INT, (const GLvoid**)_firstix[fqss], _alobjix[fqss]);
+         RenderStats::drawCalls(_alobjix[fqss]);
          for (unsigned i= 0; i < _alobjix[fqss]; i++)
             glDrawElements(GL_QUAD_STRIP, _sizesix[fqss][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[fqss][i]));
       }
@@ -121,6 +291,7 @@ void trend::ToshaderTV::drawTriQuads()
          assert(_sizesix[ftrs]);
          assert(_firstix[ftrs]);
          //glMultiDrawElements(GL_TRIANGLES     , _sizesix[ftrs], GL_UNSIGNED_INT, (const GLvoid**)_firstix[ftrs], _alobjix[ftrs]);
+         RenderStats::drawCalls(_alobjix[ftrs]);
          for (unsigned i= 0; i < _alobjix[ftrs]; i++)
             glDrawElements(GL_TRIANGLES, _sizesix[ftrs][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftrs][i]));
       }
@@ -129,6 +300,7 @@ void trend::ToshaderTV::drawTriQuads()
          assert(_sizesix[ftfs]);
          assert(_firstix[ftfs]);
          //glMultiDrawElements(GL_TRIANGLE_FAN  , _sizesix[ftfs], GL_UNSIGNED_INT, (const GLvoid**)_firstix[ftfs], _alobjix[ftfs]);
+         RenderStats::drawCalls(_alobjix[ftfs]);
          for (unsigned i= 0; i < _alobjix[ftfs]; i++)
             glDrawElements(GL_TRIANGLE_FAN, _sizesix[ftfs][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftfs][i]));
       }
@@ -137,6 +309,7 @@ void trend::ToshaderTV::drawTriQuads()
          assert(_sizesix[ftss]);
          assert(_firstix[ftss]);
          //glMultiDrawElements(GL_TRIANGLE_STRIP, _sizesix[ftss], GL_UNSIGNED_INT, (const GLvoid**)_firstix[ftss], _alobjix[ftss]);
+         RenderStats::drawCalls(_alobjix[ftss]);
          for (unsigned i= 0; i < _alobjix[ftss]; i++)
             glDrawElements(GL_TRIANGLE_STRIP, _sizesix[ftss][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix[ftss][i]));
       }
@@ -150,12 +323,14 @@ void trend::ToshaderTV::drawLines()
       assert(_firstvx[line]);
       assert(_sizesvx[line]);
       glMultiDrawArrays(GL_LINE_STRIP, _firstvx[line], _sizesvx[line], _alobjvx[line]);
+      RenderStats::drawCalls();
    }
    if  (_alobjvx[cnvx] > 0)
    {// Draw convex polygons
       assert(_firstvx[cnvx]);
       assert(_sizesvx[cnvx]);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx[cnvx], _sizesvx[cnvx], _alobjvx[cnvx]);
+      RenderStats::drawCalls();
    }
    if  (_alobjvx[ncvx] > 0)
    {// Draw non-convex polygons
@@ -163,23 +338,20 @@ void trend::ToshaderTV::drawLines()
       assert(_firstvx[ncvx]);
       assert(_sizesvx[ncvx]);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx[ncvx], _sizesvx[ncvx], _alobjvx[ncvx]);
+      RenderStats::drawCalls();
    }
    if (_alobjvx[cont] > 0)
    {// Draw the remaining non-filled shapes of any kind
       assert(_firstvx[cont]);
       assert(_sizesvx[cont]);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx[cont], _sizesvx[cont], _alobjvx[cont]);
+      RenderStats::drawCalls();
    }
 }
 
 void trend::ToshaderTV::setAlpha(layprop::DrawProperties* drawprop)
 {
-   layprop::tellRGB tellColor;
-   if (drawprop->getAlpha(_refCell->alphaDepth() - 1, tellColor))
-   {
-      float alpha = (float)tellColor.alpha() / 255.0f;
-      glUniform1f(TRENDC->getUniformLoc(glslu_in_Alpha), alpha);
-   }
+   setShaderAlpha(drawprop, _refCell->alphaDepth());
 }
 
 //=============================================================================
@@ -201,13 +373,187 @@ void trend::ToshaderTV::setAlpha(layprop::DrawProperties* drawprop)
 //}
 
 
+typedef std::pair<word, bool>                          TextBatchKey; //! alpha depth & fill
+typedef std::map<TextBatchKey, trend::GlyphBatch>      TextBatches;
+
+/**
+ * Adds the glyphs of all strings in chunk placed with refCell to the
+ * corresponding batch. The font transformation is the same as in
+ * ToshaderTV::drawTexts(). The strings of the cell arrays expanded in the
+ * shader are collected once per array element.
+ */
+static void collectTexts(trend::TrendTV* chunk, trend::TrxCellRef* refCell, TextBatches& batches, layprop::DrawProperties* drawprop)
+{
+   const trend::TrendStrings& texts = chunk->texts();
+   if (texts.empty()) return;
+   trend::GlyphBatch& batch = batches[TextBatchKey(refCell->alphaDepth(), chunk->filled())];
+   const trend::TrxCellArray& cArray = refCell->cellArray();
+   for (unsigned i = 0; i < cArray.numElements(); i++)
+   {
+      CTM rctm(refCell->ctm() * cArray.displ(i % cArray.cols(), i / cArray.cols()) * drawprop->topCtm());
+      for (trend::TrendStrings::const_iterator TSTR = texts.begin(); TSTR != texts.end(); TSTR++)
+      {
+         CTM ftm((*TSTR)->ctm());
+         CTM ctm( ftm.a(), ftm.b(), ftm.c(), ftm.d(), 0,0);
+         ctm.Scale((real)OPENGL_FONT_UNIT, (real)OPENGL_FONT_UNIT);
+         ctm.Translate(TP(ftm.tx(), ftm.ty()));
+         TRENDC->collectString((*TSTR)->text(), ctm * rctm, batch);
+      }
+   }
+}
+
 //=============================================================================
 //
 // class ToshaderLay
 //
 trend::ToshaderLay::ToshaderLay():
-   TenderLay           (             )
+   TenderLay           (             ),
+   _instbuffer         (          0u )
+{
+}
+
+/**
+ * All placements of a reusable chunk (see TrendReTV) are drawn with a single
+ * instanced draw. The translations of the placements are collected in a
+ * per instance vertex buffer (_instbuffer). The chunks which are placed only
+ * once are drawn as usual. The placements in the cell arrays expanded by the
+ * shader are drawn with one instanced draw per array (see drawArray()).
+ */
+void trend::ToshaderLay::draw(layprop::DrawProperties* drawprop)
+{
+   // group the placements by chunk and by alpha depth
+   InstanceMap instances;
+   for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
+   {
+      if ((*TLAY)->refCell()->cellArray().expanded())
+         drawArray(*TLAY, (*TLAY)->refCell(), drawprop);
+      else if ((*TLAY)->reusable())
+         instances[InstanceKey(*TLAY, (*TLAY)->refCell()->alphaDepth())].push_back((*TLAY)->refCell());
+      else
+      {
+         bindChunk(*TLAY);
+         (*TLAY)->draw(drawprop);
+      }
+   }
+   for (TrendReTVList::const_iterator TLAY = _reLayData.begin(); TLAY != _reLayData.end(); TLAY++)
+   {
+      if ((*TLAY)->refCell()->cellArray().expanded())
+         drawArray((*TLAY)->chunk(), (*TLAY)->refCell(), drawprop);
+      else
+         instances[InstanceKey((*TLAY)->chunk(), (*TLAY)->refCell()->alphaDepth())].push_back((*TLAY)->refCell());
+   }
+   // gather the translations of the instanced placements
+   std::vector<float> instData;
+   for (InstanceMap::const_iterator CI = instances.begin(); CI != instances.end(); CI++)
+   {
+      if (1 == CI->second.size()) continue;
+      for (RefBoxList::const_iterator CR = CI->second.begin(); CR != CI->second.end(); CR++)
+      {
+         CTM ictm((*CR)->ctm() * drawprop->topCtm());
+         instData.push_back(ictm.a()); instData.push_back(ictm.c()); instData.push_back(ictm.tx());
+         instData.push_back(ictm.b()); instData.push_back(ictm.d()); instData.push_back(ictm.ty());
+      }
+   }
+   if (!instData.empty())
+   {
+      if (0u == _instbuffer) glGenBuffers(1, &_instbuffer);
+      glBindBuffer(GL_ARRAY_BUFFER, _instbuffer);
+      glBufferData(GL_ARRAY_BUFFER, instData.size() * sizeof(float), &(instData[0]), GL_STREAM_DRAW);
+   }
+   // ... and draw
+   GLsizei curInst = 0;
+   for (InstanceMap::const_iterator CI = instances.begin(); CI != instances.end(); CI++)
+   {
+      TrendTV* chunk = CI->first.first;
+      if (1 == CI->second.size())
+      {
+         drawPlacement(chunk, CI->second.front(), drawprop);
+         continue;
+      }
+      GLsizei numInst = CI->second.size();
+      glBindBuffer(GL_ARRAY_BUFFER, _instbuffer);
+      glEnableVertexAttribArray(TSHDR_LOC_INSTX);
+      glEnableVertexAttribArray(TSHDR_LOC_INSTY);
+      glVertexAttribPointer(TSHDR_LOC_INSTX, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), VBO_BUFFER_OFFSET(sizeof(float) * 6 * curInst    ));
+      glVertexAttribPointer(TSHDR_LOC_INSTY, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), VBO_BUFFER_OFFSET(sizeof(float) * (6 * curInst + 3)));
+      glVertexAttribDivisor(TSHDR_LOC_INSTX, 1);
+      glVertexAttribDivisor(TSHDR_LOC_INSTY, 1);
+      bindChunk(chunk);
+      // the alpha depth is the same for the entire group
+      TrxCellRef* sref_cell = chunk->swapRefCells(CI->second.front());
+      static_cast<ToshaderTV*>(chunk)->drawInstanced(drawprop, numInst);
+      chunk->swapRefCells(sref_cell);
+      glVertexAttribDivisor(TSHDR_LOC_INSTX, 0);
+      glVertexAttribDivisor(TSHDR_LOC_INSTY, 0);
+      glDisableVertexAttribArray(TSHDR_LOC_INSTX);
+      glDisableVertexAttribArray(TSHDR_LOC_INSTY);
+      resetShaderInstance();
+      curInst += numInst;
+   }
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/**
+ * All strings of the layer are drawn in a single batch. The strings are
+ * grouped by alpha depth and fill and every group is drawn with one instanced
+ * draw per font symbol (see ToshaderGlfFont::drawGlyphs) instead of one draw
+ * per glyph.
+ */
+void trend::ToshaderLay::drawTexts(layprop::DrawProperties* drawprop)
+{
+   TextBatches batches;
+   for (TrendTVList::const_iterator TLAY = _layData.begin(); TLAY != _layData.end(); TLAY++)
+      collectTexts(*TLAY, (*TLAY)->refCell(), batches, drawprop);
+   for (TrendReTVList::const_iterator TLAY = _reLayData.begin(); TLAY != _reLayData.end(); TLAY++)
+      collectTexts((*TLAY)->chunk(), (*TLAY)->refCell(), batches, drawprop);
+   // The entire translation is in the instance data
+   float mtrxOrtho [16];
+   CTM().oglForm(mtrxOrtho);
+   glUniformMatrix4fv(TRENDC->getUniformLoc(glslu_in_CTM), 1, GL_FALSE, mtrxOrtho);
+   if (0u == _instbuffer) glGenBuffers(1, &_instbuffer);
+   for (TextBatches::const_iterator CB = batches.begin(); CB != batches.end(); CB++)
+   {
+      setShaderAlpha(drawprop, CB->first.first);
+      TRENDC->drawGlyphs(CB->second, CB->first.second, _instbuffer);
+   }
+   resetShaderInstance();
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+
+void trend::ToshaderLay::drawPlacement(TrendTV* chunk, TrxCellRef* refCell, layprop::DrawProperties* drawprop)
 {
+   bindChunk(chunk);
+   TrxCellRef* sref_cell = chunk->swapRefCells(refCell);
+   chunk->draw(drawprop);
+   chunk->swapRefCells(sref_cell);
+}
+
+/**
+ * Draws the chunk in all elements of the cell array of refCell with a single
+ * instanced draw. The placement of the first element is a constant per
+ * instance attribute and the vertex shader adds the displacement of every
+ * element (see TrxCellArray).
+ */
+void trend::ToshaderLay::drawArray(TrendTV* chunk, TrxCellRef* refCell, layprop::DrawProperties* drawprop)
+{
+   CTM ictm(refCell->ctm() * drawprop->topCtm());
+   glVertexAttrib3f(TSHDR_LOC_INSTX, (float)ictm.a(), (float)ictm.c(), (float)ictm.tx());
+   glVertexAttrib3f(TSHDR_LOC_INSTY, (float)ictm.b(), (float)ictm.d(), (float)ictm.ty());
+   setShaderArray(drawprop, refCell->cellArray());
+   bindChunk(chunk);
+   TrxCellRef* sref_cell = chunk->swapRefCells(refCell);
+   static_cast<ToshaderTV*>(chunk)->drawInstanced(drawprop, refCell->cellArray().numElements());
+   chunk->swapRefCells(sref_cell);
+   resetShaderArray();
+   resetShaderInstance();
+}
+
+trend::ToshaderLay::~ToshaderLay()
+{
+   if (0u != _instbuffer) glDeleteBuffers(1, &_instbuffer);
 }
 
 /**
@@ -263,6 +609,7 @@ void trend::ToshaderLay::drawSelected()
       assert(_sizslix[lstr]);
       assert(_fstslix[lstr]);
       //glMultiDrawElements(GL_LINE_STRIP, _sizslix[lstr], GL_UNSIGNED_INT, (const GLvoid**)_fstslix[lstr], _asobjix[lstr]);
+      RenderStats::drawCalls(_asobjix[lstr]);
       for (unsigned i= 0; i < _asobjix[lstr]; i++)
          glDrawElements(GL_LINE_STRIP, _sizslix[lstr][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_fstslix[lstr][i]));
    }
@@ -271,6 +618,7 @@ void trend::ToshaderLay::drawSelected()
       assert(_sizslix[llps]);
       assert(_fstslix[llps]);
          //glMultiDrawElements(GL_LINE_LOOP     , _sizslix[llps], GL_UNSIGNED_INT, (const GLvoid**)_fstslix[llps], _alobjix[llps]);
+      RenderStats::drawCalls(_asobjix[llps]);
       for (unsigned i= 0; i < _asobjix[llps]; i++)
          glDrawElements(GL_LINE_LOOP, _sizslix[llps][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_fstslix[llps][i]));
    }
@@ -279,6 +627,7 @@ void trend::ToshaderLay::drawSelected()
       assert(_sizslix[lnes]);
       assert(_fstslix[lnes]);
          //glMultiDrawElements(GL_LINES  , _sizslix[lnes], GL_UNSIGNED_INT, (const GLvoid**)_fstslix[lnes], _alobjix[lnes]);
+      RenderStats::drawCalls(_asobjix[lnes]);
       for (unsigned i= 0; i < _asobjix[lnes]; i++)
          glDrawElements(GL_LINES, _sizslix[lnes][i], GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_fstslix[lnes][i]));
    }
@@ -314,11 +663,13 @@ void trend::ToshaderRefLay::draw(layprop::DrawProperties* drawprop)
    {
       assert(_firstvx); assert(_sizesvx);
       glMultiDrawArrays(GL_LINE_LOOP, _firstvx, _sizesvx, _alobjvx + _asobjix);
+      RenderStats::drawCalls();
       if (0 < _asindxs)
       {
          assert(_fstslix); assert(_sizslix);
          setLine(drawprop, true);
          glMultiDrawArrays(GL_LINE_LOOP, _fstslix, _sizslix, _asobjix);
+         RenderStats::drawCalls();
          setLine(drawprop, false);
       }
    }
@@ -367,18 +718,21 @@ void trend::ToshaderMarks::draw(layprop::DrawProperties* drawprop)
    {
       setStipple(drawprop->ref_mark_bmp());
       glDrawArrays(GL_POINTS, start, size);
+      RenderStats::drawCalls();
       start += size;
    }
    if (0 < (size = _textMarks.size()) )
    {
       setStipple(drawprop->text_mark_bmp());
       glDrawArrays(GL_POINTS, start, size);
+      RenderStats::drawCalls();
       start += size;
    }
    if (0 < (size = _arefMarks.size()) )
    {
       setStipple(drawprop->aref_mark_bmp());
       glDrawArrays(GL_POINTS, start, size);
+      RenderStats::drawCalls();
    }
    glDisableVertexAttribArray(TSHDR_LOC_VERTEX);
 
@@ -413,6 +767,13 @@ trend::Toshader::Toshader( layprop::DrawProperties* drawprop, real UU) :
    _marks    = DEBUG_NEW ToshaderMarks();
 }
 
+trend::TrendBase* trend::Toshader::newLayerJob()
+{
+   Toshader* job = DEBUG_NEW Toshader(_drawprop, _UU);
+   job->setSceneCache(_sceneCache);
+   return job;
+}
+
 bool trend::Toshader::chunkExists(const LayerDef& laydef, bool has_selected)
 {
    // Reference layer is processed differently (pushCell), so make sure
@@ -435,6 +796,12 @@ bool trend::Toshader::chunkExists(const LayerDef& laydef, bool has_selected)
    }
    if (has_selected)
       _clayer->newSlice(_cellStack.top(), _drawprop->layerFilled(laydef), true, _cslctd_array_offset);
+   else if (NULL != _sceneCache)
+   {
+      if (_sceneCache->reuse(laydef, _cellStack.top(), _drawprop->layerFilled(laydef), _clayer))
+         return true;
+      _clayer->newCacheSlice(_cellStack.top(), _drawprop->layerFilled(laydef));
+   }
    else
       _clayer->newSlice(_cellStack.top(), _drawprop->layerFilled(laydef), true);
    return false;
@@ -503,6 +870,7 @@ void trend::Toshader::grdDraw()
       //draw
       glVertexAttribPointer(TSHDR_LOC_VERTEX, 2, TNDR_GLENUMT, GL_FALSE, 0, 0);
       glDrawArrays(GL_POINTS, startP, (*CG)->asize());
+      RenderStats::drawCalls();
       startP += (*CG)->asize();
    }
    glDisableVertexAttribArray(TSHDR_LOC_VERTEX);
@@ -579,11 +947,12 @@ void trend::Toshader::draw()
       setLine(false);
       setStipple();
       // draw everything
-      if (0 != CLAY->total_points())
+      if ((0 != CLAY->total_points()) || (0 != CLAY->total_cached()))
          CLAY->draw(_drawprop);
       // draw texts
       if (0 != CLAY->total_strings())
       {
+         RenderTimer timer(_stats, rspTexts);
          TRENDC->bindFont();
          CLAY->drawTexts(_drawprop);
       }
@@ -678,6 +1047,7 @@ void trend::Toshader::rlrDraw()
    glBindBuffer(GL_ARRAY_BUFFER, _ogl_rlr_buffer[0]);
    glVertexAttribPointer(TSHDR_LOC_VERTEX, 2, TNDR_GLENUMT, GL_FALSE, 0, 0);
    glDrawArrays(GL_LINES, 0, _num_ruler_ticks);
+   RenderStats::drawCalls();
 
    glDisableVertexAttribArray(TSHDR_LOC_VERTEX);
    // clean-up the buffers
@@ -34,17 +34,28 @@
 namespace trend {
 
    void              setShaderCtm(layprop::DrawProperties*, const TrxCellRef*);
+   void              resetShaderInstance();
+   void              setShaderArray(layprop::DrawProperties*, const TrxCellArray&);
+   void              resetShaderArray();
+   void              setShaderAlpha(layprop::DrawProperties*, word);
 
    class ToshaderTV : public TenderTV {
       public:
                            ToshaderTV(TrxCellRef* const, bool, bool, unsigned, unsigned);
-         virtual          ~ToshaderTV() {};
+         virtual          ~ToshaderTV();
          virtual void      draw(layprop::DrawProperties*);
          virtual void      drawTexts(layprop::DrawProperties*);
+         void              drawInstanced(layprop::DrawProperties*, GLsizei);
       protected:
          void              setAlpha(layprop::DrawProperties*);
          void              drawLines();
          void              drawTriQuads();
+         void              drawLinesInstanced(GLsizei);
+         void              drawTriQuadsInstanced(GLsizei);
+         void              collectLineIndexes();
+         GLuint            _lbuffer;    //! Line indexes with primitive restart (instanced drawing only)
+         GLsizei           _numStripIx; //! Number of indexes for the GL_LINE_STRIP's in _lbuffer
+         GLsizei           _numLoopIx;  //! Number of indexes for the GL_LINE_LOOP's in _lbuffer
    };
 
    class ToshaderReTV : public TenderReTV {
@@ -58,11 +69,19 @@ namespace trend {
    class ToshaderLay : public TenderLay {
       public:
                            ToshaderLay();
-         virtual          ~ToshaderLay() {}
+         virtual          ~ToshaderLay();
          virtual void      newSlice(TrxCellRef* const, bool, bool /*, bool, unsigned*/);
          virtual void      newSlice(TrxCellRef* const, bool, bool, unsigned slctd_array_offset);
          virtual bool      chunkExists(TrxCellRef* const, bool);
+         virtual void      draw(layprop::DrawProperties*);
+         virtual void      drawTexts(layprop::DrawProperties*);
          virtual void      drawSelected();
+      private:
+         typedef std::pair<TrendTV*, word>                 InstanceKey;
+         typedef std::map<InstanceKey, RefBoxList>         InstanceMap;
+         void              drawPlacement(TrendTV*, TrxCellRef*, layprop::DrawProperties*);
+         void              drawArray(TrendTV*, TrxCellRef*, layprop::DrawProperties*);
+         GLuint            _instbuffer; //! Per instance transformations of the reusable chunks and of the glyphs
    };
 
    class ToshaderRefLay : public TenderRefLay {
@@ -95,6 +114,8 @@ namespace trend {
          virtual void      grcDraw();
          virtual void      rlrDraw();
       protected:
+         virtual TrendBase* newLayerJob();
+         virtual bool      shaderArrays() const {return true;}
          virtual void      setLayColor(const LayerDef& layer);
          virtual void      setStipple();
          virtual void      setLine(bool);
@@ -155,11 +155,26 @@ trend::TGlfRSymbol::TGlfRSymbol(TGlfSymbol* tsym, word voffset, word ioffset)
 void trend::TGlfRSymbol::drawWired()
 {
    glMultiDrawArrays(GL_LINE_LOOP, _firstvx, _csize, _alcntrs);
+   RenderStats::drawCalls();
 }
 
 void trend::TGlfRSymbol::drawSolid()
 {
    glDrawElements(GL_TRIANGLES, _alchnks * 3, GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix));
+   RenderStats::drawCalls();
+}
+
+void trend::TGlfRSymbol::drawWiredInstanced(GLsizei numInst) const
+{
+   RenderStats::drawCalls(_alcntrs);
+   for (unsigned i = 0; i < _alcntrs; i++)
+      glDrawArraysInstanced(GL_LINE_LOOP, _firstvx[i], _csize[i], numInst);
+}
+
+void trend::TGlfRSymbol::drawSolidInstanced(GLsizei numInst) const
+{
+   glDrawElementsInstanced(GL_TRIANGLES, _alchnks * 3, GL_UNSIGNED_INT, VBO_BUFFER_OFFSET(_firstix), numInst);
+   RenderStats::drawCalls();
 }
 
 trend::TGlfRSymbol::~TGlfRSymbol()
@@ -432,6 +447,34 @@ void trend::TenderGlfFont::drawString(const std::string& text, bool fill, laypro
    glDisableClientState(GL_VERTEX_ARRAY);
 }
 
+/**
+ * Adds the glyphs of text to batch. ctm is the translation matrix of the
+ * string. The glyphs are placed in the same way as in
+ * ToshaderGlfFont::drawString()
+ */
+void trend::TenderGlfFont::collectString(const std::string& text, const CTM& ctm, GlyphBatch& batch) const
+{
+   float right_of = 0.0f, left_of = 0.0f;
+   for (unsigned i = 0; i < text.length() ; i++)
+   {
+      FontMap::const_iterator CSI = _symbols.find(text[i]);
+      if ((0x20 == text[i]) || (_symbols.end() == CSI))
+      {
+         right_of += _spaceWidth;
+         continue;
+      }
+      // move one _pitch right
+      if (i != 0)
+         left_of += -CSI->second->minX()+_pitch;
+      // glyph transformation = translate(offset, 0) * ctm
+      float offset = left_of + right_of;
+      std::vector<float>& gdata = batch[CSI->second];
+      gdata.push_back(ctm.a()); gdata.push_back(ctm.c()); gdata.push_back(offset * ctm.a() + ctm.tx());
+      gdata.push_back(ctm.b()); gdata.push_back(ctm.d()); gdata.push_back(offset * ctm.b() + ctm.ty());
+      right_of += CSI->second->maxX();
+   }
+}
+
 trend::TenderGlfFont::~TenderGlfFont()
 {
    for (FontMap::const_iterator CS = _symbols.begin(); CS != _symbols.end(); CS++)
@@ -485,7 +528,60 @@ void trend::ToshaderGlfFont::drawString(const std::string& text, bool fill, layp
    glDisableVertexAttribArray(TSHDR_LOC_VERTEX);
 }
 
+/**
+ * Draws all glyphs of batch (see collectString()) with one instanced draw
+ * per font symbol. The per instance data is loaded in instbuffer. The
+ * in_CTM uniform and the alpha must be set-up by the caller. The caller
+ * should also restore the default instance transformation afterwards
+ * (resetShaderInstance())
+ */
+void trend::ToshaderGlfFont::drawGlyphs(const GlyphBatch& batch, bool fill, GLuint instbuffer)
+{
+   // gather the transformations of all glyphs
+   std::vector<float> instData;
+   for (GlyphBatch::const_iterator CG = batch.begin(); CG != batch.end(); CG++)
+      instData.insert(instData.end(), CG->second.begin(), CG->second.end());
+   if (instData.empty()) return;
+   glBindBuffer(GL_ARRAY_BUFFER, instbuffer);
+   glBufferData(GL_ARRAY_BUFFER, instData.size() * sizeof(float), &(instData[0]), GL_STREAM_DRAW);
+   glEnableVertexAttribArray(TSHDR_LOC_INSTX);
+   glEnableVertexAttribArray(TSHDR_LOC_INSTY);
+   glVertexAttribDivisor(TSHDR_LOC_INSTX, 1);
+   glVertexAttribDivisor(TSHDR_LOC_INSTY, 1);
+   // the symbols of the font
+   glBindBuffer(GL_ARRAY_BUFFER, _pbuffer);
+   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibuffer);
+   glEnableVertexAttribArray(TSHDR_LOC_VERTEX);
+   glVertexAttribPointer(TSHDR_LOC_VERTEX, 2, GL_FLOAT, GL_FALSE, 0, 0);
+   // ... and here we go
+   glUniform1ui(TRENDC->getUniformLoc(glslu_in_StippleEn), 0);
+   drawInstances(batch, false, instbuffer);
+   glUniform1ui(TRENDC->getUniformLoc(glslu_in_StippleEn), 1);
+   if (fill)
+      drawInstances(batch, true, instbuffer);
+   glDisableVertexAttribArray(TSHDR_LOC_VERTEX);
+   glVertexAttribDivisor(TSHDR_LOC_INSTX, 0);
+   glVertexAttribDivisor(TSHDR_LOC_INSTY, 0);
+   glDisableVertexAttribArray(TSHDR_LOC_INSTX);
+   glDisableVertexAttribArray(TSHDR_LOC_INSTY);
+}
 
+void trend::ToshaderGlfFont::drawInstances(const GlyphBatch& batch, bool fill, GLuint instbuffer)
+{
+   glBindBuffer(GL_ARRAY_BUFFER, instbuffer);
+   GLsizei curInst = 0;
+   for (GlyphBatch::const_iterator CG = batch.begin(); CG != batch.end(); CG++)
+   {
+      GLsizei numInst = CG->second.size() / 6;
+      glVertexAttribPointer(TSHDR_LOC_INSTX, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), VBO_BUFFER_OFFSET(sizeof(float) * 6 * curInst    ));
+      glVertexAttribPointer(TSHDR_LOC_INSTY, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), VBO_BUFFER_OFFSET(sizeof(float) * (6 * curInst + 3)));
+      if (fill)
+         CG->first->drawSolidInstanced(numInst);
+      else
+         CG->first->drawWiredInstanced(numInst);
+      curInst += numInst;
+   }
+}
 
 //=============================================================================
 trend::Shaders::Shaders() :
@@ -510,6 +606,9 @@ trend::Shaders::Shaders() :
    _glslUniVarNames[glslp_VF][glslu_in_StippleEn]  = "in_StippleEn";
    _glslUniVarNames[glslp_VF][glslu_in_LStippleEn] = "in_LStippleEn";
    _glslUniVarNames[glslp_VF][glslu_in_MStippleEn] = "in_MStippleEn";
+   _glslUniVarNames[glslp_VF][glslu_in_ArrCols]    = "in_ArrCols";
+   _glslUniVarNames[glslp_VF][glslu_in_ArrColStep] = "in_ArrColStep";
+   _glslUniVarNames[glslp_VF][glslu_in_ArrRowStep] = "in_ArrRowStep";
 
    _glslUniVarNames[glslp_VG][glslu_in_CTM]        = "in_CTM";
    _glslUniVarNames[glslp_VG][glslu_in_Z]          = "in_Z";
@@ -522,6 +621,9 @@ trend::Shaders::Shaders() :
    _glslUniVarNames[glslp_VG][glslu_in_ScreenSize] = "in_ScreenSize";
    _glslUniVarNames[glslp_VG][glslu_in_PatScale]   = "in_PatScale";
    _glslUniVarNames[glslp_VG][glslu_in_MStippleEn] = "in_MStippleEn";
+   _glslUniVarNames[glslp_VG][glslu_in_ArrCols]    = "in_ArrCols";
+   _glslUniVarNames[glslp_VG][glslu_in_ArrColStep] = "in_ArrColStep";
+   _glslUniVarNames[glslp_VG][glslu_in_ArrRowStep] = "in_ArrRowStep";
 
    _glslUniVarNames[glslp_PS][glslu_in_CTM]        = "in_CTM";
    _glslUniVarNames[glslp_PS][glslu_in_Z]          = "in_Z";
@@ -533,6 +635,9 @@ trend::Shaders::Shaders() :
    _glslUniVarNames[glslp_PS][glslu_in_LStippleEn] = "in_LStippleEn";
    _glslUniVarNames[glslp_PS][glslu_in_ScreenSize] = "in_ScreenSize";
    _glslUniVarNames[glslp_PS][glslu_in_MStippleEn] = "in_MStippleEn";
+   _glslUniVarNames[glslp_PS][glslu_in_ArrCols]    = "in_ArrCols";
+   _glslUniVarNames[glslp_PS][glslu_in_ArrColStep] = "in_ArrColStep";
+   _glslUniVarNames[glslp_PS][glslu_in_ArrRowStep] = "in_ArrRowStep";
    //
    _idPrograms[glslp_VF] = -1;
    _idPrograms[glslp_VG] = -1;
@@ -762,6 +867,7 @@ trend::TrendCenter::TrendCenter(bool gui, RenderType cmdLineReq, bool sprtVbo, b
    _zRenderer       (              NULL),
    _dRenderer       (              NULL),
    _cShaders        (              NULL),
+   _sceneCache      (              NULL),
    _activeFontName  (                  )
 
 {
@@ -848,6 +954,7 @@ void trend::TrendCenter::initShaders(const std::string& codeDirectory)
       if (_cShaders->status())
       {
          _cShaders->useProgram(glslp_VF);
+         trend::resetShaderInstance();
       }
       else
       {
@@ -857,7 +964,11 @@ void trend::TrendCenter::initShaders(const std::string& codeDirectory)
    }
 }
 
-trend::TrendBase* trend::TrendCenter::makeCRenderer()
+/*! Creates the renderer for the current view. If vlScale is bigger than 1,
+ * the renderer is a coarse one - i.e. all objects smaller than vlScale times
+ * the visual limit are skipped. The coarse renderers are not using the scene
+ * cache, because their data is incomplete.*/
+trend::TrendBase* trend::TrendCenter::makeCRenderer(word vlScale)
 {
    if (NULL != _cRenderer)
    {
@@ -871,17 +982,38 @@ trend::TrendBase* trend::TrendCenter::makeCRenderer()
    layprop::DrawProperties* drawProp;
    if (PROPC->tryLockDrawProp(drawProp))
    {
+      bool cached = (1 == vlScale);
       switch (_renderType)
       {
          case trend::rtTocom    : assert(false);          break;// shouldn't end-up here ever
          case trend::rtTolder   :
             _cRenderer = DEBUG_NEW trend::Tolder( drawProp, PROPC->UU() );break;
          case trend::rtTenderer :
-            _cRenderer = DEBUG_NEW trend::Tenderer( drawProp, PROPC->UU() ); break;
+         {
+            trend::Tenderer* cRenderer = DEBUG_NEW trend::Tenderer( drawProp, PROPC->UU() );
+            if (cached)
+            {
+               if (NULL == _sceneCache) _sceneCache = DEBUG_NEW trend::TenderCache();
+               cRenderer->setSceneCache(_sceneCache);
+            }
+            _cRenderer = cRenderer;
+            break;
+         }
          case trend::rtToshader : 
-            _cRenderer = DEBUG_NEW trend::Toshader( drawProp, PROPC->UU() ); break;
+         {
+            trend::Toshader* cRenderer = DEBUG_NEW trend::Toshader( drawProp, PROPC->UU() );
+            if (cached)
+            {
+               if (NULL == _sceneCache) _sceneCache = DEBUG_NEW trend::TenderCache();
+               cRenderer->setSceneCache(_sceneCache);
+            }
+            _cRenderer = cRenderer;
+            break;
+         }
          default: assert(false); break;
       }
+      if (NULL != _cRenderer)
+         _cRenderer->setCoarse(vlScale);
    }
    else
    {
@@ -894,6 +1026,63 @@ trend::TrendBase* trend::TrendCenter::makeCRenderer()
    return _cRenderer;
 }
 
+/*! Creates a renderer for a background traversal of the current view (see
+ * DataCenter::renderAsync()). Must be called from the thread holding the
+ * openGL context, because the scene cache is checked here. The property DB is
+ * unlocked on return - the traversing thread shall lock it again and update
+ * the renderer using setDrawProp(). The caller owns the renderer until it is
+ * passed back to useBRenderer()*/
+trend::TrendBase* trend::TrendCenter::makeBRenderer()
+{
+   trend::TrendBase* bRenderer = NULL;
+   layprop::DrawProperties* drawProp;
+   if (PROPC->tryLockDrawProp(drawProp))
+   {
+      switch (_renderType)
+      {
+         case trend::rtTocom    : assert(false);          break;// shouldn't end-up here ever
+         case trend::rtTolder   :
+            bRenderer = DEBUG_NEW trend::Tolder( drawProp, PROPC->UU() );break;
+         case trend::rtTenderer :
+         {
+            trend::Tenderer* cRenderer = DEBUG_NEW trend::Tenderer( drawProp, PROPC->UU() );
+            if (NULL == _sceneCache) _sceneCache = DEBUG_NEW trend::TenderCache();
+            cRenderer->setSceneCache(_sceneCache);
+            bRenderer = cRenderer;
+            break;
+         }
+         case trend::rtToshader :
+         {
+            trend::Toshader* cRenderer = DEBUG_NEW trend::Toshader( drawProp, PROPC->UU() );
+            if (NULL == _sceneCache) _sceneCache = DEBUG_NEW trend::TenderCache();
+            cRenderer->setSceneCache(_sceneCache);
+            bRenderer = cRenderer;
+            break;
+         }
+         default: assert(false); break;
+      }
+      if (NULL != _sceneCache)
+         _sceneCache->checkView(drawProp);
+      PROPC->unlockDrawProp(drawProp, false);
+   }
+   else
+      tell_log(console::MT_INFO,std::string("Property DB busy. Viewport redraw skipped"));
+   return bRenderer;
+}
+
+/*! Makes the renderer traversed in the background the current one. Returns
+ * it with the property DB locked (as getCRenderer() does) or NULL if the
+ * property DB is busy. In the latter case the renderer is still kept as
+ * current one and it will be destroyed with the next view*/
+trend::TrendBase* trend::TrendCenter::useBRenderer(trend::TrendBase* bRenderer)
+{
+   assert(NULL != bRenderer);
+   if (NULL != _cRenderer)
+      delete (_cRenderer);
+   _cRenderer = bRenderer;
+   return getCRenderer();
+}
+
 trend::TrendBase* trend::TrendCenter::getCRenderer()
 {
    if (NULL != _cRenderer)
@@ -913,6 +1102,74 @@ trend::TrendBase* trend::TrendCenter::getCRenderer()
    return NULL;
 }
 
+/*! Drops all chunks kept in the scene cache (if any) on the next view. No
+ * openGL calls here - the cache is actually cleared in checkSceneCache()*/
+void trend::TrendCenter::invalidateSceneCache()
+{
+   if (NULL != _sceneCache)
+      _sceneCache->invalidate();
+}
+
+/*! Drops the chunks of the changed cells. The same rules as above apply*/
+void trend::TrendCenter::invalidateSceneCache(const NameSet& cells)
+{
+   if (NULL != _sceneCache)
+      _sceneCache->invalidate(cells);
+}
+
+/*! Must be called with the openGL context current before the DB traversing
+ * of the current renderer*/
+void trend::TrendCenter::checkSceneCache()
+{
+   if ((NULL != _sceneCache) && (NULL != _cRenderer))
+      _sceneCache->checkView(_cRenderer->drawprop());
+}
+
+std::string trend::TrendCenter::sceneCacheReport() const
+{
+   if (NULL != _sceneCache)
+      return _sceneCache->report();
+   return std::string("Scene cache: not used");
+}
+
+/*! Keeps the profile of the last complete frame. Called in the openGL thread*/
+void trend::TrendCenter::setFrameStats(const RenderStats& stats)
+{
+   wxMutexLocker lock(_statsMutex);
+   _frameStats = stats;
+}
+
+/*! Returns the profile of the last complete frame - in a human readable form
+ * or as a JSON object. Might be called by any thread.*/
+std::string trend::TrendCenter::frameStats(bool json)
+{
+   wxMutexLocker lock(_statsMutex);
+   if (!json) return _frameStats.report();
+   switch (_renderType)
+   {
+      case trend::rtTolder   : return _frameStats.json("basic");
+      case trend::rtTenderer : return _frameStats.json("VBO");
+      case trend::rtToshader : return _frameStats.json("shader");
+      default                : return _frameStats.json("none");
+   }
+}
+
+/*! Returns the contents of the last complete frame (see RenderStats::digest()).
+ * Might be called by any thread.*/
+std::string trend::TrendCenter::frameDigest()
+{
+   wxMutexLocker lock(_statsMutex);
+   return _frameStats.digest();
+}
+
+/*! Returns the time (msec) of a phase of the last complete frame. Might be
+ * called by any thread.*/
+double trend::TrendCenter::frameTime(RenderPhase phase)
+{
+   wxMutexLocker lock(_statsMutex);
+   return _frameStats.time(phase);
+}
+
 trend::TrendBase* trend::TrendCenter::makeHRenderer()
 {
    assert(NULL == _hRenderer);
@@ -1101,6 +1358,16 @@ void trend::TrendCenter::drawString(const std::string& text, bool fill, layprop:
    _oglFont[_activeFontName]->drawString(text, fill, drawprop);
 }
 
+void trend::TrendCenter::collectString(const std::string& text, const CTM& ctm, GlyphBatch& batch)
+{
+   _oglFont[_activeFontName]->collectString(text, ctm, batch);
+}
+
+void trend::TrendCenter::drawGlyphs(const GlyphBatch& batch, bool fill, GLuint instbuffer)
+{
+   _oglFont[_activeFontName]->drawGlyphs(batch, fill, instbuffer);
+}
+
 //void trend::TrendCenter::drawWiredString(const std::string& text)
 //{
 //   bindFont();
@@ -1162,6 +1429,7 @@ trend::TrendCenter::~TrendCenter()
    for (OglFontCollectionMap::const_iterator CF = _oglFont.begin(); CF != _oglFont.end(); CF++)
       delete (CF->second);
    if (NULL != _cRenderer) delete _cRenderer;
+   if (NULL != _sceneCache) delete _sceneCache;
    if (NULL != _cShaders) delete _cShaders;
 }
 
@@ -29,9 +29,13 @@
 #define TREND_H_
 
 #include "ttt.h"
+#include <wx/thread.h>
 #include "basetrend.h"
 
 #define TSHDR_LOC_VERTEX 0 // TODO -> get this into something like glslUniVarLoc
+#define TSHDR_LOC_INSTX  1 // per instance transformation - first row
+#define TSHDR_LOC_INSTY  2 // per instance transformation - second row
+#define TSHDR_RESTART_INDEX 0xffffffff // primitive restart in the instanced line draws
 
 namespace trend {
 
@@ -42,6 +46,8 @@ namespace trend {
                  ,rtToshader   // shaders
                 } RenderType;
 
+   class TenderCache;
+
    /**
     * This class contains a raw symbol data from the GLF font files. It is used to
     * parse the symbol data from the file and if the current renderer is the rtTolder
@@ -90,6 +96,8 @@ namespace trend {
                        ~TGlfRSymbol();
          void           drawSolid();
          void           drawWired();
+         void           drawSolidInstanced(GLsizei) const;
+         void           drawWiredInstanced(GLsizei) const;
          float          minX() { return _minX; }
          float          maxX() { return _maxX; }
          float          minY() { return _minY; }
@@ -108,6 +116,13 @@ namespace trend {
          float          _maxY;
    };
 
+   /**
+    * The glyphs of a batch of strings grouped by symbol. The data of every
+    * glyph is its transformation - two rows of 3 floats, i.e. the per instance
+    * data of the vertex shader (TSHDR_LOC_INSTX & TSHDR_LOC_INSTY)
+    */
+   typedef std::map<const TGlfRSymbol*, std::vector<float> > GlyphBatch;
+
    /**
     * Base class handling a particular GLF font. Contains the parsing of the
     * GLF files and used for string drawing when the basic rendering is active.
@@ -119,6 +134,8 @@ namespace trend {
          virtual void   getStringBounds(const std::string&, DBbox*);
          virtual void   bindBuffers() {assert(false);}
          virtual void   drawString(const std::string&, bool, layprop::DrawProperties*);
+         virtual void   collectString(const std::string&, const CTM&, GlyphBatch&) const {assert(false);}
+         virtual void   drawGlyphs(const GlyphBatch&, bool, GLuint) {assert(false);}
          byte           status()        {return _status;}
       protected:
          typedef std::map<byte, TGlfSymbol*> TFontMap;
@@ -148,6 +165,7 @@ namespace trend {
          virtual void   getStringBounds(const std::string&, DBbox*);
          virtual void   bindBuffers();
          virtual void   drawString(const std::string&, bool, layprop::DrawProperties*);
+         virtual void   collectString(const std::string&, const CTM&, GlyphBatch&) const;
       protected:
          void           collect(const word, const word);
          typedef std::map<byte, TGlfRSymbol*> FontMap;
@@ -161,6 +179,9 @@ namespace trend {
                         ToshaderGlfFont(std::string, std::string&);
          virtual       ~ToshaderGlfFont() {}
          virtual void   drawString(const std::string&, bool, layprop::DrawProperties*);
+         virtual void   drawGlyphs(const GlyphBatch&, bool, GLuint);
+      private:
+         void           drawInstances(const GlyphBatch&, bool, GLuint);
    };
    //=============================================================================
    //
@@ -200,11 +221,13 @@ namespace trend {
       public:
                                 TrendCenter(bool, RenderType cmdLineReq=trend::rtTBD, bool sprtVbo=false, bool sprtShaders=false);
          virtual               ~TrendCenter();
-//         RenderType             renderType() const {return _renderType;}
+         RenderType             renderType() const {return _renderType;}
          void                   reportRenderer(RenderType) const;
          void                   initShaders(const std::string&);
-         trend::TrendBase*      makeCRenderer();                     //!Get current renderer
+         trend::TrendBase*      makeCRenderer(word vlScale = 1);     //!Get current renderer
          trend::TrendBase*      getCRenderer();
+         trend::TrendBase*      makeBRenderer();                     //!Get background renderer
+         trend::TrendBase*      useBRenderer(trend::TrendBase*);
          void                   releaseCRenderer();
          trend::TrendBase*      makeHRenderer();                     //!Get hover renderer
          void                   destroyHRenderer();
@@ -215,12 +238,22 @@ namespace trend {
          trend::TrendBase*      makeDRenderer();                     //!Get DRC renderer
          trend::TrendBase*      getDRenderer();
          void                   releaseDRenderer(bool destroy = false);
+         void                   invalidateSceneCache();
+         void                   invalidateSceneCache(const NameSet&);
+         void                   checkSceneCache();
+         std::string            sceneCacheReport() const;
+         void                   setFrameStats(const RenderStats&);
+         std::string            frameStats(bool json);
+         std::string            frameDigest();
+         double                 frameTime(RenderPhase);
 //         void                   destroyCRenderer();
 //         void                   drawFOnly();
          //Font handling
          void                   loadLayoutFont(std::string);
          void                   getStringBounds(const std::string&, DBbox*);
          void                   drawString(const std::string& str, bool fill, layprop::DrawProperties*);
+         void                   collectString(const std::string&, const CTM&, GlyphBatch&);
+         void                   drawGlyphs(const GlyphBatch&, bool, GLuint);
 //         void                   drawWiredString(const std::string& str);
 //         void                   drawSolidString(const std::string& str);
          bool                   selectFont(std::string str);
@@ -238,6 +271,9 @@ namespace trend {
          trend::TrendBase*      _zRenderer;    //! zoom    renderer
          trend::TrendBase*      _dRenderer;    //! DRC     renderer
          trend::Shaders*        _cShaders;     //! the shader init object (valid in rtToshader case only)
+         trend::TenderCache*    _sceneCache;   //! reusable chunks kept between the views (VBO & shader renderers)
+         RenderStats            _frameStats;   //! the profile of the last complete frame
+         wxMutex                _statsMutex;   //! guards _frameStats (see frameStats())
          OglFontCollectionMap   _oglFont;
          std::string            _activeFontName;
          RenderType             _renderType;
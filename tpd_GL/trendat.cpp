@@ -26,8 +26,10 @@
 //===========================================================================
 
 #include "tpdph.h"
+#include <wx/thread.h>
 #include "trendat.h"
 #include "trend.h"
+#include "polytri.h"
 
 GLUtriangulatorObj*  TessellPoly::tenderTesel = NULL;
 extern trend::TrendCenter*            TRENDC;
@@ -52,80 +54,71 @@ GLubyte aref_mark_bmp[30]= {
 
 //=============================================================================
 //
-TeselChunk::TeselChunk(const TeselVertices& data, GLenum type, unsigned offset)
-{
-   _size = data.size();
-   _index_seq = DEBUG_NEW unsigned[_size];
-   word li = 0;
-   for(TeselVertices::const_iterator CVX = data.begin(); CVX != data.end(); CVX++)
-      _index_seq[li++] = *CVX + offset;
-   _type = type;
-}
-
-TeselChunk::TeselChunk(const TeselChunk* data, unsigned offset)
-{
-   _size = data->size();
-   _type = data->type();
-   _index_seq = DEBUG_NEW unsigned[_size];
-   const unsigned* copy_seq = data->index_seq();
-   for(unsigned i = 0; i < _size; i++)
-      _index_seq[i] = copy_seq[i] + offset;
+TeselChain::TeselChain(const TeselVertices& data, word ftrs, word ftfs, word ftss) :
+   _data        (     NULL ),
+   _length      (        0 ),
+   _all_ftrs    (     ftrs ),
+   _all_ftfs    (     ftfs ),
+   _all_ftss    (     ftss )
+{
+   _length = data.size();
+   if (0 < _length)
+   {
+      _data = DEBUG_NEW word[_length];
+      memcpy(_data, &(data[0]), sizeof(word) * _length);
+   }
 }
 
-TeselChunk::TeselChunk(const int* data, unsigned size, unsigned offset)
+TeselChain::TeselChain(unsigned csize) :
+   _data        (     NULL ),
+   _length      (        0 ),
+   _all_ftrs    (        0 ),
+   _all_ftfs    (        0 ),
+   _all_ftss    (        0 )
 { // used for wire tesselation explicitly
-   _size = size;
-   _type = GL_QUAD_STRIP;
-   assert(0 ==(size % 2));
-   _index_seq = DEBUG_NEW unsigned[_size];
+   assert(0 ==(csize % 2));
+   _length = csize + 2;
+   _data = DEBUG_NEW word[_length];
+   _data[0] = GL_QUAD_STRIP;
+   _data[1] = csize;
+   word* index_seq = _data + 2;
    word findex = 0;     // forward  index
-   word bindex = _size; // backward index
-   for (word i = 0; i < _size / 2; i++)
+   word bindex = csize; // backward index
+   for (word i = 0; i < csize / 2; i++)
    {
-      _index_seq[2*i  ] = (findex++) + offset;
-      _index_seq[2*i+1] = (--bindex) + offset;
+      index_seq[2*i  ] = (findex++);
+      index_seq[2*i+1] = (--bindex);
    }
 }
 
-TeselChunk::TeselChunk(const TeselChunk& tcobj)
+TeselChain::~TeselChain()
 {
-   _size = tcobj._size;
-   _type = tcobj._type;
-   _index_seq = DEBUG_NEW unsigned[_size];
-   memcpy(_index_seq, tcobj._index_seq, sizeof(unsigned) * _size);
+   if (NULL != _data) delete [] _data;
 }
 
-TeselChunk::~TeselChunk()
-{
-   delete [] _index_seq;
-}
 //=============================================================================
 //
 
-TeselTempData::TeselTempData(unsigned offset) :
-   _the_chain   (    NULL),
-   _ctype       (      0 ),
+TeselTempData::TeselTempData() :
    _cindexes    (        ),
+   _chunkStart  (      0 ),
    _all_ftrs    (      0 ),
    _all_ftfs    (      0 ),
-   _all_ftss    (      0 ),
-   _offset      ( offset )
+   _all_ftss    (      0 )
 {}
 
-TeselTempData::TeselTempData(TeselChain* tc) :
-   _the_chain   ( tc     ),
-   _ctype       (      0 ),
-   _cindexes    (        ),
-   _all_ftrs    (      0 ),
-   _all_ftfs    (      0 ),
-   _all_ftss    (      0 ),
-   _offset      (      0 )
-{}
+void TeselTempData::newChunk(GLenum type)
+{
+   // the chunk header - {type, size}. The size is updated in storeChunk()
+   _chunkStart = _cindexes.size();
+   _cindexes.push_back(type);
+   _cindexes.push_back(0);
+}
 
 void TeselTempData::storeChunk()
 {
-   _the_chain->push_back(TeselChunk(_cindexes, _ctype, _offset));
-   switch (_ctype)
+   _cindexes[_chunkStart + 1] = _cindexes.size() - _chunkStart - 2;
+   switch (_cindexes[_chunkStart])
    {
       case GL_TRIANGLE_FAN   : _all_ftfs++; break;
       case GL_TRIANGLE_STRIP : _all_ftss++; break;
@@ -134,17 +127,230 @@ void TeselTempData::storeChunk()
    }
 }
 
+TeselChain* TeselTempData::chain() const
+{
+   return DEBUG_NEW TeselChain(_cindexes, _all_ftrs, _all_ftfs, _all_ftss);
+}
+
 //=============================================================================
 // TessellPoly
 
-TessellPoly::TessellPoly() : _tdata(), _all_ftrs(0), _all_ftfs(0), _all_ftss(0)
+// Guards the GLU tessellator and the shared tessellation data
+static wxMutex                  teselMutex;
+TessellPoly::SharedChains       TessellPoly::_sharedChains;
+unsigned                        TessellPoly::_numPolys = 0;
+
+TessellPoly::SharedChain::SharedChain(const TeselChain* chain, const ShapeKey& key, const int4b* pdata) :
+   _chain      ( chain  ),
+   _key        ( key    ),
+   _refs       ( 1      )
+{
+   unsigned numCoords = 2 * (key.first - 1);
+   _shape = DEBUG_NEW int4b[numCoords];
+   for (unsigned i = 0; i < numCoords; i++)
+      _shape[i] = pdata[i+2] - pdata[i%2];
+}
+
+TessellPoly::SharedChain::~SharedChain()
+{
+   delete _chain;
+   delete [] _shape;
+}
+
+bool TessellPoly::SharedChain::sameShape(const int4b* pdata) const
+{
+   unsigned numCoords = 2 * (_key.first - 1);
+   for (unsigned i = 0; i < numCoords; i++)
+      if (_shape[i] != pdata[i+2] - pdata[i%2]) return false;
+   return true;
+}
+
+//=============================================================================
+TessellPoly::TessellPoly() : _shared(NULL)
+{
+}
+
+TessellPoly::~TessellPoly()
+{
+   clear();
+}
+
+/*! Makes sure that the tessellation data is available. The data is shared
+ * with all other polygons of the same shape. If there is no such polygon yet,
+ * the shape is tessellated.*/
+void TessellPoly::tessellate(const int4b* pdata, unsigned psize) const
+{
+   if (NULL != _shared) return;
+   // FNV-1a hash of the vertexes relative to the first one
+   qword hash = 14695981039346656037ull;
+   for (unsigned i = 1; i < psize; i++)
+   {
+      hash = (hash ^ (dword)(pdata[2*i  ] - pdata[0])) * 1099511628211ull;
+      hash = (hash ^ (dword)(pdata[2*i+1] - pdata[1])) * 1099511628211ull;
+   }
+   ShapeKey key(psize, hash);
+   {
+      wxMutexLocker lock(teselMutex);
+      if (shareChain(key, pdata)) return;
+   }
+   // A new shape - tessellate it outside the lock. The PolyTriangulator is
+   // thread safe, the GLU tessellator (the fall-back) is not.
+   TeselChain* chain = nativeTessellate(pdata, psize);
+   wxMutexLocker lock(teselMutex);
+   if (NULL == chain)
+      chain = gluTessellate(pdata, psize);
+   if (shareChain(key, pdata))
+      delete chain; // the same shape was tessellated by another thread meanwhile
+   else
+   {
+      _shared = DEBUG_NEW SharedChain(chain, key, pdata);
+      _sharedChains.insert(std::make_pair(key, _shared));
+      _numPolys++;
+   }
+}
+
+/*! Attaches the existing tessellation of the same shape (if any). Must be
+ * called with teselMutex locked*/
+bool TessellPoly::shareChain(const ShapeKey& key, const int4b* pdata) const
 {
+   std::pair<SharedChains::const_iterator, SharedChains::const_iterator> range = _sharedChains.equal_range(key);
+   for (SharedChains::const_iterator CS = range.first; CS != range.second; CS++)
+   {
+      if (CS->second->sameShape(pdata))
+      {
+         _shared = CS->second;
+         _shared->_refs++;
+         _numPolys++;
+         return true;
+      }
+   }
+   return false;
 }
 
-void TessellPoly::tessellate(const int4b* pdata, unsigned psize)
+/*! Drops the tessellation data. Must be called when the polygon is modified*/
+void TessellPoly::clear()
 {
-   _tdata.clear();
-   TeselTempData ttdata( &_tdata );
+   if (NULL == _shared) return;
+   wxMutexLocker lock(teselMutex);
+   if (0 == --(_shared->_refs))
+   {
+      std::pair<SharedChains::iterator, SharedChains::iterator> range = _sharedChains.equal_range(_shared->_key);
+      for (SharedChains::iterator CS = range.first; CS != range.second; CS++)
+      {
+         if (_shared == CS->second)
+         {
+            _sharedChains.erase(CS);
+            break;
+         }
+      }
+      delete _shared;
+   }
+   _numPolys--;
+   _shared = NULL;
+}
+
+/*! The current memory usage of the shared tessellation data*/
+void TessellPoly::stats(Stats& tstats)
+{
+   wxMutexLocker lock(teselMutex);
+   tstats._polys    = _numPolys;
+   tstats._shapes   = _sharedChains.size();
+   tstats._words    = 0;
+   tstats._unshared = 0;
+   tstats._vertexes = 0;
+   for (SharedChains::const_iterator CS = _sharedChains.begin(); CS != _sharedChains.end(); CS++)
+   {
+      tstats._words    += CS->second->_chain->length();
+      tstats._unshared += CS->second->_chain->length() * CS->second->_refs;
+      tstats._vertexes += CS->first.first - 1;
+   }
+}
+
+#ifdef TPD_BENCH
+/*! The area of a triangle given by three vertex indexes of pdata*/
+static real triArea(const int4b* pdata, word a, word b, word c)
+{
+   real abx = (real)pdata[2*b  ] - (real)pdata[2*a  ];
+   real aby = (real)pdata[2*b+1] - (real)pdata[2*a+1];
+   real acx = (real)pdata[2*c  ] - (real)pdata[2*a  ];
+   real acy = (real)pdata[2*c+1] - (real)pdata[2*a+1];
+   return fabs(abx * acy - aby * acx) / 2.0;
+}
+
+/*! Tessellates the polygon with the PolyTriangulator (native == true) or with
+ * the GLU tessellator and returns the sum of the areas of the triangles. For a
+ * valid polygon both shall be equal to the area of the polygon. Returns -1 if
+ * the PolyTriangulator can't handle the polygon. The result is not shared
+ * with anything - this is for testing only (see tll/polytri.tll)*/
+real TessellPoly::triangleArea(const int4b* pdata, unsigned psize, bool native)
+{
+   TeselChain* chain;
+   if (native)
+   {
+      chain = nativeTessellate(pdata, psize);
+      if (NULL == chain) return -1.0;
+   }
+   else
+   {
+      wxMutexLocker lock(teselMutex);
+      chain = gluTessellate(pdata, psize);
+   }
+   real area = 0.0;
+   for (TeselChain::const_iterator CC = chain->begin(); CC != chain->end(); CC++)
+   {
+      const word* ix = CC->index_seq();
+      switch (CC->type())
+      {
+         case GL_TRIANGLES      :
+            for (word i = 2; i < CC->size(); i += 3)
+               area += triArea(pdata, ix[i-2], ix[i-1], ix[i]);
+            break;
+         case GL_TRIANGLE_FAN   :
+            for (word i = 2; i < CC->size(); i++)
+               area += triArea(pdata, ix[0], ix[i-1], ix[i]);
+            break;
+         case GL_TRIANGLE_STRIP :
+            for (word i = 2; i < CC->size(); i++)
+               area += triArea(pdata, ix[i-2], ix[i-1], ix[i]);
+            break;
+         default: assert(false); break;
+      }
+   }
+   delete chain;
+   return area;
+}
+#endif
+
+/*! Returns the triangles of the polygon as a list of GL_TRIANGLES chunks or
+ * NULL if the polygon can't be triangulated by the PolyTriangulator*/
+TeselChain* TessellPoly::nativeTessellate(const int4b* pdata, unsigned psize)
+{
+   PolyTriangulator::IndexList triangles;
+   PolyTriangulator triangulator(pdata, psize);
+   if (!triangulator.triangulate(triangles)) return NULL;
+   // The size of a chunk is a word, so a huge polygon needs more than one
+   const unsigned maxChunk = 0xffff - (0xffff % 3);
+   TeselVertices tdata;
+   tdata.reserve(triangles.size() + 2 * (triangles.size() / maxChunk + 1));
+   word numChunks = 0;
+   for (unsigned start = 0; start < triangles.size(); start += maxChunk)
+   {
+      unsigned size = std::min(maxChunk, (unsigned)triangles.size() - start);
+      tdata.push_back(GL_TRIANGLES);
+      tdata.push_back(size);
+      tdata.insert(tdata.end(), triangles.begin() + start, triangles.begin() + start + size);
+      numChunks++;
+   }
+   return DEBUG_NEW TeselChain(tdata, numChunks, 0, 0);
+}
+
+/*! The polygons which are not handled by nativeTessellate() - normally
+ * those are not valid (self-crossing) polygons. Must be called with
+ * teselMutex locked*/
+TeselChain* TessellPoly::gluTessellate(const int4b* pdata, unsigned psize)
+{
+   TeselTempData ttdata;
+   if (NULL == tenderTesel) return ttdata.chain();
    // Start tessellation
    gluTessBeginPolygon(tenderTesel, &ttdata);
    GLdouble pv[3];
@@ -158,12 +364,9 @@ void TessellPoly::tessellate(const int4b* pdata, unsigned psize)
    }
    gluTessEndPolygon(tenderTesel);
    delete [] index_arr;
-   _all_ftrs = ttdata.num_ftrs();
-   _all_ftfs = ttdata.num_ftfs();
-   _all_ftss = ttdata.num_ftss();
+   return ttdata.chain();
 }
 
-
 GLvoid TessellPoly::teselBegin(GLenum type, GLvoid* ttmp)
 {
    TeselTempData* ptmp = static_cast<TeselTempData*>(ttmp);
@@ -184,7 +387,8 @@ GLvoid TessellPoly::teselEnd(GLvoid* ttmp)
 
 void TessellPoly::num_indexs(unsigned& iftrs, unsigned& iftfs, unsigned& iftss) const
 {
-   for (TeselChain::const_iterator CCH = _tdata.begin(); CCH != _tdata.end(); CCH++)
+   assert(_shared);
+   for (TeselChain::const_iterator CCH = _shared->_chain->begin(); CCH != _shared->_chain->end(); CCH++)
    {
       switch (CCH->type())
       {
@@ -354,8 +558,7 @@ void trend::TrxWire::drctDrawFill()
 */
 void trend::TrxWire::Tesselate()
 {
-   _tdata = DEBUG_NEW TeselChain();
-   _tdata->push_back( TeselChunk(_cdata, _csize, 0));
+   _tdata = DEBUG_NEW TeselChain(_csize);
 }
 
 trend::TrxWire::~TrxWire()
@@ -1046,6 +1249,63 @@ trend::TrxTWire::~TrxTWire()
 }
 
 
+//=============================================================================
+//
+// class TrxCellArray
+//
+trend::TrxCellArray::TrxCellArray() :
+   _cols       ( 1    ),
+   _rows       ( 1    )
+{
+   _colStep[0] = _colStep[1] = _rowStep[0] = _rowStep[1] = 0.0;
+}
+
+trend::TrxCellArray::TrxCellArray(word cols, word rows, real colStepX, real colStepY,
+                                  real rowStepX, real rowStepY) :
+   _cols       ( cols ),
+   _rows       ( rows )
+{
+   _colStep[0] = colStepX; _colStep[1] = colStepY;
+   _rowStep[0] = rowStepX; _rowStep[1] = rowStepY;
+}
+
+/*! The translation of the element (col,row) relative to the first one*/
+CTM trend::TrxCellArray::displ(word col, word row) const
+{
+   return CTM(1.0, 0.0, 0.0, 1.0, col * _colStep[0] + row * _rowStep[0],
+                                  col * _colStep[1] + row * _rowStep[1]);
+}
+
+/*! Returns the region which has to be traversed in the first element, so
+ * that all of its shapes visible in clip in any element are collected. It is
+ * the bounding box of clip moved back by the displacements of the four corner
+ * elements*/
+DBbox trend::TrxCellArray::clipRegion(const DBbox& clip) const
+{
+   real lastCol[2] = {(_cols - 1) * _colStep[0], (_cols - 1) * _colStep[1]};
+   real lastRow[2] = {(_rows - 1) * _rowStep[0], (_rows - 1) * _rowStep[1]};
+   real minDispl[2], maxDispl[2];
+   for (word i = 0; i < 2; i++)
+   {
+      minDispl[i] = std::min(std::min(0.0, lastCol[i]), std::min(lastRow[i], lastCol[i] + lastRow[i]));
+      maxDispl[i] = std::max(std::max(0.0, lastCol[i]), std::max(lastRow[i], lastCol[i] + lastRow[i]));
+   }
+   DBbox expClip(clip);
+   expClip.overlap(TP((int4b)floor(clip.p1().x() - maxDispl[0]), (int4b)floor(clip.p1().y() - maxDispl[1])));
+   expClip.overlap(TP((int4b)ceil (clip.p2().x() - minDispl[0]), (int4b)ceil (clip.p2().y() - minDispl[1])));
+   return expClip;
+}
+
+/*! Returns the column and the row steps transformed by the linear part of
+ * viewCtm. The translation is not applied - those are displacements.*/
+void trend::TrxCellArray::viewSteps(const CTM& viewCtm, float* colStep, float* rowStep) const
+{
+   colStep[0] = (float)(viewCtm.a() * _colStep[0] + viewCtm.c() * _colStep[1]);
+   colStep[1] = (float)(viewCtm.b() * _colStep[0] + viewCtm.d() * _colStep[1]);
+   rowStep[0] = (float)(viewCtm.a() * _rowStep[0] + viewCtm.c() * _rowStep[1]);
+   rowStep[1] = (float)(viewCtm.b() * _rowStep[0] + viewCtm.d() * _rowStep[1]);
+}
+
 //=============================================================================
 //
 // class TrxCellRef
@@ -46,57 +46,106 @@
 // Tesselation classes
 //
 //=============================================================================
-typedef std::list<word> TeselVertices;
+typedef std::vector<word> TeselVertices;
 
+/*! A view of a single tessellation chunk in a TeselChain. The chunk is stored
+ * as {type, size, index[0] ... index[size-1]} */
 class TeselChunk {
    public:
-                        TeselChunk(const TeselVertices&, GLenum, unsigned);
-                        TeselChunk(const TeselChunk*, unsigned);
-                        TeselChunk(const int*, unsigned, unsigned);
-                        TeselChunk(const TeselChunk&); //copy constructor
-                       ~TeselChunk();
-      GLenum            type() const      {return _type;}
-      word              size() const      {return _size;}
-      const unsigned*   index_seq() const {return _index_seq;}
+                        TeselChunk(const word* data) : _data(data) {}
+      GLenum            type() const      {return _data[0];}
+      word              size() const      {return _data[1];}
+      const word*       index_seq() const {return _data + 2;}
    private:
-      unsigned*         _index_seq;  // index sequence
-      word              _size;       // size of the index sequence
-      GLenum            _type;
+      const word*       _data;
 };
 
-typedef std::list<TeselChunk> TeselChain;
+/*! The tessellation of a polygon - all the chunks packed in a single word
+ * array. The indexes are referring to the vertexes of the polygon, so the
+ * chain can be shared between all polygons with the same shape. */
+class TeselChain {
+   public:
+      class const_iterator {
+         public:
+                              const_iterator(const word* data) : _chunk(data) {}
+            const TeselChunk* operator->() const {return &_chunk;}
+            const TeselChunk& operator*()  const {return  _chunk;}
+            const_iterator&   operator++()       {_chunk = TeselChunk(_chunk.index_seq() + _chunk.size()); return *this;}
+            const_iterator    operator++(int)    {const_iterator tmp(*this); ++(*this); return tmp;}
+            bool              operator==(const const_iterator& o) const {return _chunk.index_seq() == o._chunk.index_seq();}
+            bool              operator!=(const const_iterator& o) const {return _chunk.index_seq() != o._chunk.index_seq();}
+         private:
+            TeselChunk        _chunk;
+      };
+                        TeselChain(const TeselVertices&, word, word, word);
+                        TeselChain(unsigned);
+                       ~TeselChain();
+      const_iterator    begin() const              { return const_iterator(_data);          }
+      const_iterator    end() const                { return const_iterator(_data + _length);}
+      word              num_ftrs() const           { return _all_ftrs;}
+      word              num_ftfs() const           { return _all_ftfs;}
+      word              num_ftss() const           { return _all_ftss;}
+      unsigned          length() const             { return _length;  }
+   private:
+                        TeselChain(const TeselChain&);
+      TeselChain&       operator=(const TeselChain&);
+      word*             _data;
+      unsigned          _length;     //! the size of _data in words
+      word              _all_ftrs;
+      word              _all_ftfs;
+      word              _all_ftss;
+};
 
 class TeselTempData {
    public:
-                        TeselTempData(unsigned);
-                        TeselTempData(TeselChain* tc);
-      void              setChainP(TeselChain* tc)  {_the_chain = tc;}
-      void              newChunk(GLenum type)      {_ctype = type; _cindexes.clear();}
+                        TeselTempData();
+      void              newChunk(GLenum type);
       void              newIndex(word vx)          {_cindexes.push_back(vx);}
       void              storeChunk();
-      word              num_ftrs()                 { return _all_ftrs;}
-      word              num_ftfs()                 { return _all_ftfs;}
-      word              num_ftss()                 { return _all_ftss;}
+      TeselChain*       chain() const;
    private:
-      TeselChain*       _the_chain;
-      GLenum            _ctype;
       TeselVertices     _cindexes;
+      unsigned          _chunkStart;
       word              _all_ftrs;
       word              _all_ftfs;
       word              _all_ftss;
-      unsigned          _offset;
 };
 
+/*! The tessellation data of a polygon in the DB. The tessellation is
+ * calculated on the first request (see tessellate()) - i.e. only if the
+ * polygon is rendered filled. The result is shared between all polygons with
+ * the same shape (the same vertex sequence regardless of its position). The
+ * shapes are looked-up by the number of vertexes and a 64 bit hash of the
+ * vertex sequence. The vertex sequences are compared on a hit, so a hash
+ * collision can't produce a wrong tessellation.\n
+ * The polygons are triangulated by the PolyTriangulator. The GLU tessellator
+ * is used only for the polygons which it can't handle.\n
+ * A polygon shall not be rendered by more than one thread simultaneously
+ * (see trend::TrendBase::layerJob()). The GLU tessellator and the shared data
+ * are protected internally.*/
 class TessellPoly {
    public:
                         TessellPoly();
-      void              tessellate(const int4b* pdata, unsigned psize);
-      const TeselChain* tdata() const              { return &_tdata;  }
-      word              num_ftrs() const           { return _all_ftrs;}
-      word              num_ftfs() const           { return _all_ftfs;}
-      word              num_ftss() const           { return _all_ftss;}
-      bool              valid() const              { return (0 < (_all_ftrs + _all_ftfs + _all_ftss));}
+                       ~TessellPoly();
+      void              tessellate(const int4b* pdata, unsigned psize) const;
+      void              clear();
+      const TeselChain* tdata() const              { assert(_shared); return _shared->_chain;          }
+      word              num_ftrs() const           { assert(_shared); return _shared->_chain->num_ftrs();}
+      word              num_ftfs() const           { assert(_shared); return _shared->_chain->num_ftfs();}
+      word              num_ftss() const           { assert(_shared); return _shared->_chain->num_ftss();}
+      bool              valid() const              { return (NULL != _shared) && (0 < _shared->_chain->length());}
       void              num_indexs(unsigned&, unsigned&, unsigned&) const;
+      struct Stats {
+         unsigned       _polys;      //! tessellated polygons
+         unsigned       _shapes;     //! different shapes among them
+         unsigned       _words;      //! tessellation data of the shapes
+         unsigned       _unshared;   //! tessellation data if it wasn't shared
+         unsigned       _vertexes;   //! vertexes stored to identify the shapes
+      };
+      static void       stats(Stats&);
+#ifdef TPD_BENCH
+      static real       triangleArea(const int4b*, unsigned, bool);
+#endif
       static GLUtriangulatorObj* tenderTesel; //! A pointer to the OpenGL object tesselator
 #ifdef WIN32
       static GLvoid CALLBACK teselVertex(GLvoid *, GLvoid *);
@@ -108,10 +157,25 @@ class TessellPoly {
       static GLvoid     teselEnd(GLvoid *);
 #endif
    private:
-      TeselChain        _tdata;
-      word              _all_ftrs;
-      word              _all_ftfs;
-      word              _all_ftss;
+      typedef std::pair<unsigned, qword> ShapeKey;
+      struct SharedChain {
+                        SharedChain(const TeselChain*, const ShapeKey&, const int4b*);
+                       ~SharedChain();
+         bool           sameShape(const int4b*) const;
+         const TeselChain* _chain;
+         ShapeKey          _key;
+         int4b*            _shape;      //! the vertexes relative to the first one
+         unsigned          _refs;
+      };
+      typedef std::multimap<ShapeKey, SharedChain*> SharedChains;
+                        TessellPoly(const TessellPoly&);
+      TessellPoly&      operator=(const TessellPoly&);
+      bool              shareChain(const ShapeKey&, const int4b*) const;
+      static TeselChain* nativeTessellate(const int4b*, unsigned);
+      static TeselChain* gluTessellate(const int4b*, unsigned);
+      mutable SharedChain* _shared;     //! NULL until the first tessellate() call
+      static SharedChains  _sharedChains;
+      static unsigned      _numPolys;   //! polygons referring to _sharedChains
 };
 
 
@@ -225,6 +289,7 @@ namespace trend {
                            TrxText(const std::string*, const CTM&);
          void              draw(bool, layprop::DrawProperties*) const;
          const CTM&        ctm() const {return _ctm;}
+         const std::string& text() const{return *_text;}
       private:
          const std::string* _text;
          CTM                _ctm; //! Font Translation matrix
@@ -479,6 +544,31 @@ namespace trend {
    // Cell references
    //
    //==========================================================================
+   /**
+   *  The visible elements of a cell array which are expanded by the vertex
+   *  shader (see TrendBase::pushArray()). The element cols x rows is drawn
+   *  with instance number (row * cols + col). The steps are in the coordinates
+   *  of the top cell of the view. The default object is a single element
+   *  without displacement - it describes all other cell references.
+   */
+   class TrxCellArray {
+      public:
+                           TrxCellArray();
+                           TrxCellArray(word, word, real, real, real, real);
+         word              cols() const         {return _cols;}
+         word              rows() const         {return _rows;}
+         unsigned          numElements() const  {return (unsigned)_cols * (unsigned)_rows;}
+         bool              expanded() const     {return 1u < numElements();}
+         CTM               displ(word, word) const;
+         DBbox             clipRegion(const DBbox&) const;
+         void              viewSteps(const CTM&, float*, float*) const;
+      private:
+         word              _cols;
+         word              _rows;
+         real              _colStep[2];
+         real              _rowStep[2];
+   };
+
    /**
    *  Cell reference boxes & reference related data
    */
@@ -490,6 +580,8 @@ namespace trend {
          real* const       translation()  {return _translation;}
          const CTM&        ctm() const    {return _ctm;}
          word              alphaDepth()   {return _alphaDepth;}
+         const TrxCellArray& cellArray() const {return _cellArray;}
+         void              setCellArray(const TrxCellArray& cArray) {_cellArray = cArray;}
          unsigned          cDataCopy(TNDR_GLDATAT*, unsigned&);
          void              drctDrawContour();
       private:
@@ -498,6 +590,7 @@ namespace trend {
          CTM               _ctm;
          TNDR_GLDATAT      _obox[8];
          word              _alphaDepth;
+         TrxCellArray      _cellArray;    //! The array elements placed by the shader (if expanded)
    };
 
 }
@@ -0,0 +1,204 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Rendering statistics (frame profile)
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include <sstream>
+#include <iomanip>
+#include "trendstat.h"
+#include "trendat.h"
+
+static const char* phaseNames[trend::rspNumPhases] =
+   {"traverse", "collect", "draw", "texts", "grid", "overlay"};
+
+bool     trend::RenderStats::_enabled   = false;
+unsigned trend::RenderStats::_drawCalls = 0u;
+
+//=============================================================================
+trend::RenderStats::LayStats::LayStats() :
+   _shapes     ( 0u   ),
+   _chunks     ( 0u   ),
+   _reused     ( 0u   ),
+   _vertexes   ( 0u   ),
+   _indexes    ( 0u   ),
+   _strings    ( 0u   ),
+   _tessel     ( 0.0  )
+{}
+
+void trend::RenderStats::LayStats::add(const LayStats& lstat)
+{
+   _shapes   += lstat._shapes;
+   _chunks   += lstat._chunks;
+   _reused   += lstat._reused;
+   _vertexes += lstat._vertexes;
+   _indexes  += lstat._indexes;
+   _strings  += lstat._strings;
+   _tessel   += lstat._tessel;
+}
+
+//=============================================================================
+trend::RenderStats::RenderStats() :
+   _numDrawCalls  ( 0u )
+{
+   for (int i = 0; i < rspNumPhases; i++)
+      _time[i] = 0.0;
+}
+
+void trend::RenderStats::clear()
+{
+   for (int i = 0; i < rspNumPhases; i++)
+      _time[i] = 0.0;
+   _layers.clear();
+   _numDrawCalls = 0u;
+}
+
+trend::RenderStats::LayStats trend::RenderStats::totals() const
+{
+   LayStats total;
+   for (LayStatsMap::const_iterator CL = _layers.begin(); CL != _layers.end(); CL++)
+      total.add(CL->second);
+   return total;
+}
+
+/*! The profile in a human readable form (for the log window)*/
+std::string trend::RenderStats::report() const
+{
+   std::ostringstream ost;
+   ost << std::fixed << std::setprecision(3);
+   ost << "Frame profile (msec):";
+   for (int i = 0; i < rspNumPhases; i++)
+      ost << " " << phaseNames[i] << " " << _time[i] << ";";
+   LayStats total = totals();
+   ost << " tessellation " << total._tessel << std::endl;
+   ost << "   " << _layers.size()   << " layers, "
+                << total._shapes    << " shapes, "
+                << total._chunks    << " chunks generated, "
+                << total._reused    << " chunks reused, "
+                << total._vertexes  << " vertexes, "
+                << total._indexes   << " indexes, "
+                << total._strings   << " strings, "
+                << _numDrawCalls    << " draw calls" << std::endl;
+   TessellPoly::Stats tstats;
+   TessellPoly::stats(tstats);
+   ost << "   " << tstats._polys    << " tessellated polygons, "
+                << tstats._shapes   << " shapes, "
+                << tstats._words    << " index words ("
+                << tstats._unshared << " if not shared), "
+                << tstats._vertexes << " shape vertexes";
+   return ost.str();
+}
+
+/*! The profile as a JSON object. renderer is the type of the renderer which
+ * generated the frame.*/
+std::string trend::RenderStats::json(const std::string& renderer) const
+{
+   std::ostringstream ost;
+   ost << std::fixed << std::setprecision(3);
+   ost << "{\n  \"renderer\": \"" << renderer << "\",\n  \"phases\": {";
+   for (int i = 0; i < rspNumPhases; i++)
+      ost << ((0 == i) ? "" : ",") << "\n    \"" << phaseNames[i] << "\": " << _time[i];
+   TessellPoly::Stats tstats;
+   TessellPoly::stats(tstats);
+   ost << "\n  },\n  \"draw_calls\": " << _numDrawCalls
+       << ",\n  \"tessellation\": {\"polygons\": " << tstats._polys
+       <<     ", \"shapes\": "         << tstats._shapes
+       <<     ", \"index_words\": "    << tstats._words
+       <<     ", \"unshared_words\": " << tstats._unshared
+       <<     ", \"shape_vertexes\": " << tstats._vertexes << "}"
+       << ",\n  \"layers\": [";
+   for (LayStatsMap::const_iterator CL = _layers.begin(); CL != _layers.end(); CL++)
+   {
+      const LayStats& lstat = CL->second;
+      ost << ((_layers.begin() == CL) ? "" : ",")
+          << "\n    {\"layer\": "     << CL->first.num()
+          <<     ", \"datatype\": "   << CL->first.typ()
+          <<     ", \"shapes\": "     << lstat._shapes
+          <<     ", \"chunks\": "     << lstat._chunks
+          <<     ", \"reused\": "     << lstat._reused
+          <<     ", \"vertexes\": "   << lstat._vertexes
+          <<     ", \"indexes\": "    << lstat._indexes
+          <<     ", \"strings\": "    << lstat._strings
+          <<     ", \"tessellation\": " << lstat._tessel << "}";
+   }
+   ost << "\n  ]\n}\n";
+   return ost.str();
+}
+
+/*! The contents of the frame without the timing - the numbers per layer
+ * which don't depend on the way the frame was rendered. Two renderings of the
+ * same view with different number of threads (see TrendBase::layerJob()) must
+ * have the same digest. The reused chunks are not included, because they
+ * depend on the state of the scene cache.*/
+std::string trend::RenderStats::digest() const
+{
+   std::ostringstream ost;
+   for (LayStatsMap::const_iterator CL = _layers.begin(); CL != _layers.end(); CL++)
+   {
+      const LayStats& lstat = CL->second;
+      ost << CL->first.num()  << "/" << CL->first.typ() << ":"
+          << " "  << lstat._shapes
+          << " "  << lstat._vertexes
+          << " "  << lstat._indexes
+          << " "  << lstat._strings << ";";
+   }
+   return ost.str();
+}
+
+/*! Finds the phase with the name pname (as it appears in the profile). Returns
+ * false if there is no such phase*/
+bool trend::RenderStats::phase(const std::string& pname, RenderPhase& rphase)
+{
+   for (int i = 0; i < rspNumPhases; i++)
+   {
+      if (pname == phaseNames[i])
+      {
+         rphase = (RenderPhase)i;
+         return true;
+      }
+   }
+   return false;
+}
+
+/*! The time (in msec) measured by the watch. The microseconds are available
+ * since wx 2.9.3 only*/
+double trend::RenderStats::elapsed(const wxStopWatch& watch)
+{
+#if wxCHECK_VERSION(2,9,3)
+   return watch.TimeInMicro().ToDouble() / 1000.0;
+#else
+   return (double)watch.Time();
+#endif
+}
+
+//=============================================================================
+trend::RenderTimer::RenderTimer(RenderStats& stats, RenderPhase phase) :
+   _stats      ( stats  ),
+   _phase      ( phase  )
+{}
+
+trend::RenderTimer::~RenderTimer()
+{
+   if (RenderStats::enabled())
+      _stats.addTime(_phase, RenderStats::elapsed(_watch));
+}
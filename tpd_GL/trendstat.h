@@ -0,0 +1,110 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Rendering statistics (frame profile)
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef TRENDSTAT_H_INCLUDED
+#define TRENDSTAT_H_INCLUDED
+
+#include <map>
+#include <string>
+#include <wx/stopwatch.h>
+#include "ttt.h"
+
+namespace trend {
+
+   typedef enum { rspTraverse  // DB traversing (including the tessellation)
+                 ,rspCollect   // VBO copy
+                 ,rspDraw      // drawing of the DB data (including the texts)
+                 ,rspTexts     // drawing of the texts
+                 ,rspGrid      // grid collect & draw
+                 ,rspOverlay   // rulers & zero cross
+                 ,rspNumPhases
+                } RenderPhase;
+
+   /**
+    * The profile of a rendered frame - the time spent in every phase of the
+    * rendering and some numbers per layer which explain where did the time go.
+    * All times are in milliseconds. The statistics are gathered only if they
+    * are enabled (setparams({"RENDER_STATS", "true"})). If they are not, the
+    * overhead is a check of a static flag per phase.\n
+    * The timing of the phases is done by the DataCenter (see RenderTimer). The
+    * numbers per layer are gathered from the renderer when the frame is done
+    * (TrendBase::frameStats()). The draw calls are counted by the VBO and the
+    * shader renderers in the openGL thread (drawCalls()).
+    */
+   class RenderStats {
+      public:
+         struct LayStats {
+                           LayStats();
+            void           add(const LayStats&);
+            unsigned       _shapes;    //! shapes registered during the traversing
+            unsigned       _chunks;    //! chunks (TrendTV) generated in this frame
+            unsigned       _reused;    //! chunks reused (see TrendReTV & TenderCache)
+            unsigned       _vertexes;  //! vertexes copied to the VBOs
+            unsigned       _indexes;   //! indexes copied to the VBOs
+            unsigned       _strings;   //! texts to be drawn
+            double         _tessel;    //! tessellation time (summed over the threads)
+         };
+         typedef std::map<LayerDef, LayStats> LayStatsMap;
+                           RenderStats();
+         void              clear();
+         void              addTime(RenderPhase phase, double msec) {_time[phase] += msec;}
+         void              setLayer(const LayerDef& laydef, const LayStats& lstat)
+                                                               {_layers[laydef] = lstat;}
+         void              setDrawCalls()                      {_numDrawCalls = _drawCalls;}
+         double            time(RenderPhase phase) const       {return _time[phase];}
+         std::string       report() const;
+         std::string       json(const std::string& renderer) const;
+         std::string       digest() const;
+         static bool       enabled()                           {return _enabled;}
+         static void       setEnabled(bool enabled)            {_enabled = enabled;}
+         static void       drawCalls(unsigned num = 1)         {_drawCalls += num;}
+         static void       newFrame()                          {_drawCalls = 0u;}
+         static double     elapsed(const wxStopWatch&);
+         static bool       phase(const std::string&, RenderPhase&);
+      private:
+         LayStats          totals() const;
+         double            _time[rspNumPhases];
+         LayStatsMap       _layers;
+         unsigned          _numDrawCalls;
+         static bool       _enabled;
+         static unsigned   _drawCalls; //! draw calls since the last newFrame() (openGL thread only)
+   };
+
+   /**
+    * Adds the time of its own life to a RenderStats phase if the statistics
+    * are enabled.
+    */
+   class RenderTimer {
+      public:
+                           RenderTimer(RenderStats& stats, RenderPhase phase);
+                          ~RenderTimer();
+      private:
+         RenderStats&      _stats;
+         RenderPhase       _phase;
+         wxStopWatch       _watch;
+   };
+
+}
+
+#endif //TRENDSTAT_H_INCLUDED
@@ -42,23 +42,40 @@
 #include "trend.h"
 #include "ps_out.h"
 #include "basetrend.h"
+#include "offscreen.h"
 
 
 
 #ifdef RENDER_PROFILING
    #define RENTIMER_REPORT(message) rendTimer.report(message)
    #define RENTIMER_SET             HiResTimer rendTimer
-
+   #define RENCACHE_REPORT          tell_log(console::MT_INFO, TRENDC->sceneCacheReport())
 #else
    #define RENTIMER_REPORT(message)
    #define RENTIMER_SET
+   #define RENCACHE_REPORT
 #endif
 
+// The visual limit multiplier of the coarse views (see DataCenter::renderAsync())
+#define COARSE_VISUAL_SCALE 16
+
 // Global variables
 DataCenter*                      DATC  = NULL;
 extern layprop::PropertyCenter*  PROPC;
 extern trend::TrendCenter*       TRENDC;
 
+//-----------------------------------------------------------------------------
+// class RenderThread
+//-----------------------------------------------------------------------------
+wxThread::ExitCode RenderThread::Entry()
+{
+   _status = _datc->bgTraverse(_renderer);
+   _done = true;
+   if (_status)
+      TpdPost::render_ready();
+   return NULL;
+}
+
 //-----------------------------------------------------------------------------
 // class DataCenter
 //-----------------------------------------------------------------------------
@@ -80,7 +97,10 @@ DataCenter::DataCenter(const std::string& localDir, const std::string& globalDir
    _bpSync         ( NULL                                   ),
    _tdtActMxState  ( dbmxs_unlocked                         ),
    _tdtReqMxState  ( dbmxs_unlocked                         ),
-   _objectRecovery ( laydata::ValidRecovery::getInstance()  )
+   _objectRecovery ( laydata::ValidRecovery::getInstance()  ),
+   _renderThread   ( NULL                                   ),
+   _dbStamp        ( 0                                      ),
+   _renderStamp    ( 0                                      )
 
 {
    laydata::TdtLibrary::initHierTreePtr();
@@ -88,6 +108,7 @@ DataCenter::DataCenter(const std::string& localDir, const std::string& globalDir
 
 DataCenter::~DataCenter()
 {
+   stopRender();
    laydata::TdtLibrary::clearEntireHierTree();
    if (NULL != _GDSDB    ) delete _GDSDB;
    if (NULL != _CIFDB    ) delete _CIFDB;
@@ -249,7 +270,13 @@ bool DataCenter::OASParse(std::string filename)
    }
    try
    {
+#ifdef GDSCONVERT_PROFILING
+      HiResTimer profTimer;
+#endif
       AOASDB = DEBUG_NEW Oasis::OasisInFile(wxString(filename.c_str(), wxConvUTF8));
+#ifdef GDSCONVERT_PROFILING
+      profTimer.report("Time elapsed for OASIS parse: ");
+#endif
    }
    catch (EXPTNreadOASIS&)
    {
@@ -338,6 +365,8 @@ bool DataCenter::lockTDT(laydata::TdtLibDir*& tdt_db, TdtMutexState reqLock)
    {
       // OK, the mutex is locked!
       tdt_db = &_TEDLIB;
+      // invalidates the background traversal (if any) - see renderFinish()
+      _dbStamp++;
       if (_TEDLIB())
          if (_TEDLIB()->checkActiveCell())
             _tdtActMxState = dbmxs_celllock;
@@ -829,6 +858,47 @@ void DataCenter::setRecoverWire(bool rcv)
    unlockTDT(dbLibDir, true);
 }
 
+void DataCenter::setLogicThreads(word threads)
+{
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (lockTDT(dbLibDir, dbmxs_liblock))
+   {
+      logicop::LayerLogic::setThreads(threads);
+   }
+   unlockTDT(dbLibDir, true);
+}
+
+void DataCenter::setImportThreads(word threads)
+{
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (lockTDT(dbLibDir, dbmxs_liblock))
+   {
+      ImportDB::setThreads(threads);
+   }
+   unlockTDT(dbLibDir, true);
+}
+
+void DataCenter::setRenderThreads(word threads)
+{
+   // The DB lock ensures that the render thread is not traversing the view
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (lockTDT(dbLibDir, dbmxs_liblock))
+   {
+      trend::TrendBase::setThreads(threads);
+   }
+   unlockTDT(dbLibDir, true);
+}
+
+void DataCenter::setQTreeThreads(word threads)
+{
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (lockTDT(dbLibDir, dbmxs_liblock))
+   {
+      laydata::QTreeBuild::setThreads(threads);
+   }
+   unlockTDT(dbLibDir, true);
+}
+
 void DataCenter::render()
 {
    if (_TEDLIB())
@@ -836,23 +906,29 @@ void DataCenter::render()
       trend::TrendBase* cRenderer = TRENDC->makeCRenderer();
       if (NULL != cRenderer)
       {
-         // grid
-         const layprop::LayoutGrid* allGrids[3] = {PROPC->grid(0),PROPC->grid(1),PROPC->grid(2)};
-         if (cRenderer->grdCollect(allGrids))
-            cRenderer->grdDraw();
+         trend::RenderStats::newFrame();
+         renderGrid(cRenderer);
          if (wxMUTEX_NO_ERROR == _DBLock.TryLock())
          {
             TpdPost::render_status(true);
             RENTIMER_SET;
+            updateSceneCache();
+            updateLod(cRenderer);
+            TRENDC->checkSceneCache();
+            RENTIMER_REPORT("Time elapsed for scene cache check: ");
             // There is no need to check for an active cell. If there isn't one
             // the function will return silently.
-            _TEDLIB()->openGlRender(*cRenderer);
+            {
+               trend::RenderTimer timer(cRenderer->stats(), trend::rspTraverse);
+               _TEDLIB()->openGlRender(*cRenderer);
+            }
             RENTIMER_REPORT("Time elapsed for data traversing: ");
-            if (cRenderer->collect())
+            if (renderCollect(cRenderer))
             {
                RENTIMER_REPORT("Time elapsed for data copying   : ");
-               cRenderer->draw();
+               renderDraw(cRenderer);
                RENTIMER_REPORT("    Total elapsed rendering time: ");
+               RENCACHE_REPORT;
             }
             cRenderer->grcCollect();
             VERIFY(wxMUTEX_NO_ERROR == _DBLock.Unlock());
@@ -863,24 +939,303 @@ void DataCenter::render()
             // If DB is locked - skip the DB drawing, but draw all the property DB stuff
             tell_log(console::MT_INFO,std::string("DB busy. Viewport redraw skipped"));
          }
-         // rulers & zero cross
-         layprop::RulerList const rulers = PROPC->getAllRulers();
-         DBlineList const zCross = PROPC->getZCross();
-         if (cRenderer->rlrCollect(rulers, PROPC->stepDB(),zCross))
-            cRenderer->rlrDraw();
-         TRENDC->releaseCRenderer();
-
-         // Draw DRC data (if any)
-         trend::TrendBase* dRenderer = TRENDC->getDRenderer();
-         if (NULL != dRenderer)
-         {
-            dRenderer->draw();
-            TRENDC->releaseDRenderer();
-         }
+         renderOverlay(cRenderer, true);
+      }
+   }
+}
+
+/*! The background variant of render(). The view is drawn in two steps:
+ * - coarse - the objects which are big enough on the screen (see
+ *   COARSE_VISUAL_SCALE) are traversed and drawn straight away. This
+ *   traversal is cheap, because all quad tree nodes and cells which are too
+ *   small are skipped together with their contents.
+ * - full - the entire view is traversed by a RenderThread. When it is done,
+ *   the canvas is notified and the view is completed by renderFinish().
+ *
+ * Any background traversal in progress is abandoned - it is for an obsolete
+ * view. Must be called by the thread holding the openGL context. */
+void DataCenter::renderAsync()
+{
+   stopRender();
+   if (!_TEDLIB()) return;
+   trend::TrendBase* cRenderer = TRENDC->makeCRenderer(COARSE_VISUAL_SCALE);
+   if (NULL == cRenderer) return;
+   renderGrid(cRenderer);
+   if (wxMUTEX_NO_ERROR == _DBLock.TryLock())
+   {
+      RENTIMER_SET;
+      // the changed cells must reach the scene cache before it is checked
+      // by makeBRenderer() below. Otherwise their new chunks are dropped as
+      // stale by the next view
+      updateSceneCache();
+      updateLod(cRenderer);
+      _TEDLIB()->openGlRender(*cRenderer);
+      RENTIMER_REPORT("Time elapsed for coarse traversing: ");
+      if (cRenderer->collect())
+      {
+         cRenderer->draw();
+         RENTIMER_REPORT("  Total elapsed coarse rendering: ");
       }
+      cRenderer->grcCollect();
+      VERIFY(wxMUTEX_NO_ERROR == _DBLock.Unlock());
+   }
+   // If DB is locked - the message will come from the background traversal
+   renderOverlay(cRenderer, false);
+   // now the full view
+   trend::TrendBase* bRenderer = TRENDC->makeBRenderer();
+   if (NULL == bRenderer) return;
+   RenderThread* rthrd = DEBUG_NEW RenderThread(this, bRenderer);
+   if (wxTHREAD_NO_ERROR == rthrd->Create())
+   {
+      _renderThread = rthrd;
+      TpdPost::render_status(true);
+      rthrd->Run();
+   }
+   else
+   {
+      tell_log(console::MT_ERROR, "Can't traverse the view in a separate thread");
+      delete rthrd;
+      delete bRenderer;
    }
 }
 
+/*! Returns true if the background traversal is done and the view can be
+ * completed by renderFinish()*/
+bool DataCenter::renderDone() const
+{
+   return ((NULL != _renderThread) && _renderThread->done());
+}
+
+/*! Completes the view started by renderAsync(). Returns false if there is
+ * nothing to draw. Must be called by the thread holding the openGL context.*/
+bool DataCenter::renderFinish()
+{
+   if (!renderDone()) return false;
+   _renderThread->Wait();
+   trend::TrendBase* bRenderer = _renderThread->renderer();
+   bool status = _renderThread->status();
+   delete _renderThread;
+   _renderThread = NULL;
+   TpdPost::render_status(false);
+   if (!status)
+   {
+      delete bRenderer;
+      return false;
+   }
+   // The traversed data is pointing to the DB shapes, so the collecting must
+   // be protected the same way as the traversing. Besides, the DB shouldn't
+   // have been locked for changes since the traversal - see lockTDT()
+   if (wxMUTEX_NO_ERROR != _DBLock.TryLock())
+   {
+      tell_log(console::MT_INFO,std::string("DB busy. Viewport redraw skipped"));
+      delete bRenderer;
+      return false;
+   }
+   if (_renderStamp != _dbStamp)
+   {
+      // the traversed data is stale - start over
+      VERIFY(wxMUTEX_NO_ERROR == _DBLock.Unlock());
+      delete bRenderer;
+      renderAsync();
+      return false;
+   }
+   trend::TrendBase* cRenderer = TRENDC->useBRenderer(bRenderer);
+   if (NULL == cRenderer)
+   {
+      VERIFY(wxMUTEX_NO_ERROR == _DBLock.Unlock());
+      tell_log(console::MT_INFO,std::string("Property DB busy. Viewport redraw skipped"));
+      return false;
+   }
+   trend::RenderStats::newFrame();
+   renderGrid(cRenderer);
+   RENTIMER_SET;
+   if (renderCollect(cRenderer))
+   {
+      RENTIMER_REPORT("Time elapsed for data copying   : ");
+      renderDraw(cRenderer);
+      RENTIMER_REPORT("      Total elapsed drawing time: ");
+      RENCACHE_REPORT;
+   }
+   cRenderer->grcCollect();
+   VERIFY(wxMUTEX_NO_ERROR == _DBLock.Unlock());
+   renderOverlay(cRenderer, true);
+   return true;
+}
+
+/*! Abandons the background traversal (if any). Doesn't return before the
+ * RenderThread is finished, but that doesn't take long, because the traversal
+ * is checking regularly whether it was cancelled.*/
+void DataCenter::stopRender()
+{
+   if (NULL == _renderThread) return;
+   _renderThread->cancel();
+   _renderThread->Wait();
+   delete _renderThread->renderer();
+   delete _renderThread;
+   _renderThread = NULL;
+}
+
+/*! Renders the view of the request in an off-screen buffer with the size
+ * requested and saves the image. This is the same rendering pipeline as the
+ * one of the canvas, but the frame is always rendered in the foreground
+ * (render()) and the rendering statistics are always collected. The screen
+ * CTM of the property DB is left pointing to the off-screen view. Returns
+ * false if the off-screen buffer can't be created. Must be called by the
+ * thread holding the openGL context - the canvas in the GUI, or the main
+ * thread of toped-batch with a headless context. A background traversal in
+ * progress must be stopped beforehand (see stopRender()).*/
+bool DataCenter::renderOffScreen(trend::OffScreenView& request)
+{
+   trend::OffScreen offScreen(request._width, request._height);
+   if (!offScreen.status()) return false;
+   CTM viewCTM = trend::fitView(request._view, request._width, request._height);
+   TP vpBL = TP(0,0) * viewCTM;
+   TP vpTR = TP(request._width, request._height) * viewCTM;
+   layprop::DrawProperties* drawProp;
+   if (PROPC->lockDrawProp(drawProp))
+   {
+      drawProp->setScrCTM(viewCTM.Reversed());
+      drawProp->setClipRegion(DBbox(vpBL.x(),vpTR.y(), vpTR.x(), vpBL.y()));
+   }
+   PROPC->unlockDrawProp(drawProp, false);
+   offScreen.bind();
+   glMatrixMode( GL_MODELVIEW );
+   glShadeModel( GL_FLAT ); // Single colour
+   CTM ctmOrtho(TP(vpBL.x(),vpTR.y()), TP(vpTR.x(), vpBL.y()));
+   real mtrxOrtho [16];
+   ctmOrtho.oglForm(mtrxOrtho);
+   glLoadMatrixd(mtrxOrtho);
+   glClearColor(0,0,0,0);
+   glClear(GL_COLOR_BUFFER_BIT);
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   bool statsEnabled = trend::RenderStats::enabled();
+   trend::RenderStats::setEnabled(true);
+   render();
+   trend::RenderStats::setEnabled(statsEnabled);
+   request._stats = TRENDC->frameStats(true);
+   if (!request._fileName.empty())
+   {
+      byte* theImage = offScreen.pixels();
+      if (!trend::saveTarga(request._fileName, theImage, request._width, request._height))
+      {
+         std::ostringstream info;
+         info << "Can't write the image file \""<< request._fileName <<"\"";
+         tell_log(console::MT_ERROR,info.str());
+      }
+      delete [] theImage;
+   }
+   offScreen.release();
+   return true;
+}
+
+/*! Executed by the RenderThread. Returns true if the entire view has been
+ * traversed into bRenderer*/
+bool DataCenter::bgTraverse(trend::TrendBase* bRenderer)
+{
+   // The property DB is locked only for the time required to take a snapshot
+   // of it. The traversal is using the snapshot, so the GUI thread is free
+   // to change the properties (mouse input, menus) in the meantime.
+   layprop::DrawProperties* drawProp;
+   while (!PROPC->tryLockDrawProp(drawProp))
+   {
+      if (bRenderer->cancelled()) return false;
+      wxMilliSleep(5);
+   }
+   layprop::DrawProperties* snapProp = DEBUG_NEW layprop::DrawProperties(*drawProp);
+   PROPC->unlockDrawProp(drawProp, false);
+   bRenderer->setDrawProp(snapProp);
+   bool status = false;
+   if (wxMUTEX_NO_ERROR == _DBLock.TryLock())
+   {
+      _renderStamp = _dbStamp;
+      RENTIMER_SET;
+      if (_TEDLIB())
+      {
+         // normally done by renderAsync() already - unless the DB was busy
+         updateSceneCache();
+         updateLod(bRenderer);
+         trend::RenderTimer timer(bRenderer->stats(), trend::rspTraverse);
+         _TEDLIB()->openGlRender(*bRenderer);
+      }
+      RENTIMER_REPORT("Time elapsed for data traversing: ");
+      VERIFY(wxMUTEX_NO_ERROR == _DBLock.Unlock());
+      status = !bRenderer->cancelled();
+   }
+   else
+      tell_log(console::MT_INFO,std::string("DB busy. Viewport redraw skipped"));
+   // renderFinish() will set the property DB again - see useBRenderer()
+   bRenderer->setDrawProp(drawProp);
+   delete snapProp;
+   return status;
+}
+
+/*! Passes the cells changed since the last view to the scene cache, so their
+ * chunks are not reused (see trend::TenderCache). Must be called with the DB
+ * locked, before the traversing*/
+void DataCenter::updateSceneCache()
+{
+   NameSet changed;
+   if (_TEDLIB()->takeChanged(changed))
+      TRENDC->invalidateSceneCache();
+   else if (!changed.empty())
+      TRENDC->invalidateSceneCache(changed);
+}
+
+/*! Builds the LOD data of the quad trees if the view is going to be rendered
+ * in LOD mode. The traversing only reads that data, so this must be called
+ * with the DB locked, before the traversing*/
+void DataCenter::updateLod(trend::TrendBase* cRenderer)
+{
+   if (cRenderer->drawprop()->lodRender())
+      _TEDLIB.buildLod();
+}
+
+bool DataCenter::renderCollect(trend::TrendBase* cRenderer)
+{
+   trend::RenderTimer timer(cRenderer->stats(), trend::rspCollect);
+   return cRenderer->collect();
+}
+
+void DataCenter::renderDraw(trend::TrendBase* cRenderer)
+{
+   trend::RenderTimer timer(cRenderer->stats(), trend::rspDraw);
+   cRenderer->draw();
+}
+
+void DataCenter::renderGrid(trend::TrendBase* cRenderer)
+{
+   trend::RenderTimer timer(cRenderer->stats(), trend::rspGrid);
+   const layprop::LayoutGrid* allGrids[3] = {PROPC->grid(0),PROPC->grid(1),PROPC->grid(2)};
+   if (cRenderer->grdCollect(allGrids))
+      cRenderer->grdDraw();
+}
+
+/*! Draws everything on top of the DB data and releases cRenderer. If
+ * complete is true, cRenderer contains a complete frame and its profile is
+ * kept (see trend::RenderStats)*/
+void DataCenter::renderOverlay(trend::TrendBase* cRenderer, bool complete)
+{
+   {
+      trend::RenderTimer timer(cRenderer->stats(), trend::rspOverlay);
+      // rulers & zero cross
+      layprop::RulerList const rulers = PROPC->getAllRulers();
+      DBlineList const zCross = PROPC->getZCross();
+      if (cRenderer->rlrCollect(rulers, PROPC->stepDB(),zCross))
+         cRenderer->rlrDraw();
+   }
+   if (complete && trend::RenderStats::enabled())
+      TRENDC->setFrameStats(cRenderer->frameStats());
+   TRENDC->releaseCRenderer();
+
+   // Draw DRC data (if any)
+   trend::TrendBase* dRenderer = TRENDC->getDRenderer();
+   if (NULL != dRenderer)
+   {
+      dRenderer->draw();
+      TRENDC->releaseDRenderer();
+   }
+}
 
 void DataCenter::motionDraw(const CTM& layCTM, TP base, TP newp, bool rubber, const DBlineList repers)
 {
@@ -30,6 +30,10 @@
 #include "tedesign.h"
 #include "calbr_reader.h"
 
+namespace trend {
+   struct OffScreenView;
+}
+
 typedef enum {
    //                        mutex     Lib   DB  cell
    dbmxs_unlocked  = -1,
@@ -39,6 +43,31 @@ typedef enum {
    dbmxs_celllock  =  3  //    1        1    1    1
 } TdtMutexState;
 
+class DataCenter;
+
+//=============================================================================
+/*! Traverses the main DB into a renderer in a separate thread - see
+ * DataCenter::renderAsync(). The thread doesn't make any openGL calls. The
+ * renderer is created by the thread holding the openGL context, which takes
+ * it back for collecting and drawing when the traversal is done.*/
+class RenderThread : public wxThread {
+public:
+                              RenderThread(DataCenter* datc, trend::TrendBase* renderer) :
+                                 wxThread(wxTHREAD_JOINABLE), _datc(datc), _renderer(renderer),
+                                 _done(false), _status(false) {}
+   void                       cancel()             {_renderer->cancel();}
+   bool                       done() const         {return _done;}
+   bool                       status() const       {return _status;}
+   trend::TrendBase*          renderer() const     {return _renderer;}
+protected:
+   virtual ExitCode           Entry();
+private:
+   DataCenter*                _datc;
+   trend::TrendBase*          _renderer;
+   volatile bool              _done;      //! Entry() has finished
+   bool                       _status;    //! The renderer contains a complete view
+};
+
 class DataCenter {
 public:
                               DataCenter(const std::string&, const std::string &);
@@ -82,12 +111,22 @@ public:
    void                       mouseRotate();
    void                       motionDraw(const CTM&, TP, TP, bool, const DBlineList repers);
    void                       render();
+   void                       renderAsync();
+   bool                       renderDone() const;
+   bool                       renderFinish();
+   void                       stopRender();
+   bool                       renderOffScreen(trend::OffScreenView&);
+   bool                       bgTraverse(trend::TrendBase*);
    void                       mouseHooverDraw(TP&);
    void                       zoomDraw(const TP&,const TP&);
    void                       grcDraw();
    void                       drcCollect(int, std::string);
    void                       setRecoverPoly(bool);
    void                       setRecoverWire(bool);
+   void                       setLogicThreads(word);
+   void                       setImportThreads(word);
+   void                       setRenderThreads(word);
+   void                       setQTreeThreads(word);
    void                       setCmdLayer(const LayerDef& laydef) {_curcmdlay = laydef;}
    LayerDef                   curCmdLay() const                   {return _curcmdlay;}
    bool                       modified() const                    {return _TEDLIB.modified();};
@@ -102,6 +141,12 @@ public:
    std::string                localDir() const {return _localDir;}
 
 private:
+   void                       updateSceneCache();
+   void                       updateLod(trend::TrendBase*);
+   bool                       renderCollect(trend::TrendBase*);
+   void                       renderDraw(trend::TrendBase*);
+   void                       renderGrid(trend::TrendBase*);
+   void                       renderOverlay(trend::TrendBase*, bool);
    LayerDef                   _curcmdlay;    //! layer used during current drawing operation
    bool                       _drawruler;    //! draw a ruler while composing a shape interactively
    std::string                _localDir;
@@ -120,6 +165,9 @@ private:
    TdtMutexState              _tdtActMxState; //! The actual (current) mutex state of the main DB
    TdtMutexState              _tdtReqMxState; //! The required mutex state of the main DB
    laydata::ValidRecovery*    _objectRecovery;
+   RenderThread*              _renderThread; //! Background traversal of the current view (if any)
+   unsigned long              _dbStamp;      //! Incremented each time the main DB is locked for a TELL command
+   unsigned long              _renderStamp;  //! The value of _dbStamp when the background traversal was started
 };
 
 //=============================================================================
@@ -647,6 +647,8 @@ UNDO/REDO operation - some preliminary thoughts
 |  "addBox"        |  stdADDBOXr_D     |   OK   |    x   |   x    |                     |
 |  "addBox"        |  stdADDBOXp       |   OK   |    x   |   x    |                     |
 |  "addBox"        |  stdADDBOXp_D     |   OK   |    x   |   x    |                     |
+|  "addBoxes"      |  stdADDBOXES      |        |    x   |   x    |                     |
+|  "addBoxes"      |  stdADDBOXES_D    |        |    x   |   x    |                     |
 |  "addBox"        |  stdDRAWBOX       |   OK   |    x*  |   x    |   as add<blah-blah> |
 |  "addBox"        |  stdDRAWBOX_D     |   OK   |    x*  |   x    |   as add<blah-blah> |
 |  "addPoly"       |  stdADDPOLY       |   OK   |    x   |   x    |                     |
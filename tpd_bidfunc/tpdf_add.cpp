@@ -129,6 +129,94 @@ int tellstdfunc::stdADDBOX_D::execute()
    return stdADDBOX::execute();
 }
 
+//=============================================================================
+/*! Bulk version of addbox. All boxes are staged unsorted and the quad tree of
+ * the layer is built once - before the next function which needs the DB
+ * sorted. A single UNDO record is generated for the entire list.*/
+tellstdfunc::stdADDBOXES::stdADDBOXES(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor, parsercmd::sdbrUNSORTED)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtList(telldata::tn_box)));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+}
+
+void tellstdfunc::stdADDBOXES::undo_cleanup()
+{
+   telldata::TtLayer* tlay = TELL_UNDOOPS_CLEAN(telldata::TtLayer*);
+   telldata::TtList*  pl   = TELL_UNDOOPS_CLEAN(telldata::TtList*);
+   delete tlay;
+   delete pl;
+}
+
+void tellstdfunc::stdADDBOXES::undo()
+{
+   TEUNDO_DEBUG("addboxes(box list, layer) UNDO");
+   telldata::TtList*  pl   = TELL_UNDOOPS_UNDO(telldata::TtList*);
+   telldata::TtLayer* tlay = TELL_UNDOOPS_UNDO(telldata::TtLayer*);
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (DATC->lockTDT(dbLibDir, dbmxs_celllock))
+   {
+      laydata::TdtDesign* tDesign = (*dbLibDir)();
+      // Destroying the shapes one by one would traverse and validate the
+      // quad tree after every one of them - remove them all in one pass
+      laydata::ShapeList newShapes;
+      for (unsigned i = 0; i < pl->size(); i++)
+         newShapes.push_back(static_cast<telldata::TtLayout*>((pl->mlist())[i])->data());
+      tDesign->destroyThese(newShapes, tlay->value(), dbLibDir);
+   }
+   DATC->unlockTDT(dbLibDir, true);
+   delete pl;
+   delete tlay;
+   RefreshGL();
+}
+
+int tellstdfunc::stdADDBOXES::execute()
+{
+   telldata::TtLayer* tlay = static_cast<telldata::TtLayer*>(OPstack.top());OPstack.pop();
+   LayerDef laydef(tlay->value());
+   secureLayer(laydef);
+   telldata::TtList*  bl = static_cast<telldata::TtList*>(OPstack.top());OPstack.pop();
+   real DBscale = PROPC->DBscale();
+   PointVector corners;
+   corners.reserve(2 * bl->size());
+   for (unsigned i = 0; i < bl->size(); i++)
+   {
+      telldata::TtBox* w = static_cast<telldata::TtBox*>((bl->mlist())[i]);
+      corners.push_back(TP(w->p1().x(), w->p1().y(), DBscale));
+      corners.push_back(TP(w->p2().x(), w->p2().y(), DBscale));
+   }
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (DATC->lockTDT(dbLibDir, dbmxs_celllock))
+   {
+      laydata::TdtDesign* tDesign = (*dbLibDir)();
+      laydata::ShapeList newShapes;
+      tDesign->putBoxes(laydef, corners, newShapes);
+      telldata::TtList* pl = make_ttlaylist(newShapes, laydef);
+      UNDOcmdQ.push_front(this);
+      UNDOPstack.push_front(tlay->selfcopy());
+      OPstack.push(pl); UNDOPstack.push_front(pl->selfcopy());
+      LogFile << LogFile.getFN() << "("<< *bl << "," << *tlay << ");";LogFile.flush();
+   }
+   delete bl;
+   delete tlay;
+   DATC->unlockTDT(dbLibDir, true);
+   RefreshGL();
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdADDBOXES_D::stdADDBOXES_D(telldata::typeID retype, bool eor) :
+      stdADDBOXES(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor,parsercmd::sdbrUNSORTED)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtList(telldata::tn_box)));
+}
+
+int tellstdfunc::stdADDBOXES_D::execute()
+{
+   OPstack.push(getCurrentLayer());
+   return stdADDBOXES::execute();
+}
+
 //=============================================================================
 tellstdfunc::stdDRAWBOX::stdDRAWBOX(telldata::typeID retype, bool eor) :
       cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
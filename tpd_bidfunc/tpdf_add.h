@@ -35,6 +35,8 @@ namespace tellstdfunc {
    TELL_STDCMD_CLASSA_UNDO(stdADDBOX      );  // undo - implemented
    TELL_STDCMD_CLASSB(stdADDBOX_T     , stdADDBOX     );
    TELL_STDCMD_CLASSB(stdADDBOX_D     , stdADDBOX     );
+   TELL_STDCMD_CLASSA_UNDO(stdADDBOXES    );  // undo - implemented
+   TELL_STDCMD_CLASSB(stdADDBOXES_D   , stdADDBOXES   );
    TELL_STDCMD_CLASSA_UNDO(stdDRAWBOX     );  // undo - implemented
    TELL_STDCMD_CLASSB(stdDRAWBOX_T    , stdDRAWBOX    );
    TELL_STDCMD_CLASSB(stdDRAWBOX_D    , stdDRAWBOX    );
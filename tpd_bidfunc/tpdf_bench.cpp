@@ -0,0 +1,218 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Test and benchmark TELL functions
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#ifdef TPD_BENCH
+#include <sstream>
+#include <algorithm>
+#include <wx/stopwatch.h>
+#include "tpdf_bench.h"
+#include "viewprop.h"
+#include "trend.h"
+#include "trendat.h"
+#include "boxclip.h"
+#include "tellpool.h"
+
+extern layprop::PropertyCenter*  PROPC;
+extern trend::TrendCenter*       TRENDC;
+
+//=============================================================================
+tellstdfunc::stdCLOCKTIME::stdCLOCKTIME(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{}
+
+/*! The wall clock time in msec since the first call. The scripts measure
+ * the time of their own steps with the difference between two calls*/
+int tellstdfunc::stdCLOCKTIME::execute()
+{
+   static wxStopWatch watch;
+#if wxCHECK_VERSION(2,9,3)
+   real msec = watch.TimeInMicro().ToDouble() / 1000.0;
+#else
+   real msec = (real)watch.Time();
+#endif
+   OPstack.push(DEBUG_NEW telldata::TtReal(msec));
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdTESSELAREA::stdTESSELAREA(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype, eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtList(telldata::tn_pnt)));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::stdTESSELAREA::execute()
+{
+   bool native = getBoolValue();
+   telldata::TtList *pl = static_cast<telldata::TtList*>(OPstack.top());OPstack.pop();
+   real area = 0.0;
+   if (pl->size() >= 3)
+   {
+      real DBscale = PROPC->DBscale();
+      PointVector* plst = t2tpoints(pl,DBscale);
+      unsigned psize = plst->size();
+      int4b* pdata = DEBUG_NEW int4b[2 * psize];
+      for (unsigned i = 0; i < psize; i++)
+      {
+         pdata[2*i  ] = (*plst)[i].x();
+         pdata[2*i+1] = (*plst)[i].y();
+      }
+      area = TessellPoly::triangleArea(pdata, psize, native);
+      if (0.0 < area)
+         area /= DBscale * DBscale;
+      delete [] pdata;
+      delete plst;
+   }
+   OPstack.push(DEBUG_NEW telldata::TtReal(area));
+   delete pl;
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdRENDERDIGEST::stdRENDERDIGEST(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{}
+
+int tellstdfunc::stdRENDERDIGEST::execute()
+{
+   OPstack.push(DEBUG_NEW telldata::TtString(TRENDC->frameDigest()));
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdRENDERTIME::stdRENDERTIME(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtString()));
+}
+
+int tellstdfunc::stdRENDERTIME::execute()
+{
+   std::string pname = getStringValue();
+   trend::RenderPhase phase;
+   real msec = 0.0;
+   if (trend::RenderStats::phase(pname, phase))
+      msec = TRENDC->frameTime(phase);
+   else
+   {
+      std::ostringstream info;
+      info << "Unknown rendering phase \""<< pname <<"\"";
+      tell_log(console::MT_ERROR,info.str());
+   }
+   OPstack.push(DEBUG_NEW telldata::TtReal(msec));
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdBOXCLIPBENCH::stdBOXCLIPBENCH(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtInt()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtInt()));
+}
+
+/*! Checks an array of size x size boxes against a clip box overlapping half
+ * of them with every implementation of BoxClip supported by the CPU. The
+ * check is repeated repeats times and the boxes per nanosecond of every
+ * implementation are reported. Returns false if the implementations don't
+ * find the same boxes. The implementation in use is restored in the end.*/
+int tellstdfunc::stdBOXCLIPBENCH::execute()
+{
+   word repeats = getWordValue();
+   word size    = getWordValue();
+   unsigned numBoxes = (unsigned)size * (unsigned)size;
+   // the layout of the boxes is the same as boxarray() in shapebench.tll
+   int4b* boxes = DEBUG_NEW int4b[4 * numBoxes];
+   for (unsigned i = 0; i < numBoxes; i++)
+   {
+      int4b x = 2 * (i / size), y = 2 * (i % size);
+      boxes[4*i] = x; boxes[4*i+1] = y; boxes[4*i+2] = x + 1; boxes[4*i+3] = y + 1;
+   }
+   DBbox clip(0, 0, size, 2 * size);
+   unsigned visible[BoxClip::CHUNK];
+   BoxClip::IsaLevel inUse = BoxClip::isaLevel();
+   bool consistent = true;
+   unsigned refFound = 0;
+   for (int level = BoxClip::maxIsaLevel(); level >= BoxClip::isaScalar; level--)
+   {
+      BoxClip::setIsaLevel((BoxClip::IsaLevel)level);
+      unsigned found = 0;
+      wxStopWatch watch;
+      for (word r = 0; r < repeats; r++)
+      {
+         found = 0;
+         for (unsigned first = 0; first < numBoxes; first += BoxClip::CHUNK)
+         {
+            unsigned numInChunk = std::min(BoxClip::CHUNK, numBoxes - first);
+            found += BoxClip::overlapping(boxes + 4 * first, numInChunk, clip, visible);
+         }
+      }
+      double msec = trend::RenderStats::elapsed(watch);
+      if (BoxClip::maxIsaLevel() == level)
+         refFound = found;
+      else if (refFound != found)
+         consistent = false;
+      std::ostringstream info;
+      info << BoxClip::isaName((BoxClip::IsaLevel)level) << ": " << found << " of "
+           << numBoxes << " boxes overlapping, ";
+      if (0.0 < msec)
+         info << ((double)numBoxes * repeats) / (msec * 1e6) << " boxes/ns";
+      else
+         info << "less than a msec";
+      tell_log(console::MT_INFO, info.str());
+   }
+   BoxClip::setIsaLevel(inUse);
+   delete [] boxes;
+   if (!consistent)
+      tell_log(console::MT_ERROR, "The BoxClip implementations found different boxes");
+   OPstack.push(DEBUG_NEW telldata::TtBool(consistent));
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdTELLPOOLHEAP::stdTELLPOOLHEAP(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{}
+
+/*! The number of the system allocations of the TELL variable pool (see
+ * tellpool.h) since the start, or since the last parser run in a
+ * PARSER_PROFILING build. The scripts check that it doesn't grow in a loop.
+ * Returns -1 if the thread executing the script doesn't own the pool, i.e.
+ * the variables are not reused, and 0 if the pool is not compiled in.*/
+int tellstdfunc::stdTELLPOOLHEAP::execute()
+{
+#ifdef TELL_VAR_POOL
+   telldata::VarPool& pool = telldata::VarPool::instance();
+   int4b heap = pool.owner() ? (int4b)pool.heapAllocations() : -1;
+#else
+   int4b heap = 0;
+#endif
+   OPstack.push(DEBUG_NEW telldata::TtInt(heap));
+   return EXEC_NEXT;
+}
+
+#endif //TPD_BENCH
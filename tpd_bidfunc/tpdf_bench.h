@@ -0,0 +1,45 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Test and benchmark TELL functions
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#ifndef  TPDF_BENCH_H
+#define  TPDF_BENCH_H
+
+#include "tpdf_common.h"
+// The functions below are used by the test and benchmark scripts in the tll
+// directory only. They are registered only if Toped is built with TPD_BENCH
+// (--enable-bench or cmake -DTPD_BENCH=ON)
+namespace tellstdfunc {
+   using namespace parsercmd;
+   using telldata::argumentQ;
+
+   TELL_STDCMD_CLASSA(stdCLOCKTIME     );
+   TELL_STDCMD_CLASSA(stdTESSELAREA    );
+   TELL_STDCMD_CLASSA(stdRENDERDIGEST  );
+   TELL_STDCMD_CLASSA(stdRENDERTIME    );
+   TELL_STDCMD_CLASSA(stdBOXCLIPBENCH  );
+   TELL_STDCMD_CLASSA(stdTELLPOOLHEAP  );
+}
+
+#endif
@@ -400,7 +400,8 @@ void tellstdfunc::UpdateLV(unsigned int numSel)
    wxCommandEvent eventUPDATESEL(wxEVT_CANVAS_STATUS);
    eventUPDATESEL.SetInt(tui::CNVS_SELECTED);
    eventUPDATESEL.SetString(ws);
-   wxPostEvent(TopedCanvasW, eventUPDATESEL);
+   if (NULL != TopedCanvasW)
+      wxPostEvent(TopedCanvasW, eventUPDATESEL);
    RefreshGL();
 }
 
@@ -435,7 +436,8 @@ void tellstdfunc::gridON(byte No, bool status)
       default: assert(false); break;
    }
    eventGRIDUPD.SetInt(status ? 1 : 0);
-   wxPostEvent(TopedCanvasW, eventGRIDUPD);
+   if (NULL != TopedCanvasW)
+      wxPostEvent(TopedCanvasW, eventGRIDUPD);
 }
 
 //=============================================================================
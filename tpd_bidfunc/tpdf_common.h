@@ -190,6 +190,7 @@ namespace tellstdfunc {
    void                 gridON(byte No, bool status);
    void                 updateLayerDefinitions(laydata::TdtLibDir*, NameList&, int);
    void                 initFuncLib(wxFrame*, wxWindow*);
+   void                 initInternalFunctions(parsercmd::cmdMAIN*);
    laydata::SelectList* filter_selist(const laydata::SelectList*, word mask);
    laydata::AtticList*  replace_str(laydata::AtticList*, std::string);
 //   bool                 secureLayDef(LayerNumber);
@@ -1786,6 +1786,124 @@ int tellstdfunc::OASclearlaymap::execute()
    return EXEC_NEXT;
 }
 
+//=============================================================================
+tellstdfunc::OASexportLIB::OASexportLIB(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtList(telldata::tn_laymap)));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtString()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::OASexportLIB::execute()
+{
+   bool compress        = getBoolValue();
+   std::string filename = getStringValue();
+   telldata::TtList *lll = static_cast<telldata::TtList*>(OPstack.top());OPstack.pop();
+
+   // Convert layer map
+   ExpLayMap oasLays;
+   telldata::TtLMap* nameh;
+   for (unsigned i = 0; i < lll->size(); i++)
+   {
+      nameh = static_cast<telldata::TtLMap*>((lll->mlist())[i]);
+      oasLays[nameh->layer().value()] = nameh->value().value();
+   }
+
+   if (expandFileName(filename))
+   {
+      laydata::TdtLibDir* dbLibDir = NULL;
+      if (DATC->lockTDT(dbLibDir, dbmxs_dblock))
+      {
+         laydata::TdtDesign* tDesign = (*dbLibDir)();
+         LayerMapExt default_map(oasLays, NULL);
+         Oasis::OasisExportFile oasex(filename, NULL, default_map, true, compress);
+         try {tDesign->dbExport(oasex);}
+         catch (EXPTNwriteOASIS&) {}
+      }
+      DATC->unlockTDT(dbLibDir, true);
+      LogFile << LogFile.getFN() << "( "
+              << *lll << ", "
+              << "\""<< filename << "\", "
+              << LogFile._2bool(compress) <<");";
+      LogFile.flush();
+   }
+   else
+   {
+      std::string info = "Filename \"" + filename + "\" can't be expanded properly";
+      tell_log(console::MT_ERROR,info);
+   }
+   delete lll;
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::OASexportTOP::OASexportTOP(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtString()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtList(telldata::tn_laymap)));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtString()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::OASexportTOP::execute()
+{
+   bool  compress = getBoolValue();
+   std::string filename = getStringValue();
+   telldata::TtList *lll = static_cast<telldata::TtList*>(OPstack.top());OPstack.pop();
+   bool  recur = getBoolValue();
+   std::string cellname = getStringValue();
+
+   // Convert layer map
+   ExpLayMap oasLays;
+   telldata::TtLMap* nameh;
+   for (unsigned i = 0; i < lll->size(); i++)
+   {
+      nameh = static_cast<telldata::TtLMap*>((lll->mlist())[i]);
+      oasLays[nameh->layer().value()] = nameh->value().value();
+   }
+   if (expandFileName(filename))
+   {
+      laydata::TdtCell *excell = NULL;
+      laydata::TdtLibDir* dbLibDir = NULL;
+      if (DATC->lockTDT(dbLibDir, dbmxs_dblock))
+      {
+         laydata::TdtDesign* tDesign = (*dbLibDir)();
+         excell = static_cast<laydata::TdtCell*>(tDesign->checkCell(cellname));
+
+         if (NULL != excell)
+         {
+            LayerMapExt default_map(oasLays, NULL);
+            Oasis::OasisExportFile oasex(filename, excell, default_map, recur, compress);
+            try {tDesign->dbExport(oasex);}
+            catch (EXPTNwriteOASIS&) {}
+            LogFile  << LogFile.getFN()
+                     << "(\""<< cellname << "\","
+                     << LogFile._2bool(recur) << ", "
+                     << *lll << ", "
+                     << "\"" << filename << "\","
+                     << LogFile._2bool(compress) <<");";
+            LogFile.flush();
+         }
+         else
+         {
+            std::string message = "Cell " + cellname + " not found in the database";
+            tell_log(console::MT_ERROR,message);
+         }
+      }
+      DATC->unlockTDT(dbLibDir, true);
+   }
+   else
+   {
+      std::string info = "Filename \"" + filename + "\" can't be expanded properly";
+      tell_log(console::MT_ERROR,info);
+   }
+   delete lll;
+   return EXEC_NEXT;
+}
+
 //=============================================================================
 tellstdfunc::DRCCalibreimport::DRCCalibreimport(telldata::typeID retype, bool eor) :
       cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype, eor)
@@ -2045,6 +2163,8 @@ void tellstdfunc::importGDScell(laydata::TdtLibDir* dbLibDir, const NameList& to
       ImportDB converter(AGDSDB, dbLibDir, laymap);
       converter.run(top_names, over);
       (*dbLibDir)()->setModified();
+      // the existing cells might be overwritten by the import
+      (*dbLibDir)()->markAllChanged();
 #ifdef GDSCONVERT_PROFILING
       profTimer.report("Time elapsed for GDS conversion: ");
 #endif
@@ -2071,6 +2191,8 @@ void tellstdfunc::importCIFcell( laydata::TdtLibDir* dbLibDir, const NameList& t
       ImportDB converter(ACIFDB, dbLibDir, cifLayers, techno);
       converter.run(top_names, over, false);
       (*dbLibDir)()->setModified();
+      // the existing cells might be overwritten by the import
+      (*dbLibDir)()->markAllChanged();
    }
    DATC->unlockCif(ACIFDB, true);
 }
@@ -2095,6 +2217,8 @@ void tellstdfunc::importOAScell(laydata::TdtLibDir* dbLibDir, const NameList& to
       ImportDB converter(AOASDB, dbLibDir, laymap);
       converter.run(top_names, over);
       (*dbLibDir)()->setModified();
+      // the existing cells might be overwritten by the import
+      (*dbLibDir)()->markAllChanged();
 #ifdef OASCONVERT_PROFILING
       profTimer.report("Time elapsed for OASIS conversion: ");
 #endif
@@ -68,6 +68,8 @@ namespace tellstdfunc {
    TELL_STDCMD_CLASSA(OASgetlaymap     );
    TELL_STDCMD_CLASSA(OASsetlaymap     );
    TELL_STDCMD_CLASSA(OASclearlaymap   );
+   TELL_STDCMD_CLASSA(OASexportLIB     );
+   TELL_STDCMD_CLASSA(OASexportTOP     );
 
    TELL_STDCMD_CLASSA(CIFread          );
    TELL_STDCMD_CLASSA(CIFimport        );
@@ -950,6 +950,205 @@ int tellstdfunc::lgcSTRETCH::execute()
    return EXEC_NEXT;
 }
 
+//=============================================================================
+tellstdfunc::lgcLAYLOGIC::lgcLAYLOGIC(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtInt()));
+}
+
+void tellstdfunc::lgcLAYLOGIC::undo_cleanup()
+{
+   telldata::TtList* pl1 = TELL_UNDOOPS_CLEAN(telldata::TtList*);
+   telldata::TtList* pl  = TELL_UNDOOPS_CLEAN(telldata::TtList*);
+   delete pl1; delete pl;
+}
+
+void tellstdfunc::lgcLAYLOGIC::undo()
+{
+   TEUNDO_DEBUG("layer logic UNDO");
+   LayerDefSet unselable = PROPC->allUnselectable();
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (DATC->lockTDT(dbLibDir, dbmxs_celllock))
+   {
+      laydata::TdtDesign* tDesign = (*dbLibDir)();
+      tDesign->unselectAll();
+      // get the list of the generated shapes ...
+      telldata::TtList* pl = TELL_UNDOOPS_UNDO(telldata::TtList*);
+      // select them ...
+      tDesign->selectFromList(get_ttlaylist(pl), unselable);
+      //... and delete them cleaning up the memory (don't store in the Attic)
+      tDesign->deleteSelected(NULL, dbLibDir);
+      delete pl;
+      // and finally, get the list of shapes being selected before the operation
+      pl = TELL_UNDOOPS_UNDO(telldata::TtList*);
+      // ... and restore the selection
+      tDesign->selectFromList(get_ttlaylist(pl), unselable);
+      delete pl;
+      UpdateLV(tDesign->numSelected());
+   }
+   DATC->unlockTDT(dbLibDir, true);
+}
+
+int tellstdfunc::lgcLAYLOGIC::execute()
+{
+   logicop::LayLogicOp lop = (logicop::LayLogicOp) getWordValue();
+   bool hier = getBoolValue();
+   telldata::TtLayer* tdst = static_cast<telldata::TtLayer*>(OPstack.top());OPstack.pop();
+   telldata::TtLayer* tlb  = static_cast<telldata::TtLayer*>(OPstack.top());OPstack.pop();
+   telldata::TtLayer* tla  = static_cast<telldata::TtLayer*>(OPstack.top());OPstack.pop();
+   LayerDef dstlay(tdst->value());
+   secureLayer(dstlay);
+   laydata::AtticList* nshp = DEBUG_NEW laydata::AtticList();
+   laydata::TdtLibDir* dbLibDir = NULL;
+   if (DATC->lockTDT(dbLibDir, dbmxs_celllock))
+   {
+      laydata::TdtDesign* tDesign = (*dbLibDir)();
+      if (tDesign->layerLogic(lop, tla->value(), tlb->value(), dstlay, hier, nshp))
+      {
+         // push the command for undo
+         UNDOcmdQ.push_front(this);
+         // put the list of selected shapes in undo stack
+         UNDOPstack.push_front(make_ttlaylist(tDesign->shapeSel()));
+         // add the result of the logic operation ...
+         telldata::TtList* shadded = make_ttlaylist(nshp);
+         tDesign->addList(nshp);
+         // ... and save it for undo
+         UNDOPstack.push_front(shadded);
+         LogFile << LogFile.getFN() << "(" << *tla << "," << *tlb << "," << *tdst
+                 << "," << LogFile._2bool(hier) << ");"; LogFile.flush();
+         // delete nshp; - deleted by tDesign->addList
+      }
+      else delete nshp;
+   }
+   DATC->unlockTDT(dbLibDir, true);
+   delete tla; delete tlb; delete tdst;
+   RefreshGL();
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::lgcLAYAND::lgcLAYAND(telldata::typeID retype, bool eor) :
+      lgcLAYLOGIC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::lgcLAYAND::execute()
+{
+   OPstack.push(DEBUG_NEW telldata::TtInt(logicop::lgc_and));
+   return lgcLAYLOGIC::execute();
+}
+
+//=============================================================================
+tellstdfunc::lgcLAYOR::lgcLAYOR(telldata::typeID retype, bool eor) :
+      lgcLAYLOGIC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::lgcLAYOR::execute()
+{
+   OPstack.push(DEBUG_NEW telldata::TtInt(logicop::lgc_or));
+   return lgcLAYLOGIC::execute();
+}
+
+//=============================================================================
+tellstdfunc::lgcLAYANDNOT::lgcLAYANDNOT(telldata::typeID retype, bool eor) :
+      lgcLAYLOGIC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::lgcLAYANDNOT::execute()
+{
+   OPstack.push(DEBUG_NEW telldata::TtInt(logicop::lgc_andnot));
+   return lgcLAYLOGIC::execute();
+}
+
+//=============================================================================
+tellstdfunc::lgcLAYXOR::lgcLAYXOR(telldata::typeID retype, bool eor) :
+      lgcLAYLOGIC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::lgcLAYXOR::execute()
+{
+   OPstack.push(DEBUG_NEW telldata::TtInt(logicop::lgc_xor));
+   return lgcLAYLOGIC::execute();
+}
+
+//=============================================================================
+tellstdfunc::lgcLAYSIZE::lgcLAYSIZE(telldata::typeID retype, bool eor) :
+      lgcLAYLOGIC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayer()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtReal()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBool()));
+}
+
+int tellstdfunc::lgcLAYSIZE::execute()
+{
+   bool hier = getBoolValue();
+   real sizeval = getOpValue();
+   telldata::TtLayer* tdst = static_cast<telldata::TtLayer*>(OPstack.top());OPstack.pop();
+   telldata::TtLayer* tsrc = static_cast<telldata::TtLayer*>(OPstack.top());OPstack.pop();
+   int4b dbsize = (int4b) rint(sizeval * PROPC->DBscale());
+   if (0 == dbsize)
+   {
+      tell_log(console::MT_WARNING,"Size argument is 0. Nothing was changed");
+   }
+   else
+   {
+      LayerDef dstlay(tdst->value());
+      secureLayer(dstlay);
+      laydata::AtticList* nshp = DEBUG_NEW laydata::AtticList();
+      laydata::TdtLibDir* dbLibDir = NULL;
+      if (DATC->lockTDT(dbLibDir, dbmxs_celllock))
+      {
+         laydata::TdtDesign* tDesign = (*dbLibDir)();
+         if (tDesign->layerSize(tsrc->value(), dstlay, dbsize, hier, nshp))
+         {
+            // push the command for undo
+            UNDOcmdQ.push_front(this);
+            // put the list of selected shapes in undo stack
+            UNDOPstack.push_front(make_ttlaylist(tDesign->shapeSel()));
+            // add the result of the size operation ...
+            telldata::TtList* shadded = make_ttlaylist(nshp);
+            tDesign->addList(nshp);
+            // ... and save it for undo
+            UNDOPstack.push_front(shadded);
+            LogFile << LogFile.getFN() << "(" << *tsrc << "," << *tdst << "," << sizeval
+                    << "," << LogFile._2bool(hier) << ");"; LogFile.flush();
+            // delete nshp; - deleted by tDesign->addList
+         }
+         else delete nshp;
+      }
+      DATC->unlockTDT(dbLibDir, true);
+      RefreshGL();
+   }
+   delete tsrc; delete tdst;
+   return EXEC_NEXT;
+}
+
 
 //=============================================================================
 tellstdfunc::stdCHANGELAY::stdCHANGELAY(telldata::typeID retype, bool eor) :
@@ -46,6 +46,12 @@ namespace tellstdfunc {
    TELL_STDCMD_CLASSB(lgcCUTBOX_I     , lgcCUTPOLY    );
    TELL_STDCMD_CLASSA_UNDO(lgcMERGE          );  // undo - implemented
    TELL_STDCMD_CLASSA_UNDO(lgcSTRETCH        );  // undo - implemented
+   TELL_STDCMD_CLASSA_UNDO(lgcLAYLOGIC       );  // undo - implemented
+   TELL_STDCMD_CLASSB(lgcLAYAND       , lgcLAYLOGIC   );
+   TELL_STDCMD_CLASSB(lgcLAYOR        , lgcLAYLOGIC   );
+   TELL_STDCMD_CLASSB(lgcLAYANDNOT    , lgcLAYLOGIC   );
+   TELL_STDCMD_CLASSB(lgcLAYXOR       , lgcLAYLOGIC   );
+   TELL_STDCMD_CLASSB(lgcLAYSIZE      , lgcLAYLOGIC   );
    TELL_STDCMD_CLASSA_UNDO(stdCHANGELAY      );  // undo - implemented
    TELL_STDCMD_CLASSB(stdCHANGELAY_T  , stdCHANGELAY  );
    TELL_STDCMD_CLASSA_UNDO(stdCHANGEREF      );  // undo - implemented
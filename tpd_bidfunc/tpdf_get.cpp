@@ -53,6 +53,21 @@ int tellstdfunc::stdGETLAYTYPE::execute()
    return EXEC_NEXT;
 }
 
+//=============================================================================
+tellstdfunc::stdGETLAYER::stdGETLAYER(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype, eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtLayout()));
+}
+
+int tellstdfunc::stdGETLAYER::execute()
+{
+   telldata::TtLayout* tx = static_cast<telldata::TtLayout*>(OPstack.top());OPstack.pop();
+   OPstack.push(DEBUG_NEW telldata::TtLayer(tx->layer()));
+   delete tx;
+   return EXEC_NEXT;
+}
+
 //=============================================================================
 tellstdfunc::stdGETLAYTEXTSTR::stdGETLAYTEXTSTR(telldata::typeID retype, bool eor) :
       cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype, eor)
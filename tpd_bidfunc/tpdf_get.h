@@ -34,6 +34,7 @@ namespace tellstdfunc {
    using telldata::argumentQ;
 
    TELL_STDCMD_CLASSA(stdGETLAYTYPE       );
+   TELL_STDCMD_CLASSA(stdGETLAYER         );
    TELL_STDCMD_CLASSA(stdGETLAYTEXTSTR    );
    TELL_STDCMD_CLASSA(stdGETLAYREFSTR     );
    TELL_STDCMD_CLASSA(stdGETOVERLAP       );
@@ -36,6 +36,8 @@
 #include "tuidefs.h"
 #include "viewprop.h"
 #include "trend.h"
+#include "offscreen.h"
+#include "tellvm.h"
 #include "ted_prompt.h"
 
 extern parsercmd::cmdBLOCK*      CMDBlock;
@@ -46,6 +48,7 @@ extern wxWindow*                 TopedCanvasW;
 extern wxFrame*                  TopedMainW;
 extern console::toped_logfile    LogFile;
 extern trend::TrendCenter*       TRENDC;
+extern const wxEventType         wxEVT_CANVAS_ZOOM;
 extern const wxEventType         wxEVT_RENDER_PARAMS;
 extern const wxEventType         wxEVT_CANVAS_PARAMS;
 //=============================================================================
@@ -333,6 +336,93 @@ int tellstdfunc::stdSETPARAMETERS::execute()
    return EXEC_NEXT;
 }
 
+//=============================================================================
+tellstdfunc::stdRENDERSTATS::stdRENDERSTATS(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{}
+
+int tellstdfunc::stdRENDERSTATS::execute()
+{
+   if (!trend::RenderStats::enabled())
+      tell_log(console::MT_WARNING,"Rendering statistics are disabled. Use setparams({\"RENDER_STATS\", \"true\"})");
+   tell_log(console::MT_INFO, TRENDC->frameStats(false));
+   OPstack.push(DEBUG_NEW telldata::TtString(TRENDC->frameStats(true)));
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdRENDERSTATSf::stdRENDERSTATSf(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtString()));
+}
+
+int tellstdfunc::stdRENDERSTATSf::execute()
+{
+   std::string fname = convertString(getStringValue());
+   if (!trend::RenderStats::enabled())
+      tell_log(console::MT_WARNING,"Rendering statistics are disabled. Use setparams({\"RENDER_STATS\", \"true\"})");
+   std::string stats = TRENDC->frameStats(true);
+   FILE* stats_file = fopen(fname.c_str(),"wt");
+   if (NULL == stats_file)
+   {
+      std::ostringstream info;
+      info << "Can't open file \""<< fname <<"\" for writing";
+      tell_log(console::MT_ERROR,info.str());
+   }
+   else
+   {
+      fputs(stats.c_str(), stats_file);
+      fclose(stats_file);
+   }
+   OPstack.push(DEBUG_NEW telldata::TtString(stats));
+   return EXEC_NEXT;
+}
+
+//=============================================================================
+tellstdfunc::stdRENDERVIEW::stdRENDERVIEW(telldata::typeID retype, bool eor) :
+      cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST,retype,eor)
+{
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtBox()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtInt()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtInt()));
+   _arguments->push_back(DEBUG_NEW ArgumentTYPE("", DEBUG_NEW telldata::TtString()));
+}
+
+int tellstdfunc::stdRENDERVIEW::execute()
+{
+   std::string fname = convertString(getStringValue());
+   word height       = getWordValue();
+   word width        = getWordValue();
+   telldata::TtBox *w = static_cast<telldata::TtBox*>(OPstack.top());OPstack.pop();
+   real DBscale = PROPC->DBscale();
+   trend::OffScreenView request(DBbox(TP(w->p1().x(), w->p1().y(), DBscale),
+                                      TP(w->p2().x(), w->p2().y(), DBscale)),
+                                width, height, fname);
+   delete w;
+   if (_threadExecution && (NULL != TopedCanvasW))
+   {
+      // The rendering must be done by the thread holding the openGL context,
+      // so post the request to the canvas and wait until it's done
+      wxCommandEvent eventZOOM(wxEVT_CANVAS_ZOOM);
+      eventZOOM.SetInt(tui::ZOOM_OFFSCREEN);
+      eventZOOM.SetClientData(static_cast<void*>(&request));
+      wxPostEvent(TopedCanvasW, eventZOOM);
+      Console->_threadWaits4->Wait();
+   }
+   else if ((NULL == TopedCanvasW) && (trend::rtTocom != TRENDC->renderType()))
+   {
+      // toped-batch with a headless openGL context - the parser is running
+      // in the thread holding it
+      if (!DATC->renderOffScreen(request))
+         tell_log(console::MT_ERROR,"Off-screen rendering failed");
+   }
+   else
+      tell_log(console::MT_ERROR,"Off-screen rendering is not available in this mode (see toped-batch -gl)");
+   OPstack.push(DEBUG_NEW telldata::TtString(request._stats));
+   return EXEC_NEXT;
+}
+
 //=============================================================================
 tellstdfunc::stdHIDELAYER::stdHIDELAYER(telldata::typeID retype, bool eor) :
       cmdSTDFUNC(DEBUG_NEW parsercmd::ArgumentLIST, retype, eor)
@@ -1552,6 +1642,48 @@ void tellstdfunc::analyzeTopedParameters(std::string name, std::string value)
          tell_log(console::MT_ERROR,info.str());
       }
    }
+   else if ("MIN_TEXT_SIZE" == name)
+   {//setparams({"MIN_TEXT_SIZE", "8"});
+      word val;
+      if ((from_string<word>(val, value, std::dec)) && (val < 256))
+      {
+         layprop::DrawProperties* drawProp;
+         if (PROPC->lockDrawProp(drawProp))
+         {
+            drawProp->setTextLimit(val);
+         }
+         PROPC->unlockDrawProp(drawProp, true);
+         // Request a redraw at the thread exit
+         Console->set_canvas_invalid(true);
+      }
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected value is between 0 and 255";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+   else if ("RENDER_LOD" == name)
+   {//setparams({"RENDER_LOD", "true"});
+      bool val;
+      if (from_string<bool>(val, value, std::boolalpha))
+      {
+         layprop::DrawProperties* drawProp;
+         if (PROPC->lockDrawProp(drawProp))
+         {
+            drawProp->setLodRender(val);
+         }
+         PROPC->unlockDrawProp(drawProp, true);
+         // Request a redraw at the thread exit
+         Console->set_canvas_invalid(true);
+      }
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected \"true\" or \"false\"";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
    else if ("ADJUST_TEXT_ORIENTATION" == name)
    {//setparams({"ADJUST_TEXT_ORIENTATION", "true"});
       bool val;
@@ -1753,6 +1885,97 @@ void tellstdfunc::analyzeTopedParameters(std::string name, std::string value)
       }
    }
 
+   else if ("LOGIC_THREADS" == name)
+   {//setparams({"LOGIC_THREADS", "4"});
+      word val;
+      if ((from_string<word>(val, value, std::dec)) && (val <= 256))
+         DATC->setLogicThreads(val);
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected value is between 0 (all CPUs) and 256";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+
+   else if ("IMPORT_THREADS" == name)
+   {//setparams({"IMPORT_THREADS", "4"});
+      word val;
+      if ((from_string<word>(val, value, std::dec)) && (val <= 256))
+         DATC->setImportThreads(val);
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected value is between 0 (all CPUs) and 256";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+
+   else if ("MAP_INPUT" == name)
+   {//setparams({"MAP_INPUT", "false"});
+      bool val;
+      if (from_string<bool>(val, value, std::boolalpha))
+         InputDBFile::setMapInput(val);
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected \"true\" or \"false\"";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+
+   else if ("RENDER_STATS" == name)
+   {//setparams({"RENDER_STATS", "true"});
+      bool val;
+      if (from_string<bool>(val, value, std::boolalpha))
+         trend::RenderStats::setEnabled(val);
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected \"true\" or \"false\"";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+
+   else if ("TELL_COMPILE" == name)
+   {//setparams({"TELL_COMPILE", "false"});
+      bool val;
+      if (from_string<bool>(val, value, std::boolalpha))
+         parsercmd::cmdEXPR::setEnabled(val);
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected \"true\" or \"false\"";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+
+   else if ("RENDER_THREADS" == name)
+   {//setparams({"RENDER_THREADS", "4"});
+      word val;
+      if ((from_string<word>(val, value, std::dec)) && (val <= 256))
+         DATC->setRenderThreads(val);
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected value is between 0 (all CPUs) and 256";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+
+   else if ("QTREE_THREADS" == name)
+   {//setparams({"QTREE_THREADS", "4"});
+      word val;
+      if ((from_string<word>(val, value, std::dec)) && (val <= 256))
+         DATC->setQTreeThreads(val);
+      else
+      {
+         std::ostringstream info;
+         info << "Invalid \""<< name <<"\" value. Expected value is between 0 (all CPUs) and 256";
+         tell_log(console::MT_ERROR,info.str());
+      }
+   }
+
    else
    {
       std::ostringstream info;
@@ -43,6 +43,9 @@ namespace tellstdfunc {
    TELL_STDCMD_CLASSA(stdGRIDDEF       );  //
    TELL_STDCMD_CLASSA(stdSETPARAMETER  );  //
    TELL_STDCMD_CLASSA(stdSETPARAMETERS );  //
+   TELL_STDCMD_CLASSA(stdRENDERSTATS   );  //
+   TELL_STDCMD_CLASSA(stdRENDERSTATSf  );  //
+   TELL_STDCMD_CLASSA(stdRENDERVIEW    );  //
    TELL_STDCMD_CLASSA_UNDO(stdHIDELAYER   );  // undo - implemented
    TELL_STDCMD_CLASSA_UNDO(stdHIDELAYERS  );  // undo - implemented
    TELL_STDCMD_CLASSA_UNDO(stdHIDECELLMARK);  // undo - implemented
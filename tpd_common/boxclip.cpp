@@ -0,0 +1,208 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Batched box overlap tests
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include "boxclip.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+   #define BOXCLIP_GNUC_X86
+   #include <immintrin.h>
+   #define BOXCLIP_TARGET(isa) __attribute__ ((target (isa)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   #define BOXCLIP_MSC_X86
+   #include <intrin.h>
+   #include <immintrin.h>
+   #define BOXCLIP_TARGET(isa)
+#endif
+
+// All kernels below are storing the index of every box unconditionally and
+// advance the output position only if the box is overlapping the clip box.
+// This way there are no branches in the loops at all. The clip parameter is
+// always {clx2, cly2, clx1, cly1} - the order of the box coordinates which
+// shall be compared with each of them.
+
+static unsigned overlapScalar(const int4b* boxes, unsigned num, const int4b* clip, unsigned* idx)
+{
+   const int4b clx2 = clip[0], cly2 = clip[1], clx1 = clip[2], cly1 = clip[3];
+   unsigned numOver = 0;
+   for (unsigned i = 0; i < num; i++, boxes += 4)
+   {
+      idx[numOver] = i;
+      numOver += (boxes[0] <= clx2) & (boxes[1] <= cly2) &
+                 (boxes[2] >= clx1) & (boxes[3] >= cly1);
+   }
+   return numOver;
+}
+
+#if defined(BOXCLIP_GNUC_X86) || defined(BOXCLIP_MSC_X86)
+/*! One box per register. p1 coordinates must not be bigger than the upper
+ * clip coordinates, p2 coordinates must not be smaller than the lower ones*/
+BOXCLIP_TARGET("sse2")
+static unsigned overlapSSE2(const int4b* boxes, unsigned num, const int4b* clip, unsigned* idx)
+{
+   const __m128i lim  = _mm_loadu_si128((const __m128i*)clip);
+   const __m128i mp1  = _mm_set_epi32( 0,  0, -1, -1);
+   const __m128i mp2  = _mm_set_epi32(-1, -1,  0,  0);
+   unsigned numOver = 0;
+   unsigned i = 0;
+   for (; i + 2 <= num; i += 2, boxes += 8)
+   {
+      __m128i box0 = _mm_loadu_si128((const __m128i*)boxes);
+      __m128i box1 = _mm_loadu_si128((const __m128i*)(boxes + 4));
+      __m128i out0 = _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi32(box0, lim), mp1),
+                                  _mm_and_si128(_mm_cmpgt_epi32(lim, box0), mp2));
+      __m128i out1 = _mm_or_si128(_mm_and_si128(_mm_cmpgt_epi32(box1, lim), mp1),
+                                  _mm_and_si128(_mm_cmpgt_epi32(lim, box1), mp2));
+      int m0 = _mm_movemask_ps(_mm_castsi128_ps(out0));
+      int m1 = _mm_movemask_ps(_mm_castsi128_ps(out1));
+      idx[numOver] = i    ; numOver += (0 == m0);
+      idx[numOver] = i + 1; numOver += (0 == m1);
+   }
+   unsigned numTail = overlapScalar(boxes, num - i, clip, idx + numOver);
+   for (unsigned j = 0; j < numTail; j++)
+      idx[numOver + j] += i;
+   return numOver + numTail;
+}
+
+/*! The same as SSE2, but with the AVX2 blend instead of the two masks. The
+ * 256 bit variant (two boxes per register) was measured slower - the extra
+ * work to split the movemask result and to build the indexes outweighs the
+ * saved compares*/
+BOXCLIP_TARGET("avx2")
+static unsigned overlapAVX2(const int4b* boxes, unsigned num, const int4b* clip, unsigned* idx)
+{
+   const __m128i lim  = _mm_loadu_si128((const __m128i*)clip);
+   unsigned numOver = 0;
+   unsigned i = 0;
+   for (; i + 4 <= num; i += 4, boxes += 16)
+   {
+      __m128i box0 = _mm_loadu_si128((const __m128i*)boxes);
+      __m128i box1 = _mm_loadu_si128((const __m128i*)(boxes +  4));
+      __m128i box2 = _mm_loadu_si128((const __m128i*)(boxes +  8));
+      __m128i box3 = _mm_loadu_si128((const __m128i*)(boxes + 12));
+      // p1 from (box > lim), p2 from (lim > box)
+      __m128i out0 = _mm_blend_epi32(_mm_cmpgt_epi32(box0, lim), _mm_cmpgt_epi32(lim, box0), 0x0C);
+      __m128i out1 = _mm_blend_epi32(_mm_cmpgt_epi32(box1, lim), _mm_cmpgt_epi32(lim, box1), 0x0C);
+      __m128i out2 = _mm_blend_epi32(_mm_cmpgt_epi32(box2, lim), _mm_cmpgt_epi32(lim, box2), 0x0C);
+      __m128i out3 = _mm_blend_epi32(_mm_cmpgt_epi32(box3, lim), _mm_cmpgt_epi32(lim, box3), 0x0C);
+      int m0 = _mm_movemask_ps(_mm_castsi128_ps(out0));
+      int m1 = _mm_movemask_ps(_mm_castsi128_ps(out1));
+      int m2 = _mm_movemask_ps(_mm_castsi128_ps(out2));
+      int m3 = _mm_movemask_ps(_mm_castsi128_ps(out3));
+      idx[numOver] = i    ; numOver += (0 == m0);
+      idx[numOver] = i + 1; numOver += (0 == m1);
+      idx[numOver] = i + 2; numOver += (0 == m2);
+      idx[numOver] = i + 3; numOver += (0 == m3);
+   }
+   unsigned numTail = overlapScalar(boxes, num - i, clip, idx + numOver);
+   for (unsigned j = 0; j < numTail; j++)
+      idx[numOver + j] += i;
+   return numOver + numTail;
+}
+#endif
+
+static BoxClip::IsaLevel detectIsaLevel()
+{
+#if defined(BOXCLIP_GNUC_X86)
+   __builtin_cpu_init();
+   if (__builtin_cpu_supports("avx2")) return BoxClip::isaAVX2;
+   if (__builtin_cpu_supports("sse2")) return BoxClip::isaSSE2;
+#elif defined(BOXCLIP_MSC_X86)
+   int info[4];
+   __cpuid(info, 0);
+   int maxLeaf = info[0];
+   __cpuid(info, 1);
+   bool sse2    = 0 != (info[3] & (1 << 26));
+   bool osxsave = 0 != (info[2] & (1 << 27));
+   bool avx     = 0 != (info[2] & (1 << 28));
+   // AVX2 needs the OS support for the YMM registers as well
+   if ((7 <= maxLeaf) && osxsave && avx && (6 == (_xgetbv(0) & 6)))
+   {
+      __cpuidex(info, 7, 0);
+      if (0 != (info[1] & (1 << 5))) return BoxClip::isaAVX2;
+   }
+   if (sse2) return BoxClip::isaSSE2;
+#endif
+   return BoxClip::isaScalar;
+}
+
+const unsigned       BoxClip::CHUNK;
+BoxClip::OverlapFunc BoxClip::_overlapFunc = NULL;
+BoxClip::IsaLevel    BoxClip::_isaLevel    = BoxClip::isaScalar;
+
+/*! Returns the number of boxes overlapping clip. Their indexes are stored in
+ * idx which must have room for num indexes.*/
+unsigned BoxClip::overlapping(const int4b* boxes, unsigned num, const DBbox& clip, unsigned* idx)
+{
+   if (NULL == _overlapFunc) init();
+   const int4b lim[4] = {clip.p2().x(), clip.p2().y(), clip.p1().x(), clip.p1().y()};
+   return _overlapFunc(boxes, num, lim, idx);
+}
+
+/*! Returns the implementation currently in use*/
+BoxClip::IsaLevel BoxClip::isaLevel()
+{
+   if (NULL == _overlapFunc) init();
+   return _isaLevel;
+}
+
+/*! Returns the best implementation supported by the CPU*/
+BoxClip::IsaLevel BoxClip::maxIsaLevel()
+{
+   return detectIsaLevel();
+}
+
+/*! Forces a certain implementation - for benchmarks and comparisons (see
+ * boxclipbench()). The level is limited to the one supported by the CPU*/
+void BoxClip::setIsaLevel(IsaLevel level)
+{
+   IsaLevel maxLevel = detectIsaLevel();
+   _isaLevel = (level > maxLevel) ? maxLevel : level;
+   switch (_isaLevel)
+   {
+#if defined(BOXCLIP_GNUC_X86) || defined(BOXCLIP_MSC_X86)
+      case isaAVX2: _overlapFunc = overlapAVX2  ; break;
+      case isaSSE2: _overlapFunc = overlapSSE2  ; break;
+#endif
+      default     : _overlapFunc = overlapScalar; break;
+   }
+}
+
+const char* BoxClip::isaName(IsaLevel level)
+{
+   switch (level)
+   {
+      case isaAVX2: return "AVX2";
+      case isaSSE2: return "SSE2";
+      default     : return "scalar";
+   }
+}
+
+void BoxClip::init()
+{
+   // Several threads might get here simultaneously. That's fine - they all
+   // will end-up with the same result.
+   setIsaLevel(detectIsaLevel());
+}
@@ -0,0 +1,61 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Batched box overlap tests
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef BOXCLIP_H_INCLUDED
+#define BOXCLIP_H_INCLUDED
+
+#include "ttt.h"
+
+//=============================================================================
+/*! Checks many boxes against a single clip box in one call. The boxes are
+ * expected as consecutive groups of four int4b (p1x, p1y, p2x, p2y) - the
+ * layout of the packed boxes in the quad tree (see QTreeTmpl::pack()) and of
+ * the DBbox itself. The boxes must be normalized.\n
+ * A box is overlapping the clip box exactly when DBbox::cliparea() returns
+ * non-zero for it - i.e. touching boxes are overlapping.\n
+ * The implementation is selected once on the first call depending on the CPU
+ * (AVX2, SSE2 or plain C++). All of them produce the same result.\n
+ * The packed boxes of the quad trees are the only contiguous box arrays, so
+ * this is used only by the scans over them - QTreeTmpl::drawPackedBoxes() and
+ * QTreeTmpl::forEachInBox(). The clipping and overlap checks of the single
+ * objects (DrawIterator, ClipIterator, TdtCellAref etc.) stay with DBbox. */
+class BoxClip {
+public:
+   enum IsaLevel {isaScalar, isaSSE2, isaAVX2};
+   /*! The maximum number of boxes to be checked in one call by the callers
+    * which keep the result in a local array */
+   static const unsigned   CHUNK = 256;
+   static unsigned         overlapping(const int4b*, unsigned, const DBbox&, unsigned*);
+   static IsaLevel         isaLevel();
+   static IsaLevel         maxIsaLevel();
+   static void             setIsaLevel(IsaLevel);
+   static const char*      isaName(IsaLevel);
+private:
+   typedef unsigned      (*OverlapFunc)(const int4b*, unsigned, const int4b*, unsigned*);
+   static void             init();
+   static OverlapFunc      _overlapFunc;
+   static IsaLevel         _isaLevel;
+};
+
+#endif
@@ -30,11 +30,14 @@
 #include <time.h>
 #include <string>
 #include <sstream>
+#include <map>
 #include <wx/string.h>
 #include <wx/regex.h>
 #include <wx/filename.h>
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
+#include <wx/thread.h>
+#include <wx/atomic.h>
 
 #include "outbox.h"
 #include "tuidefs.h"
@@ -277,19 +280,62 @@ void console::ted_log_ctrl::cmdLineLog(wxLogLevel level, const std::string& msg,
 
 }
 
+//=============================================================================
+typedef std::map<wxThreadIdType, console::LogBuffer*> LogCaptures;
+static LogCaptures   logCaptures;
+static wxMutex       logCapturesMutex;
+// The number of the active captures. Checked without locking by capture(), so
+// tell_log() doesn't touch the mutex unless some thread is captured. A thread
+// always sees its own capture, which is all that capture() needs.
+static wxAtomicInt   logCapturesActive = 0;
+
+void console::LogBuffer::flush()
+{
+   for (LogMessages::const_iterator CM = _messages.begin(); CM != _messages.end(); CM++)
+      tell_log(CM->first, CM->second);
+   _messages.clear();
+}
+
+console::LogCapture::LogCapture(LogBuffer& buffer)
+{
+   wxMutexLocker lock(logCapturesMutex);
+   logCaptures[wxThread::GetCurrentId()] = &buffer;
+   wxAtomicInc(logCapturesActive);
+}
+
+console::LogCapture::~LogCapture()
+{
+   wxMutexLocker lock(logCapturesMutex);
+   logCaptures.erase(wxThread::GetCurrentId());
+   wxAtomicDec(logCapturesActive);
+}
+
+bool console::LogCapture::capture(LOG_TYPE lt, const std::string& msg)
+{
+   if (0 == logCapturesActive) return false;
+   wxMutexLocker lock(logCapturesMutex);
+   LogCaptures::const_iterator CC = logCaptures.find(wxThread::GetCurrentId());
+   if (logCaptures.end() == CC) return false;
+   CC->second->add(lt, msg);
+   return true;
+}
+
 //=============================================================================
 void tell_log(console::LOG_TYPE lt, const char* msg)
 {
+   if (console::LogCapture::capture(lt, (NULL == msg) ? "" : msg)) return;
    wxLog::OnLog(lt, wxString(msg, wxConvUTF8), time(NULL));
 }
 
 void tell_log(console::LOG_TYPE lt, const std::string& msg)
 {
+   if (console::LogCapture::capture(lt, msg)) return;
    wxLog::OnLog(lt, wxString(msg.c_str(), wxConvUTF8), time(NULL));
 }
 
 void tell_log(console::LOG_TYPE lt, const wxString& msg)
 {
+   if (console::LogCapture::capture(lt, std::string(msg.mb_str(wxConvUTF8)))) return;
    wxLog::OnLog(lt, msg, time(NULL));
 }
 
@@ -438,6 +484,7 @@ void TpdPost::toped_status(console::TOPEDSTATUS_TYPE tstatus)
 
 void TpdPost::postMenuEvent(int eventID)
 {
+   if (NULL == _mainWindow) return;
    wxMenuEvent aMenuEvent(wxEVT_COMMAND_MENU_SELECTED, eventID);
    wxPostEvent(_mainWindow, aMenuEvent);
 }
@@ -472,14 +519,24 @@ void TpdPost::toped_status(console::TOPEDSTATUS_TYPE tstatus, wxString sts_cmd)
 
 void TpdPost::render_status(bool on_off)
 {
+   if (NULL == _statusBar) return;
    if (on_off)
       static_cast<console::TopedStatus*>(_statusBar)->OnRenderON();
    else
       static_cast<console::TopedStatus*>(_statusBar)->OnRenderOFF();
 }
 
+void TpdPost::render_ready()
+{
+   if (NULL == _canvasWindow) return;
+   wxCommandEvent eventZOOM(wxEVT_CANVAS_ZOOM);
+   eventZOOM.SetInt(tui::ZOOM_RENDERED);
+   wxPostEvent(_canvasWindow, eventZOOM);
+}
+
 void TpdPost::addFont(const std::string& fname)
 {
+   if (NULL == _mainWindow) return;
    wxCommandEvent eventLoadFont(wxEVT_RENDER_PARAMS);
    eventLoadFont.SetId(tui::RPS_LD_FONT);
    eventLoadFont.SetString(wxString(fname.c_str(), wxConvUTF8));
@@ -503,7 +560,7 @@ void TpdPost::refreshTDTtab(bool targetDB, bool threadExecution)
 
 void TpdPost::addGDStab(bool threadExecution)
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_ADDGDS_TAB);
    if (threadExecution)
@@ -517,7 +574,7 @@ void TpdPost::addGDStab(bool threadExecution)
 
 void TpdPost::addCIFtab(bool threadExecution)
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_ADDCIF_TAB);
    if (threadExecution)
@@ -531,7 +588,7 @@ void TpdPost::addCIFtab(bool threadExecution)
 
 void TpdPost::addOAStab(bool threadExecution)
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_ADDOAS_TAB);
    if (threadExecution)
@@ -545,7 +602,7 @@ void TpdPost::addOAStab(bool threadExecution)
 
 void TpdPost::addDRCtab(bool threadExecution)
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_ADDDRC_TAB);
    if (threadExecution)
@@ -561,7 +618,7 @@ void TpdPost::addDRCtab(bool threadExecution)
 //There is hack here: direct access to command line using pointer to window
 void TpdPost::addTextToCmd(const std::string& text)
 {
-   assert(_cmdLine);
+   if (NULL == _cmdLine) return;
    wxTextCtrl* cmd = static_cast<wxTextCtrl*>(_cmdLine);
    cmd->WriteText(wxString(text.c_str(), wxConvUTF8));
    //Set cursor between parenthesis
@@ -573,7 +630,7 @@ void TpdPost::addTextToCmd(const std::string& text)
 
 void TpdPost::clearGDStab()
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_CLEARGDS_TAB);
    wxPostEvent(_topBrowsers, eventADDTAB);
@@ -581,7 +638,7 @@ void TpdPost::clearGDStab()
 
 void TpdPost::clearCIFtab()
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_CLEARCIF_TAB);
    wxPostEvent(_topBrowsers, eventADDTAB);
@@ -589,7 +646,7 @@ void TpdPost::clearCIFtab()
 
 void TpdPost::clearOAStab()
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_CLEAROAS_TAB);
    wxPostEvent(_topBrowsers, eventADDTAB);
@@ -597,7 +654,7 @@ void TpdPost::clearOAStab()
 
 void TpdPost::clearDRCtab()
 {
-   assert(_topBrowsers);
+   if (NULL == _topBrowsers) return;
    wxCommandEvent eventADDTAB(wxEVT_CMD_BROWSER);
    eventADDTAB.SetInt(tui::BT_CLEARDRC_TAB);
    wxPostEvent(_topBrowsers, eventADDTAB);
@@ -722,7 +779,7 @@ void TpdPost::treeMarkGrcMember(const char* cell, bool error)
 void TpdPost::parseCommand(const wxString cmd)
 {
 //   assert(_cmdLine);
-   assert(_mainWindow);
+   if (NULL == _mainWindow) return;
    wxCommandEvent eventPARSE(wxEVT_CONSOLE_PARSE);
    eventPARSE.SetString(cmd);
 //   wxPostEvent(_cmdLine, eventPARSE);
@@ -731,7 +788,7 @@ void TpdPost::parseCommand(const wxString cmd)
 
 void TpdPost::restoreAuiState(const wxString state)
 {
-   assert(_mainWindow);
+   if (NULL == _mainWindow) return;
    wxCommandEvent eventAUI(wxEVT_AUI_RESTORE);
    eventAUI.SetString(state);
    wxPostEvent(_mainWindow,eventAUI);
@@ -739,6 +796,11 @@ void TpdPost::restoreAuiState(const wxString state)
 
 void TpdPost::tellFnAdd(const std::string name, void* arguments)
 {
+   if (NULL == _tllFuncList)
+   {// the list is normally deleted by the function browser
+      delete static_cast<NameList*>(arguments);
+      return;
+   }
    wxCommandEvent eventFUNCTION_ADD(wxEVT_FUNC_BROWSER);
    eventFUNCTION_ADD.SetString(wxString(name.c_str(), wxConvUTF8));
    eventFUNCTION_ADD.SetClientData(arguments);
@@ -748,6 +810,7 @@ void TpdPost::tellFnAdd(const std::string name, void* arguments)
 
 void TpdPost::tellFnSort()
 {
+   if (NULL == _tllFuncList) return;
    wxCommandEvent eventFUNCTION_ADD(wxEVT_FUNC_BROWSER);
    eventFUNCTION_ADD.SetInt(console::FT_FUNCTION_SORT);
    wxPostEvent(_tllFuncList, eventFUNCTION_ADD);
@@ -755,13 +818,14 @@ void TpdPost::tellFnSort()
 
 void TpdPost::reloadTellFuncs()
 {
-   assert(_mainWindow);
+   if (NULL == _mainWindow) return;
    wxCommandEvent eventRELOADTELLFUNC(wxEVT_RELOADTELLFUNCS);
    wxPostEvent(_mainWindow, eventRELOADTELLFUNC);
 }
 
 void TpdPost::execExt(const wxString extCmd)
 {
+   if (NULL == _mainWindow) return;
    wxCommandEvent eventEXEXEXT(wxEVT_EXECEXT);
    eventEXEXEXT.SetString(extCmd);
    wxPostEvent(_mainWindow, eventEXEXEXT);
@@ -769,6 +833,7 @@ void TpdPost::execExt(const wxString extCmd)
 
 void TpdPost::execPipe(const wxString extCmd)
 {
+   if (NULL == _mainWindow) return;
    wxCommandEvent eventExecExPipe(wxEVT_EXECEXTPIPE);
    eventExecExPipe.SetString(extCmd);
    wxPostEvent(_mainWindow, eventExecExPipe);
@@ -786,6 +851,7 @@ void TpdPost::techEditUpdate(console::TECHEDIT_UPDATE_EVT_ENUMS id)
 
 void TpdPost::drcDrawPrep(int type, const wxString name)
 {
+   if (NULL == _canvasWindow) return;
    wxCommandEvent eventDRC(wxEVT_DRCDRAWPREP);
    eventDRC.SetInt(type);
    eventDRC.SetString(name);
@@ -794,6 +860,7 @@ void TpdPost::drcDrawPrep(int type, const wxString name)
 
 void TpdPost::quitApp(int exitType)
 {
+   if (NULL == _mainWindow) return;
    wxCommandEvent eventQUITAPP(wxEVT_EXITAPP);
    eventQUITAPP.SetInt(exitType);
    wxPostEvent(_mainWindow, eventQUITAPP);
@@ -1226,6 +1293,12 @@ EXPTNreadOASIS::EXPTNreadOASIS(std::string info) {
    tell_log(console::MT_ERROR,news);
 };
 
+EXPTNwriteOASIS::EXPTNwriteOASIS(std::string info) {
+   std::string news = "Error writing OASIS file =>";
+   news += info;
+   tell_log(console::MT_ERROR,news);
+};
+
 EXPTNpolyCross::EXPTNpolyCross(std::string info) {
    std::string news = "Internal error - polygon cross =>";
    news += info;
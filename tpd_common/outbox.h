@@ -228,6 +228,30 @@ namespace console {
       real                 _progressAdj;
       DECLARE_EVENT_TABLE();
    };
+
+   //===========================================================================
+   /*! The messages logged by a thread while it is captured (see LogCapture)*/
+   class LogBuffer {
+   public:
+      void                 add(LOG_TYPE lt, const std::string& msg) {_messages.push_back(LogMessage(lt, msg));}
+      void                 flush();
+   private:
+      typedef std::pair<LOG_TYPE, std::string> LogMessage;
+      typedef std::list<LogMessage>            LogMessages;
+      LogMessages          _messages;
+   };
+
+   /*! While the object exists, the messages logged by the calling thread via
+    * tell_log() are collected in the buffer instead of being sent to the log
+    * window. Meant for the jobs running on worker threads - the thread which
+    * started them shall flush the buffers in a deterministic order (see
+    * ImportDB::convertConcurrent())*/
+   class LogCapture {
+   public:
+                           LogCapture(LogBuffer&);
+                          ~LogCapture();
+      static bool          capture(LOG_TYPE, const std::string&);
+   };
 }
 
 //===========================================================================
@@ -235,6 +259,9 @@ void tell_log(console::LOG_TYPE, const char* = NULL);
 void tell_log(console::LOG_TYPE, const std::string&);
 void tell_log(console::LOG_TYPE, const wxString&);
 
+/*! Posts the events from the DB & the parser to the GUI. The windows are
+ * registered by the constructor. Without them (the command line mode and the
+ * batch tool) all methods are doing nothing*/
 class TpdPost {
    public:
                   TpdPost(wxWindow*);
@@ -244,6 +271,7 @@ class TpdPost {
       static void toped_status(console::TOPEDSTATUS_TYPE, std::string);
       static void toped_status(console::TOPEDSTATUS_TYPE, wxString);
       static void render_status(bool);
+      static void render_ready();
       static void addFont(const std::string&);
       static void refreshTDTtab(bool, bool);
       static void addGDStab(bool);
@@ -372,6 +400,12 @@ class EXPTNreadOASIS : public EXPTN
       EXPTNreadOASIS(std::string);
 };
 
+class EXPTNwriteOASIS : public EXPTN
+{
+   public:
+      EXPTNwriteOASIS(std::string);
+};
+
 class EXPTNreadTDT : public EXPTN
 {
    public:
@@ -0,0 +1,323 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Triangulation of simple polygons
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include <math.h>
+#include <algorithm>
+#include "polytri.h"
+
+/*! Sorts the vertexes in the order of the sweep - top to bottom and left to
+ * right for the vertexes with the same y*/
+struct PolyTriangulator::SweepOrder {
+   SweepOrder(const PolyTriangulator* tri) : _tri(tri) {}
+   bool operator()(unsigned a, unsigned b) const {return _tri->above(a, b);}
+   const PolyTriangulator* _tri;
+};
+
+PolyTriangulator::PolyTriangulator(const int4b* pdata, unsigned psize) :
+   _pdata      ( pdata     ),
+   _psize      ( psize     )
+{}
+
+/*! Appends the triangles of the polygon to triangles. Returns false if the
+ * polygon can't be triangulated - in which case triangles is not changed.*/
+bool PolyTriangulator::triangulate(IndexList& triangles)
+{
+   // The indexes of the result are word's
+   if ((3 > _psize) || (0xffff < _psize)) return false;
+   // The algorithm expects counter-clockwise order of the vertexes
+   real area = 0;
+   for (unsigned i = 0; i < _psize; i++)
+   {
+      unsigned j = (i + 1) % _psize;
+      area += (real)_pdata[2*i] * _pdata[2*j+1] - (real)_pdata[2*j] * _pdata[2*i+1];
+   }
+   if (0 == area) return false;
+   _order.resize(_psize);
+   for (unsigned i = 0; i < _psize; i++)
+      _order[i] = (0 < area) ? i : _psize - 1 - i;
+   if (!monotonePartition()) return false;
+   std::vector<VertexList> pieces;
+   if (!monotonePieces(pieces)) return false;
+   _leftChain.assign(_psize, false);
+   IndexList result;
+   result.reserve(3 * (_psize - 2));
+   for (std::vector<VertexList>::const_iterator CP = pieces.begin(); CP != pieces.end(); CP++)
+      if (!triangulateMonotone(*CP, result)) return false;
+   if (result.size() != 3 * (_psize - 2)) return false;
+   triangles.insert(triangles.end(), result.begin(), result.end());
+   return true;
+}
+
+bool PolyTriangulator::above(unsigned a, unsigned b) const
+{
+   if (py(a) != py(b)) return (py(a) > py(b));
+   if (px(a) != px(b)) return (px(a) < px(b));
+   return (a < b);
+}
+
+/*! Positive if a, b, c make a left turn*/
+real PolyTriangulator::orient(unsigned a, unsigned b, unsigned c) const
+{
+   return   (real)((int8b)px(b) - px(a)) * (real)((int8b)py(c) - py(a))
+          - (real)((int8b)py(b) - py(a)) * (real)((int8b)px(c) - px(a));
+}
+
+PolyTriangulator::VertexType PolyTriangulator::vertexType(unsigned p) const
+{
+   unsigned pp = prev(p);
+   unsigned np = next(p);
+   bool convex = (0 <= orient(pp, p, np));
+   if (above(p, pp) && above(p, np))
+      return convex ? vtStart : vtSplit;
+   else if (above(pp, p) && above(np, p))
+      return convex ? vtEnd : vtMerge;
+   else
+      return vtRegular;
+}
+
+/*! The sweep. The edges are identified by their first vertex - the edge p
+ * is between the vertexes p and next(p). The sweep status contains only the
+ * edges which have the polygon interior on their right side.*/
+bool PolyTriangulator::monotonePartition()
+{
+   VertexList events(_psize);
+   for (unsigned i = 0; i < _psize; i++) events[i] = i;
+   std::sort(events.begin(), events.end(), SweepOrder(this));
+   _helper.assign(_psize, 0);
+   _status.clear();
+   _diagonals.clear();
+   for (VertexList::const_iterator CV = events.begin(); CV != events.end(); CV++)
+   {
+      unsigned p  = *CV;
+      unsigned pe = prev(p); // the edge ending in p
+      unsigned le;           // the edge left of p
+      VertexList::iterator CS;
+      switch (vertexType(p))
+      {
+         case vtStart:
+            _status.push_back(p); _helper[p] = p;
+            break;
+         case vtEnd:
+            if (vtMerge == vertexType(_helper[pe])) addDiagonal(p, _helper[pe]);
+            if (_status.end() == (CS = std::find(_status.begin(), _status.end(), pe))) return false;
+            _status.erase(CS);
+            break;
+         case vtSplit:
+            if (!leftEdge(p, le)) return false;
+            addDiagonal(p, _helper[le]);
+            _helper[le] = p;
+            _status.push_back(p); _helper[p] = p;
+            break;
+         case vtMerge:
+            if (vtMerge == vertexType(_helper[pe])) addDiagonal(p, _helper[pe]);
+            if (_status.end() == (CS = std::find(_status.begin(), _status.end(), pe))) return false;
+            _status.erase(CS);
+            if (!leftEdge(p, le)) return false;
+            if (vtMerge == vertexType(_helper[le])) addDiagonal(p, _helper[le]);
+            _helper[le] = p;
+            break;
+         default:
+            if (above(pe, p))
+            {// the interior is on the right side of p
+               if (vtMerge == vertexType(_helper[pe])) addDiagonal(p, _helper[pe]);
+               if (_status.end() == (CS = std::find(_status.begin(), _status.end(), pe))) return false;
+               _status.erase(CS);
+               _status.push_back(p); _helper[p] = p;
+            }
+            else
+            {
+               if (!leftEdge(p, le)) return false;
+               if (vtMerge == vertexType(_helper[le])) addDiagonal(p, _helper[le]);
+               _helper[le] = p;
+            }
+            break;
+      }
+   }
+   return _status.empty();
+}
+
+/*! Finds the edge in the sweep status which is directly left of p*/
+bool PolyTriangulator::leftEdge(unsigned p, unsigned& edge) const
+{
+   bool found = false;
+   real bestX = 0;
+   for (VertexList::const_iterator CS = _status.begin(); CS != _status.end(); CS++)
+   {
+      unsigned a = *CS;
+      unsigned b = next(a);
+      real edgeX;
+      if (py(a) == py(b))
+         edgeX = std::min(px(a), px(b));
+      else
+         edgeX = px(a) + (real)((int8b)py(p) - py(a)) * (real)((int8b)px(b) - px(a))
+                                                        / (real)((int8b)py(b) - py(a));
+      if ((edgeX <= px(p)) && (!found || (edgeX > bestX)))
+      {
+         found = true; bestX = edgeX; edge = a;
+      }
+   }
+   return found;
+}
+
+void PolyTriangulator::addDiagonal(unsigned a, unsigned b)
+{
+   _diagonals.push_back(Diagonal(a, b));
+}
+
+/*! Splits the polygon into pieces along the diagonals. Every piece is
+ * traced in counter-clockwise order taking the sharpest right turn in every
+ * vertex.*/
+bool PolyTriangulator::monotonePieces(std::vector<VertexList>& pieces) const
+{
+   if (_diagonals.empty())
+   {// the polygon is monotone already
+      pieces.push_back(VertexList(_psize));
+      for (unsigned p = 0; p < _psize; p++) pieces.back()[p] = p;
+      return true;
+   }
+   // outgoing half edges of every vertex - the polygon edge and the diagonals
+   std::vector<VertexList> outEdges(_psize);
+   for (unsigned p = 0; p < _psize; p++)
+      outEdges[p].push_back(next(p));
+   for (std::vector<Diagonal>::const_iterator CD = _diagonals.begin(); CD != _diagonals.end(); CD++)
+   {
+      if (CD->first == CD->second) return false;
+      outEdges[CD->first ].push_back(CD->second);
+      outEdges[CD->second].push_back(CD->first );
+   }
+   unsigned numHalfEdges = _psize + 2 * _diagonals.size();
+   std::vector<std::vector<bool> > visited(_psize);
+   for (unsigned p = 0; p < _psize; p++)
+      visited[p].assign(outEdges[p].size(), false);
+   for (unsigned p = 0; p < _psize; p++)
+   {
+      for (unsigned e = 0; e < outEdges[p].size(); e++)
+      {
+         if (visited[p][e]) continue;
+         VertexList piece;
+         unsigned from = p, edx = e;
+         do
+         {
+            if (visited[from][edx] || (numHalfEdges < piece.size())) return false;
+            visited[from][edx] = true;
+            piece.push_back(from);
+            unsigned to = outEdges[from][edx];
+            // the next edge is the first one clockwise from (to -> from)
+            real back = atan2((real)py(from) - py(to), (real)px(from) - px(to));
+            real bestTurn = 0;
+            unsigned bestEdx = 0;
+            for (unsigned i = 0; i < outEdges[to].size(); i++)
+            {
+               unsigned cand = outEdges[to][i];
+               real turn = back - atan2((real)py(cand) - py(to), (real)px(cand) - px(to));
+               while (turn <= 0)        turn += 2 * M_PI;
+               while (turn >  2 * M_PI) turn -= 2 * M_PI;
+               if (cand == from) turn = 2 * M_PI;
+               if ((0 == i) || (turn < bestTurn))
+               {
+                  bestTurn = turn; bestEdx = i;
+               }
+            }
+            from = to; edx = bestEdx;
+         } while ((from != p) || (edx != e));
+         if (3 > piece.size()) return false;
+         pieces.push_back(piece);
+      }
+   }
+   return (pieces.size() == _diagonals.size() + 1);
+}
+
+void PolyTriangulator::addTriangle(unsigned a, unsigned b, unsigned c, IndexList& triangles) const
+{
+   triangles.push_back(_order[a]);
+   triangles.push_back(_order[b]);
+   triangles.push_back(_order[c]);
+}
+
+/*! The stack based triangulation of a y-monotone polygon. piece is in
+ * counter-clockwise order. */
+bool PolyTriangulator::triangulateMonotone(const VertexList& piece, IndexList& triangles)
+{
+   unsigned size = piece.size();
+   if (3 == size)
+   {
+      addTriangle(piece[0], piece[1], piece[2], triangles);
+      return true;
+   }
+   // find the top and the bottom vertex of the piece
+   unsigned top = 0, bottom = 0;
+   for (unsigned i = 1; i < size; i++)
+   {
+      if (above(piece[i], piece[top]   )) top    = i;
+      if (above(piece[bottom], piece[i])) bottom = i;
+   }
+   // The vertexes going counter-clockwise from the top to the bottom are on
+   // the left chain
+   for (unsigned i = 0; i < size; i++)
+      _leftChain[piece[i]] = false;
+   for (unsigned i = top; i != bottom; i = (i + 1) % size)
+      _leftChain[piece[i]] = true;
+   VertexList sorted(piece);
+   std::sort(sorted.begin(), sorted.end(), SweepOrder(this));
+   VertexList stack;
+   stack.push_back(sorted[0]);
+   stack.push_back(sorted[1]);
+   for (unsigned j = 2; j < size - 1; j++)
+   {
+      unsigned u = sorted[j];
+      if (_leftChain[u] != _leftChain[stack.back()])
+      {
+         while (1 < stack.size())
+         {
+            unsigned w = stack.back(); stack.pop_back();
+            addTriangle(u, w, stack.back(), triangles);
+         }
+         stack.clear();
+         stack.push_back(sorted[j-1]);
+         stack.push_back(u);
+      }
+      else
+      {
+         unsigned last = stack.back(); stack.pop_back();
+         while (!stack.empty())
+         {
+            real turn = orient(u, last, stack.back());
+            if (_leftChain[u] ? (0 <= turn) : (0 >= turn)) break;
+            addTriangle(u, last, stack.back(), triangles);
+            last = stack.back(); stack.pop_back();
+         }
+         stack.push_back(last);
+         stack.push_back(u);
+      }
+   }
+   unsigned u = sorted[size - 1];
+   while (1 < stack.size())
+   {
+      unsigned w = stack.back(); stack.pop_back();
+      addTriangle(u, w, stack.back(), triangles);
+   }
+   return true;
+}
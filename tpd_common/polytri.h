@@ -0,0 +1,78 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Triangulation of simple polygons
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef POLYTRI_H_INCLUDED
+#define POLYTRI_H_INCLUDED
+
+#include <vector>
+#include "ttt.h"
+
+//=============================================================================
+/*! Triangulates a simple polygon with integer coordinates. The polygon is
+ * split into y-monotone pieces with a plane sweep first (the helper/diagonal
+ * algorithm from "Computational Geometry" by de Berg et al.) and then every
+ * piece is triangulated with the usual stack based algorithm. Both steps are
+ * O(n log n) for the polygons in the layouts (the number of edges crossed by
+ * the sweep line is small).\n
+ * The result is a list of triangles - three vertex indexes per triangle -
+ * i.e. the GL_TRIANGLES index sequence of the polygon. The orientation of the
+ * polygon doesn't matter.\n
+ * The class has no static data, so several polygons can be triangulated
+ * simultaneously by different threads. If the polygon is not simple the
+ * result is not reliable. Most of those cases are detected though and
+ * triangulate() returns false.*/
+class PolyTriangulator {
+public:
+   typedef std::vector<word>        IndexList;
+                        PolyTriangulator(const int4b*, unsigned);
+   bool                 triangulate(IndexList&);
+private:
+   typedef std::vector<unsigned>    VertexList;
+   typedef std::pair<unsigned, unsigned> Diagonal;
+   enum VertexType {vtStart, vtEnd, vtSplit, vtMerge, vtRegular};
+   struct SweepOrder;
+   friend struct SweepOrder;
+   bool                 above(unsigned, unsigned) const;
+   real                 orient(unsigned, unsigned, unsigned) const;
+   int4b                px(unsigned p) const  {return _pdata[2 * _order[p]    ];}
+   int4b                py(unsigned p) const  {return _pdata[2 * _order[p] + 1];}
+   unsigned             next(unsigned p) const {return (p + 1) % _psize;}
+   unsigned             prev(unsigned p) const {return (p + _psize - 1) % _psize;}
+   VertexType           vertexType(unsigned) const;
+   bool                 monotonePartition();
+   bool                 leftEdge(unsigned, unsigned&) const;
+   void                 addDiagonal(unsigned, unsigned);
+   bool                 monotonePieces(std::vector<VertexList>&) const;
+   bool                 triangulateMonotone(const VertexList&, IndexList&);
+   void                 addTriangle(unsigned, unsigned, unsigned, IndexList&) const;
+   const int4b*         _pdata;
+   unsigned             _psize;
+   VertexList           _order;     //! polygon vertexes in counter-clockwise order
+   VertexList           _status;    //! the edges crossed by the sweep line
+   VertexList           _helper;    //! the helper vertex of every edge
+   std::vector<Diagonal> _diagonals;
+   std::vector<bool>    _leftChain; //! the chain of every vertex in the current monotone piece
+};
+
+#endif
@@ -0,0 +1,92 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Simple pool of worker threads
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include <algorithm>
+#include "thrdpool.h"
+
+//-----------------------------------------------------------------------------
+// class ThreadPool
+//-----------------------------------------------------------------------------
+/*! The numThreads includes the calling thread. Value 0 means - as many threads
+ * as the CPUs in the system*/
+ThreadPool::ThreadPool(unsigned numThreads) :
+   _numThreads ( numThreads ),
+   _jobs       ( NULL       ),
+   _nextJob    ( 0          )
+{
+   if (0 == _numThreads) _numThreads = numCPUs();
+}
+
+unsigned ThreadPool::numCPUs()
+{
+   int cpus = wxThread::GetCPUCount();
+   return (0 < cpus) ? cpus : 1;
+}
+
+void ThreadPool::execute(JobList& jobs)
+{
+   _jobs = &jobs;
+   _nextJob = 0;
+   unsigned numWorkers = std::min<unsigned>(_numThreads, jobs.size());
+   std::vector<Worker*> workers;
+   for (unsigned i = 1; i < numWorkers; i++)
+   {
+      Worker* worker = DEBUG_NEW Worker(this);
+      if ((wxTHREAD_NO_ERROR == worker->Create()) && (wxTHREAD_NO_ERROR == worker->Run()))
+         workers.push_back(worker);
+      else
+         delete worker;
+   }
+   runJobs();
+   for (std::vector<Worker*>::const_iterator CW = workers.begin(); CW != workers.end(); CW++)
+   {
+      (*CW)->Wait();
+      delete (*CW);
+   }
+   _jobs = NULL;
+}
+
+ThreadJob* ThreadPool::nextJob()
+{
+   wxMutexLocker lock(_mutex);
+   if (_nextJob < _jobs->size())
+      return (*_jobs)[_nextJob++];
+   else
+      return NULL;
+}
+
+void ThreadPool::runJobs()
+{
+   ThreadJob* job;
+   while (NULL != (job = nextJob()))
+      job->run();
+}
+
+wxThread::ExitCode ThreadPool::Worker::Entry()
+{
+   _pool->runJobs();
+   return NULL;
+}
@@ -0,0 +1,74 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Simple pool of worker threads
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef THRDPOOL_H_INCLUDED
+#define THRDPOOL_H_INCLUDED
+
+#include <wx/thread.h>
+#include <vector>
+
+//=============================================================================
+/*! A piece of work which can be executed by the ThreadPool. The jobs executed
+ * by the same pool run concurrently, so they must not share any non-constant
+ * data */
+class ThreadJob {
+public:
+   virtual             ~ThreadJob() {}
+   virtual void         run() = 0;
+};
+
+//=============================================================================
+/*! Executes a list of independent jobs on a number of worker threads. The
+ * workers take the jobs one by one from a common queue, so an idle thread
+ * always picks-up the next pending job, regardless how unbalanced the jobs
+ * are. The calling thread takes part in the execution as well and the
+ * execute() method returns when all jobs are done.\n
+ * If a worker thread can't be created, the remaining threads (including the
+ * calling one) simply take more jobs - i.e. the result doesn't depend on the
+ * actual number of threads. */
+class ThreadPool {
+public:
+   typedef std::vector<ThreadJob*> JobList;
+                        ThreadPool(unsigned numThreads);
+   void                 execute(JobList&);
+   unsigned             numThreads() const {return _numThreads;}
+   static unsigned      numCPUs();
+private:
+   class Worker : public wxThread {
+   public:
+                        Worker(ThreadPool* pool) : wxThread(wxTHREAD_JOINABLE), _pool(pool) {}
+   protected:
+      virtual ExitCode  Entry();
+   private:
+      ThreadPool*       _pool;
+   };
+   ThreadJob*           nextJob();
+   void                 runJobs();
+   unsigned             _numThreads;
+   JobList*             _jobs;
+   unsigned             _nextJob;
+   wxMutex              _mutex;
+};
+
+#endif
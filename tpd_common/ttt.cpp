@@ -242,25 +242,23 @@ int8b DBbox::cliparea(const DBbox& bx, bool calculate) const
    if ((A_place | B_place) == 0) return -1.0; //inside;
    // the boxes intersect each other, so let's find the intersection area
    if (!calculate) return 1.0;
-   TP *Aprim, *Bprim;
+   TP Aprim, Bprim;
    switch (A_place) {
-      case 0x00: Aprim = DEBUG_NEW TP(bx.p1()); break;
-      case 0x01: Aprim = DEBUG_NEW TP(_p1.x(), bx.p1().y());break;
-      case 0x04: Aprim = DEBUG_NEW TP(bx.p1().x(), _p1.y());break;
-      case 0x05: Aprim = DEBUG_NEW TP(_p1);break;
+      case 0x00: Aprim = bx.p1(); break;
+      case 0x01: Aprim = TP(_p1.x(), bx.p1().y());break;
+      case 0x04: Aprim = TP(bx.p1().x(), _p1.y());break;
+      case 0x05: Aprim = _p1;break;
       default: assert(false);break;
    }
    switch (B_place) {
-      case 0x00: Bprim = DEBUG_NEW TP(bx.p2());break;
-      case 0x02: Bprim = DEBUG_NEW TP(_p2.x(),bx.p2().y());break;
-      case 0x08: Bprim = DEBUG_NEW TP(bx.p2().x(),_p2.y());break;
-      case 0x0A: Bprim = DEBUG_NEW TP(_p2);break;
+      case 0x00: Bprim = bx.p2();break;
+      case 0x02: Bprim = TP(_p2.x(),bx.p2().y());break;
+      case 0x08: Bprim = TP(bx.p2().x(),_p2.y());break;
+      case 0x0A: Bprim = _p2;break;
       default: assert(false);break;
    }
-   int8b area =  llabs(((int8b)Aprim->x() - (int8b)Bprim->x()) *
-                       ((int8b)Aprim->y() - (int8b)Bprim->y())   );
-   delete Aprim; delete Bprim;
-   return area;
+   return llabs(((int8b)Aprim.x() - (int8b)Bprim.x()) *
+                ((int8b)Aprim.y() - (int8b)Bprim.y())   );
 }
 
 int DBbox::clipbox(DBbox& bx) {
@@ -287,23 +285,22 @@ int DBbox::clipbox(DBbox& bx) {
    if ((B_place & 0x05) > 0) return 0; // outside
    if ((A_place | B_place) == 0) return -1; //inside;
    // the boxes intersect each other, so let's find the intersection area
-   TP *Aprim, *Bprim;
+   TP Aprim, Bprim;
    switch (A_place) {
-      case 0x00: Aprim = DEBUG_NEW TP(bx.p1()); break;
-      case 0x01: Aprim = DEBUG_NEW TP(_p1.x(), bx.p1().y());break;
-      case 0x04: Aprim = DEBUG_NEW TP(bx.p1().x(), _p1.y());break;
-      case 0x05: Aprim = DEBUG_NEW TP(_p1);break;
+      case 0x00: Aprim = bx.p1(); break;
+      case 0x01: Aprim = TP(_p1.x(), bx.p1().y());break;
+      case 0x04: Aprim = TP(bx.p1().x(), _p1.y());break;
+      case 0x05: Aprim = _p1;break;
       default: assert(false);break;
    }
    switch (B_place) {
-      case 0x00: Bprim = DEBUG_NEW TP(bx.p2());break;
-      case 0x02: Bprim = DEBUG_NEW TP(_p2.x(),bx.p2().y());break;
-      case 0x08: Bprim = DEBUG_NEW TP(bx.p2().x(),_p2.y());break;
-      case 0x0A: Bprim = DEBUG_NEW TP(_p2);break;
+      case 0x00: Bprim = bx.p2();break;
+      case 0x02: Bprim = TP(_p2.x(),bx.p2().y());break;
+      case 0x08: Bprim = TP(bx.p2().x(),_p2.y());break;
+      case 0x0A: Bprim = _p2;break;
       default: assert(false);break;
    }
-   bx = DBbox(*Aprim, *Bprim);
-   delete Aprim; delete Bprim;
+   bx = DBbox(Aprim, Bprim);
    return 1;
 }
 
@@ -329,16 +326,17 @@ int8b DBbox::boxarea() const
 
 bool DBbox::visible(const CTM& tmtrx, int8b visualLimit) const
 {
-   PointVector ptlist;
-   ptlist.reserve(4);
-
-   ptlist.push_back(               (_p1) * tmtrx);
-   ptlist.push_back(TP(_p2.x(), _p1.y()) * tmtrx);
-   ptlist.push_back(               (_p2) * tmtrx);
-   ptlist.push_back(TP(_p1.x(), _p2.y()) * tmtrx);
-
-   if (llabs(polyarea(ptlist)) >= visualLimit) return true;
-   else                                        return false;
+   // Called for every object on every redraw - so no heap allocations here.
+   // Same as polyarea() for the four transformed corners.
+   const TP ptlist[4] = {              (_p1) * tmtrx,
+                         TP(_p2.x(), _p1.y()) * tmtrx,
+                                       (_p2) * tmtrx,
+                         TP(_p1.x(), _p2.y()) * tmtrx};
+   int8b area = 0ll;
+   for (word i = 0, j = 1; i < 4; i++, j = (j+1) % 4)
+      area += ( (int8b)ptlist[i].x() * (int8b)ptlist[j].y() ) -
+              ( (int8b)ptlist[j].x() * (int8b)ptlist[i].y() )   ;
+   return (llabs(area) >= visualLimit);
 }
 
 DBbox DBbox::getcorner(QuadIdentificators corner)
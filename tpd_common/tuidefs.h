@@ -187,7 +187,9 @@ namespace tui
       ZOOM_UP             ,
       ZOOM_DOWN           ,
       ZOOM_EMPTY          ,
-      ZOOM_REFRESH
+      ZOOM_REFRESH        ,
+      ZOOM_RENDERED       , // the background traversal of the view is done
+      ZOOM_OFFSCREEN        // render a view in an off-screen buffer (trend::OffScreenView)
    } ZOOM_TYPE;
 
    typedef enum  {
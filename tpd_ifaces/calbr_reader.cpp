@@ -51,7 +51,6 @@ auxdata::DrcPoly::DrcPoly(int4b* pdata, unsigned psize, unsigned ordinal) :
    _psize      ( psize     ),
    _ordinal    ( ordinal   )
 {
-   _teseldata.tessellate(_pdata, _psize);
 }
 
 auxdata::DrcPoly::~DrcPoly()
@@ -41,7 +41,8 @@
 //==============================================================================
 GDSin::GdsRecord::GdsRecord()
 {
-   _record = DEBUG_NEW byte[0xffff];
+   _buffer = DEBUG_NEW byte[0xffff];
+   _record = _buffer;
    _valid = false;
    _recLen = 0;
    _recType = gds_HEADER;
@@ -56,7 +57,8 @@ GDSin::GdsRecord::GdsRecord(byte rt, byte dt, word rl)
    _recLen = rl+4; _index = 0;
    // compensation for odd length ASCII string
    if ((gdsDT_ASCII == _dataType) && (rl % 2)) _recLen++;
-   _record = DEBUG_NEW byte[_recLen];
+   _buffer = DEBUG_NEW byte[_recLen];
+   _record = _buffer;
    add_int2b(_recLen);
    _record[_index++] = _recType;
    _record[_index++] = _dataType;
@@ -67,7 +69,16 @@ void GDSin::GdsRecord::getNextRecord(ForeignDbFile* Gf, word rl, byte rt, byte d
    _recLen = rl; _recType = rt; _dataType = dt;
    if (rl)
    {
-      _valid = Gf->readStream(_record, _recLen, true);
+      if (Gf->mapped())
+      {
+         // the record is just a view in the mapped file - no copying
+         setMapped(Gf->readMapped(_recLen, true), rl, rt, dt);
+      }
+      else
+      {
+         _record = _buffer;
+         _valid = Gf->readStream(_record, _recLen, true);
+      }
    }
    else
    {
@@ -76,6 +87,14 @@ void GDSin::GdsRecord::getNextRecord(ForeignDbFile* Gf, word rl, byte rt, byte d
    }
 }
 
+void GDSin::GdsRecord::setMapped(const byte* data, word rl, byte rt, byte dt)
+{
+   _recLen = rl; _recType = rt; _dataType = dt;
+   _numread = 0;
+   _valid = (0 == rl) || (NULL != data);
+   _record = (rl && _valid) ? const_cast<byte*>(data) : _buffer;
+}
+
 size_t GDSin::GdsRecord::flush(wxFFile& Gf)
 {
    assert(_index == _recLen);
@@ -302,7 +321,7 @@ void GDSin::GdsRecord::add_real8b(const real data)
 
 GDSin::GdsRecord::~GdsRecord()
 {
-   delete[] _record;
+   delete[] _buffer;
 }
 
 //==============================================================================
@@ -317,6 +336,9 @@ GDSin::GdsInFile::GdsInFile(const wxString& wxfname) : ForeignDbFile(wxfname, fa
    {
       throw EXPTNreadGDS("Failed to open input file");
    }
+   // Both passes (parsing and import) are done directly in the mapped file if
+   // possible. Otherwise the file is streamed as usual
+   mapStream();
    do
    {// start reading
       if (getNextRecord())
@@ -467,6 +489,12 @@ bool GDSin::GdsInFile::getNextRecord()
    else return false;// error during read in
 }
 
+void GDSin::GdsInFile::addGdsiiWarnings(int warnings)
+{
+   wxMutexLocker lock(_warnMutex);
+   _gdsiiWarnings += warnings;
+}
+
 double GDSin::GdsInFile::libUnits() const
 {
    return _library->dbu();// /_library->uu();
@@ -620,17 +648,65 @@ GDSin::GdsLibrary::~GdsLibrary()
       delete (CSTR->second);
 }
 
+//==============================================================================
+//==============================================================================
+// class GdsMappedReader
+//==============================================================================
+GDSin::GdsMappedReader::GdsMappedReader(GdsInFile* file, wxFileOffset filePos) :
+   _file(file), _filePos(filePos), _gdsiiWarnings(0)
+{
+   assert(_file->mapped());
+}
+
+const byte* GDSin::GdsMappedReader::read(size_t len)
+{
+   if ((_filePos + (wxFileOffset)len) > _file->fileLength())
+      return NULL;
+   const byte* data = _file->mapAddr() + _filePos;
+   _filePos += len;
+   return data;
+}
+
+bool GDSin::GdsMappedReader::getNextRecord()
+{
+   const byte* recheader = read(4);
+   if (NULL == recheader)
+      return false;// error during read in
+   word reclen = ((word)recheader[0] << 8 | recheader[1]) - 4; // record length
+   _cRecord.setMapped(read(reclen), reclen, recheader[2], recheader[3]);
+   return _cRecord.valid();
+}
+
+GDSin::GdsMappedReader::~GdsMappedReader()
+{
+   if (_gdsiiWarnings) _file->addGdsiiWarnings(_gdsiiWarnings);
+}
+
 //==============================================================================
 // class GdsStructure
 //==============================================================================
 void GDSin::GdsStructure::import(ImportDB& iDB)
+{
+   GdsInFile* srcFile = static_cast<GdsInFile*>(iDB.srcFile());
+   if (iDB.staging())
+   {
+      // concurrent import - read from the mapped file with a private reader
+      GdsMappedReader reader(srcFile, _filePos);
+      import(&reader, iDB);
+   }
+   else
+   {
+      srcFile->setPosition(_filePos);
+      import(srcFile, iDB);
+   }
+}
+
+void GDSin::GdsStructure::import(GdsRecordReader* cf, ImportDB& iDB)
 {
    std::string strctName;
    //initializing
    iDB.calcCrossCoeff(1.0);
-   GdsInFile* cf = static_cast<GdsInFile*>(iDB.srcFile());
    const GdsRecord* cr = cf->cRecord();
-   cf->setPosition(_filePos);
    do
    { //start reading
       if (cf->getNextRecord())
@@ -993,7 +1069,7 @@ void GDSin::GdsStructure::skimText(GdsInFile* cf)
    while (true);
 }
 
-void GDSin::GdsStructure::skimNode(GdsInFile* cf)
+void GDSin::GdsStructure::skimNode(GdsRecordReader* cf)
 {
    int2b layer, singleType;
    const GdsRecord* cr = cf->cRecord();
@@ -1024,7 +1100,7 @@ void GDSin::GdsStructure::skimNode(GdsInFile* cf)
    while (true);
 }
 
-void GDSin::GdsStructure::importBox(GdsInFile* cf, ImportDB& iDB)
+void GDSin::GdsStructure::importBox(GdsRecordReader* cf, ImportDB& iDB)
 {
    int2b       layer;
    int2b       singleType;
@@ -1073,7 +1149,7 @@ void GDSin::GdsStructure::importBox(GdsInFile* cf, ImportDB& iDB)
 
 }
 
-void GDSin::GdsStructure::importPoly(GdsInFile* cf, ImportDB& iDB)
+void GDSin::GdsStructure::importPoly(GdsRecordReader* cf, ImportDB& iDB)
 {
    int2b       layer;
    int2b       singleType;
@@ -1120,7 +1196,7 @@ void GDSin::GdsStructure::importPoly(GdsInFile* cf, ImportDB& iDB)
    while (true);
 }
 
-void GDSin::GdsStructure::importPath(GdsInFile* cf, ImportDB& iDB)
+void GDSin::GdsStructure::importPath(GdsRecordReader* cf, ImportDB& iDB)
 {
    int2b layer;
    int2b singleType;
@@ -1181,7 +1257,7 @@ void GDSin::GdsStructure::importPath(GdsInFile* cf, ImportDB& iDB)
    while (cr->recType() != gds_ENDEL);
 }
 
-void GDSin::GdsStructure::importText(GdsInFile* cf, ImportDB& iDB)
+void GDSin::GdsStructure::importText(GdsRecordReader* cf, ImportDB& iDB)
 {
    int2b       layer;
    int2b       singleType;
@@ -1259,7 +1335,7 @@ void GDSin::GdsStructure::importText(GdsInFile* cf, ImportDB& iDB)
 }
 
 
-void GDSin::GdsStructure::importSref(GdsInFile* cf, ImportDB& iDB)
+void GDSin::GdsStructure::importSref(GdsRecordReader* cf, ImportDB& iDB)
 {
    word           reflection     = 0;
 //   word           absMagn        = 0; //TODO
@@ -1321,7 +1397,7 @@ void GDSin::GdsStructure::importSref(GdsInFile* cf, ImportDB& iDB)
    while (true);
 }
 
-void GDSin::GdsStructure::importAref(GdsInFile* cf, ImportDB& iDB)
+void GDSin::GdsStructure::importAref(GdsRecordReader* cf, ImportDB& iDB)
 {
    word           reflection     = 0;
 //   word           absMagn        = 0; //TODO
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <wx/ffile.h>
 #include <wx/wfstream.h>
+#include <wx/thread.h>
 #include "ttt.h"
 #include "tedstd.h"
 
@@ -139,7 +140,8 @@ namespace GDSin {
    > reclen      - length of current GDS record
    > rectype   - type of current GdsRecord
    > datatype   - type of data that this record contain
-   > record      - the information record
+   > record      - the information record. Points either to the own buffer
+   >               or directly in the input file if it is memory mapped
    > numRead   - number of really read bytes in this record
    > isvalid   - true if numRead == reclen, otherwise - false
    >>> Methods ------------------------------------------------------------------
@@ -156,6 +158,7 @@ namespace GDSin {
                            GdsRecord();
                            GdsRecord(byte rt, byte dt, word rl);
          void              getNextRecord(ForeignDbFile* Gf, word rl, byte rt, byte dt);
+         void              setMapped(const byte* data, word rl, byte rt, byte dt);
          bool              retData(void* var, word curnum = 0, byte len = 0) const;
          size_t            flush(wxFFile& Gf);
          void              add_int2b(const word);
@@ -176,6 +179,7 @@ namespace GDSin {
          byte              _recType;
          byte              _dataType;
          byte*             _record;
+         byte*             _buffer;
          size_t            _numread;
          word              _index;
    };
@@ -213,11 +217,25 @@ namespace GDSin {
    > GetReadErrors()      - Returns the number of errors during GDSII file reading
    > GetTimes()         - Reads values of t_access and t_modiff (see above)
    ******************************************************************************/
-   class   GdsInFile : public ForeignDbFile {
+   /*** GdsRecordReader *********************************************************
+   > The source of GDSII records for the cell parsers. The records are read
+   > either sequentially from the input file (GdsInFile), or from a given
+   > position of the memory mapped file (GdsMappedReader). Many of the latter
+   > can read simultaneously from the same file.
+   ******************************************************************************/
+   class   GdsRecordReader {
+      public:
+         virtual             ~GdsRecordReader() {}
+         virtual bool         getNextRecord() = 0;
+         virtual const GdsRecord* cRecord() const = 0;
+         virtual int          incGdsiiWarnings() = 0;
+   };
+
+   class   GdsInFile : public ForeignDbFile, public GdsRecordReader {
       public:
                               GdsInFile(const wxString&);
          virtual             ~GdsInFile();
-         bool                 getNextRecord();
+         virtual bool         getNextRecord();
          GdsStructure*        getStructure(const std::string);
          virtual double       libUnits() const;
          virtual void         hierOut();
@@ -227,9 +245,11 @@ namespace GDSin {
          virtual void         getTopCells(NameList&) const;
          virtual void         getAllCells(wxListBox&) const;
          virtual void         convertPrep(const NameList&, bool);
-         const GdsRecord*     cRecord() const                  { return &_cRecord;                    }
+         virtual bool         concurrentImport() const         { return mapped();                     }
+         virtual const GdsRecord* cRecord() const              { return &_cRecord;                    }
          int                  gdsiiWarnings()                  { return _gdsiiWarnings;               }
-         int                  incGdsiiWarnings()               { return ++_gdsiiWarnings;             }
+         virtual int          incGdsiiWarnings()               { return ++_gdsiiWarnings;             }
+         void                 addGdsiiWarnings(int);
          const GdsLibrary*    library() const                  { return _library;                     }
       private:
          void                 getTimes();
@@ -238,11 +258,34 @@ namespace GDSin {
          std::string          _srfName;
          GdsLibrary*          _library;
          int                  _gdsiiWarnings;
+         wxMutex              _warnMutex;
          TpdTime              _tModif;
          TpdTime              _tAccess;
          GdsRecord            _cRecord;
    };
 
+   /*** GdsMappedReader *********************************************************
+   > Reads the records of a memory mapped GdsInFile starting from a given
+   > position. It has its own position and current record, so it doesn't
+   > disturb the file or the other readers. Used for concurrent import of the
+   > GDSII structures. The warnings are accumulated locally and added to the
+   > file in the destructor.
+   ******************************************************************************/
+   class   GdsMappedReader : public GdsRecordReader {
+      public:
+                              GdsMappedReader(GdsInFile*, wxFileOffset);
+         virtual             ~GdsMappedReader();
+         virtual bool         getNextRecord();
+         virtual const GdsRecord* cRecord() const              { return &_cRecord;                    }
+         virtual int          incGdsiiWarnings()               { return ++_gdsiiWarnings;             }
+      private:
+         const byte*          read(size_t);
+         GdsInFile*           _file;
+         wxFileOffset         _filePos;
+         int                  _gdsiiWarnings;
+         GdsRecord            _cRecord;
+   };
+
    /*** GdsStructure ************************************************************
    >>> Constructor --------------------------------------------------------------
    > Reads a GDSII structure
@@ -288,19 +331,20 @@ namespace GDSin {
          void                 linkReferences(GdsInFile* const, GdsLibrary* const);
          void                 split(GdsInFile*, GdsOutFile*);
       protected:
-         void                 importBox (GdsInFile*, ImportDB&);
-         void                 importPoly(GdsInFile*, ImportDB&);
-         void                 importPath(GdsInFile*, ImportDB&);
-         void                 importText(GdsInFile*, ImportDB&);
-         void                 importSref(GdsInFile*, ImportDB&);
-         void                 importAref(GdsInFile*, ImportDB&);
+         void                 import(GdsRecordReader*, ImportDB&);
+         void                 importBox (GdsRecordReader*, ImportDB&);
+         void                 importPoly(GdsRecordReader*, ImportDB&);
+         void                 importPath(GdsRecordReader*, ImportDB&);
+         void                 importText(GdsRecordReader*, ImportDB&);
+         void                 importSref(GdsRecordReader*, ImportDB&);
+         void                 importAref(GdsRecordReader*, ImportDB&);
          void                 skimBox(GdsInFile*);
          void                 skimBoundary(GdsInFile*);
          void                 skimPath(GdsInFile*);
          void                 skimText(GdsInFile*);
          void                 skimSRef(GdsInFile*);
          void                 skimARef(GdsInFile*);
-         void                 skimNode(GdsInFile*);
+         void                 skimNode(GdsRecordReader*);
          void                 updateContents(int2b, int2b);
 //         int                  arrGetStep(TP&, TP&, int2b);
          TP                   arrGetStep(const TP&, int2b, const CTM&);
@@ -28,6 +28,7 @@
 #include "oasis_io.h"
 #include "tedesign.h"
 #include <sstream>
+#include <algorithm>
 
 const dword Oasis::Iso3309Crc32::_crc32Poly     = 0x04c11db7u;  // The CRC polynomial
 const dword Oasis::Iso3309Crc32::_crc32Constant = 0x38fb2284u;  // constant which matches polynomial above
@@ -50,7 +51,7 @@ void Oasis::Table::getCellNameTable(OasisInFile& ofh)
 {
    if (0 != _offsetStart)
    {
-      wxFileOffset savedPos = ofh.filePos();
+      wxFileOffset savedPos = ofh.oasFilePos();
       ofh.oasSetPosition(_offsetStart);
       ofh.setPropContext(pc_cell);
       byte recType;
@@ -74,7 +75,7 @@ void Oasis::Table::getPropNameTable(OasisInFile& ofh)
 {
    if (0 != _offsetStart)
    {
-      wxFileOffset savedPos = ofh.filePos();
+      wxFileOffset savedPos = ofh.oasFilePos();
       ofh.oasSetPosition(_offsetStart);
       byte recType;
       do
@@ -95,7 +96,7 @@ void Oasis::Table::getPropStringTable(OasisInFile& ofh)
 {
    if (0 != _offsetStart)
    {
-      wxFileOffset savedPos = ofh.filePos();
+      wxFileOffset savedPos = ofh.oasFilePos();
       ofh.oasSetPosition(_offsetStart);
       byte recType;
       do
@@ -116,7 +117,7 @@ void Oasis::Table::getTextStringTable(OasisInFile& ofh)
 {
    if (0 != _offsetStart)
    {
-      wxFileOffset savedPos = ofh.filePos();
+      wxFileOffset savedPos = ofh.oasFilePos();
       ofh.oasSetPosition(_offsetStart);
       byte recType;
       do
@@ -138,7 +139,7 @@ void  Oasis::Table::getTableRecord(OasisInFile& ofn, TableMode ieMode, bool tabl
 {
    // check whether we've stepped into the Table space without really trying to read
    // the Table contents (it has already been parsed)
-   if (!tableRec && (ofn.filePos() >= _offsetStart) && (ofn.filePos() <= _offsetEnd))
+   if (!tableRec && (ofn.oasFilePos() >= _offsetStart) && (ofn.oasFilePos() <= _offsetEnd))
    {
       // move the current file pointer at the end of the table
       ofn.oasSetPosition(_offsetEnd); return;
@@ -172,52 +173,56 @@ std::string Oasis::Table::getName(dword index) const
       return record->second;
 }
 //===========================================================================
-Oasis::CBlockInflate::CBlockInflate(ForeignDbFile& ifn, wxFileOffset fofset, dword size_deflated, dword size_inflated)
+Oasis::CBlockInflate::CBlockInflate(const byte* deflated, wxFileOffset fofset, dword size_deflated, dword size_inflated)
 {
    // initialize z_stream members
    zalloc       = 0;
    zfree        = 0;
    opaque       = 0;
-   next_in      = _input_buffer  = DEBUG_NEW byte[size_deflated];
+   next_in      = const_cast<byte*>(deflated);
    next_out     = _output_buffer = DEBUG_NEW byte[size_inflated];
-   if (ifn.readStream(next_in,size_deflated, true))
-   {
-      avail_in     = size_deflated;
-      avail_out    = size_inflated;
-      _startPosInFile = fofset;
-      if (Z_OK != (_state = inflateInit2(this, -15) ))
-         throw EXPTNreadOASIS(msg);
-      if (Z_STREAM_END != (_state = inflate(this,Z_NO_FLUSH)))
-         throw EXPTNreadOASIS(msg);
-      if (Z_OK != (_state = inflateEnd(this)))
-         throw EXPTNreadOASIS(msg);
-      _bufOffset = 0;
-      _bufSize   = size_inflated;
-   //   delete [] next_in;
-   }
-   else
-   {
-      std::ostringstream info;
-      info << "Error while retrieving compressed block " << " @ position " << ifn.filePos();
-      throw EXPTNreadOASIS(info.str());
-   }
+   avail_in     = size_deflated;
+   avail_out    = size_inflated;
+   _startPosInFile = fofset;
+   _bufSize     = size_inflated;
+   if (Z_OK != (_state = inflateInit2(this, -15) ))
+      throw EXPTNreadOASIS(msg);
+   if (Z_STREAM_END != (_state = inflate(this,Z_NO_FLUSH)))
+      throw EXPTNreadOASIS(msg);
+   if (Z_OK != (_state = inflateEnd(this)))
+      throw EXPTNreadOASIS(msg);
 }
 
-void Oasis::CBlockInflate::readUncompressedBuffer(void *pBuf, size_t nCount)
+Oasis::CBlockInflate::~CBlockInflate()
 {
-   if (wxFileOffset(_bufOffset + nCount) > _bufSize)
-      throw EXPTNreadOASIS("Read past the end of current CBLOCK (internal error)");
-   else
-   {
-      for (size_t i = 0; i < nCount; i++, _bufOffset++)
-         ((byte*)pBuf)[i] = _output_buffer[_bufOffset];
-   }
+   delete [] _output_buffer;
 }
 
-Oasis::CBlockInflate::~CBlockInflate()
+//===========================================================================
+Oasis::CBlockDeflate::CBlockDeflate(const byte* inflated, dword size_inflated) :
+   _output_buffer(NULL), _bufSize(0)
 {
-   delete [] _output_buffer;
-   delete [] _input_buffer;
+   // initialize z_stream members
+   zalloc       = 0;
+   zfree        = 0;
+   opaque       = 0;
+   next_in      = const_cast<byte*>(inflated);
+   avail_in     = size_inflated;
+   // raw deflate stream as required by the standard (35.3)
+   if (Z_OK != (_state = deflateInit2(this, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY)))
+      return;
+   dword bound  = deflateBound(this, size_inflated);
+   next_out     = _output_buffer = DEBUG_NEW byte[bound];
+   avail_out    = bound;
+   _state       = deflate(this, Z_FINISH);
+   _bufSize     = bound - avail_out;
+   deflateEnd(this);
+}
+
+Oasis::CBlockDeflate::~CBlockDeflate()
+{
+   if (NULL != _output_buffer)
+      delete [] _output_buffer;
 }
 
 //===========================================================================
@@ -278,6 +283,12 @@ Oasis::OasisInFile::OasisInFile(wxString fn) : ForeignDbFile(fn, true),
       _xNames           ( NULL         ),
       _offsetFlag       ( false        ),
       _curCBlock        ( NULL         ),
+      _bufCur           ( NULL         ),
+      _bufEnd           ( NULL         ),
+      _bufStart         ( NULL         ),
+      _fileCur          ( NULL         ),
+      _fileEnd          ( NULL         ),
+      _readAhead        ( NULL         ),
       _validation       ( vs_unknown   ),
       _signature        ( 0u           )
 {
@@ -285,6 +296,10 @@ Oasis::OasisInFile::OasisInFile(wxString fn) : ForeignDbFile(fn, true),
    {
       throw EXPTNreadOASIS("Failed to open input file");
    }
+   // The decoding window is a view in the mapped file if possible, otherwise
+   // a read-ahead buffer
+   if (!mapStream())
+      _readAhead = DEBUG_NEW byte[OAS_READ_AHEAD];
    byte magicBytes[13];
    if ( readStream(magicBytes, 13, true) )
    {
@@ -334,28 +349,113 @@ Oasis::OasisInFile::OasisInFile(wxString fn) : ForeignDbFile(fn, true),
 wxFileOffset Oasis::OasisInFile::oasSetPosition(wxFileOffset fPos)
 {
    wxFileOffset coffset;
-   if (NULL != _curCBlock)
-   {
+   if ((NULL != _curCBlock) && (_bufCur < _bufEnd))
       coffset = _curCBlock->startPosInFile() - 1;
-      delete _curCBlock;
-      _curCBlock = NULL;
-   }
    else
-      coffset = filePos() - 1;
-
+      coffset = oasFilePos() - 1;
+   resetBuffer();
    setPosition(fPos);
    return coffset;
 }
 
+/*! Returns the position in the input file of the next byte to be decoded.
+ * The file itself is read ahead, so its position is normally behind this one.
+ * Inside a CBLOCK - returns the position after the CBLOCK.*/
+wxFileOffset Oasis::OasisInFile::oasFilePos() const
+{
+   if (NULL != _curCBlock)
+      return filePos() - (_fileEnd - _fileCur);
+   else
+      return filePos() - (_bufEnd  - _bufCur );
+}
+
 void Oasis::OasisInFile::inflateCBlock()
 {
-   wxFileOffset cblockfPos = filePos();
+   wxFileOffset cblockfPos = oasFilePos();
    byte compression_type = getUnsignedInt(2);
    if (0 != compression_type)
       exception("Unknown compression type in the CBLOCK (35.3)");
    dword size_uncompressed = getUnsignedInt(4);
    dword size_compressed   = getUnsignedInt(4);
-   _curCBlock = DEBUG_NEW CBlockInflate(*this , cblockfPos, size_compressed, size_uncompressed);
+   // The compressed data is inflated directly from the decoding window if
+   // it's entirely there. Otherwise it is collected in a temporary buffer
+   const byte* deflated = _bufCur;
+   byte* collected = NULL;
+   if ((_bufEnd - _bufCur) >= (wxFileOffset)size_compressed)
+      _bufCur += size_compressed;
+   else
+   {
+      deflated = collected = DEBUG_NEW byte[size_compressed];
+      try {rawRead(collected, size_compressed);}
+      catch (EXPTN&) {delete [] collected; throw;}
+   }
+   try {_curCBlock = DEBUG_NEW CBlockInflate(deflated, cblockfPos, size_compressed, size_uncompressed);}
+   catch (EXPTN&) {if (NULL != collected) delete [] collected; throw;}
+   if (NULL != collected) delete [] collected;
+   // save the file window and continue decoding from the inflated data
+   _fileCur = _bufCur;
+   _fileEnd = _bufEnd;
+   _bufCur  = _curCBlock->buffer();
+   _bufEnd  = _bufCur + _curCBlock->bufSize();
+}
+
+/*! Called by getByte() when the decoding window is exhausted. If the current
+ * window is a CBLOCK - returns to the file window. Reads the next chunk of the
+ * file if required and returns its first byte*/
+byte Oasis::OasisInFile::nextBuffer()
+{
+   if (NULL != _curCBlock)
+   {
+      releaseCBlock();
+      if (_bufCur < _bufEnd) return *_bufCur++;
+   }
+   retireBuffer();
+   size_t len = std::min((wxFileOffset)OAS_READ_AHEAD, fileLength() - filePos());
+   if (0 == len)
+      exception("I/O error during read-in");
+   if (mapped())
+      _bufCur = mapAddr() + filePos();
+   else
+   {
+      _inStream->Read(_readAhead, len);
+      if (len != _inStream->LastRead())
+         exception("I/O error during read-in");
+      _bufCur = _readAhead;
+   }
+   setFilePos(filePos() + len);
+   _bufStart = _bufCur;
+   _bufEnd   = _bufCur + len;
+   return *_bufCur++;
+}
+
+//! Accounts the data decoded from the current file window in the progress indicator
+void Oasis::OasisInFile::retireBuffer()
+{
+   if (NULL == _bufStart) return;
+   const byte* consumed = (NULL != _curCBlock) ? _fileCur : _bufCur;
+   updateProgress(consumed - _bufStart);
+   _bufStart = consumed;
+}
+
+void Oasis::OasisInFile::releaseCBlock()
+{
+   delete _curCBlock;
+   _curCBlock = NULL;
+   _bufCur  = _fileCur;
+   _bufEnd  = _fileEnd;
+   _fileCur = _fileEnd = NULL;
+}
+
+//! Drops the decoding window. Must be called before any direct access to the input file
+void Oasis::OasisInFile::resetBuffer()
+{
+   retireBuffer();
+   if (NULL != _curCBlock)
+   {
+      delete _curCBlock;
+      _curCBlock = NULL;
+   }
+   _bufCur = _bufEnd = _bufStart = _fileCur = _fileEnd = NULL;
 }
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -382,7 +482,7 @@ void Oasis::OasisInFile::readStartRecord()
    else
    {
       // table offset structure is stored in the END record
-      wxFileOffset savedPos = filePos();
+      wxFileOffset savedPos = oasFilePos();
       oasSetPosition(fileLength() - 255);
       _cellNames   = DEBUG_NEW Table(*this);
       _textStrings = DEBUG_NEW Table(*this);
@@ -480,6 +580,7 @@ void Oasis::OasisInFile::readLibrary()
          case oas_XNAME_2     : assert(false);/*@TODO oas_XNAME_1*/ rlb = false; break;
          case oas_END         :
             readEndRecord();
+            resetBuffer();
             closeStream();
             TpdPost::toped_status(console::TSTS_PRGRSBAROFF);
             linkReferences();
@@ -491,13 +592,6 @@ void Oasis::OasisInFile::readLibrary()
 
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
-byte Oasis::OasisInFile::getByte()
-{
-   byte        bytein            ; // last byte read from the file stream
-   rawRead(&bytein,1);
-   return bytein;
-}
-
 float Oasis::OasisInFile::getFloat()
 {
    float        floatin          ; // last 4 bytes read from the file stream
@@ -529,77 +623,48 @@ std::string Oasis::OasisInFile::getString(/*Oasis string type check*/)
 qword Oasis::OasisInFile::getUnsignedInt(byte length)
 {
    assert((length > 0) && (length < 9));
-   byte        cmask       = 0x7f; // masks the MSB of the byte
-   byte        bytecounter = 0   ; // how many bytes were read
-   byte        bytein            ; // last byte read from the file stream
-   qword       result      = 0   ; // the result
-   // the result in array of bytes representation
-   byte       *btres       = (byte*)&result;
+   byte        bytein      = getByte();
+   // the vast majority of the numbers fit in a single byte
+   if (!(bytein & 0x80)) return bytein;
+   qword       result      = bytein & 0x7f;
+   byte        bytecounter = 1;
    do
    {
       bytein = getByte();
-      if (bytein & cmask)
+      if (bytein & 0x7f)
       {
-         switch (bytecounter)
-         {
-            case 0: btres[0]  = bytein & cmask;
-                    break;
-            case 1:
-            case 2:
-            case 3:
-            case 4:
-            case 5:
-            case 6:
-            case 7: btres[bytecounter-1] |= bytein << (8-bytecounter);
-                    btres[bytecounter  ]  = (bytein & cmask) >> bytecounter;
-                    break;
-            default: exception("Integer is too big (7.2.3)");break;
-         }
+         if (bytecounter > 7)
+            exception("Integer is too big (7.2.3)");
          if (bytecounter > length)
             exception("Unsigned integer with unexpected length(7.2.3)");
+         result |= (qword)(bytein & 0x7f) << (7 * bytecounter);
       }
       bytecounter++;
-   } while (bytein & (~cmask));
+   } while (bytein & 0x80);
    return result;
 }
 
 int8b Oasis::OasisInFile::getInt(byte length)
 {
    assert((length > 0) && (length < 9));
-   const byte  cmask       = 0x7f; // masks the MSB of the byte
-   const byte  smask       = 0x01; // highlights the sign
-   byte        bytecounter = 0   ; // how many bytes were read
-   byte        bytein            ; // last byte read from the file stream
-   byte        sign        = 0   ;
-   int8b       result      = 0   ; // the result
-   // the result in array of bytes representation
-   byte       *btres       = (byte*)&result;
-   do
+   byte        bytein      = getByte();
+   // the first byte holds the sign and 6 bits of the number
+   bool        sign        = (0 != (bytein & 0x01));
+   int8b       result      = (bytein & 0x7f) >> 1;
+   byte        bytecounter = 1;
+   while (bytein & 0x80)
    {
       bytein = getByte();
-      if ((0 == bytecounter) || (bytein & cmask))
+      if (bytein & 0x7f)
       {
-         switch (bytecounter)
-         {
-            case 0: btres[0]  = (bytein & cmask) >> 1;
-                    sign      =  bytein & smask;
-                    break;
-            case 1:
-            case 2:
-            case 3:
-            case 4:
-            case 5:
-            case 6: btres[bytecounter-1] |= bytein << (7-bytecounter);
-                    btres[bytecounter  ]  = (bytein & cmask) >> (bytecounter + 1);
-                    break;
-            case 7: btres[bytecounter-1] |= bytein; break;
-            default: exception("Integer is too big (7.2.3)"); break;
-         }
+         if (bytecounter > 7)
+            exception("Integer is too big (7.2.3)");
          if (bytecounter > length)
             exception("Unsigned integer with unexpected length(7.2.3)");
+         result |= (int8b)(bytein & 0x7f) << (7 * bytecounter - 1);
       }
       bytecounter++;
-   } while (bytein & (~cmask));
+   }
    if (sign) return -result;
    else      return  result;
 }
@@ -658,7 +723,7 @@ std::string Oasis::OasisInFile::getCellRefName(bool ref)
 void Oasis::OasisInFile::exception(std::string message)
 {
    std::ostringstream info;
-   info << message << " @ position " << filePos();
+   info << message << " @ position " << oasFilePos();
    throw EXPTNreadOASIS(info.str());
 }
 
@@ -703,34 +768,41 @@ void Oasis::OasisInFile::hierOut()
 
 size_t Oasis::OasisInFile::rawRead(void *pBuf, size_t nCount)
 {
-   if (NULL == _curCBlock)
+   byte* dst = (byte*)pBuf;
+   size_t left = nCount;
+   while (0 < left)
    {
-      if (!readStream(pBuf,nCount, true))
-         exception("I/O error during read-in");
-      return nCount;
-   }
-   else
-   {
-      _curCBlock->readUncompressedBuffer(pBuf, nCount);
-      if ( _curCBlock->endOfBuffer() )
+      if (_bufCur == _bufEnd)
       {
-         delete _curCBlock;
-         _curCBlock = NULL;
+         *dst++ = nextBuffer(); left--;
+         continue;
       }
-      return nCount;
+      size_t chunk = std::min(left, (size_t)(_bufEnd - _bufCur));
+      memcpy(dst, _bufCur, chunk);
+      _bufCur += chunk; dst += chunk; left -= chunk;
    }
+   return nCount;
 }
 
 bool Oasis::OasisInFile::calculateCRC(Oasis::Iso3309Crc32& crc32)
 {
    if (reopenFile())
    {
-      byte buf;
-      while (filePos() < fileLength() - 4)
+      resetBuffer();
+      wxFileOffset left = fileLength() - 4;
+      while (0 < left)
       {
-         rawRead(&buf, 1);
-         crc32.add(&buf, 1);
+         // calculate directly in the decoding window
+         if (_bufCur == _bufEnd)
+         {
+            byte buf = nextBuffer(); left--;
+            crc32.add(&buf, 1);
+         }
+         size_t chunk = std::min(left, (wxFileOffset)(_bufEnd - _bufCur));
+         crc32.add(_bufCur, chunk);
+         _bufCur += chunk; left -= chunk;
       }
+      resetBuffer();
       closeStream();
       return true;
    }
@@ -741,14 +813,23 @@ bool Oasis::OasisInFile::calculateChecksum(dword& checksum)
 {
    if (reopenFile())
    {
+      resetBuffer();
       qword wsum = 0ull; // get a 64 bit number to handle overflows
-      byte buf;
-      while (filePos() < fileLength() - 4)
+      wxFileOffset left = fileLength() - 4;
+      while (0 < left)
       {
-         rawRead(&buf, 1);
-         wsum +=buf;
+         // sum directly in the decoding window
+         if (_bufCur == _bufEnd)
+         {
+            wsum += nextBuffer(); left--;
+         }
+         size_t chunk = std::min(left, (wxFileOffset)(_bufEnd - _bufCur));
+         for (const byte* cb = _bufCur; cb != _bufCur + chunk; cb++)
+            wsum += *cb;
          wsum &= 0xffffffff;
+         _bufCur += chunk; left -= chunk;
       }
+      resetBuffer();
       closeStream();
       checksum = (dword) wsum;
       return true;
@@ -805,6 +886,8 @@ void Oasis::OasisInFile::convertPrep(const NameList& topCells, bool recursive)
 
 Oasis::OasisInFile::~OasisInFile()
 {
+   if ( _curCBlock  ) delete _curCBlock;
+   if ( _readAhead  ) delete [] _readAhead;
    if ( _cellNames  ) delete _cellNames;
    if ( _textStrings) delete _textStrings;
    if ( _propNames  ) delete _propNames;
@@ -832,7 +915,7 @@ Oasis::Cell::Cell() : ForeignCell()
 byte Oasis::Cell::skimCell(OasisInFile& ofn, bool refnum)
 {
    _strctName = ofn.getCellRefName(refnum);
-   _filePos = ofn.filePos();
+   _filePos = ofn.oasFilePos();
    std::ostringstream info;
    info << "OASIS : Reading cell \"" << strctName() << "\"";
    tell_log(console::MT_INFO, info.str());
@@ -864,7 +947,7 @@ byte Oasis::Cell::skimCell(OasisInFile& ofn, bool refnum)
          case oas_CIRCLE      : /*@TODO oas_CIRCLE*/assert(false);break;
          default:
             // last byte from the stream doesn't belong to this cell definition
-            _cellSize = ofn.filePos() - _filePos - 1;
+            _cellSize = ofn.oasFilePos() - _filePos - 1;
             return recType;
       }
    } while (true);
@@ -875,7 +958,7 @@ byte Oasis::Cell::skimCell(OasisInFile& ofn, bool refnum)
 void Oasis::Cell::import(ImportDB& iDB)
 {
    OasisInFile* ofn = static_cast<OasisInFile*>(iDB.srcFile());
-   ofn->setPosition(_filePos);
+   ofn->oasSetPosition(_filePos);
    initModals();
    std::ostringstream info;
    ofn->setPropContext(pc_cell);
@@ -906,7 +989,7 @@ void Oasis::Cell::import(ImportDB& iDB)
          case oas_CIRCLE      : /*@TODO oas_CIRCLE*/assert(false);break;
          default:
             // check that the cell size is the same as obtained by skim function
-            assert(_cellSize == (ofn->filePos() - _filePos - 1));
+            assert(_cellSize == (ofn->oasFilePos() - _filePos - 1));
             return;
       }
    } while (true);
@@ -1960,19 +2043,27 @@ Oasis::PointList& Oasis::PointList::operator = (const PointList& plst)
 
 void Oasis::PointList::readManhattanH(OasisInFile& ofb)
 {
-   for (dword ccrd = 0; ccrd < _vcount; ccrd++)
+   // the deltas alternate - horizontal (even) and vertical (odd)
+   int4b* cdel = _delarr;
+   int4b* edel = _delarr + 2*_vcount;
+   while (cdel != edel)
    {
-      if (ccrd % 2) {_delarr[2*ccrd] = 0            ; _delarr[2*ccrd+1] = ofb.getInt(8);}
-      else          {_delarr[2*ccrd] = ofb.getInt(8); _delarr[2*ccrd+1] = 0;            }
+      *cdel++ = ofb.getInt(8); *cdel++ = 0;
+      if (cdel == edel) break;
+      *cdel++ = 0; *cdel++ = ofb.getInt(8);
    }
 }
 
 void Oasis::PointList::readManhattanV(OasisInFile& ofb)
 {
-   for (dword ccrd = 0; ccrd < _vcount; ccrd++)
+   // the deltas alternate - vertical (even) and horizontal (odd)
+   int4b* cdel = _delarr;
+   int4b* edel = _delarr + 2*_vcount;
+   while (cdel != edel)
    {
-      if (ccrd % 2) {_delarr[2*ccrd] = ofb.getInt(8); _delarr[2*ccrd+1] = 0;            }
-      else          {_delarr[2*ccrd] = 0            ; _delarr[2*ccrd+1] = ofb.getInt(8);}
+      *cdel++ = 0; *cdel++ = ofb.getInt(8);
+      if (cdel == edel) break;
+      *cdel++ = ofb.getInt(8); *cdel++ = 0;
    }
 }
 
@@ -2476,3 +2567,806 @@ void Oasis::readDelta(OasisInFile& ofb, int4b& deltaX, int4b& deltaY)
    }
 }
 
+
+//==============================================================================
+// class OasisExportFile
+//==============================================================================
+//! Sorts the positions of the grouped shapes - rows from bottom to top
+static bool positionLess(const TP& p1, const TP& p2)
+{
+   if (p1.y() != p2.y()) return (p1.y() < p2.y());
+   return (p1.x() < p2.x());
+}
+
+bool Oasis::OasisExportFile::RefKey::operator < (const RefKey& op2) const
+{
+   if (_refnum != op2._refnum) return (_refnum < op2._refnum);
+   if (_mag    != op2._mag   ) return (_mag    < op2._mag   );
+   if (_angle  != op2._angle ) return (_angle  < op2._angle );
+   return (_flip < op2._flip);
+}
+
+Oasis::OasisExportFile::OasisExportFile(std::string fn, laydata::TdtCell* tcell,
+                                        const LayerMapExt& lmap, bool recur, bool compress) :
+   DbExportFile   ( fn, tcell, recur ),
+   _laymap        ( lmap             ),
+   _compress      ( compress         ),
+   _filePos       ( 0                ),
+   _cLayer        ( 0                ),
+   _cDType        ( 0                ),
+   _numCells      ( 0                ),
+   _numElements   ( 0                ),
+   _numRecords    ( 0                ),
+   _rawSize       ( 0                ),
+   _finished      ( false            )
+{
+   wxString wxfname(fn.c_str(), wxConvUTF8 );
+   _oasFh.Open(wxfname.c_str(),wxT("wb"));
+   if (!(_oasFh.IsOpened()))
+   {
+      std::ostringstream info;
+      info << "File "<< fn <<" can NOT be opened";
+      tell_log(console::MT_ERROR,info.str());
+   }
+}
+
+void Oasis::OasisExportFile::libraryStart(std::string /*libname*/, TpdTime& /*libtime*/, real DBU, real UU)
+{
+   _DBU = DBU;
+   _UU  = UU;
+   _stopWatch.Start();
+   for (byte i = 0; i < 13; i++)
+      putByte(oas_MagicBytes[i]);
+   putByte(oas_START);
+   putString("1.0");
+   // the OASIS unit is the number of database units per micron (13.10)
+   putReal(1e-6 / DBU);
+   // the table offsets are stored in the END record
+   putUnsignedInt(1);
+   flushBuffer();
+}
+
+void Oasis::OasisExportFile::libraryFinish()
+{
+   // CELLNAME table (15) - implicit reference numbers
+   wxFileOffset cellNamesOffset = 0;
+   if (!_cellNames.empty())
+   {
+      cellNamesOffset = _filePos;
+      for (NameList::const_iterator CN = _cellNames.begin(); CN != _cellNames.end(); CN++)
+      {
+         putByte(oas_CELLNAME_1);
+         putString(*CN);
+      }
+      flushBuffer();
+   }
+   // END record (14) - it must be exactly 256 bytes long
+   putByte(oas_END);
+   // table-offsets in the order CELLNAME, TEXTSTRING, PROPNAME, PROPSTRING, LAYERNAME, XNAME
+   putUnsignedInt(1); putUnsignedInt(cellNamesOffset);
+   for (byte i = 1; i < 6; i++)
+   {
+      putUnsignedInt(0); putUnsignedInt(0);
+   }
+   // padding string - 2 bytes for its length, 1 for the validation scheme and 4 for the signature
+   dword padLength = 256 - _buffer.size() - 2 - 1 - 4;
+   assert((0x80 <= padLength) && (padLength < 0x4000));
+   putString(std::string(padLength, ' '));
+   putUnsignedInt(vs_crc32);
+   flushBuffer();
+   // the signature is a little-endian 4-byte integer
+   dword signature = _crc32.theCrc();
+   for (byte i = 0; i < 4; i++)
+      putByte((byte)(signature >> (8*i)));
+   flushBuffer(false);
+   _stopWatch.Pause();
+   // size & throughput report
+   std::ostringstream info;
+   real seconds = _stopWatch.Time() / 1000.0;
+   info << "OASIS export: " << _numCells << " cells, " << _numElements << " elements in "
+        << _numRecords << " records. File size " << _filePos << " bytes";
+   if (_compress)
+      info << " (" << _rawSize << " bytes of cell data before compression)";
+   info << ", " << seconds << " sec.";
+   if (0.0 < seconds)
+      info << " (" << (qword)(_numElements / seconds) << " elements/sec.)";
+   tell_log(console::MT_INFO, info.str());
+   _finished = true;
+}
+
+void Oasis::OasisExportFile::definitionStart(std::string cname)
+{
+   _ccname = cname;
+   std::string message = "...converting " + _ccname;
+   tell_log(console::MT_INFO, message);
+   putByte(oas_CELL_1);
+   putUnsignedInt(cellRefnum(_ccname));
+   flushBuffer();
+   // modal variables are reset at the start of each cell (10.3)
+   _mod_layer.reset();
+   _mod_datatype.reset();
+   _mod_tlayer.reset();
+   _mod_tdatatype.reset();
+   _mod_gwidth.reset();
+   _mod_gheight.reset();
+   _mod_pathhw.reset();
+   _mod_exs.reset();
+   _mod_gx.reset();
+   _mod_gy.reset();
+   _mod_px.reset();
+   _mod_py.reset();
+   _mod_tx.reset();
+   _mod_ty.reset();
+   _mod_cellref.reset();
+   _mod_text.reset();
+}
+
+void Oasis::OasisExportFile::definitionFinish()
+{
+   writeShapes();
+   _rawSize += _buffer.size();
+   if (_compress && !_buffer.empty())
+   {
+      dword size_uncompressed = _buffer.size();
+      CBlockDeflate cblock(&_buffer[0], size_uncompressed);
+      // CBLOCK header is up to 12 bytes. Use it only if it pays off
+      if (cblock.status() && (cblock.bufSize() + 12 < size_uncompressed))
+      {
+         _buffer.clear();
+         putByte(oas_CBLOCK);
+         putUnsignedInt(0); // compression type - DEFLATE (35.3)
+         putUnsignedInt(size_uncompressed);
+         putUnsignedInt(cblock.bufSize());
+         _buffer.insert(_buffer.end(), cblock.buffer(), cblock.buffer() + cblock.bufSize());
+      }
+   }
+   flushBuffer();
+   _rectangles.clear();
+   _polygons.clear();
+   _paths.clear();
+   _texts.clear();
+   _refs.clear();
+   _numCells++;
+   registerCellWritten(_ccname);
+}
+
+bool Oasis::OasisExportFile::layerSpecification(const LayerDef& laydef)
+{
+   return _laymap.getExtLayType(_cLayer, _cDType, laydef);
+}
+
+void Oasis::OasisExportFile::box(const int4b* const pdata)
+{
+   ShapeKey key(4);
+   key[0] = _cLayer;
+   key[1] = _cDType;
+   key[2] = abs(pdata[2] - pdata[0]);
+   key[3] = abs(pdata[3] - pdata[1]);
+   _rectangles[key].push_back(TP(std::min(pdata[0], pdata[2]), std::min(pdata[1], pdata[3])));
+   _numElements++;
+}
+
+void Oasis::OasisExportFile::polygon(const int4b* const pdata, unsigned psize)
+{
+   ShapeKey key(2*psize);
+   key[0] = _cLayer;
+   key[1] = _cDType;
+   for (unsigned i = 1; i < psize; i++)
+   {
+      key[2*i  ] = pdata[2*i  ] - pdata[0];
+      key[2*i+1] = pdata[2*i+1] - pdata[1];
+   }
+   _polygons[key].push_back(TP(pdata[0], pdata[1]));
+   _numElements++;
+}
+
+void Oasis::OasisExportFile::wire(const int4b* const pdata, unsigned psize, WireWidth width)
+{
+   // OASIS paths are defined by their half-width (27.4) and the edges of a
+   // wire with odd width are off the grid, so it can be written neither as a
+   // path nor as a polygon without changing its geometry.
+   if (width % 2)
+   {
+      std::ostringstream info;
+      info << " wire with odd width (" << width << ") in cell \"" << _ccname
+           << "\". Export aborted";
+      throw EXPTNwriteOASIS(info.str());
+   }
+   ShapeKey key(2*psize + 1);
+   key[0] = _cLayer;
+   key[1] = _cDType;
+   key[2] = width / 2;
+   for (unsigned i = 1; i < psize; i++)
+   {
+      key[2*i+1] = pdata[2*i  ] - pdata[0];
+      key[2*i+2] = pdata[2*i+1] - pdata[1];
+   }
+   _paths[key].push_back(TP(pdata[0], pdata[1]));
+   _numElements++;
+}
+
+void Oasis::OasisExportFile::text(const std::string& text, const CTM& trans)
+{
+   // OASIS texts have no size and orientation (31) - only the position is exported
+   TP bind;
+   real rotation, scale;
+   bool flipX;
+   trans.Decompose(bind,rotation,scale,flipX);
+   ShapeKey key(2);
+   key[0] = _cLayer;
+   key[1] = _cDType;
+   _texts[TextKey(key, text)].push_back(bind);
+   _numElements++;
+}
+
+void Oasis::OasisExportFile::ref(const std::string& name, const CTM& translation)
+{
+   TP origin;
+   RefKey key = placement(name, translation, origin);
+   _refs[key].push_back(origin);
+   _numElements++;
+}
+
+void Oasis::OasisExportFile::aref(const std::string& name, const CTM& translation,
+                                  const laydata::ArrayProps& arrprops)
+{
+   TP origin;
+   RefKey key = placement(name, translation, origin);
+   if (1 == (arrprops.cols() * arrprops.rows()))
+   {
+      _refs[key].push_back(origin);
+      _numElements++;
+      return;
+   }
+   // the array steps in the coordinate system of the current cell
+   CTM orient(translation.a(), translation.b(), translation.c(), translation.d(), 0, 0);
+   TP colStep(arrprops.colStep() * orient);
+   TP rowStep(arrprops.rowStep() * orient);
+   writePlacement(key, origin, true);
+   putArrayRepetition(arrprops.cols(), arrprops.rows(), colStep, rowStep);
+   _numElements += arrprops.cols() * arrprops.rows();
+}
+
+bool Oasis::OasisExportFile::checkCellWritten(std::string cellname) const
+{
+   return (_childnames.end() != _childnames.find(cellname));
+}
+
+void Oasis::OasisExportFile::registerCellWritten(std::string cellname)
+{
+   _childnames.insert(cellname);
+}
+
+//------------------------------------------------------------------------------
+void Oasis::OasisExportFile::writeShapes()
+{
+   for (ShapeMap::iterator CS = _rectangles.begin(); CS != _rectangles.end(); CS++)
+   {
+      std::sort(CS->second.begin(), CS->second.end(), positionLess);
+      writeRectangle(CS->first, CS->second);
+   }
+   for (ShapeMap::iterator CS = _polygons.begin(); CS != _polygons.end(); CS++)
+   {
+      std::sort(CS->second.begin(), CS->second.end(), positionLess);
+      writePolygon(CS->first, CS->second);
+   }
+   for (ShapeMap::iterator CS = _paths.begin(); CS != _paths.end(); CS++)
+   {
+      std::sort(CS->second.begin(), CS->second.end(), positionLess);
+      writePath(CS->first, CS->second);
+   }
+   for (TextMap::iterator CS = _texts.begin(); CS != _texts.end(); CS++)
+   {
+      std::sort(CS->second.begin(), CS->second.end(), positionLess);
+      writeText(CS->first, CS->second);
+   }
+   for (RefMap::iterator CS = _refs.begin(); CS != _refs.end(); CS++)
+   {
+      std::sort(CS->second.begin(), CS->second.end(), positionLess);
+      writePlacement(CS->first, CS->second[0], (1 < CS->second.size()));
+      if (1 < CS->second.size())
+         putRepetition(CS->second);
+   }
+}
+
+void Oasis::OasisExportFile::writeRectangle(const ShapeKey& key, PointVector& pos)
+{
+   const byte Smask   = 0x80;
+   const byte Wmask   = 0x40;
+   const byte Hmask   = 0x20;
+   const byte Xmask   = 0x10;
+   const byte Ymask   = 0x08;
+   const byte Rmask   = 0x04;
+   const byte Dmask   = 0x02;
+   const byte Lmask   = 0x01;
+
+   byte info = 0;
+   if (_mod_layer.update(key[0]))    info |= Lmask;
+   if (_mod_datatype.update(key[1])) info |= Dmask;
+   if (_mod_gwidth.update(key[2]))   info |= Wmask;
+   if (key[2] == key[3])
+   {
+      info |= Smask;
+      _mod_gheight.update(key[3]);
+   }
+   else if (_mod_gheight.update(key[3])) info |= Hmask;
+   if (_mod_gx.update(pos[0].x()))   info |= Xmask;
+   if (_mod_gy.update(pos[0].y()))   info |= Ymask;
+   if (1 < pos.size())               info |= Rmask;
+
+   putByte(oas_RECTANGLE);
+   putByte(info);
+   if (info & Lmask) putUnsignedInt(key[0]);
+   if (info & Dmask) putUnsignedInt(key[1]);
+   if (info & Wmask) putUnsignedInt(key[2]);
+   if (info & Hmask) putUnsignedInt(key[3]);
+   if (info & Xmask) putInt(pos[0].x());
+   if (info & Ymask) putInt(pos[0].y());
+   if (info & Rmask) putRepetition(pos);
+   _numRecords++;
+}
+
+void Oasis::OasisExportFile::writePolygon(const ShapeKey& key, PointVector& pos)
+{
+   const byte Pmask   = 0x20;
+   const byte Xmask   = 0x10;
+   const byte Ymask   = 0x08;
+   const byte Rmask   = 0x04;
+   const byte Dmask   = 0x02;
+   const byte Lmask   = 0x01;
+
+   byte info = Pmask;
+   if (_mod_layer.update(key[0]))    info |= Lmask;
+   if (_mod_datatype.update(key[1])) info |= Dmask;
+   if (_mod_gx.update(pos[0].x()))   info |= Xmask;
+   if (_mod_gy.update(pos[0].y()))   info |= Ymask;
+   if (1 < pos.size())               info |= Rmask;
+
+   putByte(oas_POLYGON);
+   putByte(info);
+   if (info & Lmask) putUnsignedInt(key[0]);
+   if (info & Dmask) putUnsignedInt(key[1]);
+   putPointList(key, 2, true);
+   if (info & Xmask) putInt(pos[0].x());
+   if (info & Ymask) putInt(pos[0].y());
+   if (info & Rmask) putRepetition(pos);
+   _numRecords++;
+}
+
+void Oasis::OasisExportFile::writePath(const ShapeKey& key, PointVector& pos)
+{
+   const byte Emask   = 0x80;
+   const byte Wmask   = 0x40;
+   const byte Pmask   = 0x20;
+   const byte Xmask   = 0x10;
+   const byte Ymask   = 0x08;
+   const byte Rmask   = 0x04;
+   const byte Dmask   = 0x02;
+   const byte Lmask   = 0x01;
+   // flush start and end extensions (27.8)
+   const byte extScheme = (ex_flush << 2) | ex_flush;
+
+   byte info = Pmask;
+   if (_mod_layer.update(key[0]))    info |= Lmask;
+   if (_mod_datatype.update(key[1])) info |= Dmask;
+   if (_mod_pathhw.update(key[2]))   info |= Wmask;
+   if (_mod_exs.update(extScheme))   info |= Emask;
+   if (_mod_gx.update(pos[0].x()))   info |= Xmask;
+   if (_mod_gy.update(pos[0].y()))   info |= Ymask;
+   if (1 < pos.size())               info |= Rmask;
+
+   putByte(oas_PATH);
+   putByte(info);
+   if (info & Lmask) putUnsignedInt(key[0]);
+   if (info & Dmask) putUnsignedInt(key[1]);
+   if (info & Wmask) putUnsignedInt(key[2]);
+   if (info & Emask) putByte(extScheme);
+   putPointList(key, 3, false);
+   if (info & Xmask) putInt(pos[0].x());
+   if (info & Ymask) putInt(pos[0].y());
+   if (info & Rmask) putRepetition(pos);
+   _numRecords++;
+}
+
+void Oasis::OasisExportFile::writeText(const TextKey& key, PointVector& pos)
+{
+   const byte Cmask   = 0x40;
+   const byte Xmask   = 0x10;
+   const byte Ymask   = 0x08;
+   const byte Rmask   = 0x04;
+   const byte Tmask   = 0x02;
+   const byte Lmask   = 0x01;
+
+   byte info = 0;
+   if (_mod_text.update(key.second))        info |= Cmask;
+   if (_mod_tlayer.update(key.first[0]))    info |= Lmask;
+   if (_mod_tdatatype.update(key.first[1])) info |= Tmask;
+   if (_mod_tx.update(pos[0].x()))          info |= Xmask;
+   if (_mod_ty.update(pos[0].y()))          info |= Ymask;
+   if (1 < pos.size())                      info |= Rmask;
+
+   putByte(oas_TEXT);
+   putByte(info);
+   if (info & Cmask) putString(key.second);
+   if (info & Lmask) putUnsignedInt(key.first[0]);
+   if (info & Tmask) putUnsignedInt(key.first[1]);
+   if (info & Xmask) putInt(pos[0].x());
+   if (info & Ymask) putInt(pos[0].y());
+   if (info & Rmask) putRepetition(pos);
+   _numRecords++;
+}
+
+/*! Writes a PLACEMENT record without the repetition which (if required) should
+ * follow immediately. The short form (PLACEMENT_1) is used for the references
+ * without magnification and rotated at a multiple of 90 degrees*/
+void Oasis::OasisExportFile::writePlacement(const RefKey& key, const TP& origin, bool repetition)
+{
+   const byte Cmask   = 0x80;
+   const byte Nmask   = 0x40;
+   const byte Xmask   = 0x20;
+   const byte Ymask   = 0x10;
+   const byte Rmask   = 0x08;
+   const byte Mmask   = 0x04;
+   const byte Amask   = 0x02;
+   const byte Fmask   = 0x01;
+
+   byte info = 0;
+   if (_mod_cellref.update(key._refnum)) info |= (Cmask | Nmask);
+   if (_mod_px.update(origin.x()))       info |= Xmask;
+   if (_mod_py.update(origin.y()))       info |= Ymask;
+   if (repetition)                       info |= Rmask;
+   if (key._flip)                        info |= Fmask;
+   int quadrant = (int) floor(key._angle / 90.0 + 0.5);
+   if ((1.0 == key._mag) && (fabs(key._angle - 90.0 * quadrant) < 1e-9))
+   {
+      info |= (byte)((quadrant % 4) << 1);
+      putByte(oas_PLACEMENT_1);
+      putByte(info);
+      if (info & Cmask) putUnsignedInt(key._refnum);
+   }
+   else
+   {
+      if (1.0 != key._mag  ) info |= Mmask;
+      if (0.0 != key._angle) info |= Amask;
+      putByte(oas_PLACEMENT_2);
+      putByte(info);
+      if (info & Cmask) putUnsignedInt(key._refnum);
+      if (info & Mmask) putReal(key._mag);
+      if (info & Amask) putReal(key._angle);
+   }
+   if (info & Xmask) putInt(origin.x());
+   if (info & Ymask) putInt(origin.y());
+   _numRecords++;
+}
+
+Oasis::OasisExportFile::RefKey Oasis::OasisExportFile::placement(const std::string& name,
+                                                   const CTM& translation, TP& origin)
+{
+   real rotation, scale;
+   bool flipX;
+   translation.Decompose(origin, rotation, scale, flipX);
+   if (0.0 > rotation) rotation += 360.0;
+   if (fabs(scale - 1.0) < 1e-9) scale = 1.0;
+   return RefKey(cellRefnum(name), scale, rotation, flipX);
+}
+
+//------------------------------------------------------------------------------
+void Oasis::OasisExportFile::putUnsignedInt(qword value)
+{
+   while (0x7f < value)
+   {
+      putByte((byte)(value & 0x7f) | 0x80);
+      value >>= 7;
+   }
+   putByte((byte)value);
+}
+
+void Oasis::OasisExportFile::putInt(int8b value)
+{
+   // the first byte holds the sign and 6 bits of the number
+   qword magnitude = (0 > value) ? -value : value;
+   byte  bytein    = (byte)((magnitude & 0x3f) << 1) | ((0 > value) ? 0x01 : 0x00);
+   magnitude >>= 6;
+   if (0 == magnitude)
+      putByte(bytein);
+   else
+   {
+      putByte(bytein | 0x80);
+      putUnsignedInt(magnitude);
+   }
+}
+
+void Oasis::OasisExportFile::putReal(real value)
+{
+   real magnitude = fabs(value);
+   real rounded   = floor(magnitude + 0.5);
+   if ((rounded <= (real)0xffffffff) && (fabs(magnitude - rounded) < 1e-9 * std::max(1.0, rounded)))
+   {
+      // positive or negative whole number (7.3.3)
+      putUnsignedInt((0 > value) ? 1 : 0);
+      putUnsignedInt((qword)rounded);
+   }
+   else
+   {
+      // IEEE 754 double - little-endian regardless of the host byte order
+      putUnsignedInt(7);
+      double doubleout = value;
+      qword bits;
+      memcpy(&bits, &doubleout, sizeof(bits));
+      for (byte i = 0; i < 8; i++)
+         putByte((byte)(bits >> (8*i)));
+   }
+}
+
+void Oasis::OasisExportFile::putString(const std::string& value)
+{
+   putUnsignedInt(value.size());
+   _buffer.insert(_buffer.end(), value.begin(), value.end());
+}
+
+/*! Writes a g-delta (7.5.5). The first form is used for the horizontal,
+ * vertical and diagonal deltas*/
+void Oasis::OasisExportFile::putDelta(int4b deltaX, int4b deltaY)
+{
+   qword absX = (0 > deltaX) ? -(int8b)deltaX : deltaX;
+   qword absY = (0 > deltaY) ? -(int8b)deltaY : deltaY;
+   if ((0 == deltaX) || (0 == deltaY) || (absX == absY))
+   {
+      DeltaDirections direction;
+      qword           magnitude = std::max(absX, absY);
+      if      (0 == deltaY) direction = (0 > deltaX) ? dr_west      : dr_east     ;
+      else if (0 == deltaX) direction = (0 > deltaY) ? dr_south     : dr_north    ;
+      else if (0 < deltaX ) direction = (0 > deltaY) ? dr_southeast : dr_northeast;
+      else                  direction = (0 > deltaY) ? dr_southwest : dr_northwest;
+      putUnsignedInt((magnitude << 4) | ((qword)direction << 1));
+   }
+   else
+   {
+      putUnsignedInt((absX << 2) | ((0 > deltaX) ? 0x02 : 0x00) | 0x01);
+      putInt(deltaY);
+   }
+}
+
+/*! Writes the point list (7.7) of a polygon or a path. The points start at
+ * position @first of the @key relative to the first point of the shape which
+ * is not in the list. The most compact point list type is selected*/
+void Oasis::OasisExportFile::putPointList(const ShapeKey& key, unsigned first, bool polygon)
+{
+   // the deltas between the consecutive points. The closing delta of the
+   // polygons is included here because it's checked for the list type
+   PointVector deltas;
+   TP cpnt(0,0);
+   for (unsigned i = first; i < key.size(); i += 2)
+   {
+      TP npnt(key[i], key[i+1]);
+      deltas.push_back(npnt - cpnt);
+      cpnt = npnt;
+   }
+   if (polygon)
+      deltas.push_back(TP(0,0) - cpnt);
+   bool manhH = !polygon || (0 == (deltas.size() % 2));
+   bool manhV = manhH;
+   bool manhE = true;
+   bool octa  = true;
+   for (unsigned i = 0; i < deltas.size(); i++)
+   {
+      bool hor = (0 == deltas[i].y());
+      bool ver = (0 == deltas[i].x());
+      if (!(hor || ver)) manhE = false;
+      if (!(hor || ver || (abs(deltas[i].x()) == abs(deltas[i].y())))) octa = false;
+      if (!((i % 2) ? ver : hor)) manhH = false;
+      if (!((i % 2) ? hor : ver)) manhV = false;
+   }
+   PointListType pltype;
+   if      (manhH) pltype = dt_manhattanH;
+   else if (manhV) pltype = dt_manhattanV;
+   else if (manhE) pltype = dt_mamhattanE;
+   else if (octa ) pltype = dt_octangular;
+   else            pltype = dt_allangle;
+   // the last delta of the polygons is implicit. Manhattan H/V lists
+   // imply the last point as well
+   dword vcount = deltas.size();
+   if (polygon)
+      vcount -= ((dt_manhattanH == pltype) || (dt_manhattanV == pltype)) ? 2 : 1;
+   putByte(pltype);
+   putUnsignedInt(vcount);
+   for (dword i = 0; i < vcount; i++)
+   {
+      int4b dx = deltas[i].x();
+      int4b dy = deltas[i].y();
+      qword magnitude = std::max(abs(dx), abs(dy));
+      switch (pltype)
+      {
+         case dt_manhattanH: putInt((i % 2) ? dy : dx); break;
+         case dt_manhattanV: putInt((i % 2) ? dx : dy); break;
+         case dt_mamhattanE:
+         {
+            DeltaDirections direction;
+            if      (0 < dy) direction = dr_north;
+            else if (0 > dy) direction = dr_south;
+            else if (0 > dx) direction = dr_west;
+            else             direction = dr_east;
+            putUnsignedInt((magnitude << 2) | direction);
+            break;
+         }
+         case dt_octangular:
+         {
+            DeltaDirections direction;
+            if      (0 == dy) direction = (0 > dx) ? dr_west      : dr_east     ;
+            else if (0 == dx) direction = (0 > dy) ? dr_south     : dr_north    ;
+            else if (0 <  dx) direction = (0 > dy) ? dr_southeast : dr_northeast;
+            else              direction = (0 > dy) ? dr_southwest : dr_northwest;
+            putUnsignedInt((magnitude << 3) | direction);
+            break;
+         }
+         default: putDelta(dx, dy); break;
+      }
+   }
+}
+
+/*! Writes the repetition (7.6) of a group of shapes. The positions must be
+ * sorted (see positionLess()) and the first one is the position of the
+ * record itself. Regular matrices, rows and columns are recognised,
+ * all the rest is written as an arbitrary repetition*/
+void Oasis::OasisExportFile::putRepetition(const PointVector& pos)
+{
+   const dword count = pos.size();
+   assert(1 < count);
+   // the size of the first row
+   dword countx = 1;
+   while ((countx < count) && (pos[countx].y() == pos[0].y())) countx++;
+   dword county = count / countx;
+   int4b stepx  = (1 < countx) ? pos[1].x()      - pos[0].x() : 0;
+   int4b stepy  = (1 < county) ? pos[countx].y() - pos[0].y() : 0;
+   bool matrix  = (0 == (count % countx)) && ((1 == countx) || (0 < stepx));
+   for (dword i = 0; matrix && (i < count); i++)
+      matrix = (pos[i] == TP(pos[0].x() + (int4b)(i % countx) * stepx, pos[0].y() + (int4b)(i / countx) * stepy));
+   if (matrix)
+   {
+      if (1 == county)
+      {
+         putByte(rp_regX);
+         putUnsignedInt(countx - 2);
+         putUnsignedInt(stepx);
+      }
+      else if (1 == countx)
+      {
+         putByte(rp_regY);
+         putUnsignedInt(county - 2);
+         putUnsignedInt(stepy);
+      }
+      else
+      {
+         putByte(rp_regXY);
+         putUnsignedInt(countx - 2);
+         putUnsignedInt(county - 2);
+         putUnsignedInt(stepx);
+         putUnsignedInt(stepy);
+      }
+      return;
+   }
+   bool column   = true;
+   bool diagonal = true;
+   TP   step     = pos[1] - pos[0];
+   for (dword i = 1; i < count; i++)
+   {
+      if (pos[i].x() != pos[0].x()) column   = false;
+      if ((pos[i] - pos[i-1]) != step) diagonal = false;
+   }
+   if (count == countx)
+   {// a single row with variable spacing
+      putByte(rp_varX);
+      putUnsignedInt(count - 2);
+      for (dword i = 1; i < count; i++)
+         putUnsignedInt(pos[i].x() - pos[i-1].x());
+   }
+   else if (column)
+   {
+      putByte(rp_varY);
+      putUnsignedInt(count - 2);
+      for (dword i = 1; i < count; i++)
+         putUnsignedInt(pos[i].y() - pos[i-1].y());
+   }
+   else if (diagonal)
+   {
+      putByte(rp_regDia1D);
+      putUnsignedInt(count - 2);
+      putDelta(step.x(), step.y());
+   }
+   else
+   {
+      putByte(rp_varAny);
+      putUnsignedInt(count - 2);
+      for (dword i = 1; i < count; i++)
+         putDelta(pos[i].x() - pos[i-1].x(), pos[i].y() - pos[i-1].y());
+   }
+}
+
+//! Writes the repetition of a cell reference array with steps already transformed
+void Oasis::OasisExportFile::putArrayRepetition(word cols, word rows, const TP& colStep, const TP& rowStep)
+{
+   assert(1 < (cols * rows));
+   if ((1 < cols) && (1 < rows))
+   {
+      if ((0 == colStep.y()) && (0 == rowStep.x()) && (0 < colStep.x()) && (0 < rowStep.y()))
+      {
+         putByte(rp_regXY);
+         putUnsignedInt(cols - 2);
+         putUnsignedInt(rows - 2);
+         putUnsignedInt(colStep.x());
+         putUnsignedInt(rowStep.y());
+      }
+      else if ((0 == colStep.x()) && (0 == rowStep.y()) && (0 < colStep.y()) && (0 < rowStep.x()))
+      {// rotated array
+         putByte(rp_regXY);
+         putUnsignedInt(rows - 2);
+         putUnsignedInt(cols - 2);
+         putUnsignedInt(rowStep.x());
+         putUnsignedInt(colStep.y());
+      }
+      else
+      {
+         putByte(rp_regDia2D);
+         putUnsignedInt(cols - 2);
+         putUnsignedInt(rows - 2);
+         putDelta(colStep.x(), colStep.y());
+         putDelta(rowStep.x(), rowStep.y());
+      }
+   }
+   else
+   {
+      word      count = std::max(cols, rows);
+      const TP& step  = (1 < cols) ? colStep : rowStep;
+      if ((0 == step.y()) && (0 < step.x()))
+      {
+         putByte(rp_regX);
+         putUnsignedInt(count - 2);
+         putUnsignedInt(step.x());
+      }
+      else if ((0 == step.x()) && (0 < step.y()))
+      {
+         putByte(rp_regY);
+         putUnsignedInt(count - 2);
+         putUnsignedInt(step.y());
+      }
+      else
+      {
+         putByte(rp_regDia1D);
+         putUnsignedInt(count - 2);
+         putDelta(step.x(), step.y());
+      }
+   }
+}
+
+//! Returns the reference number of the cell name in the CELLNAME table
+dword Oasis::OasisExportFile::cellRefnum(const std::string& name)
+{
+   RefnumMap::const_iterator CR = _cellRefnums.find(name);
+   if (_cellRefnums.end() != CR) return CR->second;
+   dword refnum = _cellRefnums.size();
+   _cellRefnums[name] = refnum;
+   _cellNames.push_back(name);
+   return refnum;
+}
+
+void Oasis::OasisExportFile::flushBuffer(bool crc)
+{
+   if (_buffer.empty()) return;
+   if (_oasFh.IsOpened())
+      _oasFh.Write(&_buffer[0], _buffer.size());
+   if (crc)
+      _crc32.add(&_buffer[0], _buffer.size());
+   _filePos += _buffer.size();
+   _buffer.clear();
+}
+
+Oasis::OasisExportFile::~OasisExportFile()
+{
+   if (_oasFh.IsOpened())
+   {
+      _oasFh.Close();
+      // don't leave an incomplete file behind (see wire())
+      if (!_finished)
+         wxRemoveFile(wxString(_fileName.c_str(), wxConvUTF8));
+   }
+}
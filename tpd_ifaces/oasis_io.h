@@ -28,6 +28,7 @@
 #define OASIS_H_INCLUDED
 
 #include <wx/ffile.h>
+#include <wx/stopwatch.h>
 #include <zlib.h>
 #include "outbox.h"
 #include "tedstd.h"
@@ -71,6 +72,8 @@ namespace Oasis {
    const byte oas_XGEOMETRY        = 33;
    const byte oas_CBLOCK           = 34;
    const byte oas_MagicBytes[]     = {0x25, 0x53, 0x45, 0x4d, 0x49, 0x2D, 0x4F, 0x41, 0x53, 0x49, 0x53, 0x0D, 0x0A};
+   //! The size of the read-ahead window of the input file (see OasisInFile::getByte())
+   const size_t OAS_READ_AHEAD     = 0x10000;
 
    /*! The enum values correspond to the Point List Types as defined in the standard
        (7.7, Table 7). The last member 'dt_unknown' is added for maintaining proper
@@ -210,6 +213,23 @@ namespace Oasis {
          TYPE              _value;
    };
 
+   /*! The counterpart of ModalVar used by the OasisExportFile. Keeps the value
+       last written in the file, so that the fields which don't change the state
+       of the modal variable can be omitted (10.3). The state is reset at the
+       beginning of each cell as required by the standard.
+   */
+   template <class TYPE> class OutModalVar {
+      public:
+                           OutModalVar()                 {_status = false;}
+         void              reset()                       {_status = false;}
+         //! Assigns the value. Returns true if it has to be written in the file
+         bool              update(const TYPE& value)     {if (_status && (value == _value)) return false;
+                                                          _value = value; _status = true; return true;}
+      private:
+         bool              _status;
+         TYPE              _value;
+   };
+
    /*! The class represents OASIS Point Lists (7.7). Contains dedicated methods for
        parsing all Point List types and also for the corresponding coordinate calculation
        All parsed delta values are stored in the PointList::_delarr. The calculated
@@ -376,22 +396,40 @@ namespace Oasis {
          ExtLayers         _contSummary     ; //! Layer contents summary
    };
 
+   /*! Inflates a CBLOCK in a memory buffer. The buffer is read directly by
+       the decoding window of the OasisInFile (see OasisInFile::inflateCBlock())
+   */
    class CBlockInflate : public z_stream {
       public:
-                           CBlockInflate(ForeignDbFile&, wxFileOffset, dword, dword);
-         void              readUncompressedBuffer(void *pBuf, size_t nCount);
-         bool              endOfBuffer() const  {return _bufOffset == _bufSize;}
+                           CBlockInflate(const byte*, wxFileOffset, dword, dword);
+         const byte*       buffer() const       {return _output_buffer;}
+         dword             bufSize() const      {return _bufSize;}
          wxFileOffset      startPosInFile() const {return _startPosInFile;}
          virtual          ~CBlockInflate();
       private:
          byte*             _output_buffer;
-         byte*             _input_buffer;
          int               _state;
-         wxFileOffset      _bufOffset;
-         wxFileOffset      _bufSize;
+         dword             _bufSize;
          wxFileOffset      _startPosInFile;
    };
 
+   /*! Deflates the contents of a cell into a memory buffer which is written in
+       the file as a CBLOCK (35). status() is false if the data can't be
+       compressed, in which case it should be written in the file as it is.
+   */
+   class CBlockDeflate : public z_stream {
+      public:
+                           CBlockDeflate(const byte*, dword);
+         const byte*       buffer() const       {return _output_buffer;}
+         dword             bufSize() const      {return _bufSize;}
+         bool              status() const       {return (Z_STREAM_END == _state);}
+         virtual          ~CBlockDeflate();
+      private:
+         byte*             _output_buffer;
+         int               _state;
+         dword             _bufSize;
+   };
+
    /*!
     * Implementation of the OASIS CRC. The polynomial is as as specified in
     * ISO 3309 and ITU-T V.42 used in Ethernet, FDDI, cksum, etc.
@@ -425,6 +463,7 @@ namespace Oasis {
          virtual             ~OasisInFile();
          virtual void         hierOut();
          wxFileOffset         oasSetPosition(wxFileOffset);
+         wxFileOffset         oasFilePos() const;
          void                 inflateCBlock();
          bool                 calculateCRC(Iso3309Crc32&);
          bool                 calculateChecksum(dword& checksum);
@@ -445,7 +484,8 @@ namespace Oasis {
          virtual void         getAllCells(wxListBox&) const;
          virtual void         convertPrep(const NameList&, bool);
          //----------------------------------------------------------------------
-         byte                 getByte();
+         //! The next byte from the decoding window. Refills the window if it's exhausted
+         byte                 getByte()          { return (_bufCur < _bufEnd) ? *_bufCur++ : nextBuffer();}
          qword                getUnsignedInt(byte);
          int8b                getInt(byte);
          real                 getReal(char type = -1);
@@ -465,6 +505,10 @@ namespace Oasis {
          void                 readStartRecord();
          void                 readEndRecord();
          size_t               rawRead(void *pBuf, size_t nCount);
+         byte                 nextBuffer();
+         void                 retireBuffer();
+         void                 releaseCBlock();
+         void                 resetBuffer();
          //
          void                 linkReferences();
          // Oasis tables
@@ -484,10 +528,131 @@ namespace Oasis {
          std::string          _version;   //! OASIS version record retrieved from the file
          real                 _unit;      //! OASIS unit (DBU) retrieved from the file
          CBlockInflate*       _curCBlock; //! Current uncompressed CBLOCK
+         // The decoding window. Points either to the read-ahead data of the
+         // file or to the inflated data of the current CBLOCK
+         const byte*          _bufCur;    //! Current position in the decoding window
+         const byte*          _bufEnd;    //! End of the decoding window
+         const byte*          _bufStart;  //! Start of the current file window (for the progress indicator)
+         const byte*          _fileCur;   //! Saved position in the file window while reading a CBLOCK
+         const byte*          _fileEnd;   //! Saved end of the file window while reading a CBLOCK
+         byte*                _readAhead; //! Read-ahead buffer (used if the file is not mapped)
          ValidationScheme     _validation;//! Validation Scheme of this OASIS file
          dword                _signature; //! The signature of the OASIS file (depends on the validation scheme)
    };
 
+   /*! Exports the Toped database in OASIS format.\n
+       The shapes and the cell references of each cell are collected during the
+       database traversal and grouped by layer, type and geometry (relative to
+       the first point). Each group is written as a single record. The groups
+       with more than one member get a repetition (7.6) - the regular ones
+       (rows, columns and matrices) are recognised, all the rest are written as
+       arbitrary repetitions. The cell reference arrays are written directly as
+       regular repetitions.\n
+       The modal variables are used to omit the fields which are the same as
+       in the previous record and the contents of each cell is compressed in a
+       CBLOCK unless compression is not requested or it doesn't pay off. The
+       cell names are written in a CELLNAME table (implicit reference numbers)
+       at the end of the file. The table offsets are in the END record together
+       with the CRC32 signature.
+   */
+   class OasisExportFile : public DbExportFile {
+      public:
+                              OasisExportFile(std::string, laydata::TdtCell*, const LayerMapExt&, bool, bool);
+         virtual             ~OasisExportFile();
+         virtual void         definitionStart(std::string);
+         virtual void         definitionFinish();
+         virtual void         libraryStart(std::string, TpdTime&, real, real);
+         virtual void         libraryFinish();
+         virtual bool         layerSpecification(const LayerDef&);
+         virtual void         box(const int4b* const);
+         virtual void         polygon(const int4b* const, unsigned);
+         virtual void         wire(const int4b* const, unsigned, WireWidth);
+         virtual void         text(const std::string&, const CTM&);
+         virtual void         ref(const std::string&, const CTM&);
+         virtual void         aref(const std::string&, const CTM&, const laydata::ArrayProps&);
+         virtual bool         checkCellWritten(std::string) const;
+         virtual void         registerCellWritten(std::string);
+      private:
+         //! Layer, data type and geometry of a shape relative to its first point
+         typedef std::vector<int4b>                   ShapeKey;
+         typedef std::map<ShapeKey, PointVector>      ShapeMap;
+         typedef std::pair<ShapeKey, std::string>     TextKey;
+         typedef std::map<TextKey, PointVector>       TextMap;
+         //! The placement properties of a cell reference except the position
+         class RefKey {
+            public:
+                              RefKey(dword refnum, real mag, real angle, bool flip) :
+                                 _refnum(refnum), _mag(mag), _angle(angle), _flip(flip) {}
+               bool           operator < (const RefKey&) const;
+               dword          _refnum;
+               real           _mag;
+               real           _angle;
+               bool           _flip;
+         };
+         typedef std::map<RefKey, PointVector>        RefMap;
+         typedef std::map<std::string, dword>         RefnumMap;
+         void                 writeShapes();
+         void                 writeRectangle(const ShapeKey&, PointVector&);
+         void                 writePolygon(const ShapeKey&, PointVector&);
+         void                 writePath(const ShapeKey&, PointVector&);
+         void                 writeText(const TextKey&, PointVector&);
+         void                 writePlacement(const RefKey&, const TP&, bool);
+         RefKey               placement(const std::string&, const CTM&, TP&);
+         void                 putByte(byte value)           {_buffer.push_back(value);}
+         void                 putUnsignedInt(qword);
+         void                 putInt(int8b);
+         void                 putReal(real);
+         void                 putString(const std::string&);
+         void                 putDelta(int4b, int4b);
+         void                 putPointList(const ShapeKey&, unsigned, bool);
+         void                 putRepetition(const PointVector&);
+         void                 putArrayRepetition(word, word, const TP&, const TP&);
+         dword                cellRefnum(const std::string&);
+         void                 flushBuffer(bool crc = true);
+         const LayerMapExt&   _laymap;
+         bool                 _compress;  //! Compress the cells in CBLOCKs
+         wxFFile              _oasFh;
+         std::vector<byte>    _buffer;    //! Encoded records which are not written yet
+         Iso3309Crc32         _crc32;
+         wxFileOffset         _filePos;
+         std::string          _ccname;
+         NameSet              _childnames;
+         NameList             _cellNames; //! Cell names in the order of their reference numbers
+         RefnumMap            _cellRefnums;
+         word                 _cLayer;
+         word                 _cDType;
+         // shapes of the current cell grouped by geometry
+         ShapeMap             _rectangles;
+         ShapeMap             _polygons;
+         ShapeMap             _paths;
+         TextMap              _texts;
+         RefMap               _refs;
+         // modal variables (10.3)
+         OutModalVar<word>    _mod_layer;
+         OutModalVar<word>    _mod_datatype;
+         OutModalVar<word>    _mod_tlayer;
+         OutModalVar<word>    _mod_tdatatype;
+         OutModalVar<int4b>   _mod_gwidth;
+         OutModalVar<int4b>   _mod_gheight;
+         OutModalVar<int4b>   _mod_pathhw;
+         OutModalVar<byte>    _mod_exs;
+         OutModalVar<int4b>   _mod_gx;
+         OutModalVar<int4b>   _mod_gy;
+         OutModalVar<int4b>   _mod_px;
+         OutModalVar<int4b>   _mod_py;
+         OutModalVar<int4b>   _mod_tx;
+         OutModalVar<int4b>   _mod_ty;
+         OutModalVar<dword>   _mod_cellref;
+         OutModalVar<std::string> _mod_text;
+         // statistics
+         wxStopWatch          _stopWatch;
+         dword                _numCells;
+         qword                _numElements;
+         qword                _numRecords;
+         qword                _rawSize;   //! The size of the cells before compression
+         bool                 _finished;  //! The END record is written
+   };
+
    void readDelta(OasisInFile&, int4b&, int4b&);
 }
 
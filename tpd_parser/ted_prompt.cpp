@@ -27,6 +27,7 @@
 
 #include "tpdph.h"
 #include <string>
+#include <sstream>
 #include <wx/string.h>
 #include <wx/regex.h>
 #include <wx/filename.h>
@@ -303,9 +304,11 @@ void* console::parse_thread::Entry()
       telllloc.filename = NULL;
       parsercmd::cmdSTDFUNC::setThreadExecution(true);
       TpdPost::toped_status(TSTS_THREADON, _command);
+      bool poolOwner = telldata::VarPool::instance().enter();
 
    #ifdef PARSER_PROFILING
          HiResTimer profTimer;
+         telldata::VarPool::instance().resetStats();
    #endif
       try {
          void* b = tell_scan_string(_command.mb_str(wxConvUTF8) );
@@ -320,7 +323,16 @@ void* console::parse_thread::Entry()
       }
    #ifdef PARSER_PROFILING
          profTimer.report("Time elapsed by the last parser run: ");
+      #ifdef TELL_VAR_POOL
+         std::ostringstream allocs;
+         allocs << "TELL variables allocated by the last parser run: "
+                << telldata::VarPool::instance().allocations() << " (system allocations: "
+                << telldata::VarPool::instance().heapAllocations() << ")";
+         tell_log(console::MT_INFO, allocs.str());
+      #endif
    #endif
+      if (poolOwner)
+         telldata::VarPool::instance().leave();
       if (Console->exitRequested())
       {
          Console->setExitRequest(false);
@@ -377,6 +389,7 @@ void console::TllCmdLine::getCommand(bool thread)
       { // executing the parser without thread
          // essentially the same code as in parse_thread::Entry, but
          // without the mutexes
+         bool poolOwner = telldata::VarPool::instance().enter();
          telllloc.first_column = telllloc.first_line = 1;
          telllloc.last_column  = telllloc.last_line  = 1;
          telllloc.filename = NULL;
@@ -392,6 +405,8 @@ void console::TllCmdLine::getCommand(bool thread)
             // maybe check for available dynamic memory
             // see the same comment @line 307
          }
+         if (poolOwner)
+            telldata::VarPool::instance().leave();
          // Make sure that exit command didn't get trough
          assert(!exitRequested());
       }
@@ -0,0 +1,151 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Memory pool of the TELL variables
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include <new>
+#include <wx/thread.h>
+#include "tellpool.h"
+
+//=============================================================================
+telldata::VarPool::VarPool() :
+   _owner            ( 0     ),
+   _owned            ( false ),
+   _allocations      ( 0     ),
+   _heapAllocations  ( 0     )
+{
+   for (unsigned i = 0; i < VPOOL_CLASSES; i++)
+      _free[i] = _foreign[i] = NULL;
+}
+
+/*! The pool is created on the first request and it's never destroyed, because
+ * the static variables might be deleted after the end of main()*/
+telldata::VarPool& telldata::VarPool::instance()
+{
+   static VarPool* pool = DEBUG_NEW VarPool();
+   return *pool;
+}
+
+/*! The calling thread takes the free lists for the duration of a parser run.
+ * Returns false if they are already taken - by the same thread in a nested
+ * run, or by another thread. The latter shouldn't happen, because the parser
+ * runs are serialized, but if it does, the caller works with the system
+ * allocator. The mutex makes the free lists left by the previous owner
+ * visible to the new one.*/
+bool telldata::VarPool::enter()
+{
+   wxMutexLocker lock(_mutex);
+   if (_owned) return false;
+   _owner = wxThread::GetCurrentId();
+   _owned = true;
+   return true;
+}
+
+/*! The end of the parser run which got true from enter(). The blocks released
+ * from now on go to the foreign lists until the next parser run*/
+void telldata::VarPool::leave()
+{
+   wxMutexLocker lock(_mutex);
+   assert(owner());
+   _owned = false;
+}
+
+void* telldata::VarPool::allocate(size_t size)
+{
+   unsigned sclass = sizeClass(size);
+   if (VPOOL_CLASSES <= sclass)
+   {
+      if (owner())
+      {
+         _allocations++;
+         _heapAllocations++;
+      }
+      return ::operator new(size);
+   }
+   if (!owner())
+      return ::operator new((sclass + 1) * VPOOL_GRANULE);
+   _allocations++;
+   if (NULL == _free[sclass])
+      refill(sclass);
+   FreeBlock* block = _free[sclass];
+   _free[sclass] = block->_next;
+   return block;
+}
+
+void telldata::VarPool::release(void* ptr, size_t size)
+{
+   if (NULL == ptr) return;
+   unsigned sclass = sizeClass(size);
+   if (VPOOL_CLASSES <= sclass)
+   {
+      ::operator delete(ptr);
+      return;
+   }
+   FreeBlock* block = static_cast<FreeBlock*>(ptr);
+   if (owner())
+   {
+      block->_next = _free[sclass];
+      _free[sclass] = block;
+   }
+   else
+   {
+      wxMutexLocker lock(_mutex);
+      block->_next = _foreign[sclass];
+      _foreign[sclass] = block;
+   }
+}
+
+/*! The counters are updated by the owner only, so this must be called by the
+ * owner as well*/
+void telldata::VarPool::resetStats()
+{
+   _allocations = _heapAllocations = 0;
+}
+
+/*! Takes over the blocks released by the other threads, or if there are none
+ * - cuts a new slab. Called by the owner when its free list is empty*/
+void telldata::VarPool::refill(unsigned sclass)
+{
+   {
+      wxMutexLocker lock(_mutex);
+      _free[sclass] = _foreign[sclass];
+      _foreign[sclass] = NULL;
+   }
+   if (NULL == _free[sclass])
+      newSlab(sclass);
+}
+
+/*! Cuts a new slab in blocks of the size class and puts them in the free list*/
+void telldata::VarPool::newSlab(unsigned sclass)
+{
+   size_t bsize = (sclass + 1) * VPOOL_GRANULE;
+   char* slab = static_cast<char*>(::operator new(VPOOL_SLAB_SIZE));
+   _heapAllocations++;
+   for (size_t offset = 0; offset + bsize <= VPOOL_SLAB_SIZE; offset += bsize)
+   {
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+      block->_next = _free[sclass];
+      _free[sclass] = block;
+   }
+}
@@ -0,0 +1,93 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: Memory pool of the TELL variables
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef TELLPOOL_H_INCLUDED
+#define TELLPOOL_H_INCLUDED
+
+#include <cstddef>
+#include <wx/thread.h>
+#include "ttt.h"
+
+// The pool is bypassed when the allocations are traced (see tpdph.h)
+#if !defined(DB_MEMORY_TRACE) && !(defined(WIN32) && defined(_DEBUG))
+   #define TELL_VAR_POOL
+#endif
+
+namespace telldata {
+
+   /**
+    * Slab allocator of the TELL variables. The interpreter creates and deletes
+    * a variable for almost every executed operator - the operands are copied
+    * in the operand stack and the results are new objects. All of them are
+    * small and most of them are short lived. The pool keeps a free list per
+    * size class (a multiple of VPOOL_GRANULE bytes), so the memory of the
+    * deleted variables is reused without a trip to the system allocator.
+    * New memory is taken from the system in slabs of VPOOL_SLAB_SIZE bytes and
+    * is never returned, i.e. the footprint of the pool is the peak number of
+    * simultaneously existing variables. Bigger objects go directly to the
+    * system allocator.\n
+    * The free lists belong to the thread which is currently running the
+    * parser - the parser thread in the GUI, or the main thread in the batch
+    * and the console modes. Every parser run takes them with enter() and
+    * gives them back with leave(), so they are used without any locking. The
+    * variables created by the other threads (the main thread handling the
+    * mouse input for example) are allocated by the system, but with the size
+    * of the pool block, so the owner can reuse them after they are released.
+    * The blocks released by the other threads, or while no parser is running,
+    * can't go to the free lists directly. They are collected in separate
+    * lists under a mutex and the next owner takes them over when its own free
+    * list runs empty.\n
+    * The pool counts the allocations of the owner. The counters are reset
+    * and reported for every parser run in a PARSER_PROFILING build.
+    */
+   class VarPool {
+      public:
+         void*             allocate(size_t);
+         void              release(void*, size_t);
+         void              resetStats();
+         bool              enter();
+         void              leave();
+         dword             allocations() const     {return _allocations;}
+         dword             heapAllocations() const {return _heapAllocations;}
+         bool              owner() const {return _owned && (wxThread::GetCurrentId() == _owner);}
+         static VarPool&   instance();
+      private:
+         enum {VPOOL_GRANULE = 8, VPOOL_CLASSES = 16, VPOOL_SLAB_SIZE = 8192};
+         struct FreeBlock {FreeBlock* _next;};
+                           VarPool();
+         unsigned          sizeClass(size_t size) const {return (size + VPOOL_GRANULE - 1) / VPOOL_GRANULE - 1;}
+         void              refill(unsigned);
+         void              newSlab(unsigned);
+         FreeBlock*        _free[VPOOL_CLASSES];    //! used by the owner only
+         FreeBlock*        _foreign[VPOOL_CLASSES]; //! released by the other threads
+         wxMutex           _mutex;                  //! guards _foreign and the ownership changes
+         wxThreadIdType    _owner;
+         bool              _owned;
+         dword             _allocations;     //! all allocations of variables
+         dword             _heapAllocations; //! allocations which reached the system allocator
+   };
+
+}
+
+#endif //TELLPOOL_H_INCLUDED
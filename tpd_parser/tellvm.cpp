@@ -0,0 +1,299 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: TELL expression bytecode and register VM
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+
+#include "tpdph.h"
+#include "tellvm.h"
+
+bool parsercmd::cmdEXPR::_enabled = true;
+
+//=============================================================================
+static inline real varValue(const telldata::TellVar* var, telldata::typeID type)
+{
+   switch (type)
+   {
+      case telldata::tn_real: return static_cast<const telldata::TtReal*>(var)->value();
+      case telldata::tn_int : return static_cast<const telldata::TtInt* >(var)->value();
+      case telldata::tn_uint: return static_cast<const telldata::TtUInt*>(var)->value();
+      case telldata::tn_bool: return static_cast<const telldata::TtBool*>(var)->value() ? 1.0 : 0.0;
+      default: assert(false); return 0.0;
+   }
+}
+
+/*! Assigns the register value to the variable. The conversions are done by
+ * the assign() method of the variable, exactly as in cmdASSIGN, but without
+ * a heap allocated operand*/
+static inline void varAssign(telldata::TellVar* var, real value, telldata::typeID type)
+{
+   switch (type)
+   {
+      case telldata::tn_real: {telldata::TtReal op(value)                 ; var->assign(&op); break;}
+      case telldata::tn_int : {telldata::TtInt  op((int4b)value)          ; var->assign(&op); break;}
+      case telldata::tn_uint: {telldata::TtUInt op((int4b)(dword)value)   ; var->assign(&op); break;}
+      case telldata::tn_bool: {telldata::TtBool op(0.0 != value)          ; var->assign(&op); break;}
+      default: assert(false);
+   }
+}
+
+static inline telldata::TellVar* boxValue(real value, telldata::typeID type)
+{
+   switch (type)
+   {
+      case telldata::tn_real: return DEBUG_NEW telldata::TtReal(value);
+      case telldata::tn_int : return DEBUG_NEW telldata::TtInt((int4b)value);
+      case telldata::tn_uint: return DEBUG_NEW telldata::TtUInt((int4b)(dword)value);
+      case telldata::tn_bool: return DEBUG_NEW telldata::TtBool(0.0 != value);
+      default: assert(false); return NULL;
+   }
+}
+
+//=============================================================================
+bool parsercmd::TellCode::scalar(telldata::typeID type)
+{
+   return (NUMBER_TYPE(type) || (telldata::tn_bool == type));
+}
+
+void parsercmd::TellCode::emit(VmOpCode opc, byte dst, byte src)
+{
+   VmInstr instr;
+   instr._opc = opc;
+   instr._dst = dst;
+   instr._src = src;
+   instr._arg._var = NULL;
+   _code.push_back(instr);
+   if ((vmLDVAR != opc) && (vmLDIMM != opc)) _hasOps = true;
+}
+
+/*! Loads a variable in the next register. The value of a constant (a literal
+ * in the script) is loaded in compile time.*/
+bool parsercmd::TellCode::load(telldata::TellVar* var, bool constant)
+{
+   telldata::typeID type = var->get_type();
+   if (!scalar(type) || (VM_MAX_REGS <= depth())) return false;
+   if (constant)
+   {
+      emit(vmLDIMM, depth(), 0);
+      _code.back()._arg._imm = varValue(var, type);
+   }
+   else
+   {
+      emit(vmLDVAR, depth(), type);
+      _code.back()._arg._var = var;
+   }
+   _types.push_back(type);
+   return true;
+}
+
+/*! Binary operation with numbers*/
+bool parsercmd::TellCode::arith(VmOpCode opc, telldata::typeID retype)
+{
+   if (!operands(2)) return false;
+   word top = depth() - 1;
+   if (!NUMBER_TYPE(_types[top]) || !NUMBER_TYPE(_types[top-1])) return false;
+   emit(opc, top - 1, top);
+   _types.pop_back();
+   _types.back() = retype;
+   return true;
+}
+
+/*! Binary operation with bools*/
+bool parsercmd::TellCode::logic(VmOpCode opc)
+{
+   if (!operands(2)) return false;
+   word top = depth() - 1;
+   if ((telldata::tn_bool != _types[top]) || (telldata::tn_bool != _types[top-1])) return false;
+   emit(opc, top - 1, top);
+   _types.pop_back();
+   return true;
+}
+
+/*! Binary operation with integers of the same type*/
+bool parsercmd::TellCode::bitwise(VmOpCode opc, telldata::typeID type)
+{
+   if (!operands(2)) return false;
+   word top = depth() - 1;
+   if ((type != _types[top]) || (type != _types[top-1])) return false;
+   emit(opc, top - 1, top);
+   _types.pop_back();
+   return true;
+}
+
+bool parsercmd::TellCode::unary(VmOpCode opc, telldata::typeID retype, telldata::typeID optype)
+{
+   if (!operands(1)) return false;
+   word top = depth() - 1;
+   if (optype != _types[top]) return false;
+   emit(opc, top, top);
+   _types.back() = retype;
+   return true;
+}
+
+/*! == and != . The operands are either numbers or bools (see cmdEQ)*/
+bool parsercmd::TellCode::compare(bool equal)
+{
+   if (!operands(2)) return false;
+   word top = depth() - 1;
+   if      (NUMBER_TYPE(_types[top]) && NUMBER_TYPE(_types[top-1])) ;
+   else if ((telldata::tn_bool == _types[top]) && (telldata::tn_bool == _types[top-1])) ;
+   else return false;
+   emit(equal ? vmEQ : vmNE, top - 1, top);
+   _types.pop_back();
+   _types.back() = telldata::tn_bool;
+   return true;
+}
+
+/*! Assigns the top register to a variable. The register gets the type and the
+ * value of the variable after the assignment (see cmdASSIGN)*/
+bool parsercmd::TellCode::store(telldata::TellVar* var)
+{
+   if (!operands(1)) return false;
+   word top = depth() - 1;
+   telldata::typeID type = var->get_type();
+   if (!scalar(type)) return false;
+   if ((telldata::tn_bool == type) != (telldata::tn_bool == _types[top])) return false;
+   emit(vmSTORE, top, _types[top]);
+   _code.back()._arg._var = var;
+   _types.back() = type;
+   return true;
+}
+
+/*! The end of the statement (see cmdSTACKRST). The registers are abandoned*/
+bool parsercmd::TellCode::reset()
+{
+   emit(vmRESET, 0, 0);
+   _types.clear();
+   return true;
+}
+
+//=============================================================================
+parsercmd::cmdEXPR::cmdEXPR(const TellCode& code, CmdQUEUE& cmdQ) :
+   _code    ( code.code()  ),
+   _retypes ( code.types() )
+{
+   _cmdQ.swap(cmdQ);
+}
+
+int parsercmd::cmdEXPR::execute()
+{
+   if (!_enabled)
+   {
+      int retexec = EXEC_NEXT;
+      for (CmdQUEUE::const_iterator cmd = _cmdQ.begin(); cmd != _cmdQ.end(); cmd++)
+         if ((retexec = (*cmd)->execute())) break;
+      return retexec;
+   }
+   real reg[VM_MAX_REGS];
+   for (VmCode::const_iterator CI = _code.begin(); CI != _code.end(); CI++)
+   {
+      real& dst = reg[CI->_dst];
+      const real& src = reg[CI->_src];
+      switch (CI->_opc)
+      {
+         case vmLDVAR : dst = varValue(CI->_arg._var, CI->_src); break;
+         case vmLDIMM : dst = CI->_arg._imm; break;
+         case vmADDR  : dst = dst + src; break;
+         case vmADDI  : dst = (int4b)dst + (int4b)src; break;
+         case vmADDU  : dst = (dword)dst + (dword)src; break;
+         case vmSUBR  : dst = dst - src; break;
+         case vmSUBI  : dst = (int4b)dst - (int4b)src; break;
+         case vmMULR  : dst = dst * src; break;
+         case vmMULI  : dst = intMultiply(dst, src); break;
+         case vmDIVR  : dst = dst / src; break;
+         case vmDIVI  : dst = (int4b)dst / (int4b)src; break;
+         case vmNEGR  : dst = -dst; break;
+         case vmNEGI  : dst = -(int4b)dst; break;
+         case vmNEGU  : dst = -(int4b)(dword)dst; break;
+         case vmLT    : dst = (dst <  src) ? 1.0 : 0.0; break;
+         case vmLE    : dst = (dst <= src) ? 1.0 : 0.0; break;
+         case vmGT    : dst = (dst >  src) ? 1.0 : 0.0; break;
+         case vmGE    : dst = (dst >= src) ? 1.0 : 0.0; break;
+         case vmEQ    : dst = (dst == src) ? 1.0 : 0.0; break;
+         case vmNE    : dst = (dst != src) ? 1.0 : 0.0; break;
+         case vmAND   : dst = ((0.0 != dst) && (0.0 != src)) ? 1.0 : 0.0; break;
+         case vmOR    : dst = ((0.0 != dst) || (0.0 != src)) ? 1.0 : 0.0; break;
+         case vmNOT   : dst = (0.0 == dst) ? 1.0 : 0.0; break;
+         case vmBANDI : dst = (int4b)dst & (int4b)src; break;
+         case vmBANDU : dst = (dword)dst & (dword)src; break;
+         case vmBORI  : dst = (int4b)dst | (int4b)src; break;
+         case vmBORU  : dst = (dword)dst | (dword)src; break;
+         case vmBXORI : dst = (int4b)dst ^ (int4b)src; break;
+         case vmBXORU : dst = (dword)dst ^ (dword)src; break;
+         case vmBNOTI : dst = ~(int4b)dst; break;
+         case vmBNOTU : dst = ~(dword)dst; break;
+         case vmSTORE :
+            varAssign(CI->_arg._var, dst, CI->_src);
+            dst = varValue(CI->_arg._var, CI->_arg._var->get_type());
+            break;
+         case vmRESET :
+            while (!OPstack.empty())
+            {
+               delete OPstack.top(); OPstack.pop();
+            }
+            break;
+         default: assert(false);
+      }
+   }
+   for (word i = 0; i < _retypes.size(); i++)
+      OPstack.push(boxValue(reg[i], _retypes[i]));
+   return EXEC_NEXT;
+}
+
+/*! Replaces every worthy run of compilable commands in cmdQ with a cmdEXPR.
+ * Called by the parser when a block is completed (see cmdBLOCK::popblk()).*/
+void parsercmd::cmdEXPR::compile(CmdQUEUE& cmdQ)
+{
+   CmdQUEUE result;
+   CmdQUEUE run;
+   TellCode code;
+   for (CmdQUEUE::const_iterator cmd = cmdQ.begin(); cmd != cmdQ.end(); cmd++)
+   {
+      if ((*cmd)->compile(code))
+         run.push_back(*cmd);
+      else
+      {
+         flush(result, code, run);
+         // the command might be compilable on its own (register overflow)
+         if ((*cmd)->compile(code)) run.push_back(*cmd);
+         else                       result.push_back(*cmd);
+      }
+   }
+   flush(result, code, run);
+   cmdQ.swap(result);
+}
+
+void parsercmd::cmdEXPR::flush(CmdQUEUE& result, TellCode& code, CmdQUEUE& run)
+{
+   if ((1 < run.size()) && code.worthy())
+      result.push_back(DEBUG_NEW cmdEXPR(code, run));
+   else
+      result.insert(result.end(), run.begin(), run.end());
+   run.clear();
+   code = TellCode();
+}
+
+parsercmd::cmdEXPR::~cmdEXPR()
+{
+   for (CmdQUEUE::iterator CMDI = _cmdQ.begin(); CMDI != _cmdQ.end(); CMDI++)
+      delete *CMDI;
+}
@@ -0,0 +1,127 @@
+//===========================================================================
+//                                                                          =
+//   This program is free software; you can redistribute it and/or modify   =
+//   it under the terms of the GNU General Public License as published by   =
+//   the Free Software Foundation; either version 2 of the License, or      =
+//   (at your option) any later version.                                    =
+// ------------------------------------------------------------------------ =
+//                  TTTTT    OOO    PPPP    EEEE    DDDD                    =
+//                  T T T   O   O   P   P   E       D   D                   =
+//                    T    O     O  PPPP    EEE     D    D                  =
+//                    T     O   O   P       E       D   D                   =
+//                    T      OOO    P       EEEEE   DDDD                    =
+//                                                                          =
+//   This file is a part of Toped project (C) 2001-2012 Toped developers    =
+// ------------------------------------------------------------------------ =
+//           $URL$
+//    Description: TELL expression bytecode and register VM
+//---------------------------------------------------------------------------
+//  Revision info
+//---------------------------------------------------------------------------
+//      $Revision$
+//          $Date$
+//        $Author$
+//===========================================================================
+#ifndef TELLVM_H_INCLUDED
+#define TELLVM_H_INCLUDED
+
+#include <vector>
+#include "tellyzer.h"
+
+#define VM_MAX_REGS  32
+
+namespace parsercmd {
+
+   /*! The bytecode of the TELL expression VM. Every instruction works on the
+    * (unboxed) registers. r - real, i - int, u - uint operands*/
+   typedef enum { vmLDVAR       // dst = var
+                 ,vmLDIMM       // dst = immediate
+                 ,vmADDR  ,vmADDI  ,vmADDU
+                 ,vmSUBR  ,vmSUBI
+                 ,vmMULR  ,vmMULI
+                 ,vmDIVR  ,vmDIVI
+                 ,vmNEGR  ,vmNEGI  ,vmNEGU
+                 ,vmLT    ,vmLE    ,vmGT    ,vmGE
+                 ,vmEQ    ,vmNE
+                 ,vmAND   ,vmOR    ,vmNOT
+                 ,vmBANDI ,vmBANDU ,vmBORI  ,vmBORU  ,vmBXORI ,vmBXORU
+                 ,vmBNOTI ,vmBNOTU
+                 ,vmSTORE       // var = src; dst = var
+                 ,vmRESET       // clear the operand stack (cmdSTACKRST)
+                } VmOpCode;
+
+   struct VmInstr {
+      byte                 _opc;    //! VmOpCode
+      byte                 _dst;    //! destination register
+      byte                 _src;    //! second operand register (the type of the variable for vmLDVAR & vmSTORE)
+      union {
+         telldata::TellVar* _var;
+         real               _imm;
+      }                    _arg;
+   };
+
+   typedef std::vector<VmInstr>           VmCode;
+   typedef std::vector<telldata::typeID>  VmTypes;
+
+   /**
+    * The compiler of the TELL expressions. The command tree generated by the
+    * parser is a postfix sequence of operators working on the operand stack,
+    * where every operand (even a simple int) is a heap allocated TellVar. The
+    * compiler translates a run of such operators into bytecode for a simple
+    * register machine. The registers are allocated in the order of the operand
+    * stack, so the translation is straightforward. The types of the registers
+    * are tracked in compile time, so the values in the registers are unboxed.
+    * Only scalar (int, uint, real & bool) expressions and assignments are
+    * compiled. The instructions are appended by cmdVIRTUAL::compile() of the
+    * corresponding commands.
+    */
+   class TellCode {
+      public:
+                           TellCode() : _hasOps(false) {}
+         bool              load(telldata::TellVar*, bool constant);
+         bool              arith(VmOpCode, telldata::typeID retype);
+         bool              logic(VmOpCode);
+         bool              bitwise(VmOpCode, telldata::typeID type);
+         bool              unary(VmOpCode, telldata::typeID retype, telldata::typeID optype);
+         bool              compare(bool equal);
+         bool              store(telldata::TellVar*);
+         bool              reset();
+         bool              worthy() const    {return _hasOps;}
+         word              depth() const     {return _types.size();}
+         const VmCode&     code() const      {return _code;}
+         const VmTypes&    types() const     {return _types;}
+         static bool       scalar(telldata::typeID);
+      private:
+         void              emit(VmOpCode, byte dst, byte src);
+         bool              operands(word num) const {return depth() >= num;}
+         VmCode            _code;
+         VmTypes           _types;  //! the types of the occupied registers
+         bool              _hasOps; //! something else than loads in the code
+   };
+
+   /**
+    * A compiled run of commands. It replaces the original commands in the
+    * command queue of the block, but keeps them in case the VM is disabled
+    * (see enabled()). The result is the same as the result of the original
+    * commands - all registers left after the last instruction are pushed in
+    * the operand stack.
+    */
+   class cmdEXPR : public cmdVIRTUAL {
+      public:
+                           cmdEXPR(const TellCode&, CmdQUEUE&);
+         virtual          ~cmdEXPR();
+         virtual int       execute();
+         static void       compile(CmdQUEUE&);
+         static bool       enabled()               {return _enabled;}
+         static void       setEnabled(bool val)    {_enabled = val;}
+      private:
+         static void       flush(CmdQUEUE&, TellCode&, CmdQUEUE&);
+         VmCode            _code;
+         VmTypes           _retypes;   //! the types of the resulting registers
+         CmdQUEUE          _cmdQ;      //! the original commands
+         static bool       _enabled;
+   };
+
+}
+
+#endif //TELLVM_H_INCLUDED
@@ -30,7 +30,9 @@
 #include <algorithm>
 #include <wx/string.h>
 #include <wx/regex.h>
+#include <wx/stopwatch.h>
 #include "tellyzer.h"
+#include "tellvm.h"
 #include "tldat.h"
 #include "outbox.h"
 
@@ -77,6 +79,9 @@ bool parsercmd::cmdSTDFUNC::_ignoreOnRecovery = false;
 bool parsercmd::cmdSTDFUNC::_threadExecution = false;
 // Depth of the UNDO stack
 word parsercmd::cmdBLOCK::_undoDepth = 100;
+// Timing of the top level function calls (batch mode)
+bool parsercmd::cmdFUNCCALL::_profiling = false;
+word parsercmd::cmdFUNCCALL::_callDepth = 0;
 
 
 //=============================================================================
@@ -562,6 +567,17 @@ int parsercmd::cmdPLUS::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdPLUS::compile(TellCode& code) const
+{
+   switch (_retype)
+   {
+      case telldata::tn_real: return code.arith(vmADDR, _retype);
+      case telldata::tn_int : return code.arith(vmADDI, _retype);
+      case telldata::tn_uint: return code.arith(vmADDU, _retype);
+      default: return false;
+   }
+}
+
 //=============================================================================
 int parsercmd::cmdCONCATENATE::execute()
 {
@@ -598,6 +614,16 @@ int parsercmd::cmdMINUS::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdMINUS::compile(TellCode& code) const
+{
+   switch (_retype)
+   {
+      case telldata::tn_real: return code.arith(vmSUBR, _retype);
+      case telldata::tn_int : return code.arith(vmSUBI, _retype);
+      default: return false;
+   }
+}
+
 //=============================================================================
 int parsercmd::cmdSHIFTPNT::execute()
 {
@@ -782,11 +808,17 @@ int parsercmd::cmdMULTIPLY::execute()
    {
       real value2 = getOpValue();
       real value1 = getOpValue();
-      OPstack.push(DEBUG_NEW telldata::TtInt(value1 * value2));
+      OPstack.push(DEBUG_NEW telldata::TtInt(intMultiply(value1, value2)));
    }
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdMULTIPLY::compile(TellCode& code) const
+{
+   if (telldata::tn_real == _retype) return code.arith(vmMULR, telldata::tn_real);
+   else                              return code.arith(vmMULI, telldata::tn_int );
+}
+
 //=============================================================================
 int parsercmd::cmdDIVISION::execute()
 {
@@ -806,6 +838,12 @@ int parsercmd::cmdDIVISION::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdDIVISION::compile(TellCode& code) const
+{
+   if (telldata::tn_real == _retype) return code.arith(vmDIVR, telldata::tn_real);
+   else                              return code.arith(vmDIVI, telldata::tn_int );
+}
+
 //=============================================================================
 int parsercmd::cmdSCALEPNT::execute()
 {
@@ -871,6 +909,11 @@ int parsercmd::cmdLT::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdLT::compile(TellCode& code) const
+{
+   return code.arith(vmLT, telldata::tn_bool);
+}
+
 //=============================================================================
 int parsercmd::cmdLET::execute()
 {
@@ -881,6 +924,11 @@ int parsercmd::cmdLET::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdLET::compile(TellCode& code) const
+{
+   return code.arith(vmLE, telldata::tn_bool);
+}
+
 //=============================================================================
 int parsercmd::cmdGT::execute()
 {
@@ -891,6 +939,11 @@ int parsercmd::cmdGT::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdGT::compile(TellCode& code) const
+{
+   return code.arith(vmGT, telldata::tn_bool);
+}
+
 //=============================================================================
 int parsercmd::cmdGET::execute()
 {
@@ -901,6 +954,11 @@ int parsercmd::cmdGET::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdGET::compile(TellCode& code) const
+{
+   return code.arith(vmGE, telldata::tn_bool);
+}
+
 //=============================================================================
 int parsercmd::cmdEQ::execute()
 {
@@ -914,6 +972,11 @@ int parsercmd::cmdEQ::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdEQ::compile(TellCode& code) const
+{
+   return code.compare(true);
+}
+
 //=============================================================================
 int parsercmd::cmdNE::execute()
 {
@@ -927,6 +990,11 @@ int parsercmd::cmdNE::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdNE::compile(TellCode& code) const
+{
+   return code.compare(false);
+}
+
 //=============================================================================
 int parsercmd::cmdAND::execute()
 {
@@ -937,6 +1005,11 @@ int parsercmd::cmdAND::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdAND::compile(TellCode& code) const
+{
+   return code.logic(vmAND);
+}
+
 //=============================================================================
 int parsercmd::cmdBWAND::execute()
 {
@@ -963,6 +1036,13 @@ int parsercmd::cmdBWAND::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdBWAND::compile(TellCode& code) const
+{
+   if      (telldata::tn_int  == _type) return code.bitwise(vmBANDI, _type);
+   else if (telldata::tn_uint == _type) return code.bitwise(vmBANDU, _type);
+   else return false;
+}
+
 //=============================================================================
 int parsercmd::cmdOR::execute()
 {
@@ -973,6 +1053,11 @@ int parsercmd::cmdOR::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdOR::compile(TellCode& code) const
+{
+   return code.logic(vmOR);
+}
+
 //=============================================================================
 int parsercmd::cmdBWOR::execute()
 {
@@ -999,6 +1084,13 @@ int parsercmd::cmdBWOR::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdBWOR::compile(TellCode& code) const
+{
+   if      (telldata::tn_int  == _type) return code.bitwise(vmBORI, _type);
+   else if (telldata::tn_uint == _type) return code.bitwise(vmBORU, _type);
+   else return false;
+}
+
 //=============================================================================
 int parsercmd::cmdBWXOR::execute()
 {
@@ -1026,6 +1118,13 @@ int parsercmd::cmdBWXOR::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdBWXOR::compile(TellCode& code) const
+{
+   if      (telldata::tn_int  == _type) return code.bitwise(vmBXORI, _type);
+   else if (telldata::tn_uint == _type) return code.bitwise(vmBXORU, _type);
+   else return false;
+}
+
 //=============================================================================
 int parsercmd::cmdBWSHIFT::execute()
 {
@@ -1072,6 +1171,11 @@ int parsercmd::cmdNOT::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdNOT::compile(TellCode& code) const
+{
+   return code.unary(vmNOT, telldata::tn_bool, telldata::tn_bool);
+}
+
 //=============================================================================
 int parsercmd::cmdBWNOT::execute()
 {
@@ -1085,6 +1189,13 @@ int parsercmd::cmdBWNOT::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdBWNOT::compile(TellCode& code) const
+{
+   if      (telldata::tn_int  == _type) return code.unary(vmBNOTI, _type, _type);
+   else if (telldata::tn_uint == _type) return code.unary(vmBNOTU, _type, _type);
+   else return false;
+}
+
 //=============================================================================
 int parsercmd::cmdUMINUS::execute()
 {
@@ -1103,6 +1214,17 @@ int parsercmd::cmdUMINUS::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdUMINUS::compile(TellCode& code) const
+{
+   switch (_type)
+   {
+      case telldata::tn_real: return code.unary(vmNEGR, telldata::tn_real, _type);
+      case telldata::tn_int : return code.unary(vmNEGI, telldata::tn_int , _type);
+      case telldata::tn_uint: return code.unary(vmNEGU, telldata::tn_int , _type);
+      default: return false;
+   }
+}
+
 //=============================================================================
 int parsercmd::cmdSTACKRST::execute()
 {
@@ -1113,6 +1235,11 @@ int parsercmd::cmdSTACKRST::execute()
    return EXEC_NEXT;
 }
 
+bool parsercmd::cmdSTACKRST::compile(TellCode& code) const
+{
+   return code.reset();
+}
+
 //=============================================================================
 parsercmd::cmdLISTSIZE::cmdLISTSIZE(telldata::TellVar* var):
    _var(var)
@@ -1286,6 +1413,12 @@ int parsercmd::cmdASSIGN::execute()
    return EXEC_ABORT;
 }
 
+bool parsercmd::cmdASSIGN::compile(TellCode& code) const
+{
+   if (0 != _indexed) return false;
+   return code.store(_var);
+}
+
 //=============================================================================
 int parsercmd::cmdLISTADD::execute()
 {
@@ -1744,6 +1877,12 @@ int parsercmd::cmdPUSH::execute()
    return EXEC_ABORT;
 }
 
+bool parsercmd::cmdPUSH::compile(TellCode& code) const
+{
+   if (0 != _indexed) return false;
+   return code.load(_var, _constant);
+}
+
 //=============================================================================
 telldata::TellVar* parsercmd::cmdSTRUCT::getList()
 {
@@ -1840,9 +1979,31 @@ int parsercmd::cmdFUNCCALL::execute()
       if (!CMDBlock->checkDbSortState(_funcbody->dbSortStatus()))
       {
          cmdSTDFUNC* sortFunc = CMDBlock->getIntFuncBody("$sort_db");
-         sortFunc->execute();
+         if (_profiling && (0 == _callDepth))
+         {
+            // the quad trees of the unsorted layers are built here
+            wxStopWatch watch;
+            sortFunc->execute();
+            std::ostringstream info;
+            info << "DB sorted in " << watch.Time() << " msec.";
+            tell_log(console::MT_INFO, info.str());
+         }
+         else
+            sortFunc->execute();
+      }
+      if (_profiling && (0 == _callDepth))
+      {
+         wxStopWatch watch;
+         _callDepth++;
+         try {fresult = _funcbody->execute();}
+         catch (EXPTN&) {_callDepth--; throw;}
+         _callDepth--;
+         std::ostringstream info;
+         info << _funcname << "() executed in " << watch.Time() << " msec.";
+         tell_log(console::MT_INFO, info.str());
       }
-      fresult = _funcbody->execute();
+      else
+         fresult = _funcbody->execute();
    }
    catch (EXPTN&) {return EXEC_ABORT;}
    _funcbody->reduce_undo_stack();
@@ -2135,6 +2296,7 @@ parsercmd::cmdBLOCK* parsercmd::cmdBLOCK::popblk()
 {
    TELL_DEBUG(cmdBLOCK_popblk);
    assert(_blocks.size() > 1);
+   cmdEXPR::compile(_blocks.front()->_cmdQ);
    _blocks.pop_front();
    return _blocks.front();
 }
@@ -2860,15 +3022,28 @@ int parsercmd::cmdFOREACH::execute()
       clist = static_cast<telldata::TtList*>(OPstack.top());OPstack.pop();
    }
 
-   telldata::memlist valist = clist->mlist();
-   for (telldata::memlist::const_iterator CI = valist.begin(); CI != valist.end(); CI++)
+   // The list is iterated by index, because the body might change it. The
+   // members appended by the body are not iterated. Once the body removes,
+   // inserts or replaces members (see TtList::changes()), the indexes don't
+   // point to the same members anymore (and the removed ones might be
+   // deleted), so the loop stops there
+   const telldata::memlist& valist = clist->mlist();
+   const unsigned lsize = valist.size();
+   const dword lchanges = clist->changes();
+   for (unsigned i = 0; i < lsize; i++)
    {
-      _var->assign(*CI);
+      _var->assign(valist[i]);
       retexec = _body->execute();
-      if (listVariable)
-         (*CI)->assign(_var);
+      bool changed = (lchanges != clist->changes());
+      if (listVariable && !changed)
+         valist[i]->assign(_var);
 
       if (checkNextLoop(retexec, retexec1)) break;
+      if (changed)
+      {
+         tell_log(console::MT_WARNING, "foreach: members removed or replaced in the list by the loop body. Loop terminated");
+         break;
+      }
    }
    if (!listVariable)
       delete clist;
@@ -3799,6 +3974,16 @@ bool parsercmd::vplFunc(std::string fname)
            );
 }
 
+/*! The integer product of the TELL operators (see cmdMULTIPLY and cmdEXPR).
+ * The operands are multiplied as 64 bit integers and the product is truncated
+ * to 32 bits, so an overflow wraps around instead of being undefined as the
+ * conversion of an out of range real to int is.*/
+int4b parsercmd::intMultiply(real value1, real value2)
+{
+   qword product = (qword)(int8b)value1 * (qword)(int8b)value2;
+   return (int4b)(dword)product;
+}
+
 bool parsercmd::checkNextLoop(int retexec, int&retexec1)
 {
    switch (retexec)
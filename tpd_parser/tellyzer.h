@@ -111,6 +111,7 @@ namespace  parsercmd {
    class cmdBLOCK;
    class FuncDeclaration;
    class cmdCALLBACK;
+   class TellCode;
 //-----------------------------------------------------------------------------
 // Define the types of tell structures
 //-----------------------------------------------------------------------------
@@ -155,6 +156,7 @@ namespace  parsercmd {
    public:
                    cmdVIRTUAL(): _opstackerr(false) {};
       virtual int  execute() = 0;
+      virtual bool compile(TellCode&) const {return false;}
               real getOpValue(telldata::operandSTACK& OPs = OPstack);
               word getWordValue(telldata::operandSTACK& OPs = OPstack);
               byte getByteValue(telldata::operandSTACK& OPs = OPstack);
@@ -183,6 +185,7 @@ namespace  parsercmd {
                   cmdPLUS(telldata::typeID retype): _retype(retype) {};
       virtual    ~cmdPLUS() {};
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID _retype;
    };
@@ -199,6 +202,7 @@ namespace  parsercmd {
                   cmdMINUS(telldata::typeID retype): _retype(retype) {};
       virtual    ~cmdMINUS(){}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID _retype;
    };
@@ -287,6 +291,7 @@ namespace  parsercmd {
                   cmdMULTIPLY(telldata::typeID type):_retype(type)  {}
       virtual    ~cmdMULTIPLY() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID  _retype;
    };
@@ -296,6 +301,7 @@ namespace  parsercmd {
                   cmdDIVISION(telldata::typeID type):_retype(type)  {}
       virtual    ~cmdDIVISION() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID  _retype;
    };
@@ -325,6 +331,7 @@ namespace  parsercmd {
                   cmdUMINUS(telldata::typeID type):_type(type) {};
       virtual    ~cmdUMINUS() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID  _type;
    };
@@ -334,6 +341,7 @@ namespace  parsercmd {
                   cmdLT() {}
       virtual    ~cmdLT() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdLET:public cmdVIRTUAL {
@@ -341,6 +349,7 @@ namespace  parsercmd {
                   cmdLET() {}
       virtual    ~cmdLET() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdGT:public cmdVIRTUAL {
@@ -348,6 +357,7 @@ namespace  parsercmd {
                   cmdGT() {}
       virtual    ~cmdGT() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdGET:public cmdVIRTUAL {
@@ -355,6 +365,7 @@ namespace  parsercmd {
                   cmdGET() {}
       virtual    ~cmdGET() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdEQ:public cmdVIRTUAL {
@@ -362,6 +373,7 @@ namespace  parsercmd {
                   cmdEQ() {}
       virtual    ~cmdEQ() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdNE:public cmdVIRTUAL {
@@ -369,6 +381,7 @@ namespace  parsercmd {
                   cmdNE() {}
       virtual    ~cmdNE() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdNOT:public cmdVIRTUAL {
@@ -376,6 +389,7 @@ namespace  parsercmd {
                   cmdNOT() {}
       virtual    ~cmdNOT() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdBWNOT:public cmdVIRTUAL {
@@ -383,6 +397,7 @@ namespace  parsercmd {
                   cmdBWNOT(telldata::typeID type):_type(type)  {}
       virtual    ~cmdBWNOT() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID  _type;
    };
@@ -392,6 +407,7 @@ namespace  parsercmd {
                   cmdAND() {}
       virtual    ~cmdAND() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdBWAND:public cmdVIRTUAL {
@@ -399,6 +415,7 @@ namespace  parsercmd {
                   cmdBWAND(telldata::typeID type):_type(type)  {}
       virtual    ~cmdBWAND() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID  _type;
    };
@@ -408,6 +425,7 @@ namespace  parsercmd {
                   cmdOR() {}
       virtual    ~cmdOR() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdBWOR:public cmdVIRTUAL {
@@ -415,6 +433,7 @@ namespace  parsercmd {
                   cmdBWOR(telldata::typeID type):_type(type)  {}
       virtual    ~cmdBWOR() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID  _type;
    };
@@ -424,6 +443,7 @@ namespace  parsercmd {
                   cmdBWXOR(telldata::typeID type):_type(type)  {}
       virtual    ~cmdBWXOR() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::typeID  _type;
    };
@@ -452,6 +472,7 @@ namespace  parsercmd {
                   cmdSTACKRST() {}
       virtual    ~cmdSTACKRST() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    };
 
    class cmdLISTSIZE:public cmdVIRTUAL {
@@ -469,6 +490,7 @@ namespace  parsercmd {
                   cmdASSIGN(telldata::TellVar* var, byte indexed): _var(var), _indexed(indexed) {};
       virtual    ~cmdASSIGN() {}
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    protected:
       telldata::TellVar*   _var;
       byte                 _indexed;
@@ -480,6 +502,7 @@ namespace  parsercmd {
                         _var(v),  _indexed(indexed), _constant(constant) {};
       virtual    ~cmdPUSH() {if (_constant) delete _var;};
       virtual int execute();
+      virtual bool compile(TellCode&) const;
    private:
       telldata::TellVar*   _var;
       byte                 _indexed;
@@ -651,9 +674,12 @@ namespace  parsercmd {
                   cmdFUNCCALL(cmdSTDFUNC* bd, std::string fn):_funcbody(bd), _funcname(fn) {};
       virtual    ~cmdFUNCCALL() {}
       virtual int execute();
+      static void setProfiling(bool prof) {_profiling = prof;}
    protected:
       cmdSTDFUNC*       _funcbody;
       std::string       _funcname;
+      static bool       _profiling;    //! log the execution time of the top level calls
+      static word       _callDepth;    //! nesting of the profiled calls
    };
 
    /*** cmdBLOCK ****************************************************************
@@ -937,6 +963,7 @@ namespace  parsercmd {
    void              ClearArgumentList(ArgumentLIST*);
    bool              vplFunc(std::string);
    bool              checkNextLoop(int, int&);
+   int4b             intMultiply(real, real);
 
 
    /*!
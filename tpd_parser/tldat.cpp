@@ -359,7 +359,8 @@ void telldata::TtAuxdata::assign(TellVar* data)
    update_cstat();
 }
 //=============================================================================
-telldata::TtList::TtList(const telldata::TtList& cobj) : TellVar(cobj.get_type())
+telldata::TtList::TtList(const telldata::TtList& cobj) : TellVar(cobj.get_type()),
+   _changes(0)
 {
    // copy constructor
    unsigned count = cobj._mlist.size();
@@ -376,6 +377,7 @@ const telldata::TtList& telldata::TtList::operator =(const telldata::TtList& cob
    for (i = 0; i < count; i++)
       delete _mlist[i];
    _mlist.clear();
+   _changes++;
    count = cobj._mlist.size();
    _mlist.reserve(count);
    for (i = 0; i < count; i++)
@@ -436,6 +438,7 @@ void telldata::TtList::initialize()
       delete _mlist[i];
    }
    _mlist.clear();
+   _changes++;
 }
 
 void telldata::TtList::assign(TellVar* rt)
@@ -477,6 +480,7 @@ bool telldata::TtList::part_assign(dword index1, dword index2, const TtList* rva
       _mlist[i] = rvalue->_mlist[j++]->selfcopy();
       delete tvar;
    }
+   _changes++;
    return true;
 }
 
@@ -487,6 +491,7 @@ void telldata::TtList::resize(unsigned num, TellVar* initVar)
    {
       _mlist[i] = initVar->selfcopy();
    }
+   _changes++;
 }
 
 bool telldata::TtList::validIndex(dword index)
@@ -522,6 +527,7 @@ void telldata::TtList::insert(telldata::TellVar* newval, dword index)
       }
       assert(NULL != (*CI));
       _mlist.insert(CI,newval->selfcopy());
+      _changes++;
    }
 }
 
@@ -543,6 +549,7 @@ void telldata::TtList::lunion(telldata::TtList* inlist, dword index)
    {
       for (unsigned i=1; i <= oldSize - index; i++)
          _mlist[newSize - i] = _mlist[oldSize - i];
+      _changes++;
    }
    for(unsigned i=0; i < inlist->size(); i++)
       _mlist[index+i] = inlist->mlist()[i]->selfcopy();
@@ -568,6 +575,7 @@ telldata::TellVar* telldata::TtList::erase(dword index)
       }
       _mlist.erase(CI);
    }
+   _changes++;
    return erased;
 }
 
@@ -592,6 +600,7 @@ telldata::TellVar* telldata::TtList::erase(dword idxB, dword idxE)
    // If I remember correctly erase method from the STDLIB should not delete
    // the components. Means that we can reuse them - i.e. - don't need a selfcopy
    _mlist.erase(CIB, CIE);
+   _changes++;
 
    return erased;
 }
@@ -32,6 +32,7 @@
 #include <vector>
 #include <algorithm>
 #include "ttt.h"
+#include "tellpool.h"
 
 #define NUMBER_TYPE(op) ((op > telldata::tn_void) && (op < telldata::tn_bool ))
 #define INTEGER_TYPE(op) ((op == telldata::tn_uint) || (op == telldata::tn_int ))
@@ -201,6 +202,10 @@ namespace telldata {
       bool                 constant() const {return 0 == _changeable;}
       void                 const_declaration() {_changeable = 1;}
       virtual             ~TellVar() {};
+#ifdef TELL_VAR_POOL
+      static void*         operator new(size_t size)              {return VarPool::instance().allocate(size);}
+      static void          operator delete(void* ptr, size_t size) {VarPool::instance().release(ptr, size);}
+#endif
    protected:
       typeID              _ID;
       byte                _changeable;
@@ -343,7 +348,7 @@ namespace telldata {
    //==============================================================================
    class TtList:public TellVar {
    public:
-                           TtList(typeID ltype): TellVar(ltype) {};
+                           TtList(typeID ltype): TellVar(ltype), _changes(0) {};
                            TtList(const TtList& cobj);
       const TtList&        operator = (const TtList&);
       virtual void         initialize();
@@ -351,11 +356,11 @@ namespace telldata {
       bool                 part_assign(dword, dword, const TtList*);
       virtual TellVar*     selfcopy() const  {return DEBUG_NEW TtList(*this);}
       virtual const typeID get_type() const  {return _ID | tn_listmask;}
-      memlist              mlist() const     {return _mlist;}
+      const memlist&       mlist() const     {return _mlist;}
       void                 add(TellVar* p) {_mlist.push_back(p);}
       void                 reserve(unsigned num) {_mlist.reserve(num);}
       void                 resize(unsigned num, TellVar* initVar);
-      void                 reverse()         {std::reverse(_mlist.begin(), _mlist.end());}
+      void                 reverse()         {std::reverse(_mlist.begin(), _mlist.end()); _changes++;}
       unsigned             size() const      {return _mlist.size();}
       virtual TellVar*     index_var(dword);
       virtual TtList*      index_range_var(dword, dword);
@@ -367,9 +372,11 @@ namespace telldata {
       TellVar*             erase(dword);
       TellVar*             erase(dword, dword);
       unsigned             size() {return _mlist.size();}
+      dword                changes() const   {return _changes;}
       virtual             ~TtList();
    private:
       memlist             _mlist;    // the list itself
+      dword               _changes;  // members removed, replaced or moved (not appended) - see cmdFOREACH
    };
 
    //==============================================================================